@@ -0,0 +1,68 @@
+/**
+ * Arena Module
+ *
+ * Bump allocator. Memory is taken from slabs in order and is only given back
+ * when the whole arena is deleted, which frees every slab at once. Used for
+ * data that lives as long as its owner, such as the entries and keys of a dict
+ * created with the `arena` option.
+ *
+ * Implementation details:
+ * The first slab has the size given on creation and every new slab doubles it,
+ * up to ARENA_MAX_SLAB_SZ, so small owners waste little memory and large ones
+ * need few slabs. Allocations that don't fit a regular slab get one of their
+ * own. Every allocation is aligned to 8 bytes.
+ */
+
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stdlib.h>
+
+#define ARENA_DEFAULT_SLAB_SZ 1024
+#define ARENA_MAX_SLAB_SZ (64 * 1024)
+
+typedef struct _arena arena_t;
+
+/**
+ * Creates an arena.
+ *
+ * @param slab_size - the size of the first slab, 0 for ARENA_DEFAULT_SLAB_SZ.
+ * @return a pointer to the created arena. [ownership]
+ */
+arena_t *arena_create(size_t slab_size);
+
+/**
+ * Allocates memory from the arena.
+ *
+ * @param arena - the arena. [mut ref]
+ * @param size - the number of bytes.
+ * @return a pointer to the memory, valid until the arena is deleted. [ref]
+ */
+void *arena_alloc(arena_t *arena, size_t size);
+
+/**
+ * Copies `len` bytes of a string into the arena and terminates the copy.
+ *
+ * @param arena - the arena. [mut ref]
+ * @param str - the string. [ref]
+ * @param len - the number of bytes to copy.
+ * @return the copy, valid until the arena is deleted. [ref]
+ */
+char *arena_strndup(arena_t *arena, const char *str, size_t len);
+
+/**
+ * Gets the number of bytes the arena took from malloc.
+ *
+ * @param arena - the arena. [ref]
+ * @return the total size of the slabs.
+ */
+size_t arena_get_capacity(arena_t *arena);
+
+/**
+ * Deletes the arena and every allocation made from it.
+ *
+ * @param arena - the arena. [ownership]
+ */
+void arena_delete(arena_t *arena);
+
+#endif
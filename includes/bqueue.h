@@ -0,0 +1,126 @@
+/**
+ * Blocking Queue Module
+ *
+ * A bounded queue shared by producer and consumer threads that blocks instead
+ * of failing: a consumer waits until an element arrives, and a producer waits
+ * while the queue is full, so producers faster than their consumers are slowed
+ * down to their pace (backpressure). Each wait may be bounded by a timeout.
+ *
+ * Closing the queue wakes every waiting thread. From then on pushes fail, and
+ * pops still return the elements left until the queue is drained, so workers
+ * finish the pending work and then see that the queue is closed:
+ *
+ *     while (bqueue_pop(queue, &task, BQUEUE_FOREVER) == BQUEUE_OK) run(&task);
+ *
+ * Like queue_t (see queue_bank.h), elements have a fixed size and are copied
+ * in and out of the queue.
+ *
+ * Implementation details:
+ * Elements are in a ring buffer with a power of two number of slots, guarded
+ * by a lock. Threads that have to wait sleep on a futex (Linux only): one word
+ * is bumped by every push and consumers wait on it, another one is bumped by
+ * every pop and producers wait on it. Each word is read under the lock before
+ * sleeping, so a change made after the lock is released wakes the thread right
+ * away instead of being missed. Wakeups are only issued when some thread is
+ * waiting, so an uncontended push or pop makes no system call.
+ * The lock itself is a futex based mutex that spins for a short while before
+ * sleeping.
+ */
+
+#ifndef __BQUEUE_H__
+#define __BQUEUE_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#define BQUEUE_FOREVER (-1L) // Timeout to wait as long as needed.
+
+typedef struct _bqueue bqueue_t;
+
+typedef enum {
+    BQUEUE_OK,
+    BQUEUE_TIMEOUT, // The queue stayed full (or empty) for the whole timeout.
+    BQUEUE_CLOSED,  // The queue was closed (and, for a pop, is empty).
+} bqueue_status_t;
+
+/**
+ * Creates a blocking queue.
+ *
+ * @param elsize - the size of the elements.
+ * @param cap - the number of elements the queue holds before pushes wait,
+ *     rounded up to a power of two.
+ * @return a pointer to the created queue. [ownership]
+ */
+bqueue_t *bqueue_create(size_t elsize, size_t cap);
+
+/**
+ * Pushes an element, waiting while the queue is full.
+ *
+ * @param queue - the queue. [mut ref]
+ * @param element - the element, copied in the queue. [ref]
+ * @param timeout_us - the longest time to wait in microseconds, 0 to not wait
+ *     or BQUEUE_FOREVER.
+ * @return BQUEUE_OK if the element was pushed, BQUEUE_TIMEOUT or BQUEUE_CLOSED
+ *     otherwise.
+ */
+bqueue_status_t bqueue_push(bqueue_t *queue, const void *element, long timeout_us);
+
+/**
+ * Pops the oldest element, waiting while the queue is empty.
+ *
+ * @param queue - the queue. [mut ref]
+ * @param element - where the element is copied. [mut ref]
+ * @param timeout_us - the longest time to wait in microseconds, 0 to not wait
+ *     or BQUEUE_FOREVER.
+ * @return BQUEUE_OK if an element was popped, BQUEUE_TIMEOUT or BQUEUE_CLOSED
+ *     otherwise.
+ */
+bqueue_status_t bqueue_pop(bqueue_t *queue, void *element, long timeout_us);
+
+/**
+ * Pops up to n elements, waiting while the queue is empty. Takes whatever is
+ * there once there is something, without waiting for n elements.
+ *
+ * @param queue - the queue. [mut ref]
+ * @param elements - where the elements are copied, room for n. [mut ref]
+ * @param n - the maximum number of elements.
+ * @param timeout_us - the longest time to wait in microseconds, 0 to not wait
+ *     or BQUEUE_FOREVER.
+ * @return the number of elements popped, 0 on timeout or if the queue is
+ *     closed and empty.
+ */
+size_t bqueue_pop_n(bqueue_t *queue, void *elements, size_t n, long timeout_us);
+
+/**
+ * Closes the queue and wakes every thread waiting on it. Elements already in
+ * the queue may still be popped.
+ *
+ * @param queue - the queue. [mut ref]
+ */
+void bqueue_close(bqueue_t *queue);
+
+/**
+ * Checks if the queue was closed.
+ *
+ * @param queue - the queue. [ref]
+ * @return true if bqueue_close was called, false otherwise.
+ */
+bool bqueue_is_closed(bqueue_t *queue);
+
+/**
+ * Gets the number of elements in the queue. With other threads using the queue
+ * it may already be out of date when it returns.
+ *
+ * @param queue - the queue. [ref]
+ * @return the number of elements.
+ */
+size_t bqueue_get_size(bqueue_t *queue);
+
+/**
+ * Deletes the queue. No thread may be using or waiting on it.
+ *
+ * @param queue - the queue. [ownership]
+ */
+void bqueue_delete(bqueue_t *queue);
+
+#endif
@@ -0,0 +1,127 @@
+/**
+ * Concurrent Dict Module
+ *
+ * A string keyed dictionary that may be used by many threads at once, with the
+ * same key and value semantics as dict_t: keys are copied, inserting a key that
+ * is already there fails and removing returns the value of the key.
+ *
+ * Implementation details:
+ * The table is split in stripes, picked by the high bits of the hash. Each
+ * stripe is a chained table of its own with its own lock, so writers on
+ * different stripes never wait on each other.
+ *
+ * Lookups take no lock and write no shared memory. Nodes are published with
+ * release stores, so a reader sees either the chain before or after a change.
+ * A sequence counter per stripe (seqlock) is bumped around resizes only, the
+ * one change that moves nodes between chains; a lookup that finds nothing
+ * while the counter moved is retried.
+ * Memory of removed nodes and old bucket arrays is freed only once no lookup
+ * that started before the removal is still running (epoch based
+ * reclamation). Each thread that does lookups takes one of CDICT_MAX_THREADS
+ * reader slots, released when the thread exits; threads beyond that take the
+ * stripe lock for their lookups instead.
+ *
+ * The dict does not manage the lifetime of values: a value returned by a
+ * lookup may be removed (and freed by its owner) by another thread afterwards.
+ */
+
+#ifndef __CDICT_H__
+#define __CDICT_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <dict.h>
+
+#define CDICT_MAX_THREADS 128
+
+typedef struct _cdict cdict_t;
+
+// Options used to create a concurrent dict. Fields left as 0 use the defaults.
+typedef struct {
+    size_t size;    // The starting number of buckets over all stripes.
+    size_t stripes; // The number of stripes, rounded to a power of two (64).
+} cdict_opts_t;
+
+// Shorthand for a cdict_opts_t literal. Usage: CDICT_OPTS(.stripes = 16)
+#define CDICT_OPTS(args...) ((cdict_opts_t){ args })
+
+/**
+ * Creates a concurrent dict with the default options.
+ *
+ * @return a pointer to the created dict. [ownership]
+ */
+cdict_t *cdict_create();
+
+/**
+ * Creates a concurrent dict with the given options.
+ *
+ * @param opts - the options, see cdict_opts_t.
+ * @return a pointer to the created dict. [ownership]
+ */
+cdict_t *cdict_create_with(cdict_opts_t opts);
+
+/**
+ * Gets the value of a key. Takes no lock.
+ *
+ * @param cdict - the dict. [ref]
+ * @param key - the key. [ref]
+ * @return the value of the key or NULL if the key is not in the dict.
+ */
+dict_value_t cdict_get(cdict_t *cdict, char *key);
+
+/**
+ * Verifies if the dict contains a key. Takes no lock.
+ *
+ * @param cdict - the dict. [ref]
+ * @param key - the key. [ref]
+ * @return true if the key is in the dict, false otherwise.
+ */
+bool cdict_contains(cdict_t *cdict, char *key);
+
+/**
+ * Gets the number of entries in the dict. While other threads insert or remove
+ * entries the result is only an approximation.
+ *
+ * @param cdict - the dict. [ref]
+ * @return the number of entries.
+ */
+size_t cdict_get_size(cdict_t *cdict);
+
+/**
+ * Inserts a key if it is not in the dict yet.
+ *
+ * @param cdict - the dict. [mut ref]
+ * @param key - the key, a copy of it is stored. [ref]
+ * @param value - the value.
+ * @return true if the key was inserted, false if it was already in the dict.
+ */
+bool cdict_insert(cdict_t *cdict, char *key, dict_value_t value);
+
+/**
+ * Removes a key from the dict and returns its value.
+ *
+ * @param cdict - the dict. [mut ref]
+ * @param key - the key. [ref]
+ * @return the value of the key or NULL if the key is not in the dict.
+ */
+dict_value_t cdict_remove_entry(cdict_t *cdict, char *key);
+
+/**
+ * Removes a key from the dict and frees its value.
+ *
+ * @param cdict - the dict. [mut ref]
+ * @param key - the key. [ref]
+ * @param free_fn - frees the value, may be NULL.
+ * @return true if the key was removed, false if it was not in the dict.
+ */
+bool cdict_remove(cdict_t *cdict, char *key, free_fn_t free_fn);
+
+/**
+ * Deletes the dict. No other thread may be using it.
+ *
+ * @param cdict - the dict. [ownership]
+ * @param free_fn - frees each value, may be NULL.
+ */
+void cdict_delete(cdict_t *cdict, free_fn_t free_fn);
+
+#endif
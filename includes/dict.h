@@ -1,9 +1,43 @@
+/**
+ * Dict Module
+ *
+ * Module that implements a string keyed dictionary as an Abstract Data Type.
+ *
+ * Implementation details:
+ * Three engines are available and can be selected when the dict is created with
+ * dict_create_with. Every other function works the same regardless of engine.
+ *
+ * DICT_CHAINED (default): separate chaining, every entry is a node in the
+ *     linked list of its bucket. The load factor is 0.75. Optionally the
+ *     table may be resized incrementally (see dict_opts_t).
+ * DICT_OPEN: open addressing in the style of SwissTable. Entries live in a flat
+ *     slot array and a parallel array of control bytes stores a 7 bit tag of
+ *     each hash. Lookups compare 16 control bytes at a time (with SSE2 when
+ *     available), so a probe usually touches one or two cache lines. The
+ *     maximum load factor is 7/8.
+ * DICT_ORDERED: compact layout in the style of CPython. Entries are stored in a
+ *     dense array in insertion order and a table of small integer indices
+ *     (1 to 8 bytes wide depending on its size) maps hashes to them. It uses
+ *     less memory per entry than the other engines and dict_iter visits the
+ *     entries in insertion order with a linear walk over the array.
+ *
+ * All engines shrink the table when less than 1/8 of it is used, but never
+ * below the starting size or the size set with dict_reserve.
+ *
+ * With the `arena` option, entries and copies of keys are allocated from slabs
+ * owned by the dict (see arena.h) and are all freed at once by dict_delete.
+ *
+ * Keys are hashed with HASH_DEFAULT (see hash.h) unless another hash function
+ * is given, with a seed picked at random for each dict.
+ */
+
 #ifndef __DICT_H__
 #define __DICT_H__
 
 #include <stdlib.h>
 #include <stdbool.h>
 #include <utils.h>
+#include <hash.h>
 
 typedef struct _dict dict_t;
 typedef struct _dict_entry dict_entry_t;
@@ -11,14 +45,150 @@ typedef void * dict_value_t;
 
 typedef void (*free_fn_t)(dict_value_t);
 
+typedef enum {
+    DICT_CHAINED,
+    DICT_OPEN,
+    DICT_ORDERED,
+} dict_kind_t;
+
+// Options used to create a dict. Fields left as 0 use the defaults.
+typedef struct {
+    dict_kind_t kind; // The engine used by the dict.
+    size_t size;      // The starting table size (16 by default).
+    // Only for DICT_CHAINED. Instead of moving every entry at once when the
+    // table grows, the old and new tables coexist and each operation moves a
+    // few buckets, so no single insertion pays for the whole resize.
+    bool incremental;
+    hash_fn_t hash; // The hash function for the keys (HASH_DEFAULT by default).
+    uint64_t seed;  // The seed of the hash function (random by default).
+    // Allocates entries and keys from slabs owned by the dict instead of one
+    // malloc each. Memory of removed entries is only reclaimed by dict_delete,
+    // so it suits dicts that are filled and then dropped as a whole.
+    bool arena;
+} dict_opts_t;
+
+// Shorthand for a dict_opts_t literal. Usage: DICT_OPTS(.kind = DICT_OPEN)
+#define DICT_OPTS(args...) ((dict_opts_t){ args })
+
 dict_t *dict_create();
 dict_t *dict_create_sized(size_t size);
 
+/**
+ * Creates a dict with the given options.
+ *
+ * @param opts - the options, see dict_opts_t.
+ * @return a pointer to the created dict. [ownership]
+ */
+dict_t *dict_create_with(dict_opts_t opts);
+
+/**
+ * Gets the engine that a dict uses.
+ *
+ * @param dict - the dict. [ref]
+ * @return the engine the dict was created with.
+ */
+dict_kind_t dict_get_kind(dict_t *dict);
+
 dict_entry_t *dict_get_entry(dict_t *dict, char *key);
 dict_value_t dict_get(dict_t *dict, char *key);
 bool dict_contains(dict_t *dict, char *key);
+
+/**
+ * Looks up many keys at once. Keys are hashed and resolved in batches, with
+ * prefetches issued for every key of a batch before any of them is compared,
+ * so the cache misses of independent lookups overlap.
+ *
+ * @param dict - the dict. [ref]
+ * @param keys - the keys to look up. [ref]
+ * @param n - the number of keys.
+ * @param out - receives the value of each key, or NULL if it is not in the
+ *              dict. Must have room for `n` values. [mut ref]
+ * @return the number of keys found.
+ */
+size_t dict_get_many(dict_t *dict, char **keys, size_t n, dict_value_t *out);
+
 size_t dict_get_size(dict_t *dict);
 
+/**
+ * Gets the number of buckets (or slots) of the dict table.
+ *
+ * @param dict - the dict. [ref]
+ * @return the size of the table.
+ */
+size_t dict_get_capacity(dict_t *dict);
+
+/**
+ * Makes sure that the dict can hold `n` entries without resizing. The table
+ * won't shrink automatically below this size until dict_shrink_to_fit.
+ *
+ * @param dict - the dict. [mut ref]
+ * @param n - the number of entries.
+ */
+void dict_reserve(dict_t *dict, size_t n);
+
+/**
+ * Shrinks the table to the smallest size that holds the current entries.
+ *
+ * @param dict - the dict. [mut ref]
+ */
+void dict_shrink_to_fit(dict_t *dict);
+
+// State of an iteration over a dict, see dict_iter. Its fields are private.
+typedef struct {
+    dict_t *dict;
+    size_t idx;
+    void *node;
+} dict_iter_t;
+
+/**
+ * Starts an iteration over every entry of a dict, in no particular order
+ * except for DICT_ORDERED dicts, whose entries are visited in the order they
+ * were inserted. The iterator needs no allocation and no cleanup. Usage:
+ *
+ *     char *key; dict_value_t value;
+ *     for (dict_iter_t it = dict_iter(dict); dict_iter_next(&it, &key, &value);)
+ *
+ * Any incremental rehash in progress is finished first, so lookups may be done
+ * while iterating, but the dict must not be modified until the iteration ends.
+ *
+ * @param dict - the dict. [mut ref]
+ * @return the iterator, positioned before the first entry.
+ */
+dict_iter_t dict_iter(dict_t *dict);
+
+/**
+ * Advances an iterator to the next entry.
+ *
+ * @param it - the iterator. [mut ref]
+ * @param key - receives the key of the entry, owned by the dict. May be NULL. [mut ref]
+ * @param value - receives the value of the entry. May be NULL. [mut ref]
+ * @return true if there was an entry, false once every entry was visited.
+ */
+bool dict_iter_next(dict_iter_t *it, char **key, dict_value_t *value);
+
+typedef void (*dict_scan_fn_t)(char *key, dict_value_t value, void *ctx);
+
+/**
+ * Visits a chunk of the entries of a dict, resuming from a cursor. The scan
+ * starts with cursor 0 and is over when the returned cursor is 0 again.
+ *
+ * The dict may be modified and resized between calls. The cursor walks the
+ * buckets in reverse binary order (as Redis SCAN does), so every entry that
+ * is in the dict for the whole scan is visited at least once, even across
+ * resizes, and no state is kept in the dict. Entries may be visited more than
+ * once when the table shrinks, and entries inserted or removed during the scan
+ * may or may not be visited.
+ *
+ * @param dict - the dict. [ref]
+ * @param cursor - 0 to start a scan, or the value returned by the last call.
+ * @param count - the scan stops after the bucket in which this many entries
+ *                were visited, so a call may visit a few more.
+ * @param fn - called with each entry visited. Must not use the dict.
+ * @param ctx - passed to fn as is.
+ * @return the cursor to resume from, 0 if the scan is over.
+ */
+size_t dict_scan(dict_t *dict, size_t cursor, size_t count, dict_scan_fn_t fn, void *ctx);
+
 bool dict_insert(dict_t *dict, char *key, dict_value_t value);
 bool dict_insert_entry(dict_t *dict, dict_entry_t *entry);
 bool dict_remove(dict_t *dict, char *key, free_fn_t free_fn);
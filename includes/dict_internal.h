@@ -0,0 +1,129 @@
+/**
+ * Dict internals
+ *
+ * Definitions shared by the dict engines (src/dict*.c). This is not part of
+ * the public interface of the dict module and should only be included by its
+ * sources.
+ */
+
+#ifndef __DICT_INTERNAL_H__
+#define __DICT_INTERNAL_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <dict.h>
+#include <arena.h>
+
+#define DICT_DEFAULT_SZ 16
+#define DICT_BATCH_SZ 16 // Keys resolved together by dict_get_many.
+
+// The part of an entry that is the same for every engine. The full hash and
+// the length of the key are cached so that mismatches are rejected without
+// reading the key and resizes never need to hash the keys again.
+struct _dict_entry {
+    char *key;
+    dict_value_t value;
+    uint64_t hash;
+    size_t len;
+};
+
+// Verifies if an entry has a key with a given hash and length.
+#define entry_matches(e, k, h, l) \
+    ((e)->hash == (h) && (e)->len == (l) && !memcmp((e)->key, (k), (l)))
+
+// A node in a bucket of a DICT_CHAINED dict.
+typedef struct _dict_node {
+    dict_entry_t entry;
+    struct _dict_node *next;
+} dict_node_t;
+
+// Control byte of a DICT_OPEN slot. Either a special value (empty or deleted,
+// both negative) or the 7 bit tag of the hash of the key in the slot.
+typedef int8_t dict_ctrl_t;
+
+struct _dict {
+    dict_kind_t kind;
+    bool incremental;
+    size_t max_size; // Number of buckets or slots.
+    size_t min_size; // The table never shrinks automatically below this size.
+    size_t size;
+    hash_fn_t hash;
+    uint64_t seed;
+    bool use_arena;
+    arena_t *arena; // Created on first use, see dict_arena.
+    union {
+        // DICT_CHAINED
+        struct {
+            dict_node_t **buckets;
+            // While an incremental rehash is in progress, entries are moved
+            // from `buckets` into `new_buckets`, starting at `rehash_idx`.
+            dict_node_t **new_buckets;
+            size_t new_size;
+            size_t rehash_idx;
+        };
+
+        // DICT_OPEN
+        struct {
+            dict_ctrl_t *ctrl;
+            dict_entry_t *slots;
+            size_t growth_left; // Inserts left before a rehash is required.
+        };
+
+        // DICT_ORDERED
+        struct {
+            void *indices; // `max_size` positions in `entries`, see dict_ordered.c.
+            dict_entry_t *entries; // In insertion order, removed ones have a NULL key.
+            size_t n_entries;      // Entries used in the array, removed ones included.
+            // Inline space for the keys of small dicts, NULL for other dicts.
+            char *keybuf;
+            size_t keybuf_size;
+            size_t keybuf_used;
+        };
+    };
+
+    // Entries and keys of small DICT_ORDERED dicts, see dict_ordered.c.
+    _Alignas(8) unsigned char inline_data[];
+};
+
+uint64_t dict_hash(dict_t *dict, char *key, size_t *len);
+
+// Gets the arena of a dict with the `arena` option.
+arena_t *dict_arena(dict_t *dict);
+
+// Copies and frees keys, from the arena of the dict if it has one.
+char *dict_key_dup(dict_t *dict, char *key, size_t len);
+void dict_key_free(dict_t *dict, char *key);
+
+/* DICT_OPEN engine (src/dict_open.c) */
+
+void dict_open_init(dict_t *dict, size_t size);
+dict_entry_t *dict_open_get_entry(dict_t *dict, char *key, uint64_t hash, size_t len);
+size_t dict_open_get_batch(dict_t *dict, char **keys, uint64_t *hashes, size_t *lens,
+                           size_t n, dict_value_t *out);
+bool dict_open_insert(dict_t *dict, char *key, uint64_t hash, size_t len, dict_value_t value);
+dict_value_t dict_open_remove_entry(dict_t *dict, char *key, uint64_t hash, size_t len);
+void dict_open_delete(dict_t *dict, free_fn_t free_fn);
+void dict_open_maybe_shrink(dict_t *dict);
+void dict_open_reserve(dict_t *dict, size_t n);
+void dict_open_shrink_to_fit(dict_t *dict);
+dict_entry_t *dict_open_iter_next(dict_iter_t *it);
+size_t dict_open_scan(dict_t *dict, size_t cursor, size_t count, dict_scan_fn_t fn, void *ctx);
+
+/* DICT_ORDERED engine (src/dict_ordered.c) */
+
+// Bytes of inline data a DICT_ORDERED dict of this size needs after its struct.
+size_t dict_ordered_inline_size(size_t size);
+void dict_ordered_init(dict_t *dict, size_t size);
+dict_entry_t *dict_ordered_get_entry(dict_t *dict, char *key, uint64_t hash, size_t len);
+size_t dict_ordered_get_batch(dict_t *dict, char **keys, uint64_t *hashes, size_t *lens,
+                              size_t n, dict_value_t *out);
+bool dict_ordered_insert(dict_t *dict, char *key, uint64_t hash, size_t len, dict_value_t value);
+dict_value_t dict_ordered_remove_entry(dict_t *dict, char *key, uint64_t hash, size_t len);
+void dict_ordered_delete(dict_t *dict, free_fn_t free_fn);
+void dict_ordered_reserve(dict_t *dict, size_t n);
+void dict_ordered_shrink_to_fit(dict_t *dict);
+dict_entry_t *dict_ordered_iter_next(dict_iter_t *it);
+size_t dict_ordered_scan(dict_t *dict, size_t cursor, size_t count, dict_scan_fn_t fn, void *ctx);
+
+#endif
@@ -0,0 +1,123 @@
+/**
+ * Frozen Dict Module
+ *
+ * A read-only snapshot of a dict_t stored as a single position independent
+ * image, usually a file. Opening the file maps it in memory and lookups read
+ * it in place, so a large dict is available right away instead of being
+ * rebuilt with one dict_insert per key, and every process that opens the same
+ * file shares its pages.
+ *
+ *     fdict_freeze(dict, "words.fdict", NULL);
+ *     ...
+ *     fdict_t *words = fdict_open("words.fdict");
+ *     const char *value = fdict_get(words, "key");
+ *
+ * Values of a dict are pointers, so freezing one needs a function that gives
+ * the bytes to store for each value (see fdict_dump_fn_t); by default values
+ * are taken as strings. A lookup returns a pointer to the stored bytes, inside
+ * the image, 8 byte aligned.
+ *
+ * Implementation details:
+ * The image holds a header, an open addressing table and a pool of entries.
+ * Each slot of the table (16 bytes) stores 32 bits of the hash of its key, the
+ * length of the key and the offset of its entry from the start of the image;
+ * an entry is the key followed by the size of the value and its bytes. Keys
+ * are placed by linear probing, with a load factor of at most 0.75, so most
+ * lookups read one or two slots and compare a single key.
+ * Keys are hashed with hash_wy and a seed stored in the header. Images use the
+ * byte order of the machine that wrote them and are refused by the others.
+ */
+
+#ifndef __FDICT_H__
+#define __FDICT_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <dict.h>
+
+typedef struct _fdict fdict_t;
+
+// Gives the bytes to store for a value: points `data` to them and returns
+// their number. The bytes are copied before the next call, so `data` may point
+// to a buffer reused for every value.
+typedef size_t (*fdict_dump_fn_t)(dict_value_t value, const void **data);
+
+/**
+ * Builds the image of a dict in memory.
+ *
+ * @param dict - the dict. [mut ref]
+ * @param dump - gives the bytes of each value, NULL if values are strings (the
+ *     bytes are then the string and its null terminator, nothing for NULL).
+ * @param size - set to the size of the image in bytes. [mut ref]
+ * @return the image, 8 byte aligned. [ownership]
+ */
+void *fdict_freeze_buffer(dict_t *dict, fdict_dump_fn_t dump, size_t *size);
+
+/**
+ * Writes the image of a dict to a file. The image is written to a new
+ * temporary file in the same directory, synced to disk, then renamed over
+ * `path`: processes that have the previous file open keep reading it
+ * unchanged, and `path` always holds a complete image, even after a crash or
+ * while other freezes of the same path run.
+ *
+ * @param dict - the dict. [mut ref]
+ * @param path - the path of the file. [ref]
+ * @param dump - gives the bytes of each value, see fdict_freeze_buffer.
+ * @return true if the file was written, false otherwise.
+ */
+bool fdict_freeze(dict_t *dict, char *path, fdict_dump_fn_t dump);
+
+/**
+ * Opens a frozen dict from a file written by fdict_freeze. The file is mapped
+ * read-only and shared with the other processes that map it.
+ *
+ * @param path - the path of the file. [ref]
+ * @return a pointer to the frozen dict, NULL if the file can't be read or is
+ *     not a valid image. [ownership]
+ */
+fdict_t *fdict_open(char *path);
+
+/**
+ * Opens a frozen dict from an image in memory, as built by fdict_freeze_buffer.
+ * The image is not copied and must outlive the frozen dict.
+ *
+ * @param data - the image, 8 byte aligned. [ref]
+ * @param size - the size of the image in bytes.
+ * @return a pointer to the frozen dict, NULL if it is not a valid image.
+ *     [ownership]
+ */
+fdict_t *fdict_from_buffer(const void *data, size_t size);
+
+/**
+ * Gets the value of a key.
+ *
+ * @param fdict - the frozen dict. [ref]
+ * @param key - the key. [ref]
+ * @return the bytes of the value (in the image), NULL if the key is not there.
+ *     [ref]
+ */
+const void *fdict_get(fdict_t *fdict, char *key);
+
+/**
+ * Same as fdict_get, also gives the number of bytes of the value.
+ *
+ * @param fdict - the frozen dict. [ref]
+ * @param key - the key. [ref]
+ * @param size - set to the size of the value if the key is there. [mut ref]
+ * @return the bytes of the value (in the image), NULL if the key is not there.
+ *     [ref]
+ */
+const void *fdict_get_sized(fdict_t *fdict, char *key, size_t *size);
+
+bool fdict_contains(fdict_t *fdict, char *key);
+
+size_t fdict_get_size(fdict_t *fdict);
+
+/**
+ * Closes a frozen dict, unmapping its file if it was opened with fdict_open.
+ *
+ * @param fdict - the frozen dict. [ownership]
+ */
+void fdict_close(fdict_t *fdict);
+
+#endif
@@ -0,0 +1,193 @@
+/**
+ * Filter Module
+ *
+ * Probabilistic sets of string keys: a lookup may answer that a key is there
+ * when it is not (a false positive), but never the opposite. They take a few
+ * bits per key and answer most lookups of absent keys with one cache line, so
+ * they are meant to sit in front of a hashset_t (or anything slower) and turn
+ * most misses away before it is touched:
+ *
+ *     bloom_t *bloom = bloom_from_hashset(set, 10);
+ *     if (bloom_contains(bloom, key) && hashset_contains(set, key)) ...
+ *
+ * Keys are hashed with the same functions as the hashset (see hash.h), and the
+ * filters built from a hashset use its very hash function and seed.
+ *
+ * Implementation details:
+ * bloom_t is a blocked Bloom filter. Each key picks one 256 bit block and sets
+ * one bit in each of its 8 words of 32 bits, so a lookup reads a single block
+ * and compares it with a mask of 8 bits at once (with SSE2 or AVX2 when
+ * available). Keys can't be removed.
+ * cuckoo_t is a cuckoo filter. It stores a 16 bit fingerprint of each key in
+ * one of two buckets of 4 fingerprints, so keys can also be removed. Inserting
+ * may fail once the filter is about 95% full.
+ */
+
+#ifndef __FILTER_H__
+#define __FILTER_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <hash.h>
+#include <hashset.h>
+
+typedef struct _bloom bloom_t;
+typedef struct _cuckoo cuckoo_t;
+
+// Options used to create a Bloom filter. Fields left as 0 use the defaults.
+typedef struct {
+    size_t n;            // The expected number of keys.
+    double bits_per_key; // Memory per expected key (10 by default, ~1% false positives).
+    hash_fn_t hash;      // The hash function for the keys (HASH_DEFAULT by default).
+    uint64_t seed;       // The seed of the hash function (random by default).
+} bloom_opts_t;
+
+// Shorthand for a bloom_opts_t literal. Usage: BLOOM_OPTS(.n = 1000)
+#define BLOOM_OPTS(args...) ((bloom_opts_t){ args })
+
+// Options used to create a cuckoo filter. Fields left as 0 use the defaults.
+typedef struct {
+    size_t n;       // The maximum number of keys.
+    hash_fn_t hash; // The hash function for the keys (HASH_DEFAULT by default).
+    uint64_t seed;  // The seed of the hash function (random by default).
+} cuckoo_opts_t;
+
+// Shorthand for a cuckoo_opts_t literal. Usage: CUCKOO_OPTS(.n = 1000)
+#define CUCKOO_OPTS(args...) ((cuckoo_opts_t){ args })
+
+/* Blocked Bloom filter */
+
+/**
+ * Creates a Bloom filter with the given options.
+ *
+ * @param opts - the options, see bloom_opts_t.
+ * @return a pointer to the created filter. [ownership]
+ */
+bloom_t *bloom_create_with(bloom_opts_t opts);
+
+/**
+ * Creates a Bloom filter that holds every key of a hashset, hashed with the
+ * hash function and seed of the hashset.
+ *
+ * @param hashset - the hashset. [mut ref]
+ * @param bits_per_key - memory per key of the hashset.
+ * @return a pointer to the created filter. [ownership]
+ */
+bloom_t *bloom_from_hashset(hashset_t *hashset, double bits_per_key);
+
+/**
+ * Inserts a key in the filter.
+ *
+ * @param bloom - the filter. [mut ref]
+ * @param key - the key. [ref]
+ */
+void bloom_insert(bloom_t *bloom, char *key);
+
+/**
+ * Verifies if the filter may contain a key.
+ *
+ * @param bloom - the filter. [ref]
+ * @param key - the key. [ref]
+ * @return false if the key was never inserted, true if it probably was.
+ */
+bool bloom_contains(bloom_t *bloom, char *key);
+
+// Same as bloom_insert and bloom_contains, for a key that was already hashed
+// with the hash function and seed of the filter.
+void bloom_insert_hash(bloom_t *bloom, uint64_t hash);
+bool bloom_contains_hash(bloom_t *bloom, uint64_t hash);
+
+/**
+ * Gets the memory used by the bits of the filter.
+ *
+ * @param bloom - the filter. [ref]
+ * @return the number of bits.
+ */
+size_t bloom_get_bits(bloom_t *bloom);
+
+/**
+ * Deletes the filter.
+ *
+ * @param bloom - the filter. [ownership]
+ */
+void bloom_delete(bloom_t *bloom);
+
+/* Cuckoo filter */
+
+/**
+ * Creates a cuckoo filter with the given options.
+ *
+ * @param opts - the options, see cuckoo_opts_t.
+ * @return a pointer to the created filter. [ownership]
+ */
+cuckoo_t *cuckoo_create_with(cuckoo_opts_t opts);
+
+/**
+ * Creates a cuckoo filter that holds every key of a hashset, hashed with the
+ * hash function and seed of the hashset, with room for as many keys again.
+ *
+ * @param hashset - the hashset. [mut ref]
+ * @return a pointer to the created filter. [ownership]
+ */
+cuckoo_t *cuckoo_from_hashset(hashset_t *hashset);
+
+/**
+ * Inserts a key in the filter. A key may be inserted more than once (and must
+ * then be removed as many times).
+ *
+ * @param cuckoo - the filter. [mut ref]
+ * @param key - the key. [ref]
+ * @return true if the key was inserted, false if the filter is full.
+ */
+bool cuckoo_insert(cuckoo_t *cuckoo, char *key);
+
+/**
+ * Verifies if the filter may contain a key.
+ *
+ * @param cuckoo - the filter. [ref]
+ * @param key - the key. [ref]
+ * @return false if the key is not in the filter, true if it probably is.
+ */
+bool cuckoo_contains(cuckoo_t *cuckoo, char *key);
+
+/**
+ * Removes a key from the filter. Only keys that were inserted may be removed,
+ * removing any other key may remove a key that collides with it.
+ *
+ * @param cuckoo - the filter. [mut ref]
+ * @param key - the key. [ref]
+ * @return true if the key was removed, false if it was not in the filter.
+ */
+bool cuckoo_remove(cuckoo_t *cuckoo, char *key);
+
+// Same as cuckoo_insert, cuckoo_contains and cuckoo_remove, for a key that was
+// already hashed with the hash function and seed of the filter.
+bool cuckoo_insert_hash(cuckoo_t *cuckoo, uint64_t hash);
+bool cuckoo_contains_hash(cuckoo_t *cuckoo, uint64_t hash);
+bool cuckoo_remove_hash(cuckoo_t *cuckoo, uint64_t hash);
+
+/**
+ * Gets the number of keys in the filter.
+ *
+ * @param cuckoo - the filter. [ref]
+ * @return the number of keys.
+ */
+size_t cuckoo_get_size(cuckoo_t *cuckoo);
+
+/**
+ * Gets the memory used by the fingerprints of the filter.
+ *
+ * @param cuckoo - the filter. [ref]
+ * @return the number of bits.
+ */
+size_t cuckoo_get_bits(cuckoo_t *cuckoo);
+
+/**
+ * Deletes the filter.
+ *
+ * @param cuckoo - the filter. [ownership]
+ */
+void cuckoo_delete(cuckoo_t *cuckoo);
+
+#endif
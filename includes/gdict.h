@@ -0,0 +1,122 @@
+/**
+ * Generic Dict Module
+ *
+ * Module that implements a dictionary whose keys are of any fixed size type
+ * described by a generic (see generic.h), such as GEN_INT, GEN_DOUBLE or a
+ * GEN_STRUCT. Keys are passed by reference and copied into the table, so
+ * integer or struct keys need no formatting or allocation.
+ *
+ * Implementation details:
+ * Open addressing in the style of SwissTable (the same layout as DICT_OPEN)
+ * where every slot stores the value and the bytes of the key inline. The
+ * maximum load factor is 7/8 and the table shrinks when less than 1/8 of it is
+ * used. Keys of 4 or 8 bytes are hashed with a single multiply-mix of the word
+ * and compared as words; longer keys use HASH_DEFAULT and memcmp.
+ *
+ * Equality of keys:
+ * - GEN_FLOAT and GEN_DOUBLE keys are compared as numbers (0.0 == -0.0). NaN
+ *   keys can be inserted but are never found.
+ * - Every other key is compared by its bytes. Structs are laid out as
+ *   generic_sizeof describes them (fields packed, no padding). Pointer keys,
+ *   including GEN_STRING, are compared by address; use dict_t for strings.
+ */
+
+#ifndef __GDICT_H__
+#define __GDICT_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <generic.h>
+#include <dict.h>
+
+typedef struct _gdict gdict_t;
+
+/**
+ * Creates a generic dict.
+ *
+ * @param key_type - the type of the keys, of a non zero size. [ownership]
+ * @return a pointer to the created dict. [ownership]
+ */
+gdict_t *gdict_create(generic_t *key_type);
+
+/**
+ * Creates a generic dict with some starting table size.
+ *
+ * @param key_type - the type of the keys, of a non zero size. [ownership]
+ * @param size - the starting table size.
+ * @return a pointer to the created dict. [ownership]
+ */
+gdict_t *gdict_create_sized(generic_t *key_type, size_t size);
+
+/**
+ * Gets the number of entries in the dict.
+ *
+ * @param gdict - the dict. [ref]
+ * @return the number of entries.
+ */
+size_t gdict_get_size(gdict_t *gdict);
+
+/**
+ * Gets the number of slots of the dict table.
+ *
+ * @param gdict - the dict. [ref]
+ * @return the size of the table.
+ */
+size_t gdict_get_capacity(gdict_t *gdict);
+
+/**
+ * Verifies if the dict contains a key.
+ *
+ * @param gdict - the dict. [ref]
+ * @param key - a pointer to the key. [ref]
+ * @return true if the key is in the dict, false otherwise.
+ */
+bool gdict_contains(gdict_t *gdict, const void *key);
+
+/**
+ * Gets the value of a key.
+ *
+ * @param gdict - the dict. [ref]
+ * @param key - a pointer to the key. [ref]
+ * @return the value of the key or NULL if the key is not in the dict.
+ */
+dict_value_t gdict_get(gdict_t *gdict, const void *key);
+
+/**
+ * Inserts a key if it is not in the dict yet.
+ *
+ * @param gdict - the dict. [mut ref]
+ * @param key - a pointer to the key, the key is copied into the dict. [ref]
+ * @param value - the value.
+ * @return true if the key was inserted, false if it was already in the dict.
+ */
+bool gdict_insert(gdict_t *gdict, const void *key, dict_value_t value);
+
+/**
+ * Removes a key from the dict and returns its value.
+ *
+ * @param gdict - the dict. [mut ref]
+ * @param key - a pointer to the key. [ref]
+ * @return the value of the key or NULL if the key is not in the dict.
+ */
+dict_value_t gdict_remove_entry(gdict_t *gdict, const void *key);
+
+/**
+ * Removes a key from the dict and frees its value.
+ *
+ * @param gdict - the dict. [mut ref]
+ * @param key - a pointer to the key. [ref]
+ * @param free_fn - frees the value, may be NULL.
+ * @return true if the key was removed, false if it was not in the dict.
+ */
+bool gdict_remove(gdict_t *gdict, const void *key, free_fn_t free_fn);
+
+/**
+ * Deletes the dict and its key type.
+ *
+ * @param gdict - the dict. [ownership]
+ * @param free_fn - frees each value, may be NULL.
+ */
+void gdict_delete(gdict_t *gdict, free_fn_t free_fn);
+
+#endif
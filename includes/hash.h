@@ -0,0 +1,74 @@
+/**
+ * Hash Module
+ *
+ * Hash functions for byte strings, used by the hash tables of this project
+ * (dict, hashset, ...). Every function follows hash_fn_t and takes a seed: the
+ * tables use a random seed each, so keys that collide on one table (or one
+ * process) don't collide on another and collisions can't be crafted from the
+ * outside to degrade a table.
+ */
+
+#ifndef __HASH_H__
+#define __HASH_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+
+// A function that hashes `len` bytes of `data` with some `seed`.
+typedef uint64_t (*hash_fn_t)(const void *data, size_t len, uint64_t seed);
+
+// The hash function used by the tables when none is given.
+#define HASH_DEFAULT hash_wy
+
+/**
+ * Hash in the style of wyhash. Reads the input 8 bytes at a time (up to 48
+ * per iteration) and mixes it with 64 bit multiplications, folding the 128 bit
+ * product.
+ *
+ * @param data - the bytes to hash. [ref]
+ * @param len - the number of bytes.
+ * @param seed - the seed.
+ * @return the hash.
+ */
+uint64_t hash_wy(const void *data, size_t len, uint64_t seed);
+
+/**
+ * The sdbm hash, processes one byte per iteration. The seed is used as the
+ * starting value. Mostly kept for comparison.
+ * Source: http://www.cse.yorku.ca/~oz/hash.html
+ *
+ * @param data - the bytes to hash. [ref]
+ * @param len - the number of bytes.
+ * @param seed - the seed.
+ * @return the hash.
+ */
+uint64_t hash_sdbm(const void *data, size_t len, uint64_t seed);
+
+/**
+ * Spreads the entropy of a hash over all of its bits (Murmur3 finalizer).
+ * Tables that take bits from a particular part of the hash mix it first, so
+ * that weaker hash functions (such as sdbm) still work with them.
+ *
+ * @param h - the hash.
+ * @return the mixed hash.
+ */
+static inline uint64_t hash_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * Gets a random seed. A random value is read from the operating system once
+ * (falls back to the time if that fails) and every call mixes it with a
+ * counter, so seeds differ between calls and between processes. Never returns
+ * 0.
+ *
+ * @return the seed.
+ */
+uint64_t hash_random_seed();
+
+#endif
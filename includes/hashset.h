@@ -5,7 +5,13 @@
  *
  * Inplementation details:
  * The load factor is set to 0.75 by default and de starting table size is 16.
- * To resolve collisions, chaining is used.
+ * Table sizes are always powers of two. The table shrinks when less than 1/8 of
+ * it is used, but never below the starting size or the size set with
+ * hashset_reserve.
+ * To resolve collisions, chaining is used. Each entry caches the full hash and
+ * the length of its key, so chain walks only compare keys when those match.
+ * Keys are hashed with HASH_DEFAULT (see hash.h) unless another hash function
+ * is given, with a seed picked at random for each hashset.
  *
  * NOTE: This Hashset implementation only allows for string keys.
  */
@@ -15,10 +21,33 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <hash.h>
 
 typedef struct _hashset_entry hashset_entry_t;
 typedef struct _hashset hashset_t;
 
+// Options used to create a hashset. Fields left as 0 use the defaults.
+typedef struct {
+    size_t size; // The starting table size (16 by default).
+    // Instead of moving every entry at once when the table grows, the old and
+    // new tables coexist and each operation moves a few buckets, so no single
+    // insertion pays for the whole resize.
+    bool incremental;
+    hash_fn_t hash; // The hash function for the keys (HASH_DEFAULT by default).
+    uint64_t seed;  // The seed of the hash function (random by default).
+} hashset_opts_t;
+
+// Shorthand for a hashset_opts_t literal. Usage: HASHSET_OPTS(.incremental = true)
+#define HASHSET_OPTS(args...) ((hashset_opts_t){ args })
+
+/**
+ * Creates a hashset with the given options.
+ *
+ * @param opts - the options, see hashset_opts_t.
+ * @return a pointer to the created hashset. [ownership]
+ */
+hashset_t *hashset_create_with(hashset_opts_t opts);
+
 /**
  * Creates a hashset with some starting table size.
  *
@@ -42,6 +71,40 @@ hashset_t *hashset_create();
  */
 size_t hashset_get_size(hashset_t *hashset);
 
+/**
+ * Gets the number of buckets of the hashset table.
+ *
+ * @param hashset - the hashset. [ref]
+ * @return the size of the table.
+ */
+size_t hashset_get_capacity(hashset_t *hashset);
+
+/**
+ * Gets the hash function and seed that the hashset hashes its keys with, so
+ * that other structures (such as the filters of filter.h) can share them.
+ *
+ * @param hashset - the hashset. [ref]
+ * @param hash - receives the hash function. [mut ref]
+ * @param seed - receives the seed. [mut ref]
+ */
+void hashset_get_hash(hashset_t *hashset, hash_fn_t *hash, uint64_t *seed);
+
+/**
+ * Makes sure that the hashset can hold `n` keys without resizing. The table
+ * won't shrink automatically below this size until hashset_shrink_to_fit.
+ *
+ * @param hashset - the hashset. [mut ref]
+ * @param n - the number of keys.
+ */
+void hashset_reserve(hashset_t *hashset, size_t n);
+
+/**
+ * Shrinks the table to the smallest size that holds the current keys.
+ *
+ * @param hashset - the hashset. [mut ref]
+ */
+void hashset_shrink_to_fit(hashset_t *hashset);
+
 /**
  * Verifies if the hashset contains a certain key.
  *
@@ -51,11 +114,75 @@ size_t hashset_get_size(hashset_t *hashset);
  */
 bool hashset_contains(hashset_t *hashset, char *key);
 
+/**
+ * Verifies if the hashset contains each of many keys. Keys are hashed and
+ * resolved in batches, with prefetches issued for every key of a batch before
+ * any of them is compared, so the cache misses of independent lookups overlap.
+ *
+ * @param hashset - the hashset to search on. [ref]
+ * @param keys - the keys to search for. [ref]
+ * @param n - the number of keys.
+ * @param out - receives whether each key is contained. Must have room for `n`
+ *              values. [mut ref]
+ * @return the number of keys contained in the hashset.
+ */
+size_t hashset_contains_many(hashset_t *hashset, char **keys, size_t n, bool *out);
+
+// State of an iteration over a hashset, see hashset_iter. Its fields are private.
+typedef struct {
+    hashset_t *hashset;
+    size_t idx;
+    hashset_entry_t *entry;
+} hashset_iter_t;
+
+/**
+ * Starts an iteration over every key of a hashset, in no particular order. The
+ * iterator needs no allocation and no cleanup. Usage:
+ *
+ *     char *key;
+ *     for (hashset_iter_t it = hashset_iter(hashset); hashset_iter_next(&it, &key);)
+ *
+ * Any incremental rehash in progress is finished first, so lookups may be done
+ * while iterating, but the hashset must not be modified until the iteration ends.
+ *
+ * @param hashset - the hashset. [mut ref]
+ * @return the iterator, positioned before the first key.
+ */
+hashset_iter_t hashset_iter(hashset_t *hashset);
+
+/**
+ * Advances an iterator to the next key.
+ *
+ * @param it - the iterator. [mut ref]
+ * @param key - receives the key, owned by the hashset. [mut ref]
+ * @return true if there was a key, false once every key was visited.
+ */
+bool hashset_iter_next(hashset_iter_t *it, char **key);
+
+typedef void (*hashset_scan_fn_t)(char *key, void *ctx);
+
+/**
+ * Visits a chunk of the keys of a hashset, resuming from a cursor. The scan
+ * starts with cursor 0 and is over when the returned cursor is 0 again. The
+ * hashset may be modified between calls, with the same guarantees as dict_scan:
+ * keys that are in the hashset for the whole scan are visited at least once.
+ *
+ * @param hashset - the hashset. [ref]
+ * @param cursor - 0 to start a scan, or the value returned by the last call.
+ * @param count - the scan stops after the bucket in which this many keys were
+ *                visited.
+ * @param fn - called with each key visited. Must not use the hashset.
+ * @param ctx - passed to fn as is.
+ * @return the cursor to resume from, 0 if the scan is over.
+ */
+size_t hashset_scan(hashset_t *hashset, size_t cursor, size_t count,
+                    hashset_scan_fn_t fn, void *ctx);
+
 /**
  * Inserts a new key in the hashset if its not a duplicate.
  *
  * @param hashset - the hashset to insert on. [mut ref]
- * @param key - the key to insert. [ref]
+ * @param key - the key to insert, a copy of it is stored. [ref]
  * @return true if the insertion is successfull, false if its a duplicate.
  */
 bool hashset_insert(hashset_t *hashset, char *key);
@@ -0,0 +1,122 @@
+/**
+ * Inline Stack Module
+ *
+ * A stack of elements of any fixed size, copied into the stack (like queue_t of
+ * queue_bank.h), for the explicit stacks of iterative traversals and parsers.
+ *
+ * The stack struct is public so it can live in the stack frame of the function
+ * using it, and it has a small buffer of its own: as long as the elements fit
+ * there, nothing is allocated.
+ *
+ *     istack_t stack;
+ *     istack_init(&stack, sizeof(node_t *));
+ *     istack_push(&stack, &root);
+ *     while (istack_pop(&stack, &node)) { ... istack_push(&stack, &child); ... }
+ *     istack_destroy(&stack);
+ *
+ * Since data may point into the struct, an initialized stack must not be
+ * copied or moved, only used through pointers.
+ *
+ * Implementation details:
+ * Past the small buffer, elements move to the heap, whose capacity doubles when
+ * full. It is halved only when the stack is down to a quarter of it, so a stack
+ * going up and down around a size does not reallocate every time. Once the
+ * elements fit in the small buffer again they move back there and the heap
+ * buffer is freed.
+ */
+
+#ifndef __INLINE_STACK_H__
+#define __INLINE_STACK_H__
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define ISTACK_SMALL_BYTES 256
+
+typedef struct {
+    unsigned char *data; // small or a heap buffer.
+    size_t size;
+    size_t cap;
+    size_t elsize;
+    _Alignas(max_align_t) unsigned char small[ISTACK_SMALL_BYTES];
+} istack_t;
+
+/**
+ * Initializes a stack in place, without allocating.
+ *
+ * @param stack - the stack. [mut ref]
+ * @param elsize - the size of the elements.
+ */
+void istack_init(istack_t *stack, size_t elsize);
+
+/**
+ * Frees the memory of a stack initialized with istack_init.
+ * NOTE: Does not free the elements.
+ *
+ * @param stack - the stack. [mut ref]
+ */
+void istack_destroy(istack_t *stack);
+
+/**
+ * Creates a stack on the heap, for stacks that outlive a function.
+ *
+ * @param elsize - the size of the elements.
+ * @return a pointer to the created stack. [ownership]
+ */
+istack_t *istack_create(size_t elsize);
+
+/**
+ * Deletes a stack made by istack_create.
+ * NOTE: Does not free the elements.
+ *
+ * @param stack - the stack. [ownership]
+ */
+void istack_delete(istack_t *stack);
+
+/**
+ * Pushes an element on the top of the stack.
+ *
+ * @param stack - the stack. [mut ref]
+ * @param element - the element, copied into the stack. [ref]
+ */
+void istack_push(istack_t *stack, const void *element);
+
+/**
+ * Pops the element on the top of the stack.
+ *
+ * @param stack - the stack. [mut ref]
+ * @param element - where the element is copied, or NULL. [mut ref]
+ * @return true if an element was popped, false if the stack is empty.
+ */
+bool istack_pop(istack_t *stack, void *element);
+
+/**
+ * Gets the element on the top of the stack without removing it.
+ *
+ * @param stack - the stack. [ref]
+ * @return a pointer to the element, valid until the next push or pop, or NULL
+ *     if the stack is empty. [mut ref]
+ */
+void *istack_peek(istack_t *stack);
+
+/**
+ * Removes every element, keeping the memory.
+ *
+ * @param stack - the stack. [mut ref]
+ */
+void istack_clear(istack_t *stack);
+
+size_t istack_get_size(istack_t *stack);
+
+/**
+ * Gets the number of elements the stack holds before it reallocates.
+ *
+ * @param stack - the stack. [ref]
+ * @return the capacity.
+ */
+size_t istack_get_cap(istack_t *stack);
+
+bool istack_is_empty(istack_t *stack);
+
+#endif
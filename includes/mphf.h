@@ -0,0 +1,115 @@
+/**
+ * Minimal Perfect Hash Module
+ *
+ * A minimal perfect hash function (MPHF) maps each key of a fixed set of n
+ * distinct keys to its own index in [0, n). It is built once from the keys and
+ * does not store them: it takes about 3 bits per key, and keys outside of the
+ * set are mapped to some index as well. To test membership, keep the keys (or
+ * fingerprints of them) in an array ordered by index and compare with the one
+ * at the index of a lookup:
+ *
+ *     mphf_t *mphf = mphf_from_hashset(set);
+ *     for (each key of the set) by_index[mphf_index(mphf, key)] = key;
+ *     ...
+ *     bool found = strcmp(by_index[mphf_index(mphf, key)], key) == 0;
+ *
+ * Implementation details:
+ * The structure is PTHash. Keys are hashed and split in buckets of a few keys
+ * (log2(n) / c on average, see mphf_opts_t), with a skewed distribution so
+ * that 60% of the keys fall in 30% of the buckets. Buckets are placed from
+ * the largest to the smallest: for each one, pilot values 0, 1, 2... are tried
+ * until the positions hash(key) ^ hash(pilot) of all of its keys fall on free
+ * slots of a table slightly larger than n, and the pilot is stored. Positions
+ * past n are mapped back to the free slots below n by a small array.
+ * Pilots are packed with the bits of the largest one, so a lookup hashes the
+ * key, reads one pilot and computes the index, with a single memory access for
+ * 99% of the keys.
+ */
+
+#ifndef __MPHF_H__
+#define __MPHF_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <hashset.h>
+
+typedef struct _mphf mphf_t;
+
+// Options used to build a MPHF. Fields left as 0 use the defaults.
+typedef struct {
+    // Number of buckets per key, times log2(n) (4.5 by default). Fewer
+    // buckets make the function smaller and the build slower.
+    double c;
+    // Ratio of n to the size of the table keys are placed in (0.99 by
+    // default). Lower values make the build faster and mapping back the
+    // positions past n more frequent.
+    double alpha;
+    uint64_t seed; // The seed of the first build attempt (random by default).
+} mphf_opts_t;
+
+// Shorthand for a mphf_opts_t literal. Usage: MPHF_OPTS(.c = 6)
+#define MPHF_OPTS(args...) ((mphf_opts_t){ args })
+
+/**
+ * Builds a MPHF of distinct keys with the given options.
+ *
+ * @param keys - the keys. [ref]
+ * @param n - the number of keys.
+ * @param opts - the options, see mphf_opts_t.
+ * @return a pointer to the MPHF, NULL if some key is repeated. [ownership]
+ */
+mphf_t *mphf_build_with(char **keys, size_t n, mphf_opts_t opts);
+
+/**
+ * Builds a MPHF of distinct keys with the default options.
+ *
+ * @param keys - the keys. [ref]
+ * @param n - the number of keys.
+ * @return a pointer to the MPHF, NULL if some key is repeated. [ownership]
+ */
+mphf_t *mphf_build(char **keys, size_t n);
+
+/**
+ * Builds a MPHF of the keys of a hashset with the default options.
+ *
+ * @param hashset - the hashset. [mut ref]
+ * @return a pointer to the MPHF. [ownership]
+ */
+mphf_t *mphf_from_hashset(hashset_t *hashset);
+
+/**
+ * Gets the index of a key. Every key the function was built with has its own
+ * index, other keys get the index of any of them.
+ *
+ * @param mphf - the MPHF. [ref]
+ * @param key - the key. [ref]
+ * @return the index of the key, in [0, n).
+ */
+size_t mphf_index(mphf_t *mphf, char *key);
+
+/**
+ * Gets the number of keys the function was built with.
+ *
+ * @param mphf - the MPHF. [ref]
+ * @return the number of keys.
+ */
+size_t mphf_get_size(mphf_t *mphf);
+
+/**
+ * Gets the memory used by the pilots and the array that maps positions back
+ * below n.
+ *
+ * @param mphf - the MPHF. [ref]
+ * @return the number of bits.
+ */
+size_t mphf_get_bits(mphf_t *mphf);
+
+/**
+ * Deletes the MPHF.
+ *
+ * @param mphf - the MPHF. [ownership]
+ */
+void mphf_delete(mphf_t *mphf);
+
+#endif
@@ -0,0 +1,102 @@
+/**
+ * Thread Pool Module
+ *
+ * A pool of worker threads for fork-join parallelism, as in parallel divide
+ * and conquer: a task forks the work on one half, does the other half itself,
+ * then joins the forked half.
+ *
+ *     void sort(void *arg) {
+ *         range_t *range = (range_t *)arg;
+ *         if (range->n < CUTOFF) return sort_sequentially(range);
+ *         range_t left = ..., right = ...;
+ *         pool_task_t task = POOL_TASK(sort, &left);
+ *         pool_fork(&task);
+ *         sort(&right);
+ *         pool_join(&task);
+ *         merge(range);
+ *     }
+ *
+ *     pool_run(pool, sort, &range);
+ *
+ * Tasks live in the stack frame that forks them: pool_join returns only after
+ * the task has run, so no task is allocated.
+ *
+ * Implementation details:
+ * Each worker has a work stealing deque (see wsdeque.h) where its forked tasks
+ * are pushed. A worker pops its own tasks, newest first, and when it has none
+ * it steals the oldest task of another worker, which in divide and conquer is
+ * the largest piece left. A join whose task was not stolen pops and runs it
+ * right away. If it was stolen, the worker steals and runs other tasks while
+ * waiting for it, so it never sits idle and the stack of waiting joins stays
+ * short.
+ * Tasks from threads outside of the pool (pool_run) go to a shared queue that
+ * idle workers check. Workers with nothing to do sleep on a condition
+ * variable, and forks wake one only when some worker is asleep.
+ */
+
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+typedef struct _pool pool_t;
+
+typedef void (*pool_fn_t)(void *arg);
+
+typedef struct {
+    pool_fn_t fn;
+    void *arg;
+    // Internal.
+    int done;
+    bool external;
+} pool_task_t;
+
+#define POOL_TASK(f, a) ((pool_task_t){ .fn = (f), .arg = (a) })
+
+/**
+ * Creates a thread pool.
+ *
+ * @param threads - the number of worker threads, 0 for one per online CPU.
+ * @return a pointer to the created pool. [ownership]
+ */
+pool_t *pool_create(size_t threads);
+
+/**
+ * Runs fn(arg) on a worker of the pool and waits for it (and so for all the
+ * tasks it forks) to finish. May be called by many threads at once. Called by
+ * a worker of the pool, it just calls fn(arg).
+ *
+ * @param pool - the pool. [mut ref]
+ * @param fn - the function to run.
+ * @param arg - its argument.
+ */
+void pool_run(pool_t *pool, pool_fn_t fn, void *arg);
+
+/**
+ * Forks a task: it may run on another worker while this one goes on. Every
+ * forked task must be joined before the function that forked it returns.
+ * Called outside of a pool, the task runs right away.
+ *
+ * @param task - the task, from POOL_TASK. [mut ref]
+ */
+void pool_fork(pool_task_t *task);
+
+/**
+ * Waits for a forked task to finish, running other tasks meanwhile.
+ *
+ * @param task - the task. [mut ref]
+ */
+void pool_join(pool_task_t *task);
+
+size_t pool_get_threads(pool_t *pool);
+
+/**
+ * Deletes the pool, after its workers finish the tasks they are running. No
+ * thread may be waiting in pool_run.
+ *
+ * @param pool - the pool. [ownership]
+ */
+void pool_delete(pool_t *pool);
+
+#endif
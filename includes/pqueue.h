@@ -0,0 +1,135 @@
+/**
+ * Priority Queue Module
+ *
+ * A priority queue of elements of any type, compared with a comp_t like the
+ * sorting functions (see sorting.h). Pop gives the smallest element, the one a
+ * sort would put first.
+ *
+ * Elements are copied into the queue. Every push gives a handle that follows
+ * the element while it moves inside the queue, so it can later be read,
+ * changed (like the decrease key of Dijkstra's algorithm or the new deadline
+ * of a timer) or removed. A handle is valid until its element is popped or
+ * removed, after which it may be given to another element.
+ *
+ * Implementation details:
+ * The elements are in a 4-ary heap stored in an array: the children of slot i
+ * are slots 4i + 1 to 4i + 4. Compared to a binary heap it is half as deep and
+ * the 4 children of a slot are next to each other in memory, so a pop makes
+ * more comparisons but touches fewer cache lines. An element moving up or down
+ * is kept aside while the others shift into its place, so it is copied once.
+ * Each slot has the handle of its element and each handle the slot of its
+ * element; free handles are linked through the same array.
+ * Building from an array uses the bottom up heapify of Floyd, in O(n).
+ */
+
+#ifndef __PQUEUE_H__
+#define __PQUEUE_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <sorting.h>
+
+typedef struct _pqueue pqueue_t;
+
+typedef size_t pqueue_handle_t;
+
+/**
+ * Creates an empty priority queue.
+ *
+ * @param elsize - the size of the elements.
+ * @param comp - the function that compares two elements.
+ * @return a pointer to the created queue. [ownership]
+ */
+pqueue_t *pqueue_create(size_t elsize, comp_t comp);
+
+/**
+ * Creates a priority queue from the elements of an array, in O(n). The handle
+ * of the element at index i of the array is i.
+ *
+ * @param elements - the elements, copied into the queue. [ref]
+ * @param n - the number of elements.
+ * @param elsize - the size of the elements.
+ * @param comp - the function that compares two elements.
+ * @return a pointer to the created queue. [ownership]
+ */
+pqueue_t *pqueue_from_array(const void *elements, size_t n, size_t elsize, comp_t comp);
+
+/**
+ * Pushes an element.
+ *
+ * @param queue - the queue. [mut ref]
+ * @param element - the element, copied into the queue. [ref]
+ * @return the handle of the element.
+ */
+pqueue_handle_t pqueue_push(pqueue_t *queue, const void *element);
+
+/**
+ * Pops the smallest element.
+ *
+ * @param queue - the queue. [mut ref]
+ * @param element - where the element is copied, or NULL. [mut ref]
+ * @return true if an element was popped, false if the queue is empty.
+ */
+bool pqueue_pop(pqueue_t *queue, void *element);
+
+/**
+ * Gets the smallest element without removing it.
+ *
+ * @param queue - the queue. [ref]
+ * @return a pointer to the element, valid until the queue changes, or NULL if
+ *     the queue is empty. It must not be changed. [ref]
+ */
+void *pqueue_peek(pqueue_t *queue);
+
+/**
+ * Gets the element of a handle.
+ *
+ * @param queue - the queue. [ref]
+ * @param handle - the handle of an element in the queue.
+ * @return a pointer to the element, valid until the queue changes. It must not
+ *     be changed, use pqueue_update. [ref]
+ */
+void *pqueue_get(pqueue_t *queue, pqueue_handle_t handle);
+
+/**
+ * Replaces the element of a handle, moving it up or down the queue as needed.
+ * The handle stays the same.
+ *
+ * @param queue - the queue. [mut ref]
+ * @param handle - the handle of an element in the queue.
+ * @param element - the new element, copied into the queue. [ref]
+ */
+void pqueue_update(pqueue_t *queue, pqueue_handle_t handle, const void *element);
+
+/**
+ * Removes the element of a handle.
+ *
+ * @param queue - the queue. [mut ref]
+ * @param handle - the handle of an element in the queue.
+ * @param element - where the element is copied, or NULL. [mut ref]
+ */
+void pqueue_remove(pqueue_t *queue, pqueue_handle_t handle, void *element);
+
+/**
+ * Checks if a handle belongs to an element in the queue. A handle that was
+ * given again to a new element belongs to it.
+ *
+ * @param queue - the queue. [ref]
+ * @param handle - the handle.
+ * @return true if the handle belongs to an element in the queue.
+ */
+bool pqueue_contains(pqueue_t *queue, pqueue_handle_t handle);
+
+size_t pqueue_get_size(pqueue_t *queue);
+
+bool pqueue_is_empty(pqueue_t *queue);
+
+/**
+ * Deletes the queue.
+ * NOTE: Does not free the elements.
+ *
+ * @param queue - the queue. [ownership]
+ */
+void pqueue_delete(pqueue_t *queue);
+
+#endif
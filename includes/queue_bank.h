@@ -8,7 +8,18 @@
  *       structure. When the element is retreived with queue_pop, a pointer to
  *       the element is returned. This pointer can not be freed directly because
  *       it points to part of the queue structure. However if the element has
- *       some internal fields, those may be freed.
+ *       some internal fields, those may be freed. The element stays there
+ *       until the next push or pop.
+ *       Elements never move while they are in the queue, so pointers given
+ *       by queue_peak and queue_reserve stay valid until they are popped.
+ *
+ * Implementation details:
+ * Elements are stored in a list of segments of contiguous slots, pushed at the
+ * end of the last one and popped from the start of the first one. Segments
+ * double in size as the queue grows, up to 64 KiB, so the queue grows by
+ * adding a segment instead of moving its elements. The last segment that was
+ * emptied is kept for the next one needed, so a queue whose size stays about
+ * the same does not allocate.
  */
 
 #ifndef __QUEUE_BANK_H__
@@ -31,7 +42,8 @@ queue_t *queue_create(size_t elsize);
  * Creates a new queue with a starting capacity.
  *
  * @param elsize - the size of the elements that will be stored in the queue.
- * @param cap - the starting capacity (cap * elsize bytes qwill be allocated).
+ * @param cap - the starting capacity (cap * elsize bytes will be allocated by
+ *     the first push).
  * @return the newly created queue struct. [ownership]
  */
 queue_t *queue_create_with_cap(size_t elsize, size_t cap);
@@ -44,21 +56,53 @@ queue_t *queue_create_with_cap(size_t elsize, size_t cap);
  */
 void queue_push(queue_t *queue, void *element);
 
+/**
+ * Pushes n elements into the top of the queue, in order.
+ *
+ * @param queue - the queue to push the elements into. [mut ref]
+ * @param elements - the elements to push, contiguous. [ref]
+ * @param n - the number of elements.
+ */
+void queue_push_n(queue_t *queue, void *elements, size_t n);
+
+/**
+ * Pushes n elements into the top of the queue without writing them, and gives
+ * their contiguous slots to be written in place (for instance by reading or
+ * deserializing straight into them). The elements count as pushed right away
+ * and must be written before they are popped.
+ *
+ * @param queue - the queue to push the elements into. [mut ref]
+ * @param n - the number of elements.
+ * @return a pointer to the first of the n slots. [mut ref]
+ */
+void *queue_reserve(queue_t *queue, size_t n);
+
 /**
  * Pops a value from the bottom of the queue.
  * NOTE: The pointer that is returned can not be freed. However, the structure
  *       that it points to can and must be freed after pop.
  *
  * @param queue - the queue to pop from. [mut ref]
- * @return a pointer to the element popped. [mut ref]
+ * @return a pointer to the element popped, or NULL if the queue is empty.
+ *     [mut ref]
  */
 void *queue_pop(queue_t *queue);
 
+/**
+ * Pops up to n values from the bottom of the queue, copying them out.
+ *
+ * @param queue - the queue to pop from. [mut ref]
+ * @param elements - where the elements are copied, room for n. [mut ref]
+ * @param n - the maximum number of elements.
+ * @return the number of elements popped.
+ */
+size_t queue_pop_n(queue_t *queue, void *elements, size_t n);
+
 /**
  * Returns the value at the bottom of the queue but does not remove it.
  *
  * @param queue - the queue to peak in. [ref]
- * @return a pointer to the element popped. [mut ref]
+ * @return a pointer to the element, or NULL if the queue is empty. [mut ref]
  */
 void *queue_peak(queue_t *queue);
 
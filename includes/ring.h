@@ -0,0 +1,182 @@
+/**
+ * Ring Buffer Module
+ *
+ * Bounded lock-free queues to pass elements between threads. Like queue_t (see
+ * queue_bank.h), elements have a fixed size and are copied into the ring, so
+ * no allocation happens after the ring is created. Since the slot of an
+ * element is reused as soon as it is popped, pop copies the element out
+ * instead of returning a pointer to it.
+ *
+ * Two rings are available:
+ * spsc_t: one producer thread and one consumer thread.
+ * mpmc_t: any number of producer and consumer threads.
+ *
+ * A push on a full ring and a pop on an empty ring fail right away instead of
+ * waiting, so the caller decides whether to spin, yield or do other work.
+ *
+ * Implementation details:
+ * Both rings have a power of two number of slots and use positions that only
+ * grow, the slot of a position being position & (cap - 1).
+ * spsc_t keeps the write position (head) and read position (tail) on cache
+ * lines of their own. Each side also keeps a copy of the position of the other
+ * side and only reads the shared one when its copy says the ring is full (or
+ * empty), so in a steady stream the cache line of the other side is rarely
+ * touched.
+ * mpmc_t is the queue of Dmitry Vyukov: each slot has a sequence number that
+ * tells whether it is free for the position of a producer or filled for the
+ * position of a consumer. Producers (and consumers) claim positions with a
+ * compare and swap on a shared counter, then copy their element and publish it
+ * through the sequence number of its slot.
+ * Batch operations claim and publish many positions at once, so the shared
+ * counters are updated once per batch.
+ */
+
+#ifndef __RING_H__
+#define __RING_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+typedef struct _spsc spsc_t;
+typedef struct _mpmc mpmc_t;
+
+/* Single producer single consumer ring */
+
+/**
+ * Creates a single producer single consumer ring.
+ *
+ * @param elsize - the size of the elements.
+ * @param cap - the number of elements the ring holds, rounded up to a power of
+ *     two.
+ * @return a pointer to the created ring. [ownership]
+ */
+spsc_t *spsc_create(size_t elsize, size_t cap);
+
+/**
+ * Pushes an element. Only one thread at a time may push.
+ *
+ * @param ring - the ring. [mut ref]
+ * @param element - the element, copied in the ring. [ref]
+ * @return true if it was pushed, false if the ring is full.
+ */
+bool spsc_push(spsc_t *ring, const void *element);
+
+/**
+ * Pops the oldest element. Only one thread at a time may pop.
+ *
+ * @param ring - the ring. [mut ref]
+ * @param element - where the element is copied. [mut ref]
+ * @return true if an element was popped, false if the ring is empty.
+ */
+bool spsc_pop(spsc_t *ring, void *element);
+
+/**
+ * Pushes as many as possible of n elements, in order.
+ *
+ * @param ring - the ring. [mut ref]
+ * @param elements - the elements, contiguous. [ref]
+ * @param n - the number of elements.
+ * @return the number of elements pushed.
+ */
+size_t spsc_push_n(spsc_t *ring, const void *elements, size_t n);
+
+/**
+ * Pops up to n elements, oldest first.
+ *
+ * @param ring - the ring. [mut ref]
+ * @param elements - where the elements are copied, room for n. [mut ref]
+ * @param n - the maximum number of elements.
+ * @return the number of elements popped.
+ */
+size_t spsc_pop_n(spsc_t *ring, void *elements, size_t n);
+
+/**
+ * Gets the number of elements in the ring. With other threads pushing or
+ * popping it may already be out of date when it returns.
+ *
+ * @param ring - the ring. [ref]
+ * @return the number of elements.
+ */
+size_t spsc_get_size(spsc_t *ring);
+
+size_t spsc_get_cap(spsc_t *ring);
+
+/**
+ * Deletes the ring. No other thread may be using it.
+ *
+ * @param ring - the ring. [ownership]
+ */
+void spsc_delete(spsc_t *ring);
+
+/* Multiple producers multiple consumers ring */
+
+/**
+ * Creates a multiple producers multiple consumers ring.
+ *
+ * @param elsize - the size of the elements.
+ * @param cap - the number of elements the ring holds, rounded up to a power of
+ *     two (at least 2).
+ * @return a pointer to the created ring. [ownership]
+ */
+mpmc_t *mpmc_create(size_t elsize, size_t cap);
+
+/**
+ * Pushes an element.
+ *
+ * @param ring - the ring. [mut ref]
+ * @param element - the element, copied in the ring. [ref]
+ * @return true if it was pushed, false if the ring is full.
+ */
+bool mpmc_push(mpmc_t *ring, const void *element);
+
+/**
+ * Pops the oldest element.
+ *
+ * @param ring - the ring. [mut ref]
+ * @param element - where the element is copied. [mut ref]
+ * @return true if an element was popped, false if the ring is empty.
+ */
+bool mpmc_pop(mpmc_t *ring, void *element);
+
+/**
+ * Pushes as many as possible of n elements. They take consecutive positions,
+ * so they are popped in order and with no element of other producers between
+ * them.
+ *
+ * @param ring - the ring. [mut ref]
+ * @param elements - the elements, contiguous. [ref]
+ * @param n - the number of elements.
+ * @return the number of elements pushed.
+ */
+size_t mpmc_push_n(mpmc_t *ring, const void *elements, size_t n);
+
+/**
+ * Pops up to n consecutive elements, oldest first.
+ *
+ * @param ring - the ring. [mut ref]
+ * @param elements - where the elements are copied, room for n. [mut ref]
+ * @param n - the maximum number of elements.
+ * @return the number of elements popped.
+ */
+size_t mpmc_pop_n(mpmc_t *ring, void *elements, size_t n);
+
+/**
+ * Gets the number of elements in the ring, counting those being pushed or
+ * popped. With other threads using the ring it may already be out of date when
+ * it returns.
+ *
+ * @param ring - the ring. [ref]
+ * @return the number of elements.
+ */
+size_t mpmc_get_size(mpmc_t *ring);
+
+size_t mpmc_get_cap(mpmc_t *ring);
+
+/**
+ * Deletes the ring. No other thread may be using it.
+ *
+ * @param ring - the ring. [ownership]
+ */
+void mpmc_delete(mpmc_t *ring);
+
+#endif
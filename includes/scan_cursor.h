@@ -0,0 +1,35 @@
+/**
+ * Scan cursors
+ *
+ * The cursor arithmetic shared by dict_scan and hashset_scan. This is not part
+ * of the public interface of either module and should only be included by
+ * their sources.
+ */
+
+#ifndef __SCAN_CURSOR_H__
+#define __SCAN_CURSOR_H__
+
+#include <stdlib.h>
+
+// Reverses the bits of a cursor, so it can be incremented from the top bit.
+static inline size_t cursor_rev(size_t v) {
+    size_t s = sizeof(v) * 8, mask = ~(size_t)0;
+    while ((s >>= 1) > 0) {
+        mask ^= mask << s;
+        v = ((v >> s) & mask) | ((v << s) & ~mask);
+    }
+    return v;
+}
+
+// Moves a scan cursor to the next bucket of a table with `mask + 1` buckets in
+// reverse binary order: the high bits of the bucket index are incremented
+// first, so the buckets that one bucket splits into (or merges with) when the
+// table doubles (or halves) are visited next to each other.
+static inline size_t cursor_next(size_t cursor, size_t mask) {
+    cursor |= ~mask;
+    cursor = cursor_rev(cursor);
+    cursor++;
+    return cursor_rev(cursor);
+}
+
+#endif
@@ -29,8 +29,12 @@ void radix256_sort_with(void *vec,         // Vetor a ser ordenado.
                         void *arg          // Argumento adicional a função get_key.
                         );
 
-// Função que ordena um vetor de valores arbitrários usando quick sort com primeiro
-// elemento de pivot.
+// Função que ordena um vetor de valores arbitrários usando pattern-defeating
+// quick sort: pivot pela mediana de três (ou de nove em vetores grandes),
+// partição que agrupa elementos repetidos, insertion sort em trechos pequenos e
+// heap sort caso as partições fiquem desbalanceadas demais. O(n log n) no pior
+// caso e linear em vetores já ordenados ou com poucos valores distintos. Não é
+// estável.
 void quick_sort_with(void *vec,     // Vetor a ser ordenado.
                      size_t nmemb,  // Número de elementos (membros) do vetor.
                      size_t elsize, // Tamanho de cada elemento (em bytes).
@@ -43,12 +47,23 @@ void heap_sort_with(void *vec,
                     comp_t comp
                     );
 
+// Merge sort estável. Aloca uma única vez um buffer de nmemb / 2 elementos.
 void merge_sort_with(void *vec,
                      size_t nmemb,
                      size_t elsize,
                      comp_t comp
                      );
 
+// Como merge_sort_with, mas usando o buffer dado, que deve ter espaço para pelo
+// menos nmemb / 2 elementos. Não aloca memória, então o mesmo buffer pode ser
+// reutilizado por quem ordena vetores repetidamente.
+void merge_sort_with_buffer(void *vec,
+                            size_t nmemb,
+                            size_t elsize,
+                            comp_t comp,
+                            void *buffer
+                            );
+
 void insertion_sort_with(void *vec,
                          size_t nmemb,
                          size_t elsize,
@@ -61,12 +76,22 @@ void binary_insertion_sort_with(void *vec,
                                 comp_t comp
                                 );
 
+// Tim sort estável. Aloca uma única vez um buffer de nmemb / 2 elementos.
 void tim_sort_with(void *vec,
                    size_t nmemb,
                    size_t elsize,
                    comp_t comp
                    );
 
+// Como tim_sort_with, mas usando o buffer dado, que deve ter espaço para pelo
+// menos nmemb / 2 elementos.
+void tim_sort_with_buffer(void *vec,
+                          size_t nmemb,
+                          size_t elsize,
+                          comp_t comp,
+                          void *buffer
+                          );
+
 void *lower_bound(void *search,
                   void *vec,
                   size_t nmemb,
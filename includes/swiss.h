@@ -0,0 +1,140 @@
+/**
+ * SwissTable groups
+ *
+ * Control byte primitives and sizing rules shared by the open addressing tables
+ * in the style of SwissTable (src/dict_open.c, src/gdict.c). This is not part
+ * of the public interface of any module and should only be included by their
+ * sources. src/dict_ordered.c also uses mix() to spread its hashes and shrinks
+ * by the same rule.
+ *
+ * For every slot there is a control byte that is either CTRL_EMPTY,
+ * CTRL_DELETED or, for full slots, the 7 low bits of the hash (H2). The rest of
+ * the hash (H1) selects the first group to probe. A group is 16 consecutive
+ * control bytes that are compared at once (with SSE2 when available).
+ */
+
+#ifndef __SWISS_H__
+#define __SWISS_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <hash.h>
+
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
+
+#define GROUP_SZ 16
+
+#define CTRL_EMPTY   ((int8_t)-128) // 0b10000000
+#define CTRL_DELETED ((int8_t)-2)   // 0b11111110
+
+#define is_full(ctrl) ((ctrl) >= 0)
+
+#define H1(hash) ((hash) >> 7)
+#define H2(hash) ((int8_t)((hash) & 0x7f))
+
+// Maximum number of full or deleted slots for a certain capacity (7/8).
+#define max_growth(cap) ((cap) - (cap) / 8)
+
+// Bit i is set if slot i of the group matches.
+typedef uint32_t bitmask_t;
+
+// Spreads the entropy of a hash over all of its bits, see hash_mix.
+static inline uint64_t mix(uint64_t h) { return hash_mix(h); }
+
+static inline bitmask_t group_match(const int8_t *group, int8_t h2) {
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (bitmask_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+#else
+    bitmask_t mask = 0;
+    for (int i = 0; i < GROUP_SZ; i++)
+        if (group[i] == h2) mask |= 1U << i;
+    return mask;
+#endif
+}
+
+static inline bitmask_t group_match_empty(const int8_t *group) {
+    return group_match(group, CTRL_EMPTY);
+}
+
+// Both CTRL_EMPTY and CTRL_DELETED are smaller than -1 and full slots are not.
+static inline bitmask_t group_match_empty_or_deleted(const int8_t *group) {
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (bitmask_t)_mm_movemask_epi8(_mm_cmplt_epi8(ctrl, _mm_set1_epi8(-1)));
+#else
+    bitmask_t mask = 0;
+    for (int i = 0; i < GROUP_SZ; i++)
+        if (group[i] < -1) mask |= 1U << i;
+    return mask;
+#endif
+}
+
+// Finds the first slot of a table of `cap` slots that can receive an entry
+// with a certain (mixed) hash. Groups are probed in triangular order.
+static inline size_t find_insert_slot(const int8_t *ctrl, size_t cap, uint64_t hash) {
+    size_t mask = cap / GROUP_SZ - 1;
+    size_t group = H1(hash) & mask;
+
+    for (size_t step = 1;; step++) {
+        size_t base = group * GROUP_SZ;
+        bitmask_t avail = group_match_empty_or_deleted(ctrl + base);
+        if (avail) return base + __builtin_ctz(avail);
+
+        group = (group + step) & mask;
+    }
+}
+
+/* Table sizing, shared so the tables grow, shrink and erase the same way. */
+
+// Smallest capacity of at least n slots: a power of two, at least one group.
+static inline size_t swiss_min_capacity(size_t n) {
+    size_t cap = GROUP_SZ;
+    while (cap < n) cap <<= 1;
+    return cap;
+}
+
+// Smallest capacity that holds `n` entries within the maximum load.
+static inline size_t swiss_capacity_for(size_t n) {
+    size_t cap = GROUP_SZ;
+    while (n > max_growth(cap)) cap <<= 1;
+    return cap;
+}
+
+// The capacity to rehash to when a table of `size` entries has no room left
+// for an insertion. If most of the used slots are tombstones the table is
+// rehashed in place (same capacity), otherwise it doubles.
+static inline size_t swiss_grow_capacity(size_t size, size_t cap) {
+    return size + 1 <= max_growth(cap) / 2 ? cap : cap * 2;
+}
+
+// The capacity to rehash to after a removal, `cap` if the table stays as is.
+// A table shrinks once less than 1/8 of it is used, leaving room for twice as
+// many entries to avoid resizing back and forth, but never below min_cap.
+// capacity_for gives the capacity that holds a number of entries, as
+// swiss_capacity_for does for these tables.
+static inline size_t swiss_shrink_capacity(size_t size, size_t cap, size_t min_cap,
+                                           size_t (*capacity_for)(size_t)) {
+    if (cap <= min_cap || size >= cap / 8) return cap;
+
+    size_t new_cap = capacity_for(size * 2);
+    return new_cap < min_cap ? min_cap : new_cap;
+}
+
+// Marks the full slot idx as free. If its group still has an empty slot, it
+// was never full, so no probe sequence went past it and the slot can be empty
+// again; otherwise it becomes a tombstone. Returns true if it became empty,
+// giving back room for an insertion.
+static inline bool swiss_erase(int8_t *ctrl, size_t idx) {
+    if (group_match_empty(ctrl + idx / GROUP_SZ * GROUP_SZ)) {
+        ctrl[idx] = CTRL_EMPTY;
+        return true;
+    }
+    ctrl[idx] = CTRL_DELETED;
+    return false;
+}
+
+#endif
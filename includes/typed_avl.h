@@ -0,0 +1,245 @@
+/**
+ * Typed AVL Module
+ *
+ * Generates an AVL tree for one element type, to use instead of avl_t (see
+ * avl.h) where the comparisons matter. avl_t calls its comp_fn_t through a
+ * pointer and copies elsize bytes with memcpy, so nothing can be inlined. Here
+ * the elements are values of the type, stored in the nodes, and the comparison
+ * is a function or macro the compiler sees, so it is inlined with the copies.
+ *
+ *     #define int_cmp(a, b) TYPED_CMP(a, b)
+ *     DEFINE_AVL(int_avl, int, int_cmp)
+ *
+ *     int_avl_t *avl = int_avl_create();
+ *     int_avl_insert(avl, 42);
+ *     int *found = int_avl_search(avl, 42);
+ *     int_avl_delete(avl);
+ *
+ * DEFINE_AVL(name, type, cmp) defines the types name_t and name_node_t and the
+ * functions below, all static inline so each file using the tree gets its own
+ * copy. cmp(a, b) takes two values of the type and returns < 0, 0 or > 0 like
+ * a comp_fn_t. For a type stored by pointer, such as a pointer to a record,
+ * cmp compares what they point to. cmp may be a macro that evaluates its
+ * arguments more than once.
+ *
+ * name_t *name_create(void);
+ * void name_init(name_t *tree);           Initializes a tree struct in place.
+ * void name_delete(name_t *tree);         Frees the nodes and the tree.
+ * void name_clear(name_t *tree);          Frees the nodes.
+ * type *name_search(name_t *tree, type value);
+ * bool name_insert(name_t *tree, type value);  false if it was already there.
+ * bool name_remove(name_t *tree, type value, type *removed);  removed may be NULL.
+ * type *name_min(name_t *tree);
+ * type *name_max(name_t *tree);
+ * size_t name_get_size(name_t *tree);
+ * void name_inorder_foreach(name_t *tree, void (*fn)(type *, void *), void *args);
+ *
+ * The trees behave like avl_t, removal taking the largest element of the left
+ * subtree in place of the removed one.
+ */
+
+#ifndef __TYPED_AVL_H__
+#define __TYPED_AVL_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+// Three way comparison of numbers or pointers, to use as cmp.
+#ifndef TYPED_CMP
+#define TYPED_CMP(a, b) (((a) > (b)) - ((a) < (b)))
+#endif
+
+#define DEFINE_AVL(name, type, cmp) \
+    typedef struct name##_node { \
+        struct name##_node *left; \
+        struct name##_node *right; \
+        int height; \
+        type value; \
+    } name##_node_t; \
+    \
+    typedef struct { \
+        name##_node_t *root; \
+        size_t size; \
+    } name##_t; \
+    \
+    static inline void name##_init(name##_t *tree) { \
+        tree->root = NULL; \
+        tree->size = 0; \
+    } \
+    \
+    static inline name##_t *name##_create(void) { \
+        name##_t *tree = (name##_t *)malloc(sizeof(name##_t)); \
+        name##_init(tree); \
+        return tree; \
+    } \
+    \
+    static inline void name##__free_nodes(name##_node_t *node) { \
+        while (node) { \
+            name##__free_nodes(node->left); \
+            name##_node_t *right = node->right; \
+            free(node); \
+            node = right; \
+        } \
+    } \
+    \
+    static inline void name##_clear(name##_t *tree) { \
+        name##__free_nodes(tree->root); \
+        name##_init(tree); \
+    } \
+    \
+    static inline void name##_delete(name##_t *tree) { \
+        if (!tree) return; \
+        name##__free_nodes(tree->root); \
+        free(tree); \
+    } \
+    \
+    static inline type *name##_search(name##_t *tree, type value) { \
+        name##_node_t *node = tree->root; \
+        while (node) { \
+            int c = cmp(value, node->value); \
+            if (c == 0) return &node->value; \
+            node = c < 0 ? node->left : node->right; \
+        } \
+        return NULL; \
+    } \
+    \
+    static inline int name##__height(name##_node_t *node) { \
+        return node ? node->height : 0; \
+    } \
+    \
+    static inline void name##__update(name##_node_t *node) { \
+        int l = name##__height(node->left), r = name##__height(node->right); \
+        node->height = (l > r ? l : r) + 1; \
+    } \
+    \
+    static inline name##_node_t *name##__rotate_left(name##_node_t *node) { \
+        name##_node_t *root = node->right; \
+        node->right = root->left; \
+        root->left = node; \
+        name##__update(node); \
+        name##__update(root); \
+        return root; \
+    } \
+    \
+    static inline name##_node_t *name##__rotate_right(name##_node_t *node) { \
+        name##_node_t *root = node->left; \
+        node->left = root->right; \
+        root->right = node; \
+        name##__update(node); \
+        name##__update(root); \
+        return root; \
+    } \
+    \
+    static inline name##_node_t *name##__balance(name##_node_t *node) { \
+        if (!node) return NULL; \
+        int bal = name##__height(node->left) - name##__height(node->right); \
+        if (bal < -1) { \
+            name##_node_t *r = node->right; \
+            if (name##__height(r->left) > name##__height(r->right)) \
+                node->right = name##__rotate_right(r); \
+            return name##__rotate_left(node); \
+        } \
+        if (bal > 1) { \
+            name##_node_t *l = node->left; \
+            if (name##__height(l->left) < name##__height(l->right)) \
+                node->left = name##__rotate_left(l); \
+            return name##__rotate_right(node); \
+        } \
+        name##__update(node); \
+        return node; \
+    } \
+    \
+    static inline name##_node_t *name##__insert(name##_node_t *node, type value, bool *inserted) { \
+        if (!node) { \
+            node = (name##_node_t *)malloc(sizeof(name##_node_t)); \
+            node->left = node->right = NULL; \
+            node->height = 1; \
+            node->value = value; \
+            *inserted = true; \
+            return node; \
+        } \
+        int c = cmp(value, node->value); \
+        if (c == 0) return node; \
+        if (c < 0) node->left = name##__insert(node->left, value, inserted); \
+        else node->right = name##__insert(node->right, value, inserted); \
+        /* A duplicate changes nothing on the way up. */ \
+        return *inserted ? name##__balance(node) : node; \
+    } \
+    \
+    static inline bool name##_insert(name##_t *tree, type value) { \
+        bool inserted = false; \
+        tree->root = name##__insert(tree->root, value, &inserted); \
+        tree->size += inserted; \
+        return inserted; \
+    } \
+    \
+    /* Takes the largest node out of a subtree, giving its value. */ \
+    static inline name##_node_t *name##__take_max(name##_node_t *node, type *value) { \
+        if (node->right) { \
+            node->right = name##__take_max(node->right, value); \
+            return name##__balance(node); \
+        } \
+        name##_node_t *left = node->left; \
+        *value = node->value; \
+        free(node); \
+        return left; \
+    } \
+    \
+    static inline name##_node_t *name##__remove(name##_node_t *node, type value, type *removed, bool *found) { \
+        if (!node) return NULL; \
+        int c = cmp(value, node->value); \
+        if (c < 0) { \
+            node->left = name##__remove(node->left, value, removed, found); \
+        } else if (c > 0) { \
+            node->right = name##__remove(node->right, value, removed, found); \
+        } else { \
+            *found = true; \
+            if (removed) *removed = node->value; \
+            if (!node->left || !node->right) { \
+                name##_node_t *child = node->left ? node->left : node->right; \
+                free(node); \
+                return child; \
+            } \
+            node->left = name##__take_max(node->left, &node->value); \
+        } \
+        return *found ? name##__balance(node) : node; \
+    } \
+    \
+    static inline bool name##_remove(name##_t *tree, type value, type *removed) { \
+        bool found = false; \
+        tree->root = name##__remove(tree->root, value, removed, &found); \
+        tree->size -= found; \
+        return found; \
+    } \
+    \
+    static inline type *name##_min(name##_t *tree) { \
+        name##_node_t *node = tree->root; \
+        if (!node) return NULL; \
+        while (node->left) node = node->left; \
+        return &node->value; \
+    } \
+    \
+    static inline type *name##_max(name##_t *tree) { \
+        name##_node_t *node = tree->root; \
+        if (!node) return NULL; \
+        while (node->right) node = node->right; \
+        return &node->value; \
+    } \
+    \
+    static inline size_t name##_get_size(name##_t *tree) { \
+        return tree->size; \
+    } \
+    \
+    static inline void name##__inorder(name##_node_t *node, void (*fn)(type *, void *), void *args) { \
+        while (node) { \
+            name##__inorder(node->left, fn, args); \
+            fn(&node->value, args); \
+            node = node->right; \
+        } \
+    } \
+    \
+    static inline void name##_inorder_foreach(name##_t *tree, void (*fn)(type *, void *), void *args) { \
+        name##__inorder(tree->root, fn, args); \
+    }
+
+#endif
@@ -0,0 +1,224 @@
+/**
+ * Typed LLRB Tree Module
+ *
+ * Generates a left leaning red black tree for one element type, to use instead
+ * of llrb_tree_t (see llrb_tree.h) where the comparisons matter. llrb_tree_t
+ * calls its comp_fn_t through a pointer and keeps each element in its own
+ * elsize allocation. Here the elements are values of the type, stored in the
+ * nodes, and the comparison is a function or macro the compiler sees.
+ *
+ *     #define int_cmp(a, b) TYPED_CMP(a, b)
+ *     DEFINE_LLRB(int_llrb, int, int_cmp)
+ *
+ *     int_llrb_t *tree = int_llrb_create();
+ *     int_llrb_insert(tree, 42);
+ *     int *found = int_llrb_search(tree, 42);
+ *     int_llrb_delete(tree);
+ *
+ * DEFINE_LLRB(name, type, cmp) defines the types name_t and name_node_t and
+ * the functions below, all static inline. cmp follows the rules of DEFINE_AVL
+ * (see typed_avl.h) and may be a macro that evaluates its arguments more than
+ * once.
+ *
+ * name_t *name_create(void);
+ * void name_init(name_t *tree);           Initializes a tree struct in place.
+ * void name_delete(name_t *tree);         Frees the nodes and the tree.
+ * void name_clear(name_t *tree);          Frees the nodes.
+ * type *name_search(name_t *tree, type value);
+ * bool name_insert(name_t *tree, type value);  false if it was already there.
+ * type *name_successor(name_t *tree, type value);    NULL if value is not there
+ * type *name_predecessor(name_t *tree, type value);  or has no neighbour.
+ * type *name_min(name_t *tree);
+ * type *name_max(name_t *tree);
+ * size_t name_get_size(name_t *tree);
+ * void name_inorder_foreach(name_t *tree, void (*fn)(type *, void *), void *args);
+ *
+ * Like llrb_tree_t, the trees have no removal.
+ */
+
+#ifndef __TYPED_LLRB_H__
+#define __TYPED_LLRB_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+// Three way comparison of numbers or pointers, to use as cmp.
+#ifndef TYPED_CMP
+#define TYPED_CMP(a, b) (((a) > (b)) - ((a) < (b)))
+#endif
+
+#define DEFINE_LLRB(name, type, cmp) \
+    typedef struct name##_node { \
+        struct name##_node *left; \
+        struct name##_node *right; \
+        bool is_red; \
+        type value; \
+    } name##_node_t; \
+    \
+    typedef struct { \
+        name##_node_t *root; \
+        size_t size; \
+    } name##_t; \
+    \
+    static inline void name##_init(name##_t *tree) { \
+        tree->root = NULL; \
+        tree->size = 0; \
+    } \
+    \
+    static inline name##_t *name##_create(void) { \
+        name##_t *tree = (name##_t *)malloc(sizeof(name##_t)); \
+        name##_init(tree); \
+        return tree; \
+    } \
+    \
+    static inline void name##__free_nodes(name##_node_t *node) { \
+        while (node) { \
+            name##__free_nodes(node->left); \
+            name##_node_t *right = node->right; \
+            free(node); \
+            node = right; \
+        } \
+    } \
+    \
+    static inline void name##_clear(name##_t *tree) { \
+        name##__free_nodes(tree->root); \
+        name##_init(tree); \
+    } \
+    \
+    static inline void name##_delete(name##_t *tree) { \
+        if (!tree) return; \
+        name##__free_nodes(tree->root); \
+        free(tree); \
+    } \
+    \
+    static inline type *name##_search(name##_t *tree, type value) { \
+        name##_node_t *node = tree->root; \
+        while (node) { \
+            int c = cmp(value, node->value); \
+            if (c == 0) return &node->value; \
+            node = c < 0 ? node->left : node->right; \
+        } \
+        return NULL; \
+    } \
+    \
+    static inline bool name##__is_red(name##_node_t *node) { \
+        return node && node->is_red; \
+    } \
+    \
+    /* The rotations keep the color of the subtree root. */ \
+    static inline name##_node_t *name##__rotate_left(name##_node_t *node) { \
+        name##_node_t *root = node->right; \
+        node->right = root->left; \
+        root->left = node; \
+        root->is_red = node->is_red; \
+        node->is_red = true; \
+        return root; \
+    } \
+    \
+    static inline name##_node_t *name##__rotate_right(name##_node_t *node) { \
+        name##_node_t *root = node->left; \
+        node->left = root->right; \
+        root->right = node; \
+        root->is_red = node->is_red; \
+        node->is_red = true; \
+        return root; \
+    } \
+    \
+    static inline name##_node_t *name##__insert(name##_node_t *node, type value, bool *inserted) { \
+        if (!node) { \
+            node = (name##_node_t *)malloc(sizeof(name##_node_t)); \
+            node->left = node->right = NULL; \
+            node->is_red = true; \
+            node->value = value; \
+            *inserted = true; \
+            return node; \
+        } \
+        int c = cmp(value, node->value); \
+        if (c == 0) return node; \
+        if (c < 0) node->left = name##__insert(node->left, value, inserted); \
+        else node->right = name##__insert(node->right, value, inserted); \
+        if (!*inserted) return node; \
+        \
+        /* Leans left, splits two reds in a row, then promotes a full 2-3 node. */ \
+        if (name##__is_red(node->right) && !name##__is_red(node->left)) \
+            node = name##__rotate_left(node); \
+        if (name##__is_red(node->left) && name##__is_red(node->left->left)) \
+            node = name##__rotate_right(node); \
+        if (name##__is_red(node->left) && name##__is_red(node->right)) { \
+            node->is_red = true; \
+            node->left->is_red = node->right->is_red = false; \
+        } \
+        return node; \
+    } \
+    \
+    static inline bool name##_insert(name##_t *tree, type value) { \
+        bool inserted = false; \
+        tree->root = name##__insert(tree->root, value, &inserted); \
+        tree->root->is_red = false; \
+        tree->size += inserted; \
+        return inserted; \
+    } \
+    \
+    static inline name##_node_t *name##__min(name##_node_t *node) { \
+        if (!node) return NULL; \
+        while (node->left) node = node->left; \
+        return node; \
+    } \
+    \
+    static inline name##_node_t *name##__max(name##_node_t *node) { \
+        if (!node) return NULL; \
+        while (node->right) node = node->right; \
+        return node; \
+    } \
+    \
+    static inline type *name##_min(name##_t *tree) { \
+        name##_node_t *node = name##__min(tree->root); \
+        return node ? &node->value : NULL; \
+    } \
+    \
+    static inline type *name##_max(name##_t *tree) { \
+        name##_node_t *node = name##__max(tree->root); \
+        return node ? &node->value : NULL; \
+    } \
+    \
+    static inline type *name##_successor(name##_t *tree, type value) { \
+        name##_node_t *node = tree->root, *succ = NULL; \
+        int c; \
+        while (node && (c = cmp(value, node->value)) != 0) { \
+            if (c < 0) succ = node; \
+            node = c < 0 ? node->left : node->right; \
+        } \
+        if (!node) return NULL; \
+        if (node->right) succ = name##__min(node->right); \
+        return succ ? &succ->value : NULL; \
+    } \
+    \
+    static inline type *name##_predecessor(name##_t *tree, type value) { \
+        name##_node_t *node = tree->root, *pred = NULL; \
+        int c; \
+        while (node && (c = cmp(value, node->value)) != 0) { \
+            if (c > 0) pred = node; \
+            node = c < 0 ? node->left : node->right; \
+        } \
+        if (!node) return NULL; \
+        if (node->left) pred = name##__max(node->left); \
+        return pred ? &pred->value : NULL; \
+    } \
+    \
+    static inline size_t name##_get_size(name##_t *tree) { \
+        return tree->size; \
+    } \
+    \
+    static inline void name##__inorder(name##_node_t *node, void (*fn)(type *, void *), void *args) { \
+        while (node) { \
+            name##__inorder(node->left, fn, args); \
+            fn(&node->value, args); \
+            node = node->right; \
+        } \
+    } \
+    \
+    static inline void name##_inorder_foreach(name##_t *tree, void (*fn)(type *, void *), void *args) { \
+        name##__inorder(tree->root, fn, args); \
+    }
+
+#endif
@@ -0,0 +1,187 @@
+/**
+ * Typed Left Leaning Treap Module
+ *
+ * Generates a treap for one element type, to use instead of lltreap_t (see
+ * lltreap.h) where the comparisons matter. lltreap_t calls its comp_fn_t
+ * through a pointer and keeps each element in its own elsize allocation. Here
+ * the elements are values of the type, stored in the nodes, and the comparison
+ * is a function or macro the compiler sees.
+ *
+ *     #define int_cmp(a, b) TYPED_CMP(a, b)
+ *     DEFINE_LLTREAP(int_treap, int, int_cmp)
+ *
+ *     int_treap_t *treap = int_treap_create();
+ *     int_treap_insert(treap, 42);
+ *     int *found = int_treap_search(treap, 42);
+ *     int_treap_delete(treap);
+ *
+ * DEFINE_LLTREAP(name, type, cmp) defines the types name_t and name_node_t and
+ * the functions below, all static inline. cmp follows the rules of DEFINE_AVL
+ * (see typed_avl.h) and may be a macro that evaluates its arguments more than
+ * once.
+ *
+ * name_t *name_create(void);
+ * void name_init(name_t *treap);          Initializes a treap struct in place.
+ * void name_delete(name_t *treap);        Frees the nodes and the treap.
+ * void name_clear(name_t *treap);         Frees the nodes.
+ * type *name_search(name_t *treap, type value);
+ * bool name_insert(name_t *treap, type value);  false if it was already there.
+ * bool name_insert_with_priority(name_t *treap, type value, int priority);
+ * bool name_remove(name_t *treap, type value, type *removed);  removed may be NULL.
+ * size_t name_get_size(name_t *treap);
+ * void name_inorder_foreach(name_t *treap, void (*fn)(type *, void *), void *args);
+ *
+ * The treaps behave like lltreap_t: name_insert draws the priority with rand()
+ * and removal rotates the node left until it has no right child.
+ */
+
+#ifndef __TYPED_LLTREAP_H__
+#define __TYPED_LLTREAP_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+// Three way comparison of numbers or pointers, to use as cmp.
+#ifndef TYPED_CMP
+#define TYPED_CMP(a, b) (((a) > (b)) - ((a) < (b)))
+#endif
+
+#define DEFINE_LLTREAP(name, type, cmp) \
+    typedef struct name##_node { \
+        struct name##_node *left; \
+        struct name##_node *right; \
+        int priority; \
+        type value; \
+    } name##_node_t; \
+    \
+    typedef struct { \
+        name##_node_t *root; \
+        size_t size; \
+    } name##_t; \
+    \
+    static inline void name##_init(name##_t *treap) { \
+        treap->root = NULL; \
+        treap->size = 0; \
+    } \
+    \
+    static inline name##_t *name##_create(void) { \
+        name##_t *treap = (name##_t *)malloc(sizeof(name##_t)); \
+        name##_init(treap); \
+        return treap; \
+    } \
+    \
+    static inline void name##__free_nodes(name##_node_t *node) { \
+        while (node) { \
+            name##__free_nodes(node->left); \
+            name##_node_t *right = node->right; \
+            free(node); \
+            node = right; \
+        } \
+    } \
+    \
+    static inline void name##_clear(name##_t *treap) { \
+        name##__free_nodes(treap->root); \
+        name##_init(treap); \
+    } \
+    \
+    static inline void name##_delete(name##_t *treap) { \
+        if (!treap) return; \
+        name##__free_nodes(treap->root); \
+        free(treap); \
+    } \
+    \
+    static inline type *name##_search(name##_t *treap, type value) { \
+        name##_node_t *node = treap->root; \
+        while (node) { \
+            int c = cmp(value, node->value); \
+            if (c == 0) return &node->value; \
+            node = c < 0 ? node->left : node->right; \
+        } \
+        return NULL; \
+    } \
+    \
+    static inline name##_node_t *name##__rotate_left(name##_node_t *node) { \
+        name##_node_t *root = node->right; \
+        node->right = root->left; \
+        root->left = node; \
+        return root; \
+    } \
+    \
+    static inline name##_node_t *name##__rotate_right(name##_node_t *node) { \
+        name##_node_t *root = node->left; \
+        node->left = root->right; \
+        root->right = node; \
+        return root; \
+    } \
+    \
+    static inline name##_node_t *name##__insert(name##_node_t *node, type value, int priority, bool *inserted) { \
+        if (!node) { \
+            node = (name##_node_t *)malloc(sizeof(name##_node_t)); \
+            node->left = node->right = NULL; \
+            node->priority = priority; \
+            node->value = value; \
+            *inserted = true; \
+            return node; \
+        } \
+        int c = cmp(value, node->value); \
+        if (c < 0) { \
+            node->left = name##__insert(node->left, value, priority, inserted); \
+            if (node->left->priority > node->priority) node = name##__rotate_right(node); \
+        } else if (c > 0) { \
+            node->right = name##__insert(node->right, value, priority, inserted); \
+            if (node->right->priority > node->priority) node = name##__rotate_left(node); \
+        } \
+        return node; \
+    } \
+    \
+    static inline bool name##_insert_with_priority(name##_t *treap, type value, int priority) { \
+        bool inserted = false; \
+        treap->root = name##__insert(treap->root, value, priority, &inserted); \
+        treap->size += inserted; \
+        return inserted; \
+    } \
+    \
+    static inline bool name##_insert(name##_t *treap, type value) { \
+        return name##_insert_with_priority(treap, value, rand()); \
+    } \
+    \
+    static inline name##_node_t *name##__remove_root(name##_node_t *node) { \
+        if (!node->right) return node->left; \
+        node = name##__rotate_left(node); \
+        node->left = name##__remove_root(node->left); \
+        return node; \
+    } \
+    \
+    static inline bool name##_remove(name##_t *treap, type value, type *removed) { \
+        name##_node_t **link = &treap->root; \
+        while (*link) { \
+            int c = cmp(value, (*link)->value); \
+            if (c == 0) break; \
+            link = c < 0 ? &(*link)->left : &(*link)->right; \
+        } \
+        name##_node_t *node = *link; \
+        if (!node) return false; \
+        if (removed) *removed = node->value; \
+        *link = name##__remove_root(node); \
+        free(node); \
+        treap->size--; \
+        return true; \
+    } \
+    \
+    static inline size_t name##_get_size(name##_t *treap) { \
+        return treap->size; \
+    } \
+    \
+    static inline void name##__inorder(name##_node_t *node, void (*fn)(type *, void *), void *args) { \
+        while (node) { \
+            name##__inorder(node->left, fn, args); \
+            fn(&node->value, args); \
+            node = node->right; \
+        } \
+    } \
+    \
+    static inline void name##_inorder_foreach(name##_t *treap, void (*fn)(type *, void *), void *args) { \
+        name##__inorder(treap->root, fn, args); \
+    }
+
+#endif
@@ -0,0 +1,158 @@
+/**
+ * Typed Skip List Module
+ *
+ * Generates a skip list for one element type, to use instead of skip_list_t
+ * (see skip_list.h) where the comparisons matter. skip_list_t calls its
+ * comp_fn_t through a pointer and keeps one node per element and layer. Here
+ * the comparison is a function or macro the compiler sees, and each element
+ * has a single node holding the value and its links of every layer.
+ *
+ *     #define int_cmp(a, b) TYPED_CMP(a, b)
+ *     DEFINE_SKIP_LIST(int_list, int, int_cmp)
+ *
+ *     int_list_t *list = int_list_create(16);
+ *     int_list_insert(list, 42);
+ *     int *found = int_list_search(list, 42);
+ *     int_list_delete(list);
+ *
+ * DEFINE_SKIP_LIST(name, type, cmp) defines the types name_t and name_node_t
+ * and the functions below, all static inline. cmp follows the rules of
+ * DEFINE_AVL (see typed_avl.h) and may be a macro that evaluates its arguments
+ * more than once. The list keeps the links of its head itself, so no smallest
+ * element is needed.
+ *
+ * name_t *name_create(unsigned layer_max);
+ * void name_init(name_t *list, unsigned layer_max);  Initializes a list struct in place.
+ * void name_delete(name_t *list);         Frees the nodes and the list.
+ * void name_clear(name_t *list);          Frees the nodes.
+ * type *name_search(name_t *list, type value);
+ * bool name_insert(name_t *list, type value);  false if it was already there.
+ * bool name_remove(name_t *list, type value, type *removed);  removed may be NULL.
+ * type *name_min(name_t *list);
+ * size_t name_get_size(name_t *list);
+ * void name_foreach(name_t *list, void (*fn)(type *, void *), void *args);  In order.
+ *
+ * Like skip_list_t, an element goes one layer up on each rand() coin flip it
+ * wins, up to layer_max layers (at most TYPED_SKIP_LIST_MAX_LAYERS).
+ */
+
+#ifndef __TYPED_SKIP_LIST_H__
+#define __TYPED_SKIP_LIST_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+// Three way comparison of numbers or pointers, to use as cmp.
+#ifndef TYPED_CMP
+#define TYPED_CMP(a, b) (((a) > (b)) - ((a) < (b)))
+#endif
+
+#define TYPED_SKIP_LIST_MAX_LAYERS 32
+
+#define DEFINE_SKIP_LIST(name, type, cmp) \
+    typedef struct name##_node { \
+        type value; \
+        struct name##_node *next[]; \
+    } name##_node_t; \
+    \
+    typedef struct { \
+        name##_node_t *head[TYPED_SKIP_LIST_MAX_LAYERS]; \
+        size_t size; \
+        unsigned layer_max; \
+        unsigned height; \
+    } name##_t; \
+    \
+    static inline void name##_init(name##_t *list, unsigned layer_max) { \
+        if (layer_max < 1) layer_max = 1; \
+        if (layer_max > TYPED_SKIP_LIST_MAX_LAYERS) layer_max = TYPED_SKIP_LIST_MAX_LAYERS; \
+        for (unsigned i = 0; i < TYPED_SKIP_LIST_MAX_LAYERS; i++) list->head[i] = NULL; \
+        list->size = 0; \
+        list->layer_max = layer_max; \
+        list->height = 1; \
+    } \
+    \
+    static inline name##_t *name##_create(unsigned layer_max) { \
+        name##_t *list = (name##_t *)malloc(sizeof(name##_t)); \
+        name##_init(list, layer_max); \
+        return list; \
+    } \
+    \
+    static inline void name##_clear(name##_t *list) { \
+        name##_node_t *node = list->head[0]; \
+        while (node) { \
+            name##_node_t *next = node->next[0]; \
+            free(node); \
+            node = next; \
+        } \
+        name##_init(list, list->layer_max); \
+    } \
+    \
+    static inline void name##_delete(name##_t *list) { \
+        if (!list) return; \
+        name##_clear(list); \
+        free(list); \
+    } \
+    \
+    /* Gives the first node not smaller than value, filling update with the \
+       links that lead to it in each layer when update is not NULL. */ \
+    static inline name##_node_t *name##__find(name##_t *list, type value, name##_node_t ***update) { \
+        name##_node_t **links = list->head; \
+        for (unsigned i = list->height; i-- > 0;) { \
+            while (links[i] && cmp(links[i]->value, value) < 0) links = links[i]->next; \
+            if (update) update[i] = links; \
+        } \
+        return links[0]; \
+    } \
+    \
+    static inline type *name##_search(name##_t *list, type value) { \
+        name##_node_t *node = name##__find(list, value, NULL); \
+        return node && cmp(node->value, value) == 0 ? &node->value : NULL; \
+    } \
+    \
+    static inline bool name##_insert(name##_t *list, type value) { \
+        name##_node_t **update[TYPED_SKIP_LIST_MAX_LAYERS]; \
+        name##_node_t *next = name##__find(list, value, update); \
+        if (next && cmp(next->value, value) == 0) return false; \
+        \
+        unsigned height = 1; \
+        while (height < list->layer_max && rand() % 2) height++; \
+        for (; list->height < height; list->height++) update[list->height] = list->head; \
+        \
+        name##_node_t *node = (name##_node_t *)malloc(sizeof(name##_node_t) + height * sizeof(name##_node_t *)); \
+        node->value = value; \
+        for (unsigned i = 0; i < height; i++) { \
+            node->next[i] = update[i][i]; \
+            update[i][i] = node; \
+        } \
+        list->size++; \
+        return true; \
+    } \
+    \
+    static inline bool name##_remove(name##_t *list, type value, type *removed) { \
+        name##_node_t **update[TYPED_SKIP_LIST_MAX_LAYERS]; \
+        name##_node_t *node = name##__find(list, value, update); \
+        if (!node || cmp(node->value, value) != 0) return false; \
+        \
+        if (removed) *removed = node->value; \
+        for (unsigned i = 0; i < list->height && update[i][i] == node; i++) \
+            update[i][i] = node->next[i]; \
+        free(node); \
+        while (list->height > 1 && !list->head[list->height - 1]) list->height--; \
+        list->size--; \
+        return true; \
+    } \
+    \
+    static inline type *name##_min(name##_t *list) { \
+        return list->head[0] ? &list->head[0]->value : NULL; \
+    } \
+    \
+    static inline size_t name##_get_size(name##_t *list) { \
+        return list->size; \
+    } \
+    \
+    static inline void name##_foreach(name##_t *list, void (*fn)(type *, void *), void *args) { \
+        for (name##_node_t *node = list->head[0]; node; node = node->next[0]) \
+            fn(&node->value, args); \
+    }
+
+#endif
@@ -0,0 +1,142 @@
+/**
+ * Typed Sort Module
+ *
+ * Generates sorting and binary search functions for one element type, to use
+ * instead of the functions of sorting.h where the comparisons matter. Those
+ * call a comp_t through a pointer and swap elements with memcpy of a size only
+ * known at run time, so nothing can be inlined. Here the comparison is a
+ * function or macro the compiler sees, and elements are moved by assignment.
+ *
+ *     #define int_cmp(a, b) TYPED_CMP(a, b)
+ *     DEFINE_SORT(ints, int, int_cmp)
+ *
+ *     ints_sort(vec, n);
+ *     int *found = ints_binary_search(vec, n, 42);
+ *
+ * DEFINE_SORT(name, type, cmp) defines these functions, all static inline.
+ * cmp(a, b) takes two values of the type and returns < 0, 0 or > 0 like a
+ * comp_t. It may be a macro that evaluates its arguments more than once.
+ *
+ * void name_sort(type *vec, size_t n);            Introsort, not stable.
+ * void name_insertion_sort(type *vec, size_t n);  Stable, for small arrays.
+ * void name_heap_sort(type *vec, size_t n);
+ * size_t name_lower_bound(type *vec, size_t n, type value);
+ *     The index of the first element not less than value, n if none.
+ * type *name_binary_search(type *vec, size_t n, type value);
+ *     An element equal to value, or NULL.
+ *
+ * name_sort is a quick sort with a median of three pivot that sorts small
+ * ranges with insertion sort, loops on the larger side so the stack stays
+ * logarithmic, and switches to heap sort when the recursion gets too deep, so
+ * it is O(n log n) on any input.
+ */
+
+#ifndef __TYPED_SORT_H__
+#define __TYPED_SORT_H__
+
+#include <stdlib.h>
+
+// Three way comparison of numbers or pointers, to use as cmp.
+#ifndef TYPED_CMP
+#define TYPED_CMP(a, b) (((a) > (b)) - ((a) < (b)))
+#endif
+
+#define TYPED_SORT_SMALL 16 // Ranges up to this size are insertion sorted.
+
+#define DEFINE_SORT(name, type, cmp) \
+    static inline void name##_insertion_sort(type *vec, size_t n) { \
+        for (size_t i = 1; i < n; i++) { \
+            type value = vec[i]; \
+            size_t j = i; \
+            for (; j > 0 && cmp(value, vec[j - 1]) < 0; j--) vec[j] = vec[j - 1]; \
+            vec[j] = value; \
+        } \
+    } \
+    \
+    static inline void name##__sift_down(type *vec, size_t root, size_t n) { \
+        type value = vec[root]; \
+        for (size_t child; (child = 2 * root + 1) < n; root = child) { \
+            if (child + 1 < n && cmp(vec[child], vec[child + 1]) < 0) child++; \
+            if (cmp(value, vec[child]) >= 0) break; \
+            vec[root] = vec[child]; \
+        } \
+        vec[root] = value; \
+    } \
+    \
+    static inline void name##_heap_sort(type *vec, size_t n) { \
+        for (size_t i = n / 2; i-- > 0;) name##__sift_down(vec, i, n); \
+        for (size_t i = n; i-- > 1;) { \
+            type top = vec[0]; \
+            vec[0] = vec[i]; \
+            vec[i] = top; \
+            name##__sift_down(vec, 0, i); \
+        } \
+    } \
+    \
+    static inline void name##__swap(type *a, type *b) { \
+        type t = *a; \
+        *a = *b; \
+        *b = t; \
+    } \
+    \
+    static inline void name##__introsort(type *vec, size_t n, int depth) { \
+        while (n > TYPED_SORT_SMALL) { \
+            if (depth-- == 0) return name##_heap_sort(vec, n); \
+            \
+            /* Orders the first, middle and last elements, the median being \
+               the pivot and the other two sentinels for the partition. */ \
+            size_t mid = n / 2; \
+            if (cmp(vec[mid], vec[0]) < 0) name##__swap(&vec[mid], &vec[0]); \
+            if (cmp(vec[n - 1], vec[mid]) < 0) { \
+                name##__swap(&vec[n - 1], &vec[mid]); \
+                if (cmp(vec[mid], vec[0]) < 0) name##__swap(&vec[mid], &vec[0]); \
+            } \
+            type pivot = vec[mid]; \
+            \
+            /* Hoare partition: [0, j] <= pivot <= [j + 1, n). */ \
+            size_t i = 0, j = n - 1; \
+            for (;;) { \
+                do i++; while (cmp(vec[i], pivot) < 0); \
+                do j--; while (cmp(vec[j], pivot) > 0); \
+                if (i >= j) break; \
+                name##__swap(&vec[i], &vec[j]); \
+            } \
+            size_t left = j + 1; \
+            if (left < n - left) { \
+                name##__introsort(vec, left, depth); \
+                vec += left; \
+                n -= left; \
+            } else { \
+                name##__introsort(vec + left, n - left, depth); \
+                n = left; \
+            } \
+        } \
+        name##_insertion_sort(vec, n); \
+    } \
+    \
+    static inline void name##_sort(type *vec, size_t n) { \
+        int depth = 0; \
+        for (size_t m = n; m > 1; m >>= 1) depth += 2; \
+        name##__introsort(vec, n, depth); \
+    } \
+    \
+    static inline size_t name##_lower_bound(type *vec, size_t n, type value) { \
+        size_t start = 0; \
+        while (n > 0) { \
+            size_t step = n / 2; \
+            if (cmp(vec[start + step], value) < 0) { \
+                start += step + 1; \
+                n -= step + 1; \
+            } else { \
+                n = step; \
+            } \
+        } \
+        return start; \
+    } \
+    \
+    static inline type *name##_binary_search(type *vec, size_t n, type value) { \
+        size_t i = name##_lower_bound(vec, n, value); \
+        return i < n && cmp(vec[i], value) == 0 ? &vec[i] : NULL; \
+    }
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * Work Stealing Deque Module
+ *
+ * A deque of pointers for work stealing schedulers. One thread owns the deque
+ * and pushes and pops at its bottom, like a stack, so it works on the task it
+ * made last while its data is still in cache. Other threads (thieves) take
+ * from the top, getting the oldest tasks, which in divide and conquer are the
+ * largest pieces of work.
+ *
+ * The owner never waits for the thieves: pushes and pops only contend with a
+ * thief for the last element.
+ *
+ * Implementation details:
+ * This is the deque of Chase and Lev, with the memory orderings of Lê et al.
+ * ("Correct and Efficient Work-Stealing for Weak Memory Models"). Pointers are
+ * in a circular array with a power of two number of slots, between the
+ * positions top (next to steal) and bottom (next to push), both only growing.
+ * A thief claims the element at top with a compare and swap on top. The owner
+ * takes the element at bottom and only needs the compare and swap when it is
+ * also the element at top.
+ * When the array is full the owner copies the elements into one twice as big.
+ * A thief may still be reading the old array, so old arrays are only freed
+ * with the deque.
+ */
+
+#ifndef __WSDEQUE_H__
+#define __WSDEQUE_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+typedef struct _wsdeque wsdeque_t;
+
+/**
+ * Creates a work stealing deque.
+ *
+ * @param cap - the starting number of slots, rounded up to a power of two. The
+ *     deque grows past it as needed.
+ * @return a pointer to the created deque. [ownership]
+ */
+wsdeque_t *wsdeque_create(size_t cap);
+
+/**
+ * Pushes an element at the bottom. Only the owner may push.
+ *
+ * @param deque - the deque. [mut ref]
+ * @param element - the element, not NULL.
+ */
+void wsdeque_push(wsdeque_t *deque, void *element);
+
+/**
+ * Pops the element at the bottom, the last one pushed. Only the owner may pop.
+ *
+ * @param deque - the deque. [mut ref]
+ * @return the element, or NULL if the deque is empty.
+ */
+void *wsdeque_pop(wsdeque_t *deque);
+
+/**
+ * Steals the element at the top, the oldest one. Any thread may steal.
+ *
+ * @param deque - the deque. [mut ref]
+ * @return the element, or NULL if the deque is empty or another thread took
+ *     the element first.
+ */
+void *wsdeque_steal(wsdeque_t *deque);
+
+/**
+ * Gets the number of elements in the deque. With other threads using the deque
+ * it may already be out of date when it returns.
+ *
+ * @param deque - the deque. [ref]
+ * @return the number of elements.
+ */
+size_t wsdeque_get_size(wsdeque_t *deque);
+
+bool wsdeque_is_empty(wsdeque_t *deque);
+
+/**
+ * Deletes the deque. No other thread may be using it.
+ *
+ * @param deque - the deque. [ownership]
+ */
+void wsdeque_delete(wsdeque_t *deque);
+
+#endif
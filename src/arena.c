@@ -0,0 +1,84 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <arena.h>
+
+#define ALIGN 8
+#define align_up(n) (((n) + ALIGN - 1) & ~(size_t)(ALIGN - 1))
+
+typedef struct _slab {
+    struct _slab *next;
+    size_t size;
+    size_t used;
+    // Keeps `data` aligned regardless of the fields above.
+    _Alignas(ALIGN) unsigned char data[];
+} slab_t;
+
+struct _arena {
+    slab_t *slabs; // The current slab is the first one.
+    size_t next_size;
+    size_t capacity;
+};
+
+static slab_t *mk_slab(size_t size, slab_t *next) {
+    slab_t *slab = (slab_t *)malloc(sizeof(slab_t) + size);
+    slab->next = next;
+    slab->size = size;
+    slab->used = 0;
+    return slab;
+}
+
+arena_t *arena_create(size_t slab_size) {
+    arena_t *arena = (arena_t *)malloc(sizeof(arena_t));
+    arena->slabs = NULL;
+    arena->next_size = align_up(slab_size > 0 ? slab_size : ARENA_DEFAULT_SLAB_SZ);
+    arena->capacity = 0;
+    return arena;
+}
+
+void *arena_alloc(arena_t *arena, size_t size) {
+    size = align_up(size);
+
+    slab_t *slab = arena->slabs;
+    if (!slab || slab->size - slab->used < size) {
+        if (size > arena->next_size / 4) {
+            // Too large for a regular slab: it gets its own, placed after the
+            // current one so that the space left on it is not lost.
+            slab = mk_slab(size, NULL);
+            if (arena->slabs) {
+                slab->next = arena->slabs->next;
+                arena->slabs->next = slab;
+            } else {
+                arena->slabs = slab;
+            }
+        } else {
+            slab = arena->slabs = mk_slab(arena->next_size, arena->slabs);
+            if (arena->next_size < ARENA_MAX_SLAB_SZ) arena->next_size *= 2;
+        }
+        arena->capacity += slab->size;
+    }
+
+    void *ptr = slab->data + slab->used;
+    slab->used += size;
+    return ptr;
+}
+
+char *arena_strndup(arena_t *arena, const char *str, size_t len) {
+    char *copy = (char *)arena_alloc(arena, len + 1);
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+size_t arena_get_capacity(arena_t *arena) { return arena->capacity; }
+
+void arena_delete(arena_t *arena) {
+    if (!arena) return;
+
+    slab_t *slab, *tmp;
+    for (slab = arena->slabs; slab; slab = tmp) {
+        tmp = slab->next;
+        free(slab);
+    }
+    free(arena);
+}
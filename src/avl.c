@@ -187,7 +187,9 @@ static node_t *_remove(node_t *node, void *element, size_t elsize, comp_fn_t com
             free(node);
             node = next;
         } else {
-            node = _replace_node(node, node->left, elsize, free_fn);
+            // The largest element of the left subtree takes the place of the
+            // removed one, and the left subtree loses that node.
+            node->left = _replace_node(node, node->left, elsize, free_fn);
         }
     }
     return _balance(node);
@@ -0,0 +1,148 @@
+/**
+ * Blocked Bloom filter (see filter.h).
+ *
+ * A block is 256 bits, 8 words of 32 bits. The high half of a key's hash picks
+ * the block and the low half picks one bit in each word, by multiplying it with
+ * a different odd constant per word and keeping the top 5 bits (the split
+ * block layout of Parquet and Impala). Every key sets 8 bits of a single block,
+ * so inserting and looking up touch one cache line, and with AVX2 the 8 bit
+ * positions are computed and tested with a handful of instructions.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __AVX2__
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+#include <filter.h>
+
+#define WORDS 8 // 32 bit words per block.
+#define BLOCK_BITS (WORDS * 32)
+#define DEFAULT_BITS_PER_KEY 10
+
+typedef struct {
+    _Alignas(32) uint32_t words[WORDS];
+} block_t;
+
+struct _bloom {
+    block_t *blocks;
+    size_t n_blocks;
+    hash_fn_t hash;
+    uint64_t seed;
+};
+
+static const block_t salt = { {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+} };
+
+static inline block_t *block_of(bloom_t *bloom, uint64_t hash) {
+    // Maps the high 32 bits to [0, n_blocks) without a division.
+    return &bloom->blocks[((hash >> 32) * (uint64_t)bloom->n_blocks) >> 32];
+}
+
+#ifdef __AVX2__
+
+static inline __m256i make_mask(uint32_t h) {
+    __m256i bit = _mm256_mullo_epi32(_mm256_set1_epi32(h), _mm256_load_si256((__m256i *)salt.words));
+    return _mm256_sllv_epi32(_mm256_set1_epi32(1), _mm256_srli_epi32(bit, 27));
+}
+
+static inline void block_insert(block_t *block, uint32_t h) {
+    __m256i *words = (__m256i *)block->words;
+    _mm256_store_si256(words, _mm256_or_si256(_mm256_load_si256(words), make_mask(h)));
+}
+
+static inline bool block_contains(block_t *block, uint32_t h) {
+    // testc is set when every bit of the mask is set in the block.
+    return _mm256_testc_si256(_mm256_load_si256((__m256i *)block->words), make_mask(h));
+}
+
+#else
+
+static inline void make_mask(uint32_t h, block_t *mask) {
+    for (int i = 0; i < WORDS; i++)
+        mask->words[i] = 1U << ((h * salt.words[i]) >> 27);
+}
+
+static inline void block_insert(block_t *block, uint32_t h) {
+    block_t mask;
+    make_mask(h, &mask);
+    for (int i = 0; i < WORDS; i++) block->words[i] |= mask.words[i];
+}
+
+static inline bool block_contains(block_t *block, uint32_t h) {
+    block_t mask;
+    make_mask(h, &mask);
+#ifdef __SSE2__
+    __m128i lo = _mm_load_si128((__m128i *)mask.words);
+    __m128i hi = _mm_load_si128((__m128i *)mask.words + 1);
+    __m128i eq_lo = _mm_cmpeq_epi32(_mm_and_si128(_mm_load_si128((__m128i *)block->words), lo), lo);
+    __m128i eq_hi = _mm_cmpeq_epi32(_mm_and_si128(_mm_load_si128((__m128i *)block->words + 1), hi), hi);
+    return _mm_movemask_epi8(_mm_and_si128(eq_lo, eq_hi)) == 0xffff;
+#else
+    for (int i = 0; i < WORDS; i++)
+        if ((block->words[i] & mask.words[i]) != mask.words[i]) return false;
+    return true;
+#endif
+}
+
+#endif
+
+bloom_t *bloom_create_with(bloom_opts_t opts) {
+    bloom_t *bloom = (bloom_t *)malloc(sizeof(bloom_t));
+    double bits_per_key = opts.bits_per_key > 0 ? opts.bits_per_key : DEFAULT_BITS_PER_KEY;
+    size_t bits = (size_t)((double)(opts.n > 0 ? opts.n : 1) * bits_per_key);
+
+    bloom->n_blocks = (bits + BLOCK_BITS - 1) / BLOCK_BITS;
+    if (bloom->n_blocks == 0) bloom->n_blocks = 1;
+    bloom->blocks = (block_t *)aligned_alloc(sizeof(block_t), bloom->n_blocks * sizeof(block_t));
+    memset(bloom->blocks, 0, bloom->n_blocks * sizeof(block_t));
+    bloom->hash = opts.hash ? opts.hash : HASH_DEFAULT;
+    bloom->seed = opts.seed ? opts.seed : hash_random_seed();
+    return bloom;
+}
+
+bloom_t *bloom_from_hashset(hashset_t *hashset, double bits_per_key) {
+    bloom_opts_t opts = BLOOM_OPTS(.n = hashset_get_size(hashset), .bits_per_key = bits_per_key);
+    hashset_get_hash(hashset, &opts.hash, &opts.seed);
+    bloom_t *bloom = bloom_create_with(opts);
+
+    char *key;
+    for (hashset_iter_t it = hashset_iter(hashset); hashset_iter_next(&it, &key);)
+        bloom_insert(bloom, key);
+
+    return bloom;
+}
+
+void bloom_insert_hash(bloom_t *bloom, uint64_t hash) {
+    hash = hash_mix(hash);
+    block_insert(block_of(bloom, hash), (uint32_t)hash);
+}
+
+bool bloom_contains_hash(bloom_t *bloom, uint64_t hash) {
+    hash = hash_mix(hash);
+    return block_contains(block_of(bloom, hash), (uint32_t)hash);
+}
+
+void bloom_insert(bloom_t *bloom, char *key) {
+    bloom_insert_hash(bloom, bloom->hash(key, strlen(key), bloom->seed));
+}
+
+bool bloom_contains(bloom_t *bloom, char *key) {
+    return bloom_contains_hash(bloom, bloom->hash(key, strlen(key), bloom->seed));
+}
+
+size_t bloom_get_bits(bloom_t *bloom) { return bloom->n_blocks * BLOCK_BITS; }
+
+void bloom_delete(bloom_t *bloom) {
+    if (!bloom) return;
+    free(bloom->blocks);
+    free(bloom);
+}
@@ -0,0 +1,225 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#include <bqueue.h>
+
+#define SPINS 100 // Times the lock is tried before sleeping.
+
+#define load_relaxed(p)      __atomic_load_n((p), __ATOMIC_RELAXED)
+#define store_relaxed(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+
+struct _bqueue {
+    uint32_t lock;       // 0 unlocked, 1 locked, 2 locked with sleepers.
+    uint32_t pushes;     // Bumped by every push, consumers sleep on it.
+    uint32_t pops;       // Bumped by every pop, producers sleep on it.
+    uint32_t consumers_waiting;
+    uint32_t producers_waiting;
+    bool closed;
+    unsigned char *data;
+    size_t head;         // Position of the oldest element.
+    size_t size;
+    size_t mask;
+    size_t elsize;
+};
+
+/* Futex */
+
+// Sleeps while *addr == val, at most until the deadline (if any). Returns
+// false if the deadline passed.
+static bool futex_wait(uint32_t *addr, uint32_t val, const struct timespec *deadline) {
+    struct timespec timeout, *relative = NULL;
+    if (deadline) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        timeout.tv_sec = deadline->tv_sec - now.tv_sec;
+        timeout.tv_nsec = deadline->tv_nsec - now.tv_nsec;
+        if (timeout.tv_nsec < 0) {
+            timeout.tv_sec--;
+            timeout.tv_nsec += 1000000000L;
+        }
+        if (timeout.tv_sec < 0) return false;
+        relative = &timeout;
+    }
+    long r = syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, relative, NULL, 0);
+    return r == 0 || errno != ETIMEDOUT;
+}
+
+static void futex_wake(uint32_t *addr, int n) {
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// The mutex of "Futexes Are Tricky" (Drepper), with a short spin first.
+static void lock(bqueue_t *queue) {
+    uint32_t expected = 0;
+    for (int i = 0; i < SPINS; i++) {
+        if (__atomic_compare_exchange_n(&queue->lock, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return;
+        expected = 0;
+        cpu_relax();
+    }
+    if (__atomic_exchange_n(&queue->lock, 2, __ATOMIC_ACQUIRE) == 0) return;
+    do {
+        futex_wait(&queue->lock, 2, NULL);
+    } while (__atomic_exchange_n(&queue->lock, 2, __ATOMIC_ACQUIRE) != 0);
+}
+
+static void unlock(bqueue_t *queue) {
+    if (__atomic_exchange_n(&queue->lock, 0, __ATOMIC_RELEASE) == 2) futex_wake(&queue->lock, 1);
+}
+
+// Sleeps until `word` changes from what it was under the lock, the lock being
+// released meanwhile. Returns false if the deadline passed.
+static bool wait_change(bqueue_t *queue, uint32_t *word, uint32_t *waiting, const struct timespec *deadline) {
+    uint32_t seen = load_relaxed(word);
+    store_relaxed(waiting, *waiting + 1);
+    unlock(queue);
+    bool in_time = futex_wait(word, seen, deadline);
+    lock(queue);
+    store_relaxed(waiting, *waiting - 1);
+    return in_time;
+}
+
+static struct timespec *deadline_of(long timeout_us, struct timespec *deadline) {
+    if (timeout_us < 0) return NULL;
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += timeout_us / 1000000;
+    deadline->tv_nsec += (timeout_us % 1000000) * 1000;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+    return deadline;
+}
+
+/* Queue */
+
+bqueue_t *bqueue_create(size_t elsize, size_t cap) {
+    bqueue_t *queue = (bqueue_t *)malloc(sizeof(bqueue_t));
+    size_t slots = 1;
+    while (slots < cap) slots <<= 1;
+
+    queue->lock = 0;
+    queue->pushes = queue->pops = 0;
+    queue->consumers_waiting = queue->producers_waiting = 0;
+    queue->closed = false;
+    queue->data = (unsigned char *)malloc(slots * elsize);
+    queue->head = 0;
+    queue->size = 0;
+    queue->mask = slots - 1;
+    queue->elsize = elsize;
+    return queue;
+}
+
+bqueue_status_t bqueue_push(bqueue_t *queue, const void *element, long timeout_us) {
+    struct timespec deadline_buf, *deadline = NULL;
+    lock(queue);
+    while (queue->size > queue->mask && !queue->closed) {
+        if (timeout_us == 0) {
+            unlock(queue);
+            return BQUEUE_TIMEOUT;
+        }
+        if (!deadline && timeout_us > 0) deadline = deadline_of(timeout_us, &deadline_buf);
+        if (!wait_change(queue, &queue->pops, &queue->producers_waiting, deadline) &&
+            queue->size > queue->mask && !queue->closed) {
+            unlock(queue);
+            return BQUEUE_TIMEOUT;
+        }
+    }
+    if (queue->closed) {
+        unlock(queue);
+        return BQUEUE_CLOSED;
+    }
+
+    memcpy(queue->data + ((queue->head + queue->size) & queue->mask) * queue->elsize, element, queue->elsize);
+    queue->size++;
+    store_relaxed(&queue->pushes, queue->pushes + 1);
+    bool wake = queue->consumers_waiting > 0;
+    unlock(queue);
+
+    if (wake) futex_wake(&queue->pushes, 1);
+    return BQUEUE_OK;
+}
+
+size_t bqueue_pop_n(bqueue_t *queue, void *elements, size_t n, long timeout_us) {
+    struct timespec deadline_buf, *deadline = NULL;
+    lock(queue);
+    while (queue->size == 0 && !queue->closed) {
+        if (timeout_us == 0) {
+            unlock(queue);
+            return 0;
+        }
+        if (!deadline && timeout_us > 0) deadline = deadline_of(timeout_us, &deadline_buf);
+        if (!wait_change(queue, &queue->pushes, &queue->consumers_waiting, deadline) &&
+            queue->size == 0 && !queue->closed) {
+            unlock(queue);
+            return 0;
+        }
+    }
+
+    if (n > queue->size) n = queue->size;
+    // Copies in up to two runs, the second one wrapping around.
+    size_t idx = queue->head & queue->mask, first = queue->mask + 1 - idx;
+    if (first > n) first = n;
+    memcpy(elements, queue->data + idx * queue->elsize, first * queue->elsize);
+    memcpy((unsigned char *)elements + first * queue->elsize, queue->data, (n - first) * queue->elsize);
+    queue->head += n;
+    queue->size -= n;
+
+    store_relaxed(&queue->pops, queue->pops + 1);
+    uint32_t producers = queue->producers_waiting;
+    unlock(queue);
+
+    // Room was made for n elements, so as many producers may go on.
+    if (n > 0 && producers > 0) futex_wake(&queue->pops, n < producers ? n : producers);
+    return n;
+}
+
+bqueue_status_t bqueue_pop(bqueue_t *queue, void *element, long timeout_us) {
+    if (bqueue_pop_n(queue, element, 1, timeout_us) == 1) return BQUEUE_OK;
+    return bqueue_is_closed(queue) ? BQUEUE_CLOSED : BQUEUE_TIMEOUT;
+}
+
+void bqueue_close(bqueue_t *queue) {
+    lock(queue);
+    queue->closed = true;
+    // Waiting threads wake up when the words change.
+    store_relaxed(&queue->pushes, queue->pushes + 1);
+    store_relaxed(&queue->pops, queue->pops + 1);
+    unlock(queue);
+
+    futex_wake(&queue->pushes, INT32_MAX);
+    futex_wake(&queue->pops, INT32_MAX);
+}
+
+bool bqueue_is_closed(bqueue_t *queue) {
+    lock(queue);
+    bool closed = queue->closed;
+    unlock(queue);
+    return closed;
+}
+
+size_t bqueue_get_size(bqueue_t *queue) {
+    lock(queue);
+    size_t size = queue->size;
+    unlock(queue);
+    return size;
+}
+
+void bqueue_delete(bqueue_t *queue) {
+    if (!queue) return;
+    free(queue->data);
+    free(queue);
+}
@@ -0,0 +1,412 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <cdict.h>
+#include <hash.h>
+
+#define CDICT_DEFAULT_SZ 1024
+#define CDICT_DEFAULT_STRIPES 64
+#define MAX_STRIPES (1 << 16)  // Stripes use bits 48 and up of the hash.
+#define MIN_STRIPE_SZ 8
+#define LOAD_FACTOR 0.75
+#define SHRINK_FACTOR 0.125    // Tables shrink when the load drops below this.
+#define RECLAIM_THRESHOLD 64   // Retired allocations per stripe between reclaims.
+#define CACHE_LINE 64
+
+#define load_relaxed(p)      __atomic_load_n((p), __ATOMIC_RELAXED)
+#define load_acquire(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define store_relaxed(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define store_release(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+// Nodes never change after they are published, except for `next`. The key is
+// stored in the same allocation.
+typedef struct _cdict_node {
+    struct _cdict_node *next;
+    dict_value_t value;
+    uint64_t hash;
+    size_t len;
+    char key[];
+} cdict_node_t;
+
+// The size is kept with the buckets so that readers load both at once.
+typedef struct {
+    size_t size;
+    cdict_node_t *buckets[];
+} table_t;
+
+// An allocation that lookups may still be reading. It is freed once every
+// lookup that started at or before `epoch` has finished.
+typedef struct _retired {
+    void *ptr;
+    uint64_t epoch;
+    struct _retired *next;
+} retired_t;
+
+// Each stripe sits on its own cache lines, so writers on different stripes
+// don't share any.
+typedef struct {
+    pthread_mutex_t lock; // Held by writers.
+    uint32_t seq;         // Odd while a resize moves nodes between chains.
+    table_t *table;
+    size_t min_size;      // The table never shrinks below this size.
+    size_t size;
+    retired_t *retired;
+    size_t n_retired;
+    size_t reclaim_at;
+} __attribute__((aligned(CACHE_LINE))) stripe_t;
+
+struct _cdict {
+    stripe_t *stripes;
+    size_t n_stripes;
+    uint64_t seed;
+};
+
+#define stripe_of(cdict, hash) (&(cdict)->stripes[((hash) >> 48) & ((cdict)->n_stripes - 1)])
+#define bucket_of(hash, size) ((hash) & ((size) - 1))
+#define node_matches(n, k, h, l) \
+    ((n)->hash == (h) && (n)->len == (l) && !memcmp((n)->key, (k), (l)))
+
+/* Epoch based reclamation */
+
+// The epoch in which the lookup of a thread started, 0 while it isn't in one.
+typedef struct {
+    uint64_t epoch;
+    bool in_use;
+} __attribute__((aligned(CACHE_LINE))) reader_t;
+
+static reader_t readers[CDICT_MAX_THREADS];
+static uint64_t global_epoch = 1;
+
+static pthread_key_t reader_key;
+static pthread_once_t reader_once = PTHREAD_ONCE_INIT;
+static _Thread_local reader_t *self = NULL;
+static _Thread_local bool no_slot = false;
+
+static void release_reader(void *reader) {
+    store_release(&((reader_t *)reader)->in_use, false);
+}
+
+static void init_reader_key() {
+    pthread_key_create(&reader_key, release_reader);
+}
+
+// Gets the reader slot of the calling thread, taking one on its first lookup.
+// Returns NULL if every slot is taken.
+static reader_t *get_reader() {
+    if (self || no_slot) return self;
+
+    pthread_once(&reader_once, init_reader_key);
+    for (int i = 0; i < CDICT_MAX_THREADS; i++) {
+        bool expected = false;
+        if (__atomic_compare_exchange_n(&readers[i].in_use, &expected, true, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            self = &readers[i];
+            pthread_setspecific(reader_key, self);
+            return self;
+        }
+    }
+    no_slot = true;
+    return NULL;
+}
+
+static inline void reader_enter(reader_t *reader) {
+    store_relaxed(&reader->epoch, __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST));
+    // The epoch must be visible before any node is read.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void reader_exit(reader_t *reader) {
+    store_release(&reader->epoch, 0);
+}
+
+// Smallest epoch among the lookups in progress.
+static uint64_t min_reader_epoch() {
+    uint64_t min = UINT64_MAX;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    for (int i = 0; i < CDICT_MAX_THREADS; i++) {
+        if (!load_acquire(&readers[i].in_use)) continue;
+
+        uint64_t epoch = load_acquire(&readers[i].epoch);
+        if (epoch && epoch < min) min = epoch;
+    }
+    return min;
+}
+
+static void reclaim(stripe_t *stripe) {
+    uint64_t min = min_reader_epoch();
+    retired_t **link = &stripe->retired;
+    while (*link) {
+        retired_t *retired = *link;
+        if (retired->epoch < min) {
+            *link = retired->next;
+            free(retired->ptr);
+            free(retired);
+            stripe->n_retired--;
+        } else {
+            link = &retired->next;
+        }
+    }
+    stripe->reclaim_at = stripe->n_retired + RECLAIM_THRESHOLD;
+}
+
+// Frees an allocation that is no longer reachable once no lookup can still be
+// reading it. The stripe lock must be held.
+static void retire(stripe_t *stripe, void *ptr) {
+    retired_t *retired = (retired_t *)malloc(sizeof(retired_t));
+    retired->ptr = ptr;
+    // Lookups that start from now on have a larger epoch and can't reach ptr.
+    retired->epoch = __atomic_fetch_add(&global_epoch, 1, __ATOMIC_SEQ_CST);
+    retired->next = stripe->retired;
+    stripe->retired = retired;
+    stripe->n_retired++;
+
+    if (stripe->n_retired >= stripe->reclaim_at) reclaim(stripe);
+}
+
+/* Stripes */
+
+static inline size_t pow2_ceil(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+static table_t *alloc_table(size_t size) {
+    table_t *table = (table_t *)calloc(1, sizeof(table_t) + size * sizeof(cdict_node_t *));
+    table->size = size;
+    return table;
+}
+
+static cdict_node_t *find_node(table_t *table, char *key, uint64_t hash, size_t len) {
+    cdict_node_t *node = load_acquire(&table->buckets[bucket_of(hash, table->size)]);
+    for (; node; node = load_acquire(&node->next))
+        if (node_matches(node, key, hash, len)) return node;
+
+    return NULL;
+}
+
+// Moves every node to a new table. Lookups that run meanwhile may miss keys
+// whose nodes are being moved, the odd sequence number tells them to retry.
+static void resize(stripe_t *stripe, size_t new_size) {
+    table_t *old = stripe->table;
+    table_t *new = alloc_table(new_size);
+    uint32_t seq = stripe->seq;
+
+    store_relaxed(&stripe->seq, seq + 1);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    for (size_t i = 0; i < old->size; i++) {
+        cdict_node_t *node = old->buckets[i], *next;
+        for (; node; node = next) {
+            next = node->next;
+            size_t idx = bucket_of(node->hash, new_size);
+            store_release(&node->next, new->buckets[idx]);
+            new->buckets[idx] = node;
+        }
+    }
+
+    store_release(&stripe->table, new);
+    store_release(&stripe->seq, seq + 2);
+    retire(stripe, old);
+}
+
+static void maybe_grow(stripe_t *stripe) {
+    size_t cap = stripe->table->size;
+    if ((float)stripe->size + 1. > (float)cap * LOAD_FACTOR) resize(stripe, cap * 2);
+}
+
+// Shrinks the table once it is mostly empty, leaving room for twice as many
+// entries to avoid resizing back and forth.
+static void maybe_shrink(stripe_t *stripe) {
+    size_t cap = stripe->table->size;
+    if (cap <= stripe->min_size || (float)stripe->size >= (float)cap * SHRINK_FACTOR) return;
+
+    size_t new_size = stripe->min_size;
+    while ((float)stripe->size * 2 > (float)new_size * LOAD_FACTOR) new_size <<= 1;
+    if (new_size < cap) resize(stripe, new_size);
+}
+
+// Looks a key up without taking the stripe lock (unless the thread has no
+// reader slot).
+static bool lookup(cdict_t *cdict, char *key, dict_value_t *value) {
+    size_t len = strlen(key);
+    uint64_t hash = HASH_DEFAULT(key, len, cdict->seed);
+    stripe_t *stripe = stripe_of(cdict, hash);
+    cdict_node_t *node;
+
+    reader_t *reader = get_reader();
+    if (!reader) {
+        pthread_mutex_lock(&stripe->lock);
+        node = find_node(stripe->table, key, hash, len);
+        if (node) *value = node->value;
+        pthread_mutex_unlock(&stripe->lock);
+        return node != NULL;
+    }
+
+    reader_enter(reader);
+    for (;;) {
+        uint32_t seq = load_acquire(&stripe->seq);
+        if (seq & 1) {
+            sched_yield();
+            continue;
+        }
+
+        // A node that is found is always an entry of the dict, only misses
+        // must be validated against resizes.
+        node = find_node(load_acquire(&stripe->table), key, hash, len);
+        if (node) {
+            *value = node->value;
+            break;
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (load_relaxed(&stripe->seq) == seq) break;
+    }
+    reader_exit(reader);
+    return node != NULL;
+}
+
+/* Public interface */
+
+cdict_t *cdict_create_with(cdict_opts_t opts) {
+    size_t n_stripes = pow2_ceil(opts.stripes > 0 ? opts.stripes : CDICT_DEFAULT_STRIPES);
+    if (n_stripes > MAX_STRIPES) n_stripes = MAX_STRIPES;
+
+    size_t size = pow2_ceil((opts.size > 0 ? opts.size : CDICT_DEFAULT_SZ) / n_stripes);
+    if (size < MIN_STRIPE_SZ) size = MIN_STRIPE_SZ;
+
+    cdict_t *cdict = (cdict_t *)malloc(sizeof(cdict_t));
+    cdict->n_stripes = n_stripes;
+    cdict->seed = hash_random_seed();
+    cdict->stripes = (stripe_t *)aligned_alloc(CACHE_LINE, n_stripes * sizeof(stripe_t));
+    for (size_t i = 0; i < n_stripes; i++) {
+        stripe_t *stripe = &cdict->stripes[i];
+        pthread_mutex_init(&stripe->lock, NULL);
+        stripe->seq = 0;
+        stripe->table = alloc_table(size);
+        stripe->min_size = size;
+        stripe->size = 0;
+        stripe->retired = NULL;
+        stripe->n_retired = 0;
+        stripe->reclaim_at = RECLAIM_THRESHOLD;
+    }
+    return cdict;
+}
+
+cdict_t *cdict_create() {
+    return cdict_create_with(CDICT_OPTS());
+}
+
+dict_value_t cdict_get(cdict_t *cdict, char *key) {
+    dict_value_t value;
+    return lookup(cdict, key, &value) ? value : NULL;
+}
+
+bool cdict_contains(cdict_t *cdict, char *key) {
+    dict_value_t value;
+    return lookup(cdict, key, &value);
+}
+
+size_t cdict_get_size(cdict_t *cdict) {
+    size_t size = 0;
+    for (size_t i = 0; i < cdict->n_stripes; i++)
+        size += load_relaxed(&cdict->stripes[i].size);
+
+    return size;
+}
+
+bool cdict_insert(cdict_t *cdict, char *key, dict_value_t value) {
+    size_t len = strlen(key);
+    uint64_t hash = HASH_DEFAULT(key, len, cdict->seed);
+    stripe_t *stripe = stripe_of(cdict, hash);
+
+    pthread_mutex_lock(&stripe->lock);
+    if (find_node(stripe->table, key, hash, len)) {
+        pthread_mutex_unlock(&stripe->lock);
+        return false;
+    }
+    maybe_grow(stripe);
+
+    cdict_node_t *node = (cdict_node_t *)malloc(sizeof(cdict_node_t) + len + 1);
+    memcpy(node->key, key, len + 1);
+    node->value = value;
+    node->hash = hash;
+    node->len = len;
+
+    // The node is complete before it becomes reachable.
+    cdict_node_t **bucket = &stripe->table->buckets[bucket_of(hash, stripe->table->size)];
+    node->next = *bucket;
+    store_release(bucket, node);
+    store_relaxed(&stripe->size, stripe->size + 1);
+
+    pthread_mutex_unlock(&stripe->lock);
+    return true;
+}
+
+// Unlinks the node of a key. Lookups that are walking the chain may still
+// reach it, so it is retired instead of freed.
+static bool remove_node(cdict_t *cdict, char *key, dict_value_t *value) {
+    size_t len = strlen(key);
+    uint64_t hash = HASH_DEFAULT(key, len, cdict->seed);
+    stripe_t *stripe = stripe_of(cdict, hash);
+
+    pthread_mutex_lock(&stripe->lock);
+    cdict_node_t **link = &stripe->table->buckets[bucket_of(hash, stripe->table->size)];
+    for (; *link && !node_matches(*link, key, hash, len); link = &(*link)->next);
+
+    cdict_node_t *node = *link;
+    if (node) {
+        *value = node->value;
+        store_release(link, node->next);
+        store_relaxed(&stripe->size, stripe->size - 1);
+        retire(stripe, node);
+        maybe_shrink(stripe);
+    }
+    pthread_mutex_unlock(&stripe->lock);
+    return node != NULL;
+}
+
+dict_value_t cdict_remove_entry(cdict_t *cdict, char *key) {
+    dict_value_t value;
+    return remove_node(cdict, key, &value) ? value : NULL;
+}
+
+bool cdict_remove(cdict_t *cdict, char *key, free_fn_t free_fn) {
+    dict_value_t value;
+    if (!remove_node(cdict, key, &value)) return false;
+
+    if (free_fn) free_fn(value);
+    return true;
+}
+
+void cdict_delete(cdict_t *cdict, free_fn_t free_fn) {
+    if (!cdict) return;
+
+    for (size_t i = 0; i < cdict->n_stripes; i++) {
+        stripe_t *stripe = &cdict->stripes[i];
+        table_t *table = stripe->table;
+        for (size_t j = 0; j < table->size; j++) {
+            cdict_node_t *node = table->buckets[j], *next;
+            for (; node; node = next) {
+                next = node->next;
+                if (free_fn) free_fn(node->value);
+                free(node);
+            }
+        }
+        free(table);
+
+        retired_t *retired = stripe->retired, *next;
+        for (; retired; retired = next) {
+            next = retired->next;
+            free(retired->ptr);
+            free(retired);
+        }
+        pthread_mutex_destroy(&stripe->lock);
+    }
+    free(cdict->stripes);
+    free(cdict);
+}
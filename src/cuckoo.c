@@ -0,0 +1,194 @@
+/**
+ * Cuckoo filter (see filter.h).
+ *
+ * The table has a power of two number of buckets, each a 64 bit word with 4
+ * fingerprints of 16 bits (0 marks an empty slot). A key with fingerprint f may
+ * be in bucket i1, picked from its hash, or i2 = i1 ^ hash(f). Since i1 can be
+ * found back from i2 and f alone, a full bucket makes room by moving one of its
+ * fingerprints to its other bucket, up to MAX_KICKS times.
+ *
+ * A bucket is compared with a fingerprint with a few word operations, finding
+ * the zero 16 bit lanes of bucket ^ (f in every lane).
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <filter.h>
+
+#define SLOTS 4        // Fingerprints per bucket.
+#define MAX_LOAD 0.95  // Load at which inserting starts to fail.
+#define MAX_KICKS 500  // Fingerprints moved before giving up on an insertion.
+
+#define LANES 0x0001000100010001ULL
+#define HIGH_BITS 0x8000800080008000ULL
+
+struct _cuckoo {
+    uint64_t *buckets;
+    size_t n_buckets;
+    size_t size;
+    hash_fn_t hash;
+    uint64_t seed;
+    uint64_t rng; // Picks the fingerprints that are moved.
+    // A fingerprint (and one of its buckets) that had no room left after
+    // MAX_KICKS moves. While there is one, the filter is full.
+    uint16_t victim;
+    size_t victim_idx;
+};
+
+// Bit 15 of a lane is set if the lane of the bucket is `fp`. Lanes above a
+// match may be set too, but the lowest set bit is always exact.
+static inline uint64_t bucket_match(uint64_t bucket, uint16_t fp) {
+    uint64_t x = bucket ^ (LANES * fp);
+    return (x - LANES) & ~x & HIGH_BITS;
+}
+
+static inline uint16_t fingerprint(uint64_t hash) {
+    uint16_t fp = (uint16_t)(hash >> 48);
+    return fp ? fp : 1;
+}
+
+static inline size_t alt_index(cuckoo_t *cuckoo, size_t idx, uint16_t fp) {
+    return (idx ^ (fp * 0x5bd1e995UL)) & (cuckoo->n_buckets - 1);
+}
+
+// Puts a fingerprint in an empty slot of a bucket, if there is one.
+static bool bucket_put(cuckoo_t *cuckoo, size_t idx, uint16_t fp) {
+    uint64_t empty = bucket_match(cuckoo->buckets[idx], 0);
+    if (!empty) return false;
+
+    int shift = __builtin_ctzll(empty) - 15;
+    cuckoo->buckets[idx] |= (uint64_t)fp << shift;
+    return true;
+}
+
+// Clears one slot of a bucket with a fingerprint, if there is one.
+static bool bucket_take(cuckoo_t *cuckoo, size_t idx, uint16_t fp) {
+    uint64_t match = bucket_match(cuckoo->buckets[idx], fp);
+    if (!match) return false;
+
+    int shift = __builtin_ctzll(match) - 15;
+    cuckoo->buckets[idx] &= ~(0xffffULL << shift);
+    return true;
+}
+
+static inline uint64_t next_random(cuckoo_t *cuckoo) {
+    cuckoo->rng ^= cuckoo->rng << 13;
+    cuckoo->rng ^= cuckoo->rng >> 7;
+    cuckoo->rng ^= cuckoo->rng << 17;
+    return cuckoo->rng;
+}
+
+// Places a fingerprint in one of its buckets, moving others out of the way.
+// If there is still no room in the end, the last fingerprint moved becomes the
+// victim.
+static void place(cuckoo_t *cuckoo, size_t idx, uint16_t fp) {
+    if (bucket_put(cuckoo, idx, fp) || bucket_put(cuckoo, alt_index(cuckoo, idx, fp), fp))
+        return;
+
+    if (next_random(cuckoo) & 1) idx = alt_index(cuckoo, idx, fp);
+    for (int kick = 0; kick < MAX_KICKS; kick++) {
+        int shift = (next_random(cuckoo) % SLOTS) * 16;
+        uint16_t evicted = (uint16_t)(cuckoo->buckets[idx] >> shift);
+        cuckoo->buckets[idx] ^= (uint64_t)(evicted ^ fp) << shift;
+
+        fp = evicted;
+        idx = alt_index(cuckoo, idx, fp);
+        if (bucket_put(cuckoo, idx, fp)) return;
+    }
+    cuckoo->victim = fp;
+    cuckoo->victim_idx = idx;
+}
+
+cuckoo_t *cuckoo_create_with(cuckoo_opts_t opts) {
+    cuckoo_t *cuckoo = (cuckoo_t *)malloc(sizeof(cuckoo_t));
+    size_t n = opts.n > 0 ? opts.n : 1;
+
+    cuckoo->n_buckets = 1;
+    while ((double)cuckoo->n_buckets * SLOTS * MAX_LOAD < (double)n) cuckoo->n_buckets <<= 1;
+    cuckoo->buckets = (uint64_t *)calloc(cuckoo->n_buckets, sizeof(uint64_t));
+    cuckoo->size = 0;
+    cuckoo->hash = opts.hash ? opts.hash : HASH_DEFAULT;
+    cuckoo->seed = opts.seed ? opts.seed : hash_random_seed();
+    cuckoo->rng = cuckoo->seed | 1;
+    cuckoo->victim = 0;
+    cuckoo->victim_idx = 0;
+    return cuckoo;
+}
+
+cuckoo_t *cuckoo_from_hashset(hashset_t *hashset) {
+    cuckoo_opts_t opts = CUCKOO_OPTS(.n = hashset_get_size(hashset) * 2);
+    hashset_get_hash(hashset, &opts.hash, &opts.seed);
+    cuckoo_t *cuckoo = cuckoo_create_with(opts);
+
+    char *key;
+    for (hashset_iter_t it = hashset_iter(hashset); hashset_iter_next(&it, &key);)
+        cuckoo_insert(cuckoo, key);
+
+    return cuckoo;
+}
+
+bool cuckoo_insert_hash(cuckoo_t *cuckoo, uint64_t hash) {
+    if (cuckoo->victim) return false;
+
+    hash = hash_mix(hash);
+    place(cuckoo, hash & (cuckoo->n_buckets - 1), fingerprint(hash));
+    cuckoo->size++;
+    return true;
+}
+
+bool cuckoo_contains_hash(cuckoo_t *cuckoo, uint64_t hash) {
+    hash = hash_mix(hash);
+    uint16_t fp = fingerprint(hash);
+    size_t i1 = hash & (cuckoo->n_buckets - 1), i2 = alt_index(cuckoo, i1, fp);
+
+    if (bucket_match(cuckoo->buckets[i1], fp) || bucket_match(cuckoo->buckets[i2], fp))
+        return true;
+
+    return cuckoo->victim == fp && (cuckoo->victim_idx == i1 || cuckoo->victim_idx == i2);
+}
+
+bool cuckoo_remove_hash(cuckoo_t *cuckoo, uint64_t hash) {
+    hash = hash_mix(hash);
+    uint16_t fp = fingerprint(hash);
+    size_t i1 = hash & (cuckoo->n_buckets - 1), i2 = alt_index(cuckoo, i1, fp);
+
+    if (cuckoo->victim == fp && (cuckoo->victim_idx == i1 || cuckoo->victim_idx == i2)) {
+        cuckoo->victim = 0;
+    } else if (bucket_take(cuckoo, i1, fp) || bucket_take(cuckoo, i2, fp)) {
+        // There is room now, so the victim may find a slot.
+        if (cuckoo->victim) {
+            uint16_t victim = cuckoo->victim;
+            cuckoo->victim = 0;
+            place(cuckoo, cuckoo->victim_idx, victim);
+        }
+    } else {
+        return false;
+    }
+    cuckoo->size--;
+    return true;
+}
+
+bool cuckoo_insert(cuckoo_t *cuckoo, char *key) {
+    return cuckoo_insert_hash(cuckoo, cuckoo->hash(key, strlen(key), cuckoo->seed));
+}
+
+bool cuckoo_contains(cuckoo_t *cuckoo, char *key) {
+    return cuckoo_contains_hash(cuckoo, cuckoo->hash(key, strlen(key), cuckoo->seed));
+}
+
+bool cuckoo_remove(cuckoo_t *cuckoo, char *key) {
+    return cuckoo_remove_hash(cuckoo, cuckoo->hash(key, strlen(key), cuckoo->seed));
+}
+
+size_t cuckoo_get_size(cuckoo_t *cuckoo) { return cuckoo->size; }
+
+size_t cuckoo_get_bits(cuckoo_t *cuckoo) { return cuckoo->n_buckets * SLOTS * 16; }
+
+void cuckoo_delete(cuckoo_t *cuckoo) {
+    if (!cuckoo) return;
+    free(cuckoo->buckets);
+    free(cuckoo);
+}
@@ -5,66 +5,374 @@
 #include <string.h>
 
 #include <dict.h>
+#include <dict_internal.h>
+#include <scan_cursor.h>
 
-#define DICT_DEFAULT_SZ 16
 #define LOAD_FACTOR 0.75
+#define REHASH_STEP 4          // Buckets moved per operation on incremental mode.
+#define REHASH_EMPTY_VISITS 10 // Empty buckets skipped per bucket moved.
+#define SHRINK_FACTOR 0.125    // Tables shrink when the load drops below this.
+#define ARENA_SLAB_SZ 256      // First slab of the arena, most dicts are small.
 
-struct _dict_entry {
-    char *key;
-    dict_value_t value;
-    dict_entry_t *next;
-};
-
-struct _dict {
-    dict_entry_t **entries;
-    size_t max_size;
-    size_t size;
-};
-
-static size_t hash(char *str);
-static dict_entry_t *mk_entry(char *key, dict_value_t value, dict_entry_t *next);
-
-// TODO: Forma de diminuir tamanho além de aumentar.
-static void maybe_resize(dict_t *dict) {
-    if ((float)dict->size + 1. <= (float)dict->max_size * LOAD_FACTOR) return;
-
-    dict_t *new_dict = dict_create_sized(dict->max_size * 2);
-    for (int i = 0; i < dict->max_size; i++) {
-        dict_entry_t *entry, *tmp;
-        for (entry = dict->entries[i]; entry; entry = tmp) {
-            tmp = entry->next;
-            size_t idx = hash(entry->key) % new_dict->max_size;
-            entry->next = new_dict->entries[idx];
-            new_dict->entries[idx] = entry;
+static dict_node_t *mk_node(dict_t *dict, char *key, uint64_t hash, size_t len,
+                            dict_value_t value, dict_node_t *next);
+
+/* DICT_CHAINED engine */
+
+#define is_rehashing(dict) ((dict)->new_buckets != NULL)
+#define bucket_of(hash, size) ((hash) & ((size) - 1))
+
+static inline size_t pow2_ceil(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+// Smallest table size that holds `n` entries within the load factor.
+static size_t chained_capacity_for(size_t n) {
+    size_t cap = DICT_DEFAULT_SZ;
+    while ((float)n > (float)cap * LOAD_FACTOR) cap <<= 1;
+    return cap;
+}
+
+static void chained_init(dict_t *dict, size_t size) {
+    dict->max_size = pow2_ceil(size);
+    dict->min_size = dict->max_size;
+    dict->buckets = (dict_node_t **)calloc(dict->max_size, sizeof(dict_node_t *));
+    dict->new_buckets = NULL;
+    dict->new_size = 0;
+    dict->rehash_idx = 0;
+}
+
+// Moves every node of a bucket in the old table to the new table.
+static void move_bucket(dict_t *dict, size_t i) {
+    dict_node_t *node, *tmp;
+    for (node = dict->buckets[i]; node; node = tmp) {
+        tmp = node->next;
+        size_t idx = bucket_of(node->entry.hash, dict->new_size);
+        node->next = dict->new_buckets[idx];
+        dict->new_buckets[idx] = node;
+    }
+    dict->buckets[i] = NULL;
+}
+
+static void rehash_finish(dict_t *dict) {
+    free(dict->buckets);
+    dict->buckets = dict->new_buckets;
+    dict->max_size = dict->new_size;
+    dict->new_buckets = NULL;
+    dict->new_size = 0;
+    dict->rehash_idx = 0;
+}
+
+// Moves up to `n` non empty buckets to the new table. To bound the work done,
+// at most REHASH_EMPTY_VISITS empty buckets are skipped per bucket moved.
+static void rehash_step(dict_t *dict, int n) {
+    int empty_visits = n * REHASH_EMPTY_VISITS;
+    while (n > 0 && dict->rehash_idx < dict->max_size) {
+        if (!dict->buckets[dict->rehash_idx]) {
+            dict->rehash_idx++;
+            if (--empty_visits == 0) break;
+            continue;
         }
+        move_bucket(dict, dict->rehash_idx++);
+        n--;
     }
-    free(dict->entries);
-    dict->max_size = new_dict->max_size;
-    dict->entries = new_dict->entries;
-    free(new_dict);
+    if (dict->rehash_idx == dict->max_size) rehash_finish(dict);
 }
 
-dict_t *dict_create_sized(size_t size) {
-    dict_t *dict = (dict_t *)malloc(sizeof(dict_t));
-    dict->max_size = size;
+static void rehash_all(dict_t *dict) {
+    for (; dict->rehash_idx < dict->max_size; dict->rehash_idx++)
+        move_bucket(dict, dict->rehash_idx);
+
+    rehash_finish(dict);
+}
+
+// Starts moving the entries to a table with `new_size` buckets. Unless the dict
+// is incremental, every entry is moved right away.
+static void chained_resize(dict_t *dict, size_t new_size) {
+    if (is_rehashing(dict)) rehash_all(dict);
+
+    dict->new_buckets = (dict_node_t **)calloc(new_size, sizeof(dict_node_t *));
+    dict->new_size = new_size;
+    dict->rehash_idx = 0;
+
+    if (!dict->incremental) rehash_all(dict);
+}
+
+// Resizes and moves every entry right away, even in incremental mode.
+static void chained_resize_now(dict_t *dict, size_t new_size) {
+    chained_resize(dict, new_size);
+    if (is_rehashing(dict)) rehash_all(dict);
+}
+
+// Size of the table that will hold the entries once any rehash is done.
+static size_t chained_capacity(dict_t *dict) {
+    return is_rehashing(dict) ? dict->new_size : dict->max_size;
+}
+
+static void chained_maybe_resize(dict_t *dict) {
+    size_t cap = chained_capacity(dict);
+    if ((float)dict->size + 1. <= (float)cap * LOAD_FACTOR) return;
+
+    chained_resize(dict, cap * 2);
+}
+
+// Shrinks the table once it is mostly empty. The new table still has room for
+// twice as many entries, so the table does not keep growing and shrinking when
+// the size goes back and forth around the threshold.
+static void chained_maybe_shrink(dict_t *dict) {
+    if (is_rehashing(dict) || dict->max_size <= dict->min_size) return;
+    if ((float)dict->size >= (float)dict->max_size * SHRINK_FACTOR) return;
+
+    size_t new_size = chained_capacity_for(dict->size * 2);
+    if (new_size < dict->min_size) new_size = dict->min_size;
+    if (new_size < dict->max_size) chained_resize(dict, new_size);
+}
+
+static void chained_reserve(dict_t *dict, size_t n) {
+    size_t cap = chained_capacity_for(n);
+    if (cap > dict->min_size) dict->min_size = cap;
+    if (cap > chained_capacity(dict)) chained_resize_now(dict, cap);
+}
+
+static void chained_shrink_to_fit(dict_t *dict) {
+    size_t cap = chained_capacity_for(dict->size);
+    dict->min_size = DICT_DEFAULT_SZ;
+    if (cap < chained_capacity(dict)) chained_resize_now(dict, cap);
+}
+
+// Walks a chain and returns the link that points to the node with the key, or
+// the link at the end of the chain if there is no such node.
+static dict_node_t **find_link(dict_node_t **link, char *key, uint64_t hash, size_t len) {
+    for (; *link && !entry_matches(&(*link)->entry, key, hash, len);
+         link = &(*link)->next);
+
+    return link;
+}
+
+// Finds the link to the node with a key in whichever table it is.
+static dict_node_t **chained_find(dict_t *dict, char *key, uint64_t hash, size_t len) {
+    if (is_rehashing(dict)) rehash_step(dict, REHASH_STEP);
+
+    dict_node_t **link = NULL;
+    size_t idx = bucket_of(hash, dict->max_size);
+    // Buckets before rehash_idx were already moved to the new table.
+    if (!is_rehashing(dict) || idx >= dict->rehash_idx)
+        link = find_link(&dict->buckets[idx], key, hash, len);
+
+    if ((!link || !*link) && is_rehashing(dict))
+        link = find_link(&dict->new_buckets[bucket_of(hash, dict->new_size)], key, hash, len);
+
+    return link;
+}
+
+static dict_entry_t *chained_get_entry(dict_t *dict, char *key, uint64_t hash, size_t len) {
+    dict_node_t *node = *chained_find(dict, key, hash, len);
+    return node ? &node->entry : NULL;
+}
+
+// Looks up a batch of hashed keys. Each pass only issues prefetches for the
+// next memory access of every key (bucket, node, key of the node), so the
+// cache misses of different keys overlap instead of happening one by one.
+static size_t chained_get_batch(dict_t *dict, char **keys, uint64_t *hashes,
+                                size_t *lens, size_t n, dict_value_t *out) {
+    size_t found = 0;
+    if (is_rehashing(dict)) {
+        // Entries may be in either table, the table is only like this for a
+        // short while so keys are just looked up one at a time.
+        for (size_t i = 0; i < n; i++) {
+            dict_entry_t *entry = chained_get_entry(dict, keys[i], hashes[i], lens[i]);
+            out[i] = entry ? entry->value : NULL;
+            found += entry != NULL;
+        }
+        return found;
+    }
+
+    dict_node_t **heads[DICT_BATCH_SZ];
+    for (size_t i = 0; i < n; i++) {
+        heads[i] = &dict->buckets[bucket_of(hashes[i], dict->max_size)];
+        __builtin_prefetch(heads[i]);
+    }
+    for (size_t i = 0; i < n; i++)
+        if (*heads[i]) __builtin_prefetch(*heads[i]);
+
+    for (size_t i = 0; i < n; i++)
+        if (*heads[i] && (*heads[i])->entry.hash == hashes[i])
+            __builtin_prefetch((*heads[i])->entry.key);
+
+    for (size_t i = 0; i < n; i++) {
+        dict_node_t *node = *find_link(heads[i], keys[i], hashes[i], lens[i]);
+        out[i] = node ? node->entry.value : NULL;
+        found += node != NULL;
+    }
+    return found;
+}
+
+static bool chained_insert(dict_t *dict, char *key, uint64_t hash, size_t len,
+                           dict_value_t value) {
+    if (*chained_find(dict, key, hash, len)) return false;
+
+    chained_maybe_resize(dict);
+    // While rehashing, new entries always go to the new table.
+    dict_node_t **bucket = is_rehashing(dict)
+        ? &dict->new_buckets[bucket_of(hash, dict->new_size)]
+        : &dict->buckets[bucket_of(hash, dict->max_size)];
+
+    *bucket = mk_node(dict, dict_key_dup(dict, key, len), hash, len, value, *bucket);
+    dict->size++;
+    return true;
+}
+
+static dict_value_t chained_remove_entry(dict_t *dict, char *key, uint64_t hash, size_t len) {
+    dict_node_t **link = chained_find(dict, key, hash, len);
+    dict_node_t *del = *link;
+    if (!del) return NULL;
+
+    *link = del->next;
+    dict_value_t value = del->entry.value;
+    dict_key_free(dict, del->entry.key);
+    if (!dict->use_arena) free(del);
+    dict->size--;
+    chained_maybe_shrink(dict);
+    return value;
+}
+
+static void free_buckets(dict_t *dict, dict_node_t **buckets, size_t size, free_fn_t free_fn) {
+    // Nodes and keys in an arena are freed with it, so there is nothing to
+    // walk unless the values must be freed.
+    if (dict->use_arena && !free_fn) {
+        free(buckets);
+        return;
+    }
+
+    dict_node_t *node, *tmp = NULL;
+    for (int i = 0; i < size; i++) {
+        for (node = buckets[i]; node; node = tmp) {
+            if (free_fn) free_fn(node->entry.value);
+            tmp = node->next;
+            if (!dict->use_arena) {
+                free(node->entry.key);
+                free(node);
+            }
+        }
+    }
+    free(buckets);
+}
+
+static void chained_delete(dict_t *dict, free_fn_t free_fn) {
+    free_buckets(dict, dict->buckets, dict->max_size, free_fn);
+    if (is_rehashing(dict))
+        free_buckets(dict, dict->new_buckets, dict->new_size, free_fn);
+}
+
+static dict_entry_t *chained_iter_next(dict_iter_t *it) {
+    dict_t *dict = it->dict;
+    dict_node_t *node = it->node ? ((dict_node_t *)it->node)->next : NULL;
+    while (!node && it->idx < dict->max_size)
+        node = dict->buckets[it->idx++];
+
+    it->node = node;
+    return node ? &node->entry : NULL;
+}
+
+static size_t scan_bucket(dict_node_t *node, dict_scan_fn_t fn, void *ctx) {
+    size_t n = 0;
+    for (; node; node = node->next, n++)
+        fn(node->entry.key, node->entry.value, ctx);
+
+    return n;
+}
+
+// While rehashing, buckets of the old table before rehash_idx are empty, so
+// both tables are scanned: the bucket of the cursor in the smaller table and
+// every bucket of the larger table that it splits into.
+static size_t chained_scan(dict_t *dict, size_t cursor, size_t count,
+                           dict_scan_fn_t fn, void *ctx) {
+    size_t visited = 0;
+    do {
+        if (!is_rehashing(dict)) {
+            size_t mask = dict->max_size - 1;
+            visited += scan_bucket(dict->buckets[cursor & mask], fn, ctx);
+            cursor = cursor_next(cursor, mask);
+            continue;
+        }
+
+        dict_node_t **small = dict->buckets, **large = dict->new_buckets;
+        size_t small_mask = dict->max_size - 1, large_mask = dict->new_size - 1;
+        if (dict->new_size < dict->max_size) {
+            small = dict->new_buckets;
+            large = dict->buckets;
+            small_mask = dict->new_size - 1;
+            large_mask = dict->max_size - 1;
+        }
+
+        visited += scan_bucket(small[cursor & small_mask], fn, ctx);
+        do {
+            visited += scan_bucket(large[cursor & large_mask], fn, ctx);
+            cursor = cursor_next(cursor, large_mask);
+        } while (cursor & (small_mask ^ large_mask));
+    } while (cursor != 0 && visited < count);
+
+    return cursor;
+}
+
+/* Public interface */
+
+dict_t *dict_create_with(dict_opts_t opts) {
+    size_t size = opts.size > 0 ? opts.size : DICT_DEFAULT_SZ;
+    size_t inline_size = opts.kind == DICT_ORDERED ? dict_ordered_inline_size(size) : 0;
+    dict_t *dict = (dict_t *)malloc(sizeof(dict_t) + inline_size);
+    dict->kind = opts.kind;
+    dict->incremental = opts.incremental;
+    dict->hash = opts.hash ? opts.hash : HASH_DEFAULT;
+    dict->seed = opts.seed ? opts.seed : hash_random_seed();
+    dict->use_arena = opts.arena;
+    dict->arena = NULL;
     dict->size = 0;
-    dict->entries = (dict_entry_t **)calloc(size, sizeof(dict_entry_t *));
+
+    switch (dict->kind) {
+        case DICT_ORDERED:
+            dict_ordered_init(dict, size);
+            break;
+
+        case DICT_OPEN:
+            dict_open_init(dict, size);
+            break;
+
+        case DICT_CHAINED:
+        default:
+            chained_init(dict, size);
+            break;
+    }
     return dict;
 }
 
+dict_t *dict_create_sized(size_t size) {
+    return dict_create_with(DICT_OPTS(.size = size));
+}
+
 dict_t *dict_create() {
-    return dict_create_sized(DICT_DEFAULT_SZ);
+    return dict_create_with(DICT_OPTS(.size = DICT_DEFAULT_SZ));
 }
 
+dict_kind_t dict_get_kind(dict_t *dict) { return dict->kind; }
+
 dict_entry_t *dict_get_entry(dict_t *dict, char *key) {
-    size_t idx = hash(key) % dict->max_size;
+    size_t len;
+    uint64_t hash = dict_hash(dict, key, &len);
 
-    dict_entry_t *entry;
-    for (entry = dict->entries[idx];
-         entry && strcmp(entry->key, key);
-         entry = entry->next);
+    switch (dict->kind) {
+        case DICT_ORDERED:
+            return dict_ordered_get_entry(dict, key, hash, len);
+
+        case DICT_OPEN:
+            return dict_open_get_entry(dict, key, hash, len);
 
-    return entry;
+        case DICT_CHAINED:
+        default:
+            return chained_get_entry(dict, key, hash, len);
+    }
 }
 
 dict_value_t dict_get(dict_t *dict, char *key) {
@@ -74,96 +382,226 @@ dict_value_t dict_get(dict_t *dict, char *key) {
 }
 
 bool dict_contains(dict_t *dict, char *key) {
-    if (dict_get(dict, key)) return true;
+    if (dict_get_entry(dict, key)) return true;
     return false;
 }
 
+size_t dict_get_many(dict_t *dict, char **keys, size_t n, dict_value_t *out) {
+    uint64_t hashes[DICT_BATCH_SZ];
+    size_t lens[DICT_BATCH_SZ];
+    size_t found = 0;
+
+    for (size_t base = 0; base < n; base += DICT_BATCH_SZ) {
+        size_t batch = n - base < DICT_BATCH_SZ ? n - base : DICT_BATCH_SZ;
+        for (size_t i = 0; i < batch; i++)
+            hashes[i] = dict_hash(dict, keys[base + i], &lens[i]);
+
+        switch (dict->kind) {
+            case DICT_ORDERED:
+                found += dict_ordered_get_batch(dict, keys + base, hashes, lens, batch, out + base);
+                break;
+
+            case DICT_OPEN:
+                found += dict_open_get_batch(dict, keys + base, hashes, lens, batch, out + base);
+                break;
+
+            case DICT_CHAINED:
+            default:
+                found += chained_get_batch(dict, keys + base, hashes, lens, batch, out + base);
+                break;
+        }
+    }
+    return found;
+}
+
 size_t dict_get_size(dict_t *dict) { return dict->size; }
 
-bool dict_insert_entry(dict_t *dict, dict_entry_t *entry) {
-    dict_entry_t *prev_entry = dict_get_entry(dict, entry->key);
-    if (prev_entry && !strcmp(prev_entry->key, entry->key)) return false;
+size_t dict_get_capacity(dict_t *dict) {
+    switch (dict->kind) {
+        case DICT_ORDERED:
+            return dict->max_size;
 
-    maybe_resize(dict);
-    size_t idx = hash(entry->key) % dict->max_size;
+        case DICT_OPEN:
+            return dict->max_size;
 
-    entry->next = dict->entries[idx];
-    dict->entries[idx] = entry;
-    dict->size++;
+        case DICT_CHAINED:
+        default:
+            return chained_capacity(dict);
+    }
+}
+
+void dict_reserve(dict_t *dict, size_t n) {
+    switch (dict->kind) {
+        case DICT_ORDERED:
+            dict_ordered_reserve(dict, n);
+            break;
+
+        case DICT_OPEN:
+            dict_open_reserve(dict, n);
+            break;
+
+        case DICT_CHAINED:
+        default:
+            chained_reserve(dict, n);
+            break;
+    }
+}
+
+void dict_shrink_to_fit(dict_t *dict) {
+    switch (dict->kind) {
+        case DICT_ORDERED:
+            dict_ordered_shrink_to_fit(dict);
+            break;
+
+        case DICT_OPEN:
+            dict_open_shrink_to_fit(dict);
+            break;
+
+        case DICT_CHAINED:
+        default:
+            chained_shrink_to_fit(dict);
+            break;
+    }
+}
+
+dict_iter_t dict_iter(dict_t *dict) {
+    if (dict->kind == DICT_CHAINED && is_rehashing(dict)) rehash_all(dict);
+    return (dict_iter_t){ .dict = dict, .idx = 0, .node = NULL };
+}
+
+bool dict_iter_next(dict_iter_t *it, char **key, dict_value_t *value) {
+    dict_entry_t *entry;
+    switch (it->dict->kind) {
+        case DICT_ORDERED:
+            entry = dict_ordered_iter_next(it);
+            break;
+
+        case DICT_OPEN:
+            entry = dict_open_iter_next(it);
+            break;
+
+        case DICT_CHAINED:
+        default:
+            entry = chained_iter_next(it);
+            break;
+    }
+    if (!entry) return false;
+
+    if (key) *key = entry->key;
+    if (value) *value = entry->value;
     return true;
 }
 
+size_t dict_scan(dict_t *dict, size_t cursor, size_t count, dict_scan_fn_t fn, void *ctx) {
+    switch (dict->kind) {
+        case DICT_ORDERED:
+            return dict_ordered_scan(dict, cursor, count, fn, ctx);
+
+        case DICT_OPEN:
+            return dict_open_scan(dict, cursor, count, fn, ctx);
+
+        case DICT_CHAINED:
+        default:
+            return chained_scan(dict, cursor, count, fn, ctx);
+    }
+}
+
+// Inserts a copy of the key in entry with its value.
+bool dict_insert_entry(dict_t *dict, dict_entry_t *entry) {
+    return dict_insert(dict, entry->key, entry->value);
+}
+
 bool dict_insert(dict_t *dict, char *key, dict_value_t value) {
-    dict_entry_t *entry = dict_get_entry(dict, key);
-    if (entry && !strcmp(entry->key, key)) return false;
+    size_t len;
+    uint64_t hash = dict_hash(dict, key, &len);
 
-    maybe_resize(dict);
-    size_t idx = hash(key) % dict->max_size;
+    switch (dict->kind) {
+        case DICT_ORDERED:
+            return dict_ordered_insert(dict, key, hash, len, value);
 
-    entry = mk_entry(strdup(key), value, dict->entries[idx]);
-    dict->entries[idx] = entry;
-    dict->size++;
-    return true;
+        case DICT_OPEN:
+            return dict_open_insert(dict, key, hash, len, value);
+
+        case DICT_CHAINED:
+        default:
+            return chained_insert(dict, key, hash, len, value);
+    }
 }
 
 dict_value_t dict_remove_entry(dict_t *dict, char *key) {
-    size_t idx = hash(key) % dict->max_size;
-    if (!dict->entries[idx]) return NULL;
+    size_t len;
+    uint64_t hash = dict_hash(dict, key, &len);
 
-    dict_entry_t *del, *prev = NULL;
-    for (del = dict->entries[idx];
-         del && strcmp(del->key, key);
-         prev = del, del = del->next);
+    switch (dict->kind) {
+        case DICT_ORDERED:
+            return dict_ordered_remove_entry(dict, key, hash, len);
 
-    if (!del) return NULL;
-    if (!prev)
-        dict->entries[idx] = del->next;
-    else
-        prev->next = del->next;
-
-    dict_value_t value = del->value;
-    free(del->key);
-    free(del);
-    return value;
+        case DICT_OPEN:
+            return dict_open_remove_entry(dict, key, hash, len);
+
+        case DICT_CHAINED:
+        default:
+            return chained_remove_entry(dict, key, hash, len);
+    }
 }
 
 bool dict_remove(dict_t *dict, char *key, free_fn_t free_fn) {
     dict_value_t value;
     if (!(value = dict_remove_entry(dict, key))) return false;
-    free_fn(value);
+    if (free_fn) free_fn(value);
     return true;
 }
 
 void dict_delete(dict_t *dict, free_fn_t free_fn) {
     if (!dict) return;
-    dict_entry_t *entry, *tmp = NULL;
-    for (int i = 0; i < dict->max_size; i++) {
-        for (entry = dict->entries[i]; entry; entry = tmp) {
-            free(entry->key);
-            free_fn(entry->value);
-            tmp = entry->next;
-            free(entry);
-        }
+    switch (dict->kind) {
+        case DICT_ORDERED:
+            dict_ordered_delete(dict, free_fn);
+            break;
+
+        case DICT_OPEN:
+            dict_open_delete(dict, free_fn);
+            break;
+
+        case DICT_CHAINED:
+        default:
+            chained_delete(dict, free_fn);
+            break;
     }
-    free(dict->entries);
+    arena_delete(dict->arena);
     free(dict);
 }
 
-static dict_entry_t *mk_entry(char *key, dict_value_t value, dict_entry_t *next) {
-    dict_entry_t *entry = (dict_entry_t *)malloc(sizeof(dict_entry_t));
-    entry->key = key;
-    entry->value = value;
-    entry->next = next;
-    return entry;
+static dict_node_t *mk_node(dict_t *dict, char *key, uint64_t hash, size_t len,
+                            dict_value_t value, dict_node_t *next) {
+    dict_node_t *node = dict->use_arena
+        ? (dict_node_t *)arena_alloc(dict_arena(dict), sizeof(dict_node_t))
+        : (dict_node_t *)malloc(sizeof(dict_node_t));
+    node->entry.key = key;
+    node->entry.value = value;
+    node->entry.hash = hash;
+    node->entry.len = len;
+    node->next = next;
+    return node;
 }
 
-// Source: http://www.cse.yorku.ca/~oz/hash.html
-static size_t hash(char *str) {
-    size_t hash = 0;
-    int c;
+// Hashes a key with the hash function of the dict and gets its length.
+uint64_t dict_hash(dict_t *dict, char *key, size_t *len) {
+    *len = strlen(key);
+    return dict->hash(key, *len, dict->seed);
+}
+
+// The arena is only created once something is allocated from it, so dicts
+// that never need it (such as small DICT_ORDERED dicts) cost one allocation.
+arena_t *dict_arena(dict_t *dict) {
+    if (!dict->arena) dict->arena = arena_create(ARENA_SLAB_SZ);
+    return dict->arena;
+}
 
-    while ((c = *str++))
-        hash = c + (hash << 6) + (hash << 16) - hash;
+char *dict_key_dup(dict_t *dict, char *key, size_t len) {
+    return dict->use_arena ? arena_strndup(dict_arena(dict), key, len) : strndup(key, len);
+}
 
-    return hash;
+void dict_key_free(dict_t *dict, char *key) {
+    if (!dict->use_arena) free(key);
 }
@@ -0,0 +1,213 @@
+/**
+ * DICT_OPEN engine.
+ *
+ * Open addressing table in the style of SwissTable (see swiss.h). The table
+ * has `max_size` slots (always a power of two, at least one group) split into
+ * groups of 16. Groups are probed in triangular order. Every group probed costs
+ * a single 16 byte comparison of control bytes and only slots whose tag matches
+ * have their keys compared.
+ *
+ * The hash function of the dict may not be well distributed on its high bits
+ * (sdbm isn't), so hashes are mixed before being split in H1 and H2.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <dict.h>
+#include <dict_internal.h>
+#include <scan_cursor.h>
+#include <swiss.h>
+
+static void alloc_table(dict_t *dict, size_t cap) {
+    dict->max_size = cap;
+    dict->ctrl = (dict_ctrl_t *)malloc(cap * sizeof(dict_ctrl_t));
+    dict->slots = (dict_entry_t *)malloc(cap * sizeof(dict_entry_t));
+    memset(dict->ctrl, CTRL_EMPTY, cap * sizeof(dict_ctrl_t));
+    dict->growth_left = max_growth(cap) - dict->size;
+}
+
+static void resize(dict_t *dict, size_t new_cap) {
+    dict_ctrl_t *old_ctrl = dict->ctrl;
+    dict_entry_t *old_slots = dict->slots;
+    size_t old_cap = dict->max_size;
+
+    alloc_table(dict, new_cap);
+    for (size_t i = 0; i < old_cap; i++) {
+        if (!is_full(old_ctrl[i])) continue;
+
+        uint64_t hash = mix(old_slots[i].hash);
+        size_t idx = find_insert_slot(dict->ctrl, dict->max_size, hash);
+        dict->ctrl[idx] = H2(hash);
+        dict->slots[idx] = old_slots[i];
+    }
+    free(old_ctrl);
+    free(old_slots);
+}
+
+// Makes room for one more insertion.
+static void maybe_resize(dict_t *dict) {
+    if (dict->growth_left == 0) resize(dict, swiss_grow_capacity(dict->size, dict->max_size));
+}
+
+// Finds the slot of a key. `hash` is the hash of the key and `mixed` is mix(hash).
+static size_t find(dict_t *dict, char *key, uint64_t hash, uint64_t mixed, size_t len) {
+    size_t mask = dict->max_size / GROUP_SZ - 1;
+    size_t group = H1(mixed) & mask;
+    dict_ctrl_t h2 = H2(mixed);
+
+    for (size_t step = 1;; step++) {
+        size_t base = group * GROUP_SZ;
+        bitmask_t match = group_match(dict->ctrl + base, h2);
+        for (; match; match &= match - 1) {
+            size_t idx = base + __builtin_ctz(match);
+            if (entry_matches(&dict->slots[idx], key, hash, len)) return idx;
+        }
+
+        // A probe sequence never continues past a group with an empty slot.
+        if (group_match_empty(dict->ctrl + base)) return -1UL;
+
+        group = (group + step) & mask;
+    }
+}
+
+void dict_open_init(dict_t *dict, size_t size) {
+    dict->min_size = swiss_min_capacity(size);
+    alloc_table(dict, dict->min_size);
+}
+
+void dict_open_maybe_shrink(dict_t *dict) {
+    size_t cap = swiss_shrink_capacity(dict->size, dict->max_size, dict->min_size, swiss_capacity_for);
+    if (cap < dict->max_size) resize(dict, cap);
+}
+
+void dict_open_reserve(dict_t *dict, size_t n) {
+    size_t cap = swiss_capacity_for(n);
+    if (cap > dict->min_size) dict->min_size = cap;
+    if (cap > dict->max_size) resize(dict, cap);
+}
+
+void dict_open_shrink_to_fit(dict_t *dict) {
+    size_t cap = swiss_capacity_for(dict->size);
+    dict->min_size = GROUP_SZ;
+    if (cap < dict->max_size) resize(dict, cap);
+}
+
+dict_entry_t *dict_open_get_entry(dict_t *dict, char *key, uint64_t hash, size_t len) {
+    size_t idx = find(dict, key, hash, mix(hash), len);
+    return idx == -1UL ? NULL : &dict->slots[idx];
+}
+
+// Looks up a batch of at most DICT_BATCH_SZ hashed keys. The control group of
+// every key is prefetched first, then the slot of its first tag match and then
+// the key in that slot, so the cache misses of different keys overlap.
+size_t dict_open_get_batch(dict_t *dict, char **keys, uint64_t *hashes, size_t *lens,
+                           size_t n, dict_value_t *out) {
+    uint64_t mixed[DICT_BATCH_SZ];
+    size_t mask = dict->max_size / GROUP_SZ - 1;
+    size_t found = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        mixed[i] = mix(hashes[i]);
+        __builtin_prefetch(dict->ctrl + (H1(mixed[i]) & mask) * GROUP_SZ);
+    }
+    size_t first[DICT_BATCH_SZ];
+    for (size_t i = 0; i < n; i++) {
+        size_t base = (H1(mixed[i]) & mask) * GROUP_SZ;
+        bitmask_t match = group_match(dict->ctrl + base, H2(mixed[i]));
+        first[i] = match ? base + __builtin_ctz(match) : -1UL;
+        if (match) __builtin_prefetch(&dict->slots[first[i]]);
+    }
+    for (size_t i = 0; i < n; i++)
+        if (first[i] != -1UL && dict->slots[first[i]].hash == hashes[i])
+            __builtin_prefetch(dict->slots[first[i]].key);
+
+    for (size_t i = 0; i < n; i++) {
+        size_t idx = find(dict, keys[i], hashes[i], mixed[i], lens[i]);
+        out[i] = idx == -1UL ? NULL : dict->slots[idx].value;
+        found += idx != -1UL;
+    }
+    return found;
+}
+
+bool dict_open_insert(dict_t *dict, char *key, uint64_t hash, size_t len, dict_value_t value) {
+    uint64_t mixed = mix(hash);
+    if (find(dict, key, hash, mixed, len) != -1UL) return false;
+
+    maybe_resize(dict);
+    size_t idx = find_insert_slot(dict->ctrl, dict->max_size, mixed);
+    if (dict->ctrl[idx] == CTRL_EMPTY) dict->growth_left--;
+
+    dict->ctrl[idx] = H2(mixed);
+    dict->slots[idx] = (dict_entry_t){
+        .key = dict_key_dup(dict, key, len),
+        .value = value,
+        .hash = hash,
+        .len = len,
+    };
+    dict->size++;
+    return true;
+}
+
+dict_value_t dict_open_remove_entry(dict_t *dict, char *key, uint64_t hash, size_t len) {
+    size_t idx = find(dict, key, hash, mix(hash), len);
+    if (idx == -1UL) return NULL;
+
+    if (swiss_erase(dict->ctrl, idx)) dict->growth_left++;
+    dict_value_t value = dict->slots[idx].value;
+    dict_key_free(dict, dict->slots[idx].key);
+    dict->size--;
+    dict_open_maybe_shrink(dict);
+    return value;
+}
+
+dict_entry_t *dict_open_iter_next(dict_iter_t *it) {
+    dict_t *dict = it->dict;
+    while (it->idx < dict->max_size && !is_full(dict->ctrl[it->idx])) it->idx++;
+    return it->idx < dict->max_size ? &dict->slots[it->idx++] : NULL;
+}
+
+// The cursor walks home groups (H1 of the hash masked by the number of groups)
+// rather than slots, since those split and merge like the buckets of a chained
+// table when the capacity doubles or halves. Entries of a home group lie on
+// its probe sequence, which never goes past a group with an empty slot.
+size_t dict_open_scan(dict_t *dict, size_t cursor, size_t count, dict_scan_fn_t fn, void *ctx) {
+    size_t mask = dict->max_size / GROUP_SZ - 1;
+    size_t visited = 0;
+    do {
+        size_t home = cursor & mask, group = home;
+        for (size_t step = 1;; step++) {
+            size_t base = group * GROUP_SZ;
+            for (size_t i = base; i < base + GROUP_SZ; i++) {
+                if (!is_full(dict->ctrl[i])) continue;
+                if ((H1(mix(dict->slots[i].hash)) & mask) != home) continue;
+
+                fn(dict->slots[i].key, dict->slots[i].value, ctx);
+                visited++;
+            }
+            if (group_match_empty(dict->ctrl + base)) break;
+
+            group = (group + step) & mask;
+        }
+        cursor = cursor_next(cursor, mask);
+    } while (cursor != 0 && visited < count);
+
+    return cursor;
+}
+
+void dict_open_delete(dict_t *dict, free_fn_t free_fn) {
+    // Keys in an arena are freed with it, so there is nothing to walk unless
+    // the values must be freed.
+    if (free_fn || !dict->use_arena) {
+        for (size_t i = 0; i < dict->max_size; i++) {
+            if (!is_full(dict->ctrl[i])) continue;
+
+            dict_key_free(dict, dict->slots[i].key);
+            if (free_fn) free_fn(dict->slots[i].value);
+        }
+    }
+    free(dict->ctrl);
+    free(dict->slots);
+}
@@ -0,0 +1,348 @@
+/**
+ * DICT_ORDERED engine.
+ *
+ * Compact dict in the style of CPython: entries are appended to a dense array
+ * in insertion order and a separate table of `max_size` indices (always a
+ * power of two) maps hashes to positions in that array. Indices are as narrow
+ * as the table allows (1, 2, 4 or 8 bytes), so for small dicts the table costs
+ * a few bytes per entry and the entries themselves have no per-node overhead.
+ *
+ * The index table uses linear probing and is at most 2/3 full. Removed entries
+ * leave a hole in the array (a NULL key) and a DUMMY index, both reclaimed
+ * when the array is full and the table is rebuilt, which also compacts the
+ * array without changing the order of the entries.
+ *
+ * Dicts created with a size of at most SMALL_SZ start without an index table:
+ * their entries, and the copies of their keys while they fit, are stored
+ * inline after the dict struct, so they cost a single allocation and lookups
+ * are a linear scan over at most SMALL_SZ contiguous entries. Once full, the
+ * dict is promoted to a regular table. Keys stored inline stay there, the
+ * space is still owned by the dict.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <dict.h>
+#include <dict_internal.h>
+#include <scan_cursor.h>
+#include <swiss.h>
+
+#define MIN_SZ 8
+#define SMALL_SZ 8      // Largest size of a dict without index table.
+#define SMALL_KEY_SZ 16 // Inline bytes for keys per entry of a small dict.
+#define IX_EMPTY (-1)
+#define IX_DUMMY (-2) // The entry of this index was removed.
+
+// Maximum number of entries (live or removed) for a table size (2/3).
+#define usable(size) ((size) * 2 / 3)
+
+#define is_small(dict) ((dict)->indices == NULL)
+#define inline_entries(dict) ((dict_entry_t *)(dict)->inline_data)
+
+// Maximum number of entries (live or removed) in the array.
+static inline size_t entries_cap(dict_t *dict) {
+    return is_small(dict) ? dict->max_size : usable(dict->max_size);
+}
+
+// Smallest table size that holds `n` entries.
+static inline size_t capacity_for(size_t n) {
+    size_t size = MIN_SZ;
+    while (usable(size) < n) size <<= 1;
+    return size;
+}
+
+// Width of each index in bytes. Entries fit in the signed index type, since
+// there are always fewer of them than index slots.
+static inline size_t index_width(size_t size) {
+    if (size <= 1UL << 7) return 1;
+    if (size <= 1UL << 15) return 2;
+    if (size <= 1UL << 31) return 4;
+    return 8;
+}
+
+static inline int64_t get_index(dict_t *dict, size_t i) {
+    switch (index_width(dict->max_size)) {
+        case 1: return ((int8_t *)dict->indices)[i];
+        case 2: return ((int16_t *)dict->indices)[i];
+        case 4: return ((int32_t *)dict->indices)[i];
+        default: return ((int64_t *)dict->indices)[i];
+    }
+}
+
+static inline void set_index(dict_t *dict, size_t i, int64_t ix) {
+    switch (index_width(dict->max_size)) {
+        case 1: ((int8_t *)dict->indices)[i] = (int8_t)ix; break;
+        case 2: ((int16_t *)dict->indices)[i] = (int16_t)ix; break;
+        case 4: ((int32_t *)dict->indices)[i] = (int32_t)ix; break;
+        default: ((int64_t *)dict->indices)[i] = ix; break;
+    }
+}
+
+static inline size_t home_of(dict_t *dict, uint64_t hash) {
+    return mix(hash) & (dict->max_size - 1);
+}
+
+// Finds an index slot that is not in use, starting at the home of the hash.
+static size_t find_free(dict_t *dict, uint64_t hash) {
+    size_t mask = dict->max_size - 1;
+    size_t i = home_of(dict, hash);
+    while (get_index(dict, i) >= 0) i = (i + 1) & mask;
+    return i;
+}
+
+// Finds the index slot of a key, or -1 if the key is not in the dict.
+static size_t find(dict_t *dict, char *key, uint64_t hash, size_t len) {
+    size_t mask = dict->max_size - 1;
+    for (size_t i = home_of(dict, hash);; i = (i + 1) & mask) {
+        int64_t ix = get_index(dict, i);
+        if (ix == IX_EMPTY) return -1UL;
+        if (ix >= 0 && entry_matches(&dict->entries[ix], key, hash, len)) return i;
+    }
+}
+
+// Finds the position of a key in the array of a small dict, or -1.
+static size_t small_find(dict_t *dict, char *key, uint64_t hash, size_t len) {
+    for (size_t i = 0; i < dict->n_entries; i++) {
+        dict_entry_t *entry = &dict->entries[i];
+        if (entry->key && entry_matches(entry, key, hash, len)) return i;
+    }
+    return -1UL;
+}
+
+// Moves the entries of a small dict over its holes, keeping their order.
+static void small_compact(dict_t *dict) {
+    size_t n = 0;
+    for (size_t i = 0; i < dict->n_entries; i++)
+        if (dict->entries[i].key) dict->entries[n++] = dict->entries[i];
+
+    dict->n_entries = n;
+}
+
+// Copies a key into the inline space of a small dict if it fits.
+static char *key_dup(dict_t *dict, char *key, size_t len) {
+    if (len + 1 > dict->keybuf_size - dict->keybuf_used) return dict_key_dup(dict, key, len);
+
+    char *copy = dict->keybuf + dict->keybuf_used;
+    memcpy(copy, key, len);
+    copy[len] = '\0';
+    dict->keybuf_used += len + 1;
+    return copy;
+}
+
+static void key_free(dict_t *dict, char *key) {
+    uintptr_t addr = (uintptr_t)key, start = (uintptr_t)dict->keybuf;
+    if (addr >= start && addr < start + dict->keybuf_size) return;
+
+    dict_key_free(dict, key);
+}
+
+static void alloc_table(dict_t *dict, size_t size) {
+    dict->max_size = size;
+    // Every byte set makes every index IX_EMPTY, whatever its width.
+    dict->indices = malloc(size * index_width(size));
+    memset(dict->indices, 0xff, size * index_width(size));
+}
+
+// Rebuilds the table with a new size, dropping the holes of the entry array.
+static void resize(dict_t *dict, size_t new_size) {
+    dict_entry_t *old_entries = dict->entries;
+    size_t n_old = dict->n_entries;
+
+    free(dict->indices);
+    alloc_table(dict, new_size);
+    dict->entries = (dict_entry_t *)malloc(usable(new_size) * sizeof(dict_entry_t));
+    dict->n_entries = 0;
+    for (size_t i = 0; i < n_old; i++) {
+        if (!old_entries[i].key) continue;
+
+        set_index(dict, find_free(dict, old_entries[i].hash), dict->n_entries);
+        dict->entries[dict->n_entries++] = old_entries[i];
+    }
+    if (old_entries != inline_entries(dict)) free(old_entries);
+}
+
+size_t dict_ordered_inline_size(size_t size) {
+    return size > SMALL_SZ ? 0 : size * (sizeof(dict_entry_t) + SMALL_KEY_SZ);
+}
+
+void dict_ordered_init(dict_t *dict, size_t size) {
+    dict->n_entries = 0;
+    dict->keybuf = NULL;
+    dict->keybuf_size = dict->keybuf_used = 0;
+    if (size <= SMALL_SZ) {
+        dict->min_size = MIN_SZ;
+        dict->max_size = size;
+        dict->indices = NULL;
+        dict->entries = inline_entries(dict);
+        dict->keybuf = (char *)(dict->entries + size);
+        dict->keybuf_size = size * SMALL_KEY_SZ;
+        return;
+    }
+
+    dict->min_size = capacity_for(usable(size));
+    alloc_table(dict, dict->min_size);
+    dict->entries = (dict_entry_t *)malloc(usable(dict->max_size) * sizeof(dict_entry_t));
+}
+
+// Shrinks the table by the rule of the SwissTable engines, see swiss.h.
+static void maybe_shrink(dict_t *dict) {
+    if (is_small(dict)) return;
+
+    size_t size = swiss_shrink_capacity(dict->size, dict->max_size, dict->min_size, capacity_for);
+    if (size < dict->max_size) resize(dict, size);
+}
+
+void dict_ordered_reserve(dict_t *dict, size_t n) {
+    size_t size = capacity_for(n);
+    if (size > dict->min_size) dict->min_size = size;
+    if (is_small(dict) ? n > dict->max_size : size > dict->max_size) resize(dict, size);
+}
+
+void dict_ordered_shrink_to_fit(dict_t *dict) {
+    if (is_small(dict)) {
+        small_compact(dict);
+        return;
+    }
+    size_t size = capacity_for(dict->size);
+    dict->min_size = MIN_SZ;
+    if (size < dict->max_size || dict->n_entries > dict->size) resize(dict, size);
+}
+
+dict_entry_t *dict_ordered_get_entry(dict_t *dict, char *key, uint64_t hash, size_t len) {
+    if (is_small(dict)) {
+        size_t i = small_find(dict, key, hash, len);
+        return i == -1UL ? NULL : &dict->entries[i];
+    }
+    size_t i = find(dict, key, hash, len);
+    return i == -1UL ? NULL : &dict->entries[get_index(dict, i)];
+}
+
+// Looks up a batch of at most DICT_BATCH_SZ hashed keys. The home index of
+// every key is prefetched first and then the entry it points to, so the cache
+// misses of different keys overlap.
+size_t dict_ordered_get_batch(dict_t *dict, char **keys, uint64_t *hashes, size_t *lens,
+                              size_t n, dict_value_t *out) {
+    size_t width = index_width(dict->max_size);
+    size_t found = 0;
+
+    for (size_t i = 0; i < n && !is_small(dict); i++)
+        __builtin_prefetch((char *)dict->indices + home_of(dict, hashes[i]) * width);
+
+    for (size_t i = 0; i < n && !is_small(dict); i++) {
+        int64_t ix = get_index(dict, home_of(dict, hashes[i]));
+        if (ix >= 0) __builtin_prefetch(&dict->entries[ix]);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        dict_entry_t *entry = dict_ordered_get_entry(dict, keys[i], hashes[i], lens[i]);
+        out[i] = entry ? entry->value : NULL;
+        found += entry != NULL;
+    }
+    return found;
+}
+
+bool dict_ordered_insert(dict_t *dict, char *key, uint64_t hash, size_t len, dict_value_t value) {
+    if (dict_ordered_get_entry(dict, key, hash, len)) return false;
+
+    // The array is full, either of holes (the table keeps its size) or of
+    // entries (it doubles). A small dict full of entries gets its first table.
+    if (dict->n_entries == entries_cap(dict)) {
+        if (is_small(dict) && dict->size < dict->n_entries) {
+            small_compact(dict);
+        } else {
+            size_t size = capacity_for(dict->size * 2);
+            resize(dict, size < dict->min_size ? dict->min_size : size);
+        }
+    }
+
+    if (!is_small(dict)) set_index(dict, find_free(dict, hash), dict->n_entries);
+    dict->entries[dict->n_entries++] = (dict_entry_t){
+        .key = key_dup(dict, key, len),
+        .value = value,
+        .hash = hash,
+        .len = len,
+    };
+    dict->size++;
+    return true;
+}
+
+dict_value_t dict_ordered_remove_entry(dict_t *dict, char *key, uint64_t hash, size_t len) {
+    dict_entry_t *entry;
+    if (is_small(dict)) {
+        size_t i = small_find(dict, key, hash, len);
+        if (i == -1UL) return NULL;
+        entry = &dict->entries[i];
+    } else {
+        size_t i = find(dict, key, hash, len);
+        if (i == -1UL) return NULL;
+        entry = &dict->entries[get_index(dict, i)];
+        set_index(dict, i, IX_DUMMY);
+    }
+
+    dict_value_t value = entry->value;
+    key_free(dict, entry->key);
+    entry->key = NULL;
+    dict->size--;
+    // Without a table, holes at the end of the array are simply dropped.
+    if (is_small(dict))
+        while (dict->n_entries > 0 && !dict->entries[dict->n_entries - 1].key) dict->n_entries--;
+
+    maybe_shrink(dict);
+    return value;
+}
+
+dict_entry_t *dict_ordered_iter_next(dict_iter_t *it) {
+    dict_t *dict = it->dict;
+    while (it->idx < dict->n_entries && !dict->entries[it->idx].key) it->idx++;
+    return it->idx < dict->n_entries ? &dict->entries[it->idx++] : NULL;
+}
+
+// Positions in the entry array change when the table is rebuilt, so the
+// cursor walks home slots of the index table instead, which split and merge
+// like the buckets of a chained table when the table doubles or halves. With
+// linear probing, the entries of a home slot lie before the next empty index.
+size_t dict_ordered_scan(dict_t *dict, size_t cursor, size_t count,
+                         dict_scan_fn_t fn, void *ctx) {
+    // A small dict has no table to walk, and few enough entries to visit all
+    // of them in one call.
+    if (is_small(dict)) {
+        for (size_t i = 0; i < dict->n_entries; i++)
+            if (dict->entries[i].key) fn(dict->entries[i].key, dict->entries[i].value, ctx);
+        return 0;
+    }
+
+    size_t mask = dict->max_size - 1;
+    size_t visited = 0;
+    do {
+        size_t home = cursor & mask;
+        for (size_t i = home;; i = (i + 1) & mask) {
+            int64_t ix = get_index(dict, i);
+            if (ix == IX_EMPTY) break;
+            if (ix < 0 || home_of(dict, dict->entries[ix].hash) != home) continue;
+
+            fn(dict->entries[ix].key, dict->entries[ix].value, ctx);
+            visited++;
+        }
+        cursor = cursor_next(cursor, mask);
+    } while (cursor != 0 && visited < count);
+
+    return cursor;
+}
+
+void dict_ordered_delete(dict_t *dict, free_fn_t free_fn) {
+    // Keys in an arena are freed with it, so there is nothing to walk unless
+    // the values must be freed.
+    if (free_fn || !dict->use_arena) {
+        for (size_t i = 0; i < dict->n_entries; i++) {
+            if (!dict->entries[i].key) continue;
+
+            key_free(dict, dict->entries[i].key);
+            if (free_fn) free_fn(dict->entries[i].value);
+        }
+    }
+    free(dict->indices);
+    if (dict->entries != inline_entries(dict)) free(dict->entries);
+}
@@ -0,0 +1,249 @@
+/**
+ * Frozen dict (see fdict.h).
+ *
+ * Layout of an image, every offset is from its start and 8 byte aligned:
+ *   header_t
+ *   slot_t[n_slots]   the table, an empty slot has offset 0
+ *   entries           key, '\0', padding, uint64_t value size, value, padding
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <fdict.h>
+
+#define MAGIC "FDICT\0\0\0"
+#define VERSION 1
+#define BYTE_ORDER_MARK 0x01020304U
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order; // BYTE_ORDER_MARK as written by the machine.
+    uint64_t image_size;
+    uint64_t size;       // Number of keys.
+    uint64_t n_slots;    // A power of two.
+    uint64_t seed;       // Seed of hash_wy.
+} header_t;
+
+typedef struct {
+    uint32_t tag;     // The high 32 bits of the hash of the key.
+    uint32_t key_len;
+    uint64_t offset;  // Offset of the entry, 0 if the slot is empty.
+} slot_t;
+
+struct _fdict {
+    const unsigned char *base;
+    const header_t *header;
+    const slot_t *slots;
+    size_t mask;
+    size_t image_size;
+    bool mapped;
+};
+
+static inline size_t align8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+static size_t dump_string(dict_value_t value, const void **data) {
+    *data = value;
+    return value ? strlen((char *)value) + 1 : 0;
+}
+
+typedef struct {
+    char *key;
+    size_t key_len;
+    size_t value_off; // Offset of the value bytes in the copied values.
+    size_t value_size;
+} item_t;
+
+void *fdict_freeze_buffer(dict_t *dict, fdict_dump_fn_t dump, size_t *size) {
+    if (!dump) dump = dump_string;
+
+    size_t n = dict_get_size(dict);
+    size_t n_slots = 1;
+    while (n_slots * 3 < n * 4 || n_slots == n) n_slots <<= 1;
+
+    // Values are dumped once, before the image size is known. Their bytes are
+    // copied right away, so dump may give a buffer it reuses for every value.
+    item_t *items = (item_t *)malloc((n ? n : 1) * sizeof(item_t));
+    size_t pool_size = 0, i = 0;
+    unsigned char *values = NULL;
+    size_t values_size = 0, values_cap = 0;
+    dict_value_t value;
+    for (dict_iter_t it = dict_iter(dict); dict_iter_next(&it, &items[i].key, &value); i++) {
+        const void *data;
+        items[i].key_len = strlen(items[i].key);
+        items[i].value_size = dump(value, &data);
+        items[i].value_off = values_size;
+        if (values_size + items[i].value_size > values_cap) {
+            while (values_size + items[i].value_size > values_cap) values_cap = values_cap ? values_cap * 2 : 4096;
+            values = (unsigned char *)realloc(values, values_cap);
+        }
+        if (items[i].value_size) memcpy(values + values_size, data, items[i].value_size);
+        values_size += items[i].value_size;
+        pool_size += align8(items[i].key_len + 1) + sizeof(uint64_t) + align8(items[i].value_size);
+    }
+
+    size_t slots_off = align8(sizeof(header_t));
+    size_t pool_off = slots_off + n_slots * sizeof(slot_t);
+    *size = pool_off + pool_size;
+    unsigned char *image = (unsigned char *)aligned_alloc(8, align8(*size));
+    memset(image, 0, *size);
+
+    header_t *header = (header_t *)image;
+    memcpy(header->magic, MAGIC, sizeof(header->magic));
+    header->version = VERSION;
+    header->byte_order = BYTE_ORDER_MARK;
+    header->image_size = *size;
+    header->size = n;
+    header->n_slots = n_slots;
+    header->seed = hash_random_seed();
+
+    slot_t *slots = (slot_t *)(image + slots_off);
+    size_t offset = pool_off;
+    for (i = 0; i < n; i++) {
+        uint64_t hash = hash_wy(items[i].key, items[i].key_len, header->seed);
+        size_t idx = hash & (n_slots - 1);
+        while (slots[idx].offset) idx = (idx + 1) & (n_slots - 1);
+
+        slots[idx] = (slot_t){ (uint32_t)(hash >> 32), (uint32_t)items[i].key_len, offset };
+        memcpy(image + offset, items[i].key, items[i].key_len);
+        offset += align8(items[i].key_len + 1);
+
+        uint64_t value_size = items[i].value_size;
+        memcpy(image + offset, &value_size, sizeof(uint64_t));
+        offset += sizeof(uint64_t);
+        if (value_size) memcpy(image + offset, values + items[i].value_off, value_size);
+        offset += align8(value_size);
+    }
+
+    free(items);
+    free(values);
+    return image;
+}
+
+bool fdict_freeze(dict_t *dict, char *path, fdict_dump_fn_t dump) {
+    size_t size;
+    void *image = fdict_freeze_buffer(dict, dump, &size);
+
+    // A unique temporary file next to path, so concurrent freezes of the same
+    // path don't write over each other and the rename stays in one filesystem.
+    char *tmp_path = (char *)malloc(strlen(path) + 8);
+    int fd = -1;
+    if (tmp_path) {
+        sprintf(tmp_path, "%s.XXXXXX", path);
+        fd = mkstemp(tmp_path);
+    }
+    if (fd < 0) {
+        free(tmp_path);
+        free(image);
+        return false;
+    }
+    fchmod(fd, 0644); // mkstemp makes it readable by the owner only.
+
+    // The data reaches the disk before the rename, so a crash can't leave a
+    // truncated image at path.
+    FILE *f = fdopen(fd, "wb");
+    bool ok = f && fwrite(image, 1, size, f) == size && fflush(f) == 0 && fsync(fd) == 0;
+    if (f ? fclose(f) != 0 : close(fd) != 0) ok = false;
+    if (ok) ok = rename(tmp_path, path) == 0;
+    if (!ok) unlink(tmp_path);
+
+    free(tmp_path);
+    free(image);
+    return ok;
+}
+
+static bool valid_header(const header_t *header, size_t size) {
+    if (size < sizeof(header_t) || memcmp(header->magic, MAGIC, sizeof(header->magic)) != 0)
+        return false;
+    if (header->version != VERSION || header->byte_order != BYTE_ORDER_MARK)
+        return false;
+
+    uint64_t n_slots = header->n_slots;
+    if (header->image_size != size || n_slots == 0 || (n_slots & (n_slots - 1)))
+        return false;
+    // The table must fit in the image.
+    return header->size < n_slots &&
+           n_slots <= (size - align8(sizeof(header_t))) / sizeof(slot_t);
+}
+
+fdict_t *fdict_from_buffer(const void *data, size_t size) {
+    if (!valid_header((const header_t *)data, size)) return NULL;
+
+    fdict_t *fdict = (fdict_t *)malloc(sizeof(fdict_t));
+    fdict->base = (const unsigned char *)data;
+    fdict->header = (const header_t *)data;
+    fdict->slots = (const slot_t *)(fdict->base + align8(sizeof(header_t)));
+    fdict->mask = fdict->header->n_slots - 1;
+    fdict->image_size = size;
+    fdict->mapped = false;
+    return fdict;
+}
+
+fdict_t *fdict_open(char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < sizeof(header_t)) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = st.st_size;
+    void *data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+
+    fdict_t *fdict = fdict_from_buffer(data, size);
+    if (!fdict) {
+        munmap(data, size);
+        return NULL;
+    }
+    fdict->mapped = true;
+    return fdict;
+}
+
+const void *fdict_get_sized(fdict_t *fdict, char *key, size_t *size) {
+    size_t len = strlen(key);
+    uint64_t hash = hash_wy(key, len, fdict->header->seed);
+    uint32_t tag = (uint32_t)(hash >> 32);
+
+    size_t idx = hash & fdict->mask;
+    for (size_t probes = 0; probes <= fdict->mask; probes++, idx = (idx + 1) & fdict->mask) {
+        const slot_t *slot = &fdict->slots[idx];
+        if (!slot->offset) return NULL;
+        if (slot->tag != tag || slot->key_len != len) continue;
+
+        // Offsets are checked against the image rather than trusted.
+        if (slot->offset >= fdict->image_size) return NULL;
+        size_t value_off = align8(slot->offset + len + 1);
+        if (value_off + sizeof(uint64_t) > fdict->image_size) return NULL;
+        if (memcmp(fdict->base + slot->offset, key, len) != 0) continue;
+
+        uint64_t value_size = *(const uint64_t *)(fdict->base + value_off);
+        if (value_size > fdict->image_size - value_off - sizeof(uint64_t)) return NULL;
+        if (size) *size = value_size;
+        return fdict->base + value_off + sizeof(uint64_t);
+    }
+    return NULL;
+}
+
+const void *fdict_get(fdict_t *fdict, char *key) { return fdict_get_sized(fdict, key, NULL); }
+
+bool fdict_contains(fdict_t *fdict, char *key) { return fdict_get_sized(fdict, key, NULL) != NULL; }
+
+size_t fdict_get_size(fdict_t *fdict) { return fdict->header->size; }
+
+void fdict_close(fdict_t *fdict) {
+    if (!fdict) return;
+    if (fdict->mapped) munmap((void *)fdict->base, fdict->image_size);
+    free(fdict);
+}
@@ -0,0 +1,290 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include <gdict.h>
+#include <generic.h>
+#include <hash.h>
+#include <swiss.h>
+
+#define GDICT_DEFAULT_SZ 16
+
+typedef unsigned char byte_t;
+
+// How keys are hashed and compared, picked from the key type on creation.
+typedef enum {
+    KEY_U32,    // 4 byte keys compared as a word.
+    KEY_U64,    // 8 byte keys compared as a word.
+    KEY_FLOAT,
+    KEY_DOUBLE,
+    KEY_BYTES,  // Anything else, hashed with HASH_DEFAULT.
+} key_kind_t;
+
+// Each slot holds the value followed by the key, padded to a multiple of 8
+// bytes so that every value is aligned.
+struct _gdict {
+    generic_t *key_type;
+    key_kind_t kind;
+    size_t key_size;
+    size_t slot_size;
+    uint64_t seed;
+    size_t max_size; // Number of slots.
+    size_t min_size; // The table never shrinks automatically below this size.
+    size_t size;
+    size_t growth_left; // Inserts left before a rehash is required.
+    int8_t *ctrl;
+    byte_t *slots;
+};
+
+#define slot_at(gdict, i) ((gdict)->slots + (i) * (gdict)->slot_size)
+#define slot_value(slot) (*(dict_value_t *)(slot))
+#define slot_key(slot) ((slot) + sizeof(dict_value_t))
+
+/* Keys */
+
+static key_kind_t kind_of(generic_t *key_type, size_t key_size) {
+    if (gis_float(key_type)) return KEY_FLOAT;
+    if (gis_double(key_type)) return KEY_DOUBLE;
+    if (key_size == sizeof(uint32_t)) return KEY_U32;
+    if (key_size == sizeof(uint64_t)) return KEY_U64;
+    return KEY_BYTES;
+}
+
+// Hashes a key as a certain kind. Always inlined with a constant kind, so each
+// kind gets its own code without any branch on the kind.
+static inline __attribute__((always_inline))
+uint64_t hash_as(const gdict_t *gdict, const void *key, const key_kind_t kind) {
+    switch (kind) {
+        case KEY_U32: {
+            uint32_t k;
+            memcpy(&k, key, sizeof(k));
+            return mix(k ^ gdict->seed);
+        }
+        case KEY_U64: {
+            uint64_t k;
+            memcpy(&k, key, sizeof(k));
+            return mix(k ^ gdict->seed);
+        }
+        case KEY_FLOAT: {
+            float f;
+            uint32_t k;
+            memcpy(&f, key, sizeof(f));
+            if (f == 0) f = 0; // -0.0 hashes as 0.0.
+            memcpy(&k, &f, sizeof(k));
+            return mix(k ^ gdict->seed);
+        }
+        case KEY_DOUBLE: {
+            double d;
+            uint64_t k;
+            memcpy(&d, key, sizeof(d));
+            if (d == 0) d = 0;
+            memcpy(&k, &d, sizeof(k));
+            return mix(k ^ gdict->seed);
+        }
+        default:
+            return HASH_DEFAULT(key, gdict->key_size, gdict->seed);
+    }
+}
+
+static inline __attribute__((always_inline))
+bool equals_as(const gdict_t *gdict, const void *a, const void *b, const key_kind_t kind) {
+    switch (kind) {
+        case KEY_U32:
+            return !memcmp(a, b, sizeof(uint32_t));
+        case KEY_U64:
+            return !memcmp(a, b, sizeof(uint64_t));
+        case KEY_FLOAT: {
+            float x, y;
+            memcpy(&x, a, sizeof(x));
+            memcpy(&y, b, sizeof(y));
+            return x == y;
+        }
+        case KEY_DOUBLE: {
+            double x, y;
+            memcpy(&x, a, sizeof(x));
+            memcpy(&y, b, sizeof(y));
+            return x == y;
+        }
+        default:
+            return !memcmp(a, b, gdict->key_size);
+    }
+}
+
+/* Table */
+
+static void alloc_table(gdict_t *gdict, size_t cap) {
+    gdict->max_size = cap;
+    gdict->ctrl = (int8_t *)malloc(cap);
+    gdict->slots = (byte_t *)malloc(cap * gdict->slot_size);
+    memset(gdict->ctrl, CTRL_EMPTY, cap);
+    gdict->growth_left = max_growth(cap) - gdict->size;
+}
+
+static inline __attribute__((always_inline))
+size_t find_as(const gdict_t *gdict, const void *key, uint64_t hash, const key_kind_t kind) {
+    size_t mask = gdict->max_size / GROUP_SZ - 1;
+    size_t group = H1(hash) & mask;
+    int8_t h2 = H2(hash);
+
+    for (size_t step = 1;; step++) {
+        size_t base = group * GROUP_SZ;
+        bitmask_t match = group_match(gdict->ctrl + base, h2);
+        for (; match; match &= match - 1) {
+            size_t idx = base + __builtin_ctz(match);
+            if (equals_as(gdict, slot_key(slot_at(gdict, idx)), key, kind)) return idx;
+        }
+
+        // A probe sequence never continues past a group with an empty slot.
+        if (group_match_empty(gdict->ctrl + base)) return -1UL;
+
+        group = (group + step) & mask;
+    }
+}
+
+// Hashes a key and finds its slot (-1 if the key is not in the dict).
+static size_t find(const gdict_t *gdict, const void *key, uint64_t *hash) {
+#define FIND_AS(kind) \
+    case kind: *hash = hash_as(gdict, key, kind); return find_as(gdict, key, *hash, kind)
+
+    switch (gdict->kind) {
+        FIND_AS(KEY_U32);
+        FIND_AS(KEY_U64);
+        FIND_AS(KEY_FLOAT);
+        FIND_AS(KEY_DOUBLE);
+        default:
+        FIND_AS(KEY_BYTES);
+    }
+#undef FIND_AS
+}
+
+static uint64_t hash_key(const gdict_t *gdict, const void *key) {
+    switch (gdict->kind) {
+        case KEY_U32:    return hash_as(gdict, key, KEY_U32);
+        case KEY_U64:    return hash_as(gdict, key, KEY_U64);
+        case KEY_FLOAT:  return hash_as(gdict, key, KEY_FLOAT);
+        case KEY_DOUBLE: return hash_as(gdict, key, KEY_DOUBLE);
+        default:         return hash_as(gdict, key, KEY_BYTES);
+    }
+}
+
+static void resize(gdict_t *gdict, size_t new_cap) {
+    int8_t *old_ctrl = gdict->ctrl;
+    byte_t *old_slots = gdict->slots;
+    size_t old_cap = gdict->max_size;
+
+    alloc_table(gdict, new_cap);
+    for (size_t i = 0; i < old_cap; i++) {
+        if (!is_full(old_ctrl[i])) continue;
+
+        byte_t *slot = old_slots + i * gdict->slot_size;
+        uint64_t hash = hash_key(gdict, slot_key(slot));
+        size_t idx = find_insert_slot(gdict->ctrl, gdict->max_size, hash);
+        gdict->ctrl[idx] = H2(hash);
+        memcpy(slot_at(gdict, idx), slot, gdict->slot_size);
+    }
+    free(old_ctrl);
+    free(old_slots);
+}
+
+// Makes room for one more insertion.
+static void maybe_resize(gdict_t *gdict) {
+    if (gdict->growth_left == 0) resize(gdict, swiss_grow_capacity(gdict->size, gdict->max_size));
+}
+
+static void maybe_shrink(gdict_t *gdict) {
+    size_t cap = swiss_shrink_capacity(gdict->size, gdict->max_size, gdict->min_size, swiss_capacity_for);
+    if (cap < gdict->max_size) resize(gdict, cap);
+}
+
+/* Public interface */
+
+gdict_t *gdict_create_sized(generic_t *key_type, size_t size) {
+    size_t key_size = generic_sizeof(key_type);
+    assert(key_size > 0);
+
+    gdict_t *gdict = (gdict_t *)malloc(sizeof(gdict_t));
+    gdict->key_type = key_type;
+    gdict->key_size = key_size;
+    gdict->kind = kind_of(key_type, key_size);
+    gdict->slot_size = sizeof(dict_value_t) + (key_size + 7) / 8 * 8;
+    gdict->seed = hash_random_seed();
+    gdict->size = 0;
+    gdict->min_size = swiss_min_capacity(size);
+    alloc_table(gdict, gdict->min_size);
+    return gdict;
+}
+
+gdict_t *gdict_create(generic_t *key_type) {
+    return gdict_create_sized(key_type, GDICT_DEFAULT_SZ);
+}
+
+size_t gdict_get_size(gdict_t *gdict) { return gdict->size; }
+
+size_t gdict_get_capacity(gdict_t *gdict) { return gdict->max_size; }
+
+bool gdict_contains(gdict_t *gdict, const void *key) {
+    uint64_t hash;
+    return find(gdict, key, &hash) != -1UL;
+}
+
+dict_value_t gdict_get(gdict_t *gdict, const void *key) {
+    uint64_t hash;
+    size_t idx = find(gdict, key, &hash);
+    return idx == -1UL ? NULL : slot_value(slot_at(gdict, idx));
+}
+
+bool gdict_insert(gdict_t *gdict, const void *key, dict_value_t value) {
+    uint64_t hash;
+    if (find(gdict, key, &hash) != -1UL) return false;
+
+    maybe_resize(gdict);
+    size_t idx = find_insert_slot(gdict->ctrl, gdict->max_size, hash);
+    if (gdict->ctrl[idx] == CTRL_EMPTY) gdict->growth_left--;
+
+    byte_t *slot = slot_at(gdict, idx);
+    gdict->ctrl[idx] = H2(hash);
+    slot_value(slot) = value;
+    memcpy(slot_key(slot), key, gdict->key_size);
+    gdict->size++;
+    return true;
+}
+
+// Empties a full slot and returns its value.
+static dict_value_t remove_at(gdict_t *gdict, size_t idx) {
+    if (swiss_erase(gdict->ctrl, idx)) gdict->growth_left++;
+    dict_value_t value = slot_value(slot_at(gdict, idx));
+    gdict->size--;
+    maybe_shrink(gdict);
+    return value;
+}
+
+dict_value_t gdict_remove_entry(gdict_t *gdict, const void *key) {
+    uint64_t hash;
+    size_t idx = find(gdict, key, &hash);
+    return idx == -1UL ? NULL : remove_at(gdict, idx);
+}
+
+bool gdict_remove(gdict_t *gdict, const void *key, free_fn_t free_fn) {
+    uint64_t hash;
+    size_t idx = find(gdict, key, &hash);
+    if (idx == -1UL) return false;
+
+    dict_value_t value = remove_at(gdict, idx);
+    if (free_fn) free_fn(value);
+    return true;
+}
+
+void gdict_delete(gdict_t *gdict, free_fn_t free_fn) {
+    if (!gdict) return;
+
+    if (free_fn) {
+        for (size_t i = 0; i < gdict->max_size; i++)
+            if (is_full(gdict->ctrl[i])) free_fn(slot_value(slot_at(gdict, i)));
+    }
+    generic_free(gdict->key_type);
+    free(gdict->ctrl);
+    free(gdict->slots);
+    free(gdict);
+}
@@ -0,0 +1,124 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <sys/random.h>
+
+#include <hash.h>
+
+// Secret primes of wyhash.
+#define P0 0xa0761d6478bd642fULL
+#define P1 0xe7037ed1a0b428dbULL
+#define P2 0x8ebc6af09c88c6e3ULL
+#define P3 0x589965cc75374cc3ULL
+
+// Multiplies a and b into 128 bits and stores the low half in a and the high
+// half in b.
+static inline void mum128(uint64_t *a, uint64_t *b) {
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+}
+
+// Multiplies a and b into 128 bits and folds the result back into 64 bits.
+static inline uint64_t mum(uint64_t a, uint64_t b) {
+    mum128(&a, &b);
+    return a ^ b;
+}
+
+// Unaligned reads.
+static inline uint64_t read64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint64_t hash_wy(const void *data, size_t len, uint64_t seed) {
+    const uint8_t *p = (const uint8_t *)data;
+    uint64_t a, b;
+
+    seed ^= mum(seed ^ P0, P1);
+    if (len <= 16) {
+        if (len >= 4) {
+            // Two (possibly overlapping) pairs of 4 byte reads cover the input.
+            size_t off = (len >> 3) << 2;
+            a = (read32(p) << 32) | read32(p + off);
+            b = (read32(p + len - 4) << 32) | read32(p + len - 4 - off);
+        } else if (len > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            // Three independent lanes keep the multipliers busy.
+            uint64_t s1 = seed, s2 = seed;
+            do {
+                seed = mum(read64(p     ) ^ P1, read64(p +  8) ^ seed);
+                s1   = mum(read64(p + 16) ^ P2, read64(p + 24) ^ s1);
+                s2   = mum(read64(p + 32) ^ P3, read64(p + 40) ^ s2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= s1 ^ s2;
+        }
+        while (i > 16) {
+            seed = mum(read64(p) ^ P1, read64(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        // The last 16 bytes, overlapping with what was already read.
+        a = read64(p + i - 16);
+        b = read64(p + i - 8);
+    }
+    a ^= P1;
+    b ^= seed;
+    mum128(&a, &b);
+    return mum(a ^ P0 ^ len, b ^ P1);
+}
+
+uint64_t hash_sdbm(const void *data, size_t len, uint64_t seed) {
+    const uint8_t *p = (const uint8_t *)data;
+    uint64_t hash = seed;
+
+    for (size_t i = 0; i < len; i++)
+        hash = p[i] + (hash << 6) + (hash << 16) - hash;
+
+    return hash;
+}
+
+// Seeds are derived from a single random value read once per process, tables
+// are often created in large numbers (one per JSON object) and a system call
+// for each of them would dominate their creation.
+uint64_t hash_random_seed() {
+    static uint64_t base = 0;
+    static uint64_t counter = 0;
+
+    uint64_t seed = __atomic_load_n(&base, __ATOMIC_RELAXED);
+    if (!seed) {
+        if (getrandom(&seed, sizeof(seed), GRND_NONBLOCK) != sizeof(seed)) {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            seed = mum(ts.tv_sec ^ P0, ts.tv_nsec ^ P1) ^ ((uintptr_t)&seed ^ P3);
+        }
+        seed |= 1;
+        // Whichever thread gets here first sets the base.
+        uint64_t expected = 0;
+        if (!__atomic_compare_exchange_n(&base, &expected, seed, false,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            seed = expected;
+    }
+
+    uint64_t n = __atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED);
+    seed = mum(seed ^ P2, n ^ P3);
+    return seed ? seed : P0;
+}
@@ -2,151 +2,405 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <stdint.h>
 #include <string.h>
 
 #include <hashset.h>
+#include <scan_cursor.h>
 
 #define SET_DEFAULT_SZ 16
 #define LOAD_FACTOR 0.75
+#define REHASH_STEP 4          // Buckets moved per operation on incremental mode.
+#define REHASH_EMPTY_VISITS 10 // Empty buckets skipped per bucket moved.
+#define SHRINK_FACTOR 0.125    // Tables shrink when the load drops below this.
+#define BATCH_SZ 16            // Keys resolved together by hashset_contains_many.
 
+// The full hash and length of the key are cached in the entry so that chain
+// walks can skip mismatches without touching the key and resizes never need to
+// hash the keys again.
 struct _hashset_entry {
     char *key;
+    uint64_t hash;
+    size_t len;
     hashset_entry_t *next;
 };
 
+#define entry_matches(e, k, h, l) \
+    ((e)->hash == (h) && (e)->len == (l) && !memcmp((e)->key, (k), (l)))
+
 struct _hashset {
     hashset_entry_t **entries;
     size_t max_size;
+    size_t min_size; // The table never shrinks automatically below this size.
     size_t size;
+    bool incremental;
+    hash_fn_t hash;
+    uint64_t seed;
+    // While an incremental rehash is in progress, entries are moved from
+    // `entries` into `new_entries`, starting at `rehash_idx`.
+    hashset_entry_t **new_entries;
+    size_t new_size;
+    size_t rehash_idx;
 };
 
-static size_t hash(char *str);
-static hashset_entry_t *mk_entry(char *key, hashset_entry_t *next);
+#define is_rehashing(set) ((set)->new_entries != NULL)
+#define bucket_of(hash, size) ((hash) & ((size) - 1))
 
-static hashset_entry_t *hashset_get_entry(hashset_t *hashset, char *key) {
-    size_t idx = hash(key) % hashset->max_size;
+static uint64_t hash(hashset_t *hashset, char *key, size_t *len);
+static hashset_entry_t *mk_entry(char *key, uint64_t hash, size_t len, hashset_entry_t *next);
 
-    hashset_entry_t *entry;
-    for (entry = hashset->entries[idx];
-         entry && strcmp(entry->key, key);
-         entry = entry->next);
+static inline size_t pow2_ceil(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
 
-    return entry;
+// Smallest table size that holds `n` entries within the load factor.
+static size_t capacity_for(size_t n) {
+    size_t cap = SET_DEFAULT_SZ;
+    while ((float)n > (float)cap * LOAD_FACTOR) cap <<= 1;
+    return cap;
 }
 
-// TODO: Forma de diminuir tamanho além de aumentar.
-static void maybe_resize(hashset_t *hashset) {
-    if ((float)hashset->size + 1. <= (float)hashset->max_size * LOAD_FACTOR) return;
+// Moves every entry of a bucket in the old table to the new table.
+static void move_bucket(hashset_t *hashset, size_t i) {
+    hashset_entry_t *entry, *tmp;
+    for (entry = hashset->entries[i]; entry; entry = tmp) {
+        tmp = entry->next;
+        size_t idx = bucket_of(entry->hash, hashset->new_size);
+        entry->next = hashset->new_entries[idx];
+        hashset->new_entries[idx] = entry;
+    }
+    hashset->entries[i] = NULL;
+}
 
-    hashset_t *new_set = hashset_create_sized(hashset->max_size * 2);
-    for (int i = 0; i < hashset->max_size; i++) {
-        hashset_entry_t *entry, *tmp;
-        for (entry = hashset->entries[i]; entry; entry = tmp) {
-            tmp = entry->next;
-            size_t idx = hash(entry->key) % new_set->max_size;
-            entry->next = new_set->entries[idx];
-            new_set->entries[idx] = entry;
+static void rehash_finish(hashset_t *hashset) {
+    free(hashset->entries);
+    hashset->entries = hashset->new_entries;
+    hashset->max_size = hashset->new_size;
+    hashset->new_entries = NULL;
+    hashset->new_size = 0;
+    hashset->rehash_idx = 0;
+}
+
+// Moves up to `n` non empty buckets to the new table. To bound the work done,
+// at most REHASH_EMPTY_VISITS empty buckets are skipped per bucket moved.
+static void rehash_step(hashset_t *hashset, int n) {
+    int empty_visits = n * REHASH_EMPTY_VISITS;
+    while (n > 0 && hashset->rehash_idx < hashset->max_size) {
+        if (!hashset->entries[hashset->rehash_idx]) {
+            hashset->rehash_idx++;
+            if (--empty_visits == 0) break;
+            continue;
         }
+        move_bucket(hashset, hashset->rehash_idx++);
+        n--;
     }
-    free(hashset->entries);
-    hashset->max_size = new_set->max_size;
-    hashset->entries = new_set->entries;
-    free(new_set);
+    if (hashset->rehash_idx == hashset->max_size) rehash_finish(hashset);
 }
 
-hashset_t *hashset_create_sized(size_t size) {
+static void rehash_all(hashset_t *hashset) {
+    for (; hashset->rehash_idx < hashset->max_size; hashset->rehash_idx++)
+        move_bucket(hashset, hashset->rehash_idx);
+
+    rehash_finish(hashset);
+}
+
+// Starts moving the entries to a table with `new_size` buckets. Unless the
+// hashset is incremental, every entry is moved right away.
+static void resize(hashset_t *hashset, size_t new_size) {
+    if (is_rehashing(hashset)) rehash_all(hashset);
+
+    hashset->new_entries = (hashset_entry_t **)calloc(new_size, sizeof(hashset_entry_t *));
+    hashset->new_size = new_size;
+    hashset->rehash_idx = 0;
+
+    if (!hashset->incremental) rehash_all(hashset);
+}
+
+// Resizes and moves every entry right away, even in incremental mode.
+static void resize_now(hashset_t *hashset, size_t new_size) {
+    resize(hashset, new_size);
+    if (is_rehashing(hashset)) rehash_all(hashset);
+}
+
+static void maybe_resize(hashset_t *hashset) {
+    size_t cap = hashset_get_capacity(hashset);
+    if ((float)hashset->size + 1. <= (float)cap * LOAD_FACTOR) return;
+
+    resize(hashset, cap * 2);
+}
+
+// Shrinks the table once it is mostly empty. The new table still has room for
+// twice as many entries, so the table does not keep growing and shrinking when
+// the size goes back and forth around the threshold.
+static void maybe_shrink(hashset_t *hashset) {
+    if (is_rehashing(hashset) || hashset->max_size <= hashset->min_size) return;
+    if ((float)hashset->size >= (float)hashset->max_size * SHRINK_FACTOR) return;
+
+    size_t new_size = capacity_for(hashset->size * 2);
+    if (new_size < hashset->min_size) new_size = hashset->min_size;
+    if (new_size < hashset->max_size) resize(hashset, new_size);
+}
+
+// Walks a chain and returns the link that points to the entry with the key, or
+// the link at the end of the chain if there is no such entry.
+static hashset_entry_t **find_link(hashset_entry_t **link, char *key, uint64_t hash, size_t len) {
+    for (; *link && !entry_matches(*link, key, hash, len);
+         link = &(*link)->next);
+
+    return link;
+}
+
+// Finds the link to the entry with a key in whichever table it is.
+static hashset_entry_t **hashset_find(hashset_t *hashset, char *key, uint64_t hash, size_t len) {
+    if (is_rehashing(hashset)) rehash_step(hashset, REHASH_STEP);
+
+    hashset_entry_t **link = NULL;
+    size_t idx = bucket_of(hash, hashset->max_size);
+    // Buckets before rehash_idx were already moved to the new table.
+    if (!is_rehashing(hashset) || idx >= hashset->rehash_idx)
+        link = find_link(&hashset->entries[idx], key, hash, len);
+
+    if ((!link || !*link) && is_rehashing(hashset))
+        link = find_link(&hashset->new_entries[bucket_of(hash, hashset->new_size)], key, hash, len);
+
+    return link;
+}
+
+hashset_t *hashset_create_with(hashset_opts_t opts) {
     hashset_t *hashset = (hashset_t *)malloc(sizeof(hashset_t));
-    hashset->max_size = size;
+    hashset->max_size = pow2_ceil(opts.size > 0 ? opts.size : SET_DEFAULT_SZ);
+    hashset->min_size = hashset->max_size;
     hashset->size = 0;
-    hashset->entries = (hashset_entry_t **)calloc(size, sizeof(hashset_entry_t *));
+    hashset->incremental = opts.incremental;
+    hashset->hash = opts.hash ? opts.hash : HASH_DEFAULT;
+    hashset->seed = opts.seed ? opts.seed : hash_random_seed();
+    hashset->entries = (hashset_entry_t **)calloc(hashset->max_size, sizeof(hashset_entry_t *));
+    hashset->new_entries = NULL;
+    hashset->new_size = 0;
+    hashset->rehash_idx = 0;
     return hashset;
 }
 
+hashset_t *hashset_create_sized(size_t size) {
+    return hashset_create_with(HASHSET_OPTS(.size = size));
+}
+
 hashset_t *hashset_create() {
     return hashset_create_sized(SET_DEFAULT_SZ);
 }
 
 bool hashset_contains(hashset_t *hashset, char *key) {
-    if (hashset_get_entry(hashset, key)) return true;
+    size_t len;
+    uint64_t h = hash(hashset, key, &len);
+    if (*hashset_find(hashset, key, h, len)) return true;
     return false;
 }
 
+// Looks up a batch of hashed keys. Each pass only issues prefetches for the
+// next memory access of every key (bucket, entry, key of the entry), so the
+// cache misses of different keys overlap instead of happening one by one.
+static size_t contains_batch(hashset_t *hashset, char **keys, uint64_t *hashes,
+                             size_t *lens, size_t n, bool *out) {
+    size_t found = 0;
+    if (is_rehashing(hashset)) {
+        // Keys may be in either table, the table is only like this for a short
+        // while so keys are just looked up one at a time.
+        for (size_t i = 0; i < n; i++)
+            found += out[i] = *hashset_find(hashset, keys[i], hashes[i], lens[i]) != NULL;
+        return found;
+    }
+
+    hashset_entry_t **heads[BATCH_SZ];
+    for (size_t i = 0; i < n; i++) {
+        heads[i] = &hashset->entries[bucket_of(hashes[i], hashset->max_size)];
+        __builtin_prefetch(heads[i]);
+    }
+    for (size_t i = 0; i < n; i++)
+        if (*heads[i]) __builtin_prefetch(*heads[i]);
+
+    for (size_t i = 0; i < n; i++)
+        if (*heads[i] && (*heads[i])->hash == hashes[i])
+            __builtin_prefetch((*heads[i])->key);
+
+    for (size_t i = 0; i < n; i++)
+        found += out[i] = *find_link(heads[i], keys[i], hashes[i], lens[i]) != NULL;
+    return found;
+}
+
+size_t hashset_contains_many(hashset_t *hashset, char **keys, size_t n, bool *out) {
+    uint64_t hashes[BATCH_SZ];
+    size_t lens[BATCH_SZ];
+    size_t found = 0;
+
+    for (size_t base = 0; base < n; base += BATCH_SZ) {
+        size_t batch = n - base < BATCH_SZ ? n - base : BATCH_SZ;
+        for (size_t i = 0; i < batch; i++)
+            hashes[i] = hash(hashset, keys[base + i], &lens[i]);
+
+        found += contains_batch(hashset, keys + base, hashes, lens, batch, out + base);
+    }
+    return found;
+}
+
 size_t hashset_get_size(hashset_t *hashset) { return hashset->size; }
 
-bool hashset_insert_entry(hashset_t *hashset, hashset_entry_t *entry) {
-    hashset_entry_t *prev_entry = hashset_get_entry(hashset, entry->key);
-    if (prev_entry && !strcmp(prev_entry->key, entry->key)) return false;
+size_t hashset_get_capacity(hashset_t *hashset) {
+    return is_rehashing(hashset) ? hashset->new_size : hashset->max_size;
+}
 
-    maybe_resize(hashset);
-    size_t idx = hash(entry->key) % hashset->max_size;
+void hashset_get_hash(hashset_t *hashset, hash_fn_t *hash, uint64_t *seed) {
+    *hash = hashset->hash;
+    *seed = hashset->seed;
+}
 
-    entry->next = hashset->entries[idx];
-    hashset->entries[idx] = entry;
-    hashset->size++;
+void hashset_reserve(hashset_t *hashset, size_t n) {
+    size_t cap = capacity_for(n);
+    if (cap > hashset->min_size) hashset->min_size = cap;
+    if (cap > hashset_get_capacity(hashset)) resize_now(hashset, cap);
+}
+
+void hashset_shrink_to_fit(hashset_t *hashset) {
+    size_t cap = capacity_for(hashset->size);
+    hashset->min_size = SET_DEFAULT_SZ;
+    if (cap < hashset_get_capacity(hashset)) resize_now(hashset, cap);
+}
+
+hashset_iter_t hashset_iter(hashset_t *hashset) {
+    if (is_rehashing(hashset)) rehash_all(hashset);
+    return (hashset_iter_t){ .hashset = hashset, .idx = 0, .entry = NULL };
+}
+
+bool hashset_iter_next(hashset_iter_t *it, char **key) {
+    hashset_t *hashset = it->hashset;
+    hashset_entry_t *entry = it->entry ? it->entry->next : NULL;
+    while (!entry && it->idx < hashset->max_size)
+        entry = hashset->entries[it->idx++];
+
+    it->entry = entry;
+    if (!entry) return false;
+
+    *key = entry->key;
     return true;
 }
 
-bool hashset_insert(hashset_t *hashset, char *key) {
-    hashset_entry_t *entry = hashset_get_entry(hashset, key);
-    if (entry && !strcmp(entry->key, key)) return false;
+static size_t scan_bucket(hashset_entry_t *entry, hashset_scan_fn_t fn, void *ctx) {
+    size_t n = 0;
+    for (; entry; entry = entry->next, n++)
+        fn(entry->key, ctx);
+
+    return n;
+}
+
+// While rehashing, both tables are scanned: the bucket of the cursor in the
+// smaller table and every bucket of the larger table that it splits into.
+size_t hashset_scan(hashset_t *hashset, size_t cursor, size_t count,
+                    hashset_scan_fn_t fn, void *ctx) {
+    size_t visited = 0;
+    do {
+        if (!is_rehashing(hashset)) {
+            size_t mask = hashset->max_size - 1;
+            visited += scan_bucket(hashset->entries[cursor & mask], fn, ctx);
+            cursor = cursor_next(cursor, mask);
+            continue;
+        }
+
+        hashset_entry_t **small = hashset->entries, **large = hashset->new_entries;
+        size_t small_mask = hashset->max_size - 1, large_mask = hashset->new_size - 1;
+        if (hashset->new_size < hashset->max_size) {
+            small = hashset->new_entries;
+            large = hashset->entries;
+            small_mask = hashset->new_size - 1;
+            large_mask = hashset->max_size - 1;
+        }
+
+        visited += scan_bucket(small[cursor & small_mask], fn, ctx);
+        do {
+            visited += scan_bucket(large[cursor & large_mask], fn, ctx);
+            cursor = cursor_next(cursor, large_mask);
+        } while (cursor & (small_mask ^ large_mask));
+    } while (cursor != 0 && visited < count);
+
+    return cursor;
+}
 
+// Links an entry whose key is not in the hashset yet.
+static void add_entry(hashset_t *hashset, hashset_entry_t *entry) {
     maybe_resize(hashset);
-    size_t idx = hash(key) % hashset->max_size;
+    // While rehashing, new entries always go to the new table.
+    hashset_entry_t **bucket = is_rehashing(hashset)
+        ? &hashset->new_entries[bucket_of(entry->hash, hashset->new_size)]
+        : &hashset->entries[bucket_of(entry->hash, hashset->max_size)];
 
-    entry = mk_entry(key, hashset->entries[idx]);
-    hashset->entries[idx] = entry;
+    entry->next = *bucket;
+    *bucket = entry;
     hashset->size++;
+}
+
+bool hashset_insert_entry(hashset_t *hashset, hashset_entry_t *entry) {
+    if (*hashset_find(hashset, entry->key, entry->hash, entry->len)) return false;
+
+    add_entry(hashset, entry);
     return true;
 }
 
-bool hashset_remove(hashset_t *hashset, char *key) {
-    size_t idx = hash(key) % hashset->max_size;
-    if (!hashset->entries[idx]) return false;
+bool hashset_insert(hashset_t *hashset, char *key) {
+    size_t len;
+    uint64_t h = hash(hashset, key, &len);
+    if (*hashset_find(hashset, key, h, len)) return false;
 
-    hashset_entry_t *del, *prev = NULL;
-    for (del = hashset->entries[idx];
-         del && strcmp(del->key, key);
-         prev = del, del = del->next);
+    add_entry(hashset, mk_entry(strndup(key, len), h, len, NULL));
+    return true;
+}
 
+bool hashset_remove(hashset_t *hashset, char *key) {
+    size_t len;
+    uint64_t h = hash(hashset, key, &len);
+    hashset_entry_t **link = hashset_find(hashset, key, h, len);
+    hashset_entry_t *del = *link;
     if (!del) return false;
-    if (!prev)
-        hashset->entries[idx] = del->next;
-    else
-        prev->next = del->next;
 
+    *link = del->next;
     free(del->key);
     free(del);
+    hashset->size--;
+    maybe_shrink(hashset);
     return true;
 }
 
-void hashset_delete(hashset_t *hashset) {
-    if (!hashset) return;
+static void free_entries(hashset_entry_t **entries, size_t size) {
     hashset_entry_t *entry, *tmp = NULL;
-    for (int i = 0; i < hashset->max_size; i++) {
-        for (entry = hashset->entries[i]; entry; entry = tmp) {
+    for (int i = 0; i < size; i++) {
+        for (entry = entries[i]; entry; entry = tmp) {
             free(entry->key);
             tmp = entry->next;
             free(entry);
         }
     }
-    free(hashset->entries);
+    free(entries);
+}
+
+void hashset_delete(hashset_t *hashset) {
+    if (!hashset) return;
+    free_entries(hashset->entries, hashset->max_size);
+    if (is_rehashing(hashset))
+        free_entries(hashset->new_entries, hashset->new_size);
+
     free(hashset);
 }
 
-static hashset_entry_t *mk_entry(char *key, hashset_entry_t *next) {
+static hashset_entry_t *mk_entry(char *key, uint64_t hash, size_t len, hashset_entry_t *next) {
     hashset_entry_t *entry = (hashset_entry_t *)malloc(sizeof(hashset_entry_t));
     entry->key = key;
+    entry->hash = hash;
+    entry->len = len;
     entry->next = next;
     return entry;
 }
 
-// Source: http://www.cse.yorku.ca/~oz/hash.html
-static size_t hash(char *str) {
-    size_t hash = 0;
-    int c;
-
-    while ((c = *str++))
-        hash = c + (hash << 6) + (hash << 16) - hash;
-
-    return hash;
+// Hashes a key with the hash function of the hashset and gets its length.
+static uint64_t hash(hashset_t *hashset, char *key, size_t *len) {
+    *len = strlen(key);
+    return hashset->hash(key, *len, hashset->seed);
 }
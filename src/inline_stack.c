@@ -0,0 +1,93 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <inline_stack.h>
+
+#define is_small(stack) ((stack)->data == (stack)->small)
+
+static size_t small_cap(istack_t *stack) {
+    return stack->elsize > 0 ? ISTACK_SMALL_BYTES / stack->elsize : 0;
+}
+
+void istack_init(istack_t *stack, size_t elsize) {
+    stack->data = stack->small;
+    stack->size = 0;
+    stack->elsize = elsize;
+    stack->cap = small_cap(stack);
+}
+
+void istack_destroy(istack_t *stack) {
+    if (!is_small(stack)) free(stack->data);
+    stack->data = stack->small;
+    stack->size = 0;
+    stack->cap = small_cap(stack);
+}
+
+istack_t *istack_create(size_t elsize) {
+    istack_t *stack = (istack_t *)malloc(sizeof(istack_t));
+    istack_init(stack, elsize);
+    return stack;
+}
+
+void istack_delete(istack_t *stack) {
+    if (!stack) return;
+    istack_destroy(stack);
+    free(stack);
+}
+
+static void grow(istack_t *stack) {
+    size_t cap = stack->cap > 0 ? stack->cap * 2 : 1;
+    if (is_small(stack)) {
+        stack->data = (unsigned char *)malloc(cap * stack->elsize);
+        memcpy(stack->data, stack->small, stack->size * stack->elsize);
+    } else {
+        stack->data = (unsigned char *)realloc(stack->data, cap * stack->elsize);
+    }
+    stack->cap = cap;
+}
+
+static void shrink(istack_t *stack) {
+    if (stack->size <= small_cap(stack)) {
+        memcpy(stack->small, stack->data, stack->size * stack->elsize);
+        free(stack->data);
+        stack->data = stack->small;
+        stack->cap = small_cap(stack);
+    } else {
+        stack->cap /= 2;
+        stack->data = (unsigned char *)realloc(stack->data, stack->cap * stack->elsize);
+    }
+}
+
+void istack_push(istack_t *stack, const void *element) {
+    if (stack->size == stack->cap) grow(stack);
+    memcpy(stack->data + stack->size++ * stack->elsize, element, stack->elsize);
+}
+
+bool istack_pop(istack_t *stack, void *element) {
+    if (stack->size == 0) return false;
+    stack->size--;
+    if (element) memcpy(element, stack->data + stack->size * stack->elsize, stack->elsize);
+    if (!is_small(stack) && stack->size < stack->cap / 4) shrink(stack);
+    return true;
+}
+
+void *istack_peek(istack_t *stack) {
+    return stack->size > 0 ? stack->data + (stack->size - 1) * stack->elsize : NULL;
+}
+
+void istack_clear(istack_t *stack) {
+    stack->size = 0;
+}
+
+size_t istack_get_size(istack_t *stack) {
+    return stack->size;
+}
+
+size_t istack_get_cap(istack_t *stack) {
+    return stack->cap;
+}
+
+bool istack_is_empty(istack_t *stack) {
+    return stack->size == 0;
+}
@@ -80,7 +80,11 @@ parser_result_t json_parse_object(char **input, json_object_t **parsed) {
     skip_space(&ptr);
     PARSER_ASSERT(parse_char('{', &ptr));
 
-    dict_t *pairs = dict_create();
+    // The ordered engine keeps the pairs in document order. Most objects have
+    // few keys, and a dict this small stores them inline, in one allocation.
+    // Objects are built once and deleted as a whole, so the keys of larger
+    // objects come from an arena.
+    dict_t *pairs = dict_create_with(DICT_OPTS(.kind = DICT_ORDERED, .size = 8, .arena = true));
 
     json_pair_t pair;
     skip_space(&ptr);
@@ -122,8 +126,8 @@ parser_result_t json_parse_array(char **input, json_array_t **parsed) {
     while (json_parse_value(&ptr, &item) == PARSER_SUCCESS) {
         skip_space(&ptr);
         if (i >= alloc) {
-            if ((alloc *= 2) == 0) alloc = 8 * sizeof(json_value_t *);
-            vec = (json_value_t **)realloc(vec, alloc);
+            if ((alloc *= 2) == 0) alloc = 8;
+            vec = (json_value_t **)realloc(vec, alloc * sizeof(json_value_t *));
         }
         vec[i++] = item;
         if (!parse_char(',', &ptr))
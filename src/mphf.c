@@ -0,0 +1,263 @@
+/**
+ * Minimal perfect hash function (see mphf.h).
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <mphf.h>
+
+#define DEFAULT_C 4.5
+#define DEFAULT_ALPHA 0.99
+#define DENSE_KEYS 0.6    // Ratio of keys that fall in the dense buckets...
+#define DENSE_BUCKETS 0.3 // ... and ratio of the buckets that are dense.
+#define MAX_PILOT (1 << 20) // Past this, the build starts over with a new seed.
+#define MAX_ATTEMPTS 32
+
+struct _mphf {
+    size_t n;
+    size_t n_buckets;
+    size_t table_size;
+    uint64_t seed;
+    uint64_t dense_threshold; // Hashes with low 32 bits below go to a dense bucket.
+    size_t n_dense;           // Number of dense buckets.
+    uint64_t *pilots;         // Packed, pilot_width bits each.
+    int pilot_width;
+    uint64_t *remap;          // Packed, remap_width bits each.
+    int remap_width;
+};
+
+typedef enum {
+    BUILD_OK,
+    BUILD_RETRY,     // Unlucky seed, try another one.
+    BUILD_DUPLICATE, // Two keys are the same.
+} build_result_t;
+
+/* Arrays of integers of `width` bits, with a word of padding at the end */
+
+static inline size_t packed_words(size_t n, int width) { return (n * width + 63) / 64 + 1; }
+
+static void packed_set(uint64_t *words, size_t i, int width, uint64_t value) {
+    size_t bit = i * width, w = bit >> 6;
+    int offset = bit & 63;
+    words[w] |= value << offset;
+    if (offset + width > 64) words[w + 1] |= value >> (64 - offset);
+}
+
+static inline uint64_t packed_get(const uint64_t *words, size_t i, int width) {
+    size_t bit = i * width, w = bit >> 6;
+    int offset = bit & 63;
+    uint64_t value = words[w] >> offset;
+    if (offset + width > 64) value |= words[w + 1] << (64 - offset);
+    return value & ((1ULL << width) - 1);
+}
+
+static int bit_width(uint64_t value) { return value ? 64 - __builtin_clzll(value) : 1; }
+
+/* Hash to bucket and position */
+
+static inline size_t fastrange(uint64_t x, size_t n) {
+    return (size_t)(((__uint128_t)x * n) >> 64);
+}
+
+static inline size_t bucket_of(mphf_t *mphf, uint64_t hash) {
+    uint64_t x = hash >> 32;
+    if ((hash & 0xffffffff) < mphf->dense_threshold) return (x * mphf->n_dense) >> 32;
+    return mphf->n_dense + ((x * (mphf->n_buckets - mphf->n_dense)) >> 32);
+}
+
+static inline size_t position(mphf_t *mphf, uint64_t hash, uint64_t pilot) {
+    return fastrange(hash_mix(hash ^ (pilot * 0x9e3779b97f4a7c15ULL)), mphf->table_size);
+}
+
+/* Build */
+
+static void sort_hashes(uint64_t *hashes, size_t n) {
+    for (size_t i = 1; i < n; i++) {
+        uint64_t h = hashes[i];
+        size_t j = i;
+        for (; j > 0 && hashes[j - 1] > h; j--) hashes[j] = hashes[j - 1];
+        hashes[j] = h;
+    }
+}
+
+// Tries pilots for the keys of a bucket until they all fall on free positions.
+static bool place_bucket(mphf_t *mphf, uint64_t *taken, uint64_t *hashes, size_t size,
+                         size_t *positions, uint64_t *pilot) {
+    for (uint64_t p = 0; p < MAX_PILOT; p++) {
+        size_t j = 0;
+        for (; j < size; j++) {
+            size_t pos = position(mphf, hashes[j], p);
+            if (taken[pos >> 6] & (1ULL << (pos & 63))) break;
+            // Marked right away, so keys of the bucket don't collide either.
+            taken[pos >> 6] |= 1ULL << (pos & 63);
+            positions[j] = pos;
+        }
+        if (j == size) {
+            *pilot = p;
+            return true;
+        }
+        while (j-- > 0) taken[positions[j] >> 6] &= ~(1ULL << (positions[j] & 63));
+    }
+    return false;
+}
+
+// Tells apart keys that are repeated from different keys with the same hash.
+static bool has_duplicate(char **keys, uint64_t *key_hashes, size_t n, uint64_t hash) {
+    char *first = NULL;
+    for (size_t i = 0; i < n; i++) {
+        if (key_hashes[i] != hash) continue;
+        if (first && strcmp(first, keys[i]) == 0) return true;
+        first = keys[i];
+    }
+    return false;
+}
+
+static build_result_t try_build(mphf_t *mphf, char **keys, uint64_t *key_hashes) {
+    size_t n = mphf->n, m = mphf->n_buckets;
+    for (size_t i = 0; i < n; i++) key_hashes[i] = hash_wy(keys[i], strlen(keys[i]), mphf->seed);
+
+    // Groups the hashes by bucket (counting sort).
+    size_t *start = (size_t *)calloc(m + 1, sizeof(size_t));
+    uint64_t *hashes = (uint64_t *)malloc((n ? n : 1) * sizeof(uint64_t));
+    for (size_t i = 0; i < n; i++) start[bucket_of(mphf, key_hashes[i]) + 1]++;
+    size_t max_size = 0;
+    for (size_t b = 0; b < m; b++) {
+        if (start[b + 1] > max_size) max_size = start[b + 1];
+        start[b + 1] += start[b];
+    }
+    size_t *fill = (size_t *)malloc(m * sizeof(size_t));
+    memcpy(fill, start, m * sizeof(size_t));
+    for (size_t i = 0; i < n; i++) hashes[fill[bucket_of(mphf, key_hashes[i])]++] = key_hashes[i];
+
+    // Orders the buckets from the largest to the smallest (counting sort).
+    size_t *by_size = (size_t *)calloc(max_size + 2, sizeof(size_t));
+    for (size_t b = 0; b < m; b++) by_size[max_size - (start[b + 1] - start[b]) + 1]++;
+    for (size_t s = 0; s <= max_size; s++) by_size[s + 1] += by_size[s];
+    size_t *order = fill;
+    for (size_t b = 0; b < m; b++) order[by_size[max_size - (start[b + 1] - start[b])]++] = b;
+
+    uint64_t *taken = (uint64_t *)calloc(mphf->table_size / 64 + 1, sizeof(uint64_t));
+    uint32_t *pilots = (uint32_t *)calloc(m, sizeof(uint32_t));
+    size_t *positions = (size_t *)malloc((max_size ? max_size : 1) * sizeof(size_t));
+    build_result_t result = BUILD_OK;
+    uint64_t max_pilot = 0;
+
+    for (size_t i = 0; i < m && result == BUILD_OK; i++) {
+        size_t b = order[i], size = start[b + 1] - start[b];
+        if (size == 0) break;
+
+        // Keys with the same hash can't ever be told apart.
+        uint64_t *bucket = hashes + start[b];
+        sort_hashes(bucket, size);
+        for (size_t j = 1; j < size && result == BUILD_OK; j++) {
+            if (bucket[j] != bucket[j - 1]) continue;
+            result = has_duplicate(keys, key_hashes, n, bucket[j]) ? BUILD_DUPLICATE : BUILD_RETRY;
+        }
+
+        uint64_t pilot;
+        if (result == BUILD_OK && !place_bucket(mphf, taken, bucket, size, positions, &pilot))
+            result = BUILD_RETRY;
+        if (result != BUILD_OK) break;
+
+        pilots[b] = (uint32_t)pilot;
+        if (pilot > max_pilot) max_pilot = pilot;
+    }
+
+    if (result == BUILD_OK) {
+        mphf->pilot_width = bit_width(max_pilot);
+        mphf->pilots = (uint64_t *)calloc(packed_words(m, mphf->pilot_width), sizeof(uint64_t));
+        for (size_t b = 0; b < m; b++) packed_set(mphf->pilots, b, mphf->pilot_width, pilots[b]);
+
+        // Each position taken past n is given one of the free slots below n,
+        // there are as many of both.
+        size_t extra = mphf->table_size - n;
+        mphf->remap_width = bit_width(n ? n - 1 : 0);
+        mphf->remap = (uint64_t *)calloc(packed_words(extra, mphf->remap_width), sizeof(uint64_t));
+        size_t free_slot = 0;
+        for (size_t pos = n; pos < mphf->table_size; pos++) {
+            if (!(taken[pos >> 6] & (1ULL << (pos & 63)))) continue;
+            while (taken[free_slot >> 6] & (1ULL << (free_slot & 63))) free_slot++;
+            packed_set(mphf->remap, pos - n, mphf->remap_width, free_slot++);
+        }
+    }
+
+    free(start);
+    free(hashes);
+    free(fill);
+    free(by_size);
+    free(taken);
+    free(pilots);
+    free(positions);
+    return result;
+}
+
+mphf_t *mphf_build_with(char **keys, size_t n, mphf_opts_t opts) {
+    mphf_t *mphf = (mphf_t *)malloc(sizeof(mphf_t));
+    double c = opts.c > 0 ? opts.c : DEFAULT_C;
+    double alpha = opts.alpha > 0 && opts.alpha <= 1 ? opts.alpha : DEFAULT_ALPHA;
+
+    mphf->n = n;
+    mphf->n_buckets = (size_t)(c * n / (n > 2 ? bit_width(n) - 1 : 1)) + 1;
+    mphf->table_size = (size_t)(n / alpha);
+    if (mphf->table_size < n) mphf->table_size = n;
+    if (mphf->table_size == 0) mphf->table_size = 1;
+    if (mphf->n_buckets >= 2) {
+        mphf->n_dense = (size_t)(mphf->n_buckets * DENSE_BUCKETS);
+        if (mphf->n_dense == 0) mphf->n_dense = 1;
+        mphf->dense_threshold = (uint64_t)(DENSE_KEYS * 4294967296.0);
+    } else {
+        mphf->n_dense = 1;
+        mphf->dense_threshold = 1ULL << 32;
+    }
+    mphf->seed = opts.seed ? opts.seed : hash_random_seed();
+
+    uint64_t *key_hashes = (uint64_t *)malloc((n ? n : 1) * sizeof(uint64_t));
+    build_result_t result = BUILD_RETRY;
+    for (int attempt = 0; attempt < MAX_ATTEMPTS && result == BUILD_RETRY; attempt++) {
+        if (attempt > 0) mphf->seed = hash_random_seed();
+        result = try_build(mphf, keys, key_hashes);
+    }
+    free(key_hashes);
+
+    if (result != BUILD_OK) {
+        free(mphf);
+        return NULL;
+    }
+    return mphf;
+}
+
+mphf_t *mphf_build(char **keys, size_t n) { return mphf_build_with(keys, n, MPHF_OPTS()); }
+
+mphf_t *mphf_from_hashset(hashset_t *hashset) {
+    size_t n = hashset_get_size(hashset), i = 0;
+    char **keys = (char **)malloc((n ? n : 1) * sizeof(char *));
+    for (hashset_iter_t it = hashset_iter(hashset); hashset_iter_next(&it, &keys[i]); i++);
+
+    mphf_t *mphf = mphf_build(keys, n);
+    free(keys);
+    return mphf;
+}
+
+size_t mphf_index(mphf_t *mphf, char *key) {
+    uint64_t hash = hash_wy(key, strlen(key), mphf->seed);
+    uint64_t pilot = packed_get(mphf->pilots, bucket_of(mphf, hash), mphf->pilot_width);
+    size_t pos = position(mphf, hash, pilot);
+    if (pos < mphf->n) return pos;
+    return mphf->n ? packed_get(mphf->remap, pos - mphf->n, mphf->remap_width) : 0;
+}
+
+size_t mphf_get_size(mphf_t *mphf) { return mphf->n; }
+
+size_t mphf_get_bits(mphf_t *mphf) {
+    return mphf->n_buckets * mphf->pilot_width + (mphf->table_size - mphf->n) * mphf->remap_width;
+}
+
+void mphf_delete(mphf_t *mphf) {
+    if (!mphf) return;
+    free(mphf->pilots);
+    free(mphf->remap);
+    free(mphf);
+}
@@ -0,0 +1,225 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <pool.h>
+#include <wsdeque.h>
+#include <queue_bank.h>
+
+#define DEQUE_CAP 64 // Starting slots of each deque, enough for a deep recursion.
+
+#define load_relaxed(p)      __atomic_load_n((p), __ATOMIC_RELAXED)
+#define load_acquire(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define store_release(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+typedef struct {
+    pool_t *pool;
+    wsdeque_t *deque;
+    pthread_t thread;
+    uint64_t rng;
+} worker_t;
+
+struct _pool {
+    worker_t *workers;
+    size_t n;
+    pthread_mutex_t lock;
+    pthread_cond_t work;     // Signaled when epoch changes.
+    pthread_cond_t finished; // Broadcast when an external task is done.
+    uint32_t epoch;          // Bumped (under the lock) to wake sleeping workers.
+    uint32_t sleepers;
+    size_t pending;          // Tasks in external, to check it without the lock.
+    queue_t *external;       // Tasks of pool_run, guarded by the lock.
+    bool stop;
+};
+
+// The worker running on this thread, if any.
+static _Thread_local worker_t *current = NULL;
+
+static uint64_t xorshift(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static void run(pool_t *pool, pool_task_t *task) {
+    task->fn(task->arg);
+    if (!task->external) {
+        // The joining thread may return (and free the task) right after this.
+        store_release(&task->done, 1);
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    task->done = 1;
+    pthread_cond_broadcast(&pool->finished);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Tries every other worker once, from a random one.
+static pool_task_t *steal(worker_t *worker) {
+    pool_t *pool = worker->pool;
+    size_t start = xorshift(&worker->rng) % pool->n;
+    for (size_t i = 0; i < pool->n; i++) {
+        worker_t *victim = &pool->workers[(start + i) % pool->n];
+        if (victim == worker) continue;
+        pool_task_t *task = (pool_task_t *)wsdeque_steal(victim->deque);
+        if (task) return task;
+    }
+    return NULL;
+}
+
+static pool_task_t *take_external(pool_t *pool) {
+    if (load_relaxed(&pool->pending) == 0) return NULL;
+    pool_task_t *task = NULL;
+    pthread_mutex_lock(&pool->lock);
+    if (!queue_is_empty(pool->external)) {
+        task = *(pool_task_t **)queue_pop(pool->external);
+        __atomic_store_n(&pool->pending, pool->pending - 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return task;
+}
+
+static pool_task_t *find_task(worker_t *worker) {
+    pool_task_t *task = (pool_task_t *)wsdeque_pop(worker->deque);
+    if (!task) task = steal(worker);
+    if (!task) task = take_external(worker->pool);
+    return task;
+}
+
+// Wakes a sleeping worker, if any, after a task was made available.
+static void notify(pool_t *pool) {
+    // Pairs with the fence of a worker going to sleep: either it sees the new
+    // task or this sees it sleeping.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (load_relaxed(&pool->sleepers) == 0) return;
+    pthread_mutex_lock(&pool->lock);
+    __atomic_store_n(&pool->epoch, pool->epoch + 1, __ATOMIC_RELAXED);
+    pthread_cond_signal(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void *worker_loop(void *arg) {
+    worker_t *worker = (worker_t *)arg;
+    pool_t *pool = worker->pool;
+    current = worker;
+
+    for (;;) {
+        pool_task_t *task = find_task(worker);
+        if (task) {
+            run(pool, task);
+            continue;
+        }
+
+        // Announces it is going to sleep, then looks once more, so a task made
+        // available meanwhile is either found now or wakes it up.
+        uint32_t epoch = load_acquire(&pool->epoch);
+        __atomic_fetch_add(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+        task = find_task(worker);
+        if (task) {
+            __atomic_fetch_sub(&pool->sleepers, 1, __ATOMIC_RELAXED);
+            run(pool, task);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        while (pool->epoch == epoch && !pool->stop) pthread_cond_wait(&pool->work, &pool->lock);
+        bool stop = pool->stop;
+        pthread_mutex_unlock(&pool->lock);
+        __atomic_fetch_sub(&pool->sleepers, 1, __ATOMIC_RELAXED);
+        if (stop) break;
+    }
+    return NULL;
+}
+
+pool_t *pool_create(size_t threads) {
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? cpus : 1;
+    }
+
+    pool_t *pool = (pool_t *)malloc(sizeof(pool_t));
+    pool->workers = (worker_t *)malloc(threads * sizeof(worker_t));
+    pool->n = threads;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->finished, NULL);
+    pool->epoch = 0;
+    pool->sleepers = 0;
+    pool->pending = 0;
+    pool->external = queue_create(sizeof(pool_task_t *));
+    pool->stop = false;
+
+    // Every deque exists before any worker may try to steal from it.
+    for (size_t i = 0; i < threads; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].deque = wsdeque_create(DEQUE_CAP);
+        pool->workers[i].rng = 0x9e3779b97f4a7c15ULL * (i + 1);
+    }
+    for (size_t i = 0; i < threads; i++)
+        pthread_create(&pool->workers[i].thread, NULL, worker_loop, &pool->workers[i]);
+    return pool;
+}
+
+void pool_run(pool_t *pool, pool_fn_t fn, void *arg) {
+    if (current && current->pool == pool) return fn(arg);
+
+    pool_task_t task = POOL_TASK(fn, arg), *ptr = &task;
+    task.external = true;
+
+    pthread_mutex_lock(&pool->lock);
+    queue_push(pool->external, &ptr);
+    __atomic_store_n(&pool->pending, pool->pending + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&pool->epoch, pool->epoch + 1, __ATOMIC_RELAXED);
+    pthread_cond_signal(&pool->work);
+    while (!task.done) pthread_cond_wait(&pool->finished, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void pool_fork(pool_task_t *task) {
+    task->done = 0;
+    task->external = false;
+    if (!current) {
+        task->fn(task->arg);
+        task->done = 1;
+        return;
+    }
+    wsdeque_push(current->deque, task);
+    notify(current->pool);
+}
+
+void pool_join(pool_task_t *task) {
+    worker_t *worker = current;
+    while (!load_acquire(&task->done)) {
+        // Unless it was stolen, the task is the last one pushed.
+        pool_task_t *other = (pool_task_t *)wsdeque_pop(worker->deque);
+        if (!other) other = steal(worker);
+        if (other) run(worker->pool, other);
+        else sched_yield();
+    }
+}
+
+size_t pool_get_threads(pool_t *pool) {
+    return pool->n;
+}
+
+void pool_delete(pool_t *pool) {
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->n; i++) pthread_join(pool->workers[i].thread, NULL);
+    for (size_t i = 0; i < pool->n; i++) wsdeque_delete(pool->workers[i].deque);
+    queue_delete(pool->external);
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->finished);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
@@ -0,0 +1,199 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <pqueue.h>
+
+#define ARITY 4
+#define MIN_CAP 16
+
+// Marks the entries of free handles in slots, which hold the next free handle.
+#define FREE_BIT ((size_t)1 << (sizeof(size_t) * 8 - 1))
+#define NO_HANDLE (~(size_t)0)
+
+struct _pqueue {
+    unsigned char *data;  // The heap of elements.
+    size_t *handles;      // The handle of the element in each slot.
+    size_t *slots;        // The slot of each handle, or the next free handle.
+    size_t size;
+    size_t cap;
+    size_t n_handles;     // Handles given so far, free or not.
+    size_t free_handle;   // First free handle, or NO_HANDLE.
+    size_t elsize;
+    comp_t comp;
+    unsigned char *hole;  // The element moving up or down.
+};
+
+#define element_at(queue, i) ((queue)->data + (i) * (queue)->elsize)
+
+static pqueue_t *alloc_queue(size_t elsize, comp_t comp, size_t cap) {
+    pqueue_t *queue = (pqueue_t *)malloc(sizeof(pqueue_t));
+    if (cap < MIN_CAP) cap = MIN_CAP;
+    queue->data = (unsigned char *)malloc(cap * elsize);
+    queue->handles = (size_t *)malloc(cap * sizeof(size_t));
+    queue->slots = (size_t *)malloc(cap * sizeof(size_t));
+    queue->size = 0;
+    queue->cap = cap;
+    queue->n_handles = 0;
+    queue->free_handle = NO_HANDLE;
+    queue->elsize = elsize;
+    queue->comp = comp;
+    queue->hole = (unsigned char *)malloc(elsize);
+    return queue;
+}
+
+pqueue_t *pqueue_create(size_t elsize, comp_t comp) {
+    return alloc_queue(elsize, comp, MIN_CAP);
+}
+
+// Puts the element in queue->hole at slot i, with its handle.
+static inline void fill(pqueue_t *queue, size_t i, size_t handle) {
+    memcpy(element_at(queue, i), queue->hole, queue->elsize);
+    queue->handles[i] = handle;
+    queue->slots[handle] = i;
+}
+
+// Moves the element at slot j to slot i.
+static inline void move(pqueue_t *queue, size_t i, size_t j) {
+    memcpy(element_at(queue, i), element_at(queue, j), queue->elsize);
+    queue->handles[i] = queue->handles[j];
+    queue->slots[queue->handles[i]] = i;
+}
+
+// Moves the element in queue->hole up from slot i, returns its final slot.
+static size_t sift_up(pqueue_t *queue, size_t i) {
+    while (i > 0) {
+        size_t parent = (i - 1) / ARITY;
+        if (queue->comp(queue->hole, element_at(queue, parent)) >= 0) break;
+        move(queue, i, parent);
+        i = parent;
+    }
+    return i;
+}
+
+// Moves the element in queue->hole down from slot i, returns its final slot.
+static size_t sift_down(pqueue_t *queue, size_t i) {
+    for (;;) {
+        size_t first = i * ARITY + 1;
+        if (first >= queue->size) break;
+        size_t last = first + ARITY < queue->size ? first + ARITY : queue->size;
+
+        size_t min = first;
+        for (size_t c = first + 1; c < last; c++)
+            if (queue->comp(element_at(queue, c), element_at(queue, min)) < 0) min = c;
+        if (queue->comp(element_at(queue, min), queue->hole) >= 0) break;
+
+        move(queue, i, min);
+        i = min;
+    }
+    return i;
+}
+
+pqueue_t *pqueue_from_array(const void *elements, size_t n, size_t elsize, comp_t comp) {
+    pqueue_t *queue = alloc_queue(elsize, comp, n);
+    memcpy(queue->data, elements, n * elsize);
+    for (size_t i = 0; i < n; i++) queue->handles[i] = queue->slots[i] = i;
+    queue->size = queue->n_handles = n;
+
+    // Sifts down every slot that has children, the last ones first.
+    for (size_t i = n > 1 ? (n - 2) / ARITY + 1 : 0; i-- > 0;) {
+        size_t handle = queue->handles[i];
+        memcpy(queue->hole, element_at(queue, i), elsize);
+        fill(queue, sift_down(queue, i), handle);
+    }
+    return queue;
+}
+
+static size_t new_handle(pqueue_t *queue) {
+    if (queue->free_handle != NO_HANDLE) {
+        size_t handle = queue->free_handle;
+        size_t next = queue->slots[handle] & ~FREE_BIT;
+        queue->free_handle = next == (NO_HANDLE & ~FREE_BIT) ? NO_HANDLE : next;
+        return handle;
+    }
+    // There are never more handles than the capacity, since each one given so
+    // far had an element at some point.
+    return queue->n_handles++;
+}
+
+static void free_handle(pqueue_t *queue, size_t handle) {
+    queue->slots[handle] = queue->free_handle | FREE_BIT;
+    queue->free_handle = handle;
+}
+
+pqueue_handle_t pqueue_push(pqueue_t *queue, const void *element) {
+    if (queue->size == queue->cap) {
+        queue->cap *= 2;
+        queue->data = (unsigned char *)realloc(queue->data, queue->cap * queue->elsize);
+        queue->handles = (size_t *)realloc(queue->handles, queue->cap * sizeof(size_t));
+        queue->slots = (size_t *)realloc(queue->slots, queue->cap * sizeof(size_t));
+    }
+    size_t handle = new_handle(queue);
+    memcpy(queue->hole, element, queue->elsize);
+    fill(queue, sift_up(queue, queue->size++), handle);
+    return handle;
+}
+
+// Takes the element out of slot i, filling its place with the last element.
+static void remove_at(pqueue_t *queue, size_t i, void *element) {
+    if (element) memcpy(element, element_at(queue, i), queue->elsize);
+    free_handle(queue, queue->handles[i]);
+
+    size_t last = --queue->size;
+    if (i == last) return;
+    size_t handle = queue->handles[last];
+    memcpy(queue->hole, element_at(queue, last), queue->elsize);
+    // The last element may be smaller than the parent of i when i is not in
+    // its subtree.
+    size_t slot = sift_up(queue, i);
+    if (slot == i) slot = sift_down(queue, i);
+    fill(queue, slot, handle);
+}
+
+bool pqueue_pop(pqueue_t *queue, void *element) {
+    if (queue->size == 0) return false;
+    remove_at(queue, 0, element);
+    return true;
+}
+
+void *pqueue_peek(pqueue_t *queue) {
+    return queue->size > 0 ? queue->data : NULL;
+}
+
+void *pqueue_get(pqueue_t *queue, pqueue_handle_t handle) {
+    return element_at(queue, queue->slots[handle]);
+}
+
+void pqueue_update(pqueue_t *queue, pqueue_handle_t handle, const void *element) {
+    size_t i = queue->slots[handle];
+    memcpy(queue->hole, element, queue->elsize);
+    size_t slot = sift_up(queue, i);
+    if (slot == i) slot = sift_down(queue, i);
+    fill(queue, slot, handle);
+}
+
+void pqueue_remove(pqueue_t *queue, pqueue_handle_t handle, void *element) {
+    remove_at(queue, queue->slots[handle], element);
+}
+
+bool pqueue_contains(pqueue_t *queue, pqueue_handle_t handle) {
+    return handle < queue->n_handles && !(queue->slots[handle] & FREE_BIT);
+}
+
+size_t pqueue_get_size(pqueue_t *queue) {
+    return queue->size;
+}
+
+bool pqueue_is_empty(pqueue_t *queue) {
+    return queue->size == 0;
+}
+
+void pqueue_delete(pqueue_t *queue) {
+    if (!queue) return;
+    free(queue->data);
+    free(queue->handles);
+    free(queue->slots);
+    free(queue->hole);
+    free(queue);
+}
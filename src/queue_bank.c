@@ -1,107 +1,165 @@
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 #include <queue_bank.h>
 
-typedef struct {
-    uint next;
-} node_t;
+#define MIN_SEGMENT 16              // Elements in the first segment by default.
+#define MAX_SEGMENT_BYTES (1 << 16) // Segments stop doubling past this size.
 
-struct _queue {
-    node_t *nodes;
-    void *data;
-    uint start;
-    uint end;
-    uint empty;
-    uint size;
+// A block of contiguous slots, elements are in [begin, end).
+typedef struct _segment {
+    struct _segment *next;
+    size_t begin;
+    size_t end;
     size_t cap;
+    _Alignas(max_align_t) unsigned char data[];
+} segment_t;
+
+// Elements are in a list of segments, popped from the first and pushed to the
+// last. A segment that was emptied is kept as `spare` for the next one needed.
+struct _queue {
+    segment_t *first;
+    segment_t *last;
+    segment_t *spare;
+    size_t size;
     size_t elsize;
+    size_t next_cap; // Slots of the next segment allocated.
 };
 
 queue_t *queue_create(size_t elsize) {
     queue_t *queue = (queue_t *)malloc(sizeof(queue_t));
-    queue->cap = 0;
-    queue->elsize = elsize;
-    queue->nodes = NULL;
-    queue->data = NULL;
-    queue->start = 0;
-    queue->end = 0;
+    queue->first = NULL;
+    queue->last = NULL;
+    queue->spare = NULL;
     queue->size = 0;
-    queue->empty = 0;
+    queue->elsize = elsize;
+    queue->next_cap = MIN_SEGMENT;
     return queue;
 }
 
 queue_t *queue_create_with_cap(size_t elsize, size_t cap) {
     queue_t *queue = queue_create(elsize);
-    queue->cap = cap;
-    queue->nodes = (node_t *)malloc(cap * sizeof(node_t));
-    queue->data = malloc(elsize * cap);
+    if (cap > 0) queue->next_cap = cap;
+    return queue;
+}
 
-    for (int i = 0; i < queue->cap; i++)
-        if (i == queue->cap - 1)
-            queue->nodes[i].next = -1U;
-        else
-            queue->nodes[i].next = i + 1;
+inline static void *_index(queue_t *queue, segment_t *segment, size_t i) {
+    return segment->data + i * queue->elsize;
+}
 
-    return queue;
+// Appends a segment with room for at least n elements.
+static segment_t *_add_segment(queue_t *queue, size_t n) {
+    if (queue->size == 0 && queue->first) {
+        // The only segment is empty, it becomes the spare.
+        free(queue->spare);
+        queue->spare = queue->first;
+        queue->first = queue->last = NULL;
+    }
+
+    segment_t *segment = queue->spare;
+    if (segment && segment->cap >= n) {
+        queue->spare = NULL;
+    } else {
+        size_t cap = queue->next_cap > n ? queue->next_cap : n;
+        segment = (segment_t *)malloc(sizeof(segment_t) + cap * queue->elsize);
+        segment->cap = cap;
+
+        size_t max_cap = queue->elsize ? MAX_SEGMENT_BYTES / queue->elsize : MAX_SEGMENT_BYTES;
+        if (queue->next_cap < max_cap) queue->next_cap *= 2;
+    }
+    segment->begin = segment->end = 0;
+    segment->next = NULL;
+
+    if (queue->last) queue->last->next = segment;
+    else queue->first = segment;
+    queue->last = segment;
+    return segment;
 }
 
-inline static void *_index(queue_t *queue, size_t i) {
-    return queue->data + i * queue->elsize;
+// Unlinks the first segment once it is empty. It is kept as the spare, so an
+// element just popped from it stays readable until the next push or pop.
+static void _drop_first(queue_t *queue) {
+    segment_t *segment = queue->first;
+    if (segment->next == NULL) {
+        // The only segment is reused from its start.
+        segment->begin = segment->end = 0;
+        return;
+    }
+    queue->first = segment->next;
+    free(queue->spare);
+    queue->spare = segment;
+}
+
+void *queue_reserve(queue_t *queue, size_t n) {
+    segment_t *segment = queue->last;
+    if (!segment || segment->cap - segment->end < n) segment = _add_segment(queue, n);
+
+    void *slots = _index(queue, segment, segment->end);
+    segment->end += n;
+    queue->size += n;
+    return slots;
 }
 
 void queue_push(queue_t *queue, void *element) {
-    if (queue->size >= queue->cap) {
-        // From empty queue, allocate space for 2 elements.
-        if ((queue->cap *= 2) == 0) queue->cap = 2;
-
-        queue->nodes = (node_t *)realloc(queue->nodes, queue->cap * sizeof(node_t));
-        queue->data = realloc(queue->data, queue->cap * queue->elsize);
-
-        queue->empty = queue->size;
-        for (int i = queue->empty; i < queue->cap; i++)
-            if (i == queue->cap - 1)
-                queue->nodes[i].next = -1U;
-            else
-                queue->nodes[i].next = i + 1;
-    }
-    if (queue->size > 0)
-        queue->nodes[queue->end].next = queue->empty;
+    segment_t *segment = queue->last;
+    if (!segment || segment->end == segment->cap) segment = _add_segment(queue, 1);
 
     // Copies element at the end of the queue.
-    memcpy(_index(queue, queue->empty), element, queue->elsize);
-    // End is the old empty space.
-    queue->end = queue->empty;
-    // Moves empty pointer.
-    queue->empty = queue->nodes[queue->empty].next;
-    // Sets next of end to "null" value.
-    queue->nodes[queue->end].next = -1U;
+    memcpy(_index(queue, segment, segment->end++), element, queue->elsize);
     queue->size++;
 }
 
+void queue_push_n(queue_t *queue, void *elements, size_t n) {
+    segment_t *segment = queue->last;
+    // Fills the room left in the last segment, then the rest goes to one new
+    // segment.
+    size_t room = segment ? segment->cap - segment->end : 0;
+    if (room > n) room = n;
+    if (room > 0) memcpy(queue_reserve(queue, room), elements, room * queue->elsize);
+    if (n > room) memcpy(queue_reserve(queue, n - room), elements + room * queue->elsize, (n - room) * queue->elsize);
+}
+
 void *queue_pop(queue_t *queue) {
-    // TODO: Implement logic to free memory as needed.
-    void *retr = _index(queue, queue->start);
+    if (queue->size == 0) return NULL;
+    segment_t *segment = queue->first;
+    void *retr = _index(queue, segment, segment->begin++);
+    queue->size--;
+    if (segment->begin == segment->end) _drop_first(queue);
+    return retr;
+}
 
-    uint next_start = queue->nodes[queue->start].next;
-    queue->nodes[queue->start].next = queue->empty;
-    queue->empty = queue->start;
+size_t queue_pop_n(queue_t *queue, void *elements, size_t n) {
+    if (n > queue->size) n = queue->size;
 
-    if (next_start != -1U)
-        queue->start = next_start;
+    for (size_t done = 0; done < n;) {
+        segment_t *segment = queue->first;
+        size_t k = segment->end - segment->begin;
+        if (k > n - done) k = n - done;
 
-    queue->size--;
-    return retr;
+        memcpy(elements + done * queue->elsize, _index(queue, segment, segment->begin), k * queue->elsize);
+        segment->begin += k;
+        queue->size -= k;
+        done += k;
+        if (segment->begin == segment->end) _drop_first(queue);
+    }
+    return n;
 }
 
 void *queue_peak(queue_t *queue) {
-    return _index(queue, queue->start);
+    if (queue->size == 0) return NULL;
+    return _index(queue, queue->first, queue->first->begin);
 }
 
 // NOTE: Does not free remaining data.
 void queue_delete(queue_t *queue) {
-    free(queue->nodes);
-    free(queue->data);
+    segment_t *segment = queue->first;
+    while (segment) {
+        segment_t *next = segment->next;
+        free(segment);
+        segment = next;
+    }
+    free(queue->spare);
     free(queue);
 }
 
@@ -112,4 +170,3 @@ size_t queue_get_size(queue_t *queue) {
 bool queue_is_empty(queue_t *queue) {
     return queue->size == 0;
 }
-
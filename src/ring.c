@@ -0,0 +1,226 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <ring.h>
+
+#define CACHE_LINE 64
+
+#define load_relaxed(p)      __atomic_load_n((p), __ATOMIC_RELAXED)
+#define load_acquire(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define store_relaxed(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define store_release(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+static size_t round_pow2(size_t n) {
+    size_t cap = 1;
+    while (cap < n) cap <<= 1;
+    return cap;
+}
+
+/* Single producer single consumer ring */
+
+struct _spsc {
+    // Written by the producer.
+    _Alignas(CACHE_LINE) size_t head;
+    size_t cached_tail;
+    // Written by the consumer.
+    _Alignas(CACHE_LINE) size_t tail;
+    size_t cached_head;
+    // Read only.
+    _Alignas(CACHE_LINE) unsigned char *data;
+    size_t mask;
+    size_t elsize;
+};
+
+spsc_t *spsc_create(size_t elsize, size_t cap) {
+    spsc_t *ring = (spsc_t *)aligned_alloc(CACHE_LINE, sizeof(spsc_t));
+    cap = round_pow2(cap);
+    ring->head = ring->cached_tail = 0;
+    ring->tail = ring->cached_head = 0;
+    ring->data = (unsigned char *)malloc(cap * elsize);
+    ring->mask = cap - 1;
+    ring->elsize = elsize;
+    return ring;
+}
+
+// Copies n elements into the ring from position pos, wrapping around.
+static void spsc_copy_in(spsc_t *ring, size_t pos, const void *elements, size_t n) {
+    size_t idx = pos & ring->mask, first = ring->mask + 1 - idx;
+    if (first > n) first = n;
+    memcpy(ring->data + idx * ring->elsize, elements, first * ring->elsize);
+    memcpy(ring->data, (const unsigned char *)elements + first * ring->elsize, (n - first) * ring->elsize);
+}
+
+static void spsc_copy_out(spsc_t *ring, size_t pos, void *elements, size_t n) {
+    size_t idx = pos & ring->mask, first = ring->mask + 1 - idx;
+    if (first > n) first = n;
+    memcpy(elements, ring->data + idx * ring->elsize, first * ring->elsize);
+    memcpy((unsigned char *)elements + first * ring->elsize, ring->data, (n - first) * ring->elsize);
+}
+
+size_t spsc_push_n(spsc_t *ring, const void *elements, size_t n) {
+    size_t head = ring->head, cap = ring->mask + 1;
+    size_t room = cap - (head - ring->cached_tail);
+    if (room < n) {
+        ring->cached_tail = load_acquire(&ring->tail);
+        room = cap - (head - ring->cached_tail);
+    }
+    if (n > room) n = room;
+    if (n == 0) return 0;
+
+    spsc_copy_in(ring, head, elements, n);
+    store_release(&ring->head, head + n);
+    return n;
+}
+
+size_t spsc_pop_n(spsc_t *ring, void *elements, size_t n) {
+    size_t tail = ring->tail;
+    size_t ready = ring->cached_head - tail;
+    if (ready < n) {
+        ring->cached_head = load_acquire(&ring->head);
+        ready = ring->cached_head - tail;
+    }
+    if (n > ready) n = ready;
+    if (n == 0) return 0;
+
+    spsc_copy_out(ring, tail, elements, n);
+    store_release(&ring->tail, tail + n);
+    return n;
+}
+
+bool spsc_push(spsc_t *ring, const void *element) {
+    size_t head = ring->head;
+    if (head - ring->cached_tail > ring->mask) {
+        ring->cached_tail = load_acquire(&ring->tail);
+        if (head - ring->cached_tail > ring->mask) return false;
+    }
+    memcpy(ring->data + (head & ring->mask) * ring->elsize, element, ring->elsize);
+    store_release(&ring->head, head + 1);
+    return true;
+}
+
+bool spsc_pop(spsc_t *ring, void *element) {
+    size_t tail = ring->tail;
+    if (tail == ring->cached_head) {
+        ring->cached_head = load_acquire(&ring->head);
+        if (tail == ring->cached_head) return false;
+    }
+    memcpy(element, ring->data + (tail & ring->mask) * ring->elsize, ring->elsize);
+    store_release(&ring->tail, tail + 1);
+    return true;
+}
+
+size_t spsc_get_size(spsc_t *ring) {
+    size_t tail = load_acquire(&ring->tail);
+    return load_acquire(&ring->head) - tail;
+}
+
+size_t spsc_get_cap(spsc_t *ring) { return ring->mask + 1; }
+
+void spsc_delete(spsc_t *ring) {
+    if (!ring) return;
+    free(ring->data);
+    free(ring);
+}
+
+/* Multiple producers multiple consumers ring */
+
+// A slot is a sequence number followed by the element. Its sequence number is
+// pos when it is free for the producer of position pos, and pos + 1 once that
+// producer filled it; the consumer then sets it to pos + cap, freeing the slot
+// for the next lap.
+typedef struct {
+    size_t seq;
+    unsigned char element[];
+} cell_t;
+
+struct _mpmc {
+    _Alignas(CACHE_LINE) size_t enqueue_pos;
+    _Alignas(CACHE_LINE) size_t dequeue_pos;
+    _Alignas(CACHE_LINE) unsigned char *cells;
+    size_t cell_size;
+    size_t mask;
+    size_t elsize;
+};
+
+static inline cell_t *cell_at(mpmc_t *ring, size_t pos) {
+    return (cell_t *)(ring->cells + (pos & ring->mask) * ring->cell_size);
+}
+
+mpmc_t *mpmc_create(size_t elsize, size_t cap) {
+    mpmc_t *ring = (mpmc_t *)aligned_alloc(CACHE_LINE, sizeof(mpmc_t));
+    cap = round_pow2(cap < 2 ? 2 : cap);
+    ring->enqueue_pos = 0;
+    ring->dequeue_pos = 0;
+    ring->cell_size = (sizeof(cell_t) + elsize + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1);
+    ring->cells = (unsigned char *)malloc(cap * ring->cell_size);
+    ring->mask = cap - 1;
+    ring->elsize = elsize;
+    for (size_t i = 0; i < cap; i++) cell_at(ring, i)->seq = i;
+    return ring;
+}
+
+// Claims up to n consecutive positions whose slots have the sequence number
+// pos + offset, from the counter at `counter`. Returns the number claimed and
+// sets `first` to the first of them.
+static size_t mpmc_claim(mpmc_t *ring, size_t *counter, size_t offset, size_t n, size_t *first) {
+    size_t pos = load_relaxed(counter);
+    for (;;) {
+        size_t k = 0;
+        while (k < n && load_acquire(&cell_at(ring, pos + k)->seq) == pos + k + offset) k++;
+
+        if (k == 0) {
+            intptr_t diff = (intptr_t)load_acquire(&cell_at(ring, pos)->seq) - (intptr_t)(pos + offset);
+            // The slot is still a lap behind: the ring is full (or empty).
+            if (diff < 0) return 0;
+            // Another thread claimed pos already.
+            pos = load_relaxed(counter);
+            continue;
+        }
+        if (__atomic_compare_exchange_n(counter, &pos, pos + k, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            *first = pos;
+            return k;
+        }
+    }
+}
+
+size_t mpmc_push_n(mpmc_t *ring, const void *elements, size_t n) {
+    size_t pos;
+    n = mpmc_claim(ring, &ring->enqueue_pos, 0, n, &pos);
+    for (size_t i = 0; i < n; i++) {
+        cell_t *cell = cell_at(ring, pos + i);
+        memcpy(cell->element, (const unsigned char *)elements + i * ring->elsize, ring->elsize);
+        store_release(&cell->seq, pos + i + 1);
+    }
+    return n;
+}
+
+size_t mpmc_pop_n(mpmc_t *ring, void *elements, size_t n) {
+    size_t pos;
+    n = mpmc_claim(ring, &ring->dequeue_pos, 1, n, &pos);
+    for (size_t i = 0; i < n; i++) {
+        cell_t *cell = cell_at(ring, pos + i);
+        memcpy((unsigned char *)elements + i * ring->elsize, cell->element, ring->elsize);
+        store_release(&cell->seq, pos + i + ring->mask + 1);
+    }
+    return n;
+}
+
+bool mpmc_push(mpmc_t *ring, const void *element) { return mpmc_push_n(ring, element, 1) == 1; }
+
+bool mpmc_pop(mpmc_t *ring, void *element) { return mpmc_pop_n(ring, element, 1) == 1; }
+
+size_t mpmc_get_size(mpmc_t *ring) {
+    size_t dequeue_pos = load_relaxed(&ring->dequeue_pos);
+    size_t enqueue_pos = load_relaxed(&ring->enqueue_pos);
+    return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+}
+
+size_t mpmc_get_cap(mpmc_t *ring) { return ring->mask + 1; }
+
+void mpmc_delete(mpmc_t *ring) {
+    if (!ring) return;
+    free(ring->cells);
+    free(ring);
+}
@@ -6,7 +6,9 @@
 // Macro para alocação de memória
 #define CHUNK 32
 
-// Helper function that allocates and deallocates the heap as needed.
+// Helper function that allocates and deallocates the heap as needed. It only
+// shrinks once a quarter is used, so pushing and popping around a power of two
+// does not realloc every time.
 void *maybe_realloc(void *ptr, const size_t used, size_t *alloc) {
     if (*alloc == 0)
         return realloc(ptr, *alloc = CHUNK);
@@ -14,7 +16,7 @@ void *maybe_realloc(void *ptr, const size_t used, size_t *alloc) {
     if (used >= *alloc)
         return realloc(ptr, *alloc *= 2);
 
-    if (used < *alloc / 2 && *alloc > CHUNK)
+    if (used < *alloc / 4 && *alloc > CHUNK)
         return realloc(ptr, *alloc /= 2);
     
     return ptr;
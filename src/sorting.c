@@ -24,39 +24,180 @@
 // Typedef interno utilizado apenas para poder se referir a um tipo de tamanho 1.
 typedef unsigned char byte_t;
 
-void quick_sort_with(void *vec, size_t nmemb, size_t elsize, comp_t comp) {
-    if (nmemb <= 1) return;
+#define QS_INSERTION 24         // Ranges smaller than this are insertion sorted.
+#define QS_NINTHER 128          // Ranges larger than this take the ninther as pivot.
+#define QS_PARTIAL_MOVES 8      // Moves allowed before giving up on a partial insertion sort.
+
+// Orders the contents of a, b and c.
+static void sort3(void *a, void *b, void *c, size_t elsize, comp_t comp) {
+    if (comp(b, a) < 0) swap(a, b, elsize);
+    if (comp(c, b) < 0) {
+        swap(b, c, elsize);
+        if (comp(b, a) < 0) swap(a, b, elsize);
+    }
+}
 
-    void *p1 = memoff(vec, elsize), *p2 = memoff(vec, (nmemb - 1) * elsize);
+// Insertion sort that shifts the larger elements with one memmove. If limit is
+// not 0, it gives up once it moved more than limit elements, returning false.
+static bool insertion_sort_limit(void *vec, size_t nmemb, size_t elsize, comp_t comp, size_t limit) {
+    byte_t tmp[elsize];
+    size_t moves = 0;
+    for (size_t i = 1; i < nmemb; i++) {
+        void *cur = memoff(vec, i * elsize);
+        if (comp(cur, memoff(cur, -elsize)) >= 0) continue;
 
-    // Estratégia de escolha de pivot: sempre o primeiro elemento do vetor.
-    void *pivot = vec;
+        memcpy(tmp, cur, elsize);
+        size_t j = i - 1;
+        while (j > 0 && comp(tmp, memoff(vec, (j - 1) * elsize)) < 0) j--;
+        memmove(memoff(vec, (j + 1) * elsize), memoff(vec, j * elsize), (i - j) * elsize);
+        memcpy(memoff(vec, j * elsize), tmp, elsize);
+
+        moves += i - j;
+        if (limit && moves > limit) return false;
+    }
+    return true;
+}
 
-    while (p1 < p2) {
-        if (comp(p1, pivot) >= 0 && comp(p2, pivot) < 0) {
-            swap(p1, p2, elsize);
-            p1 = memoff(p1, elsize);
-            p2 = memoff(p2, -elsize);
+// Moves the pivot to the start of the range: the median of the first, middle
+// and last elements, or for large ranges the median of three such medians.
+// Either way one of the last three elements ends up not less than the pivot.
+static void choose_pivot(void *vec, size_t nmemb, size_t elsize, comp_t comp) {
+    void *mid = memoff(vec, (nmemb / 2) * elsize), *last = memoff(vec, (nmemb - 1) * elsize);
+    if (nmemb > QS_NINTHER) {
+        sort3(vec, mid, last, elsize, comp);
+        sort3(memoff(vec, elsize), memoff(mid, -elsize), memoff(last, -elsize), elsize, comp);
+        sort3(memoff(vec, 2 * elsize), memoff(mid, elsize), memoff(last, -2 * elsize), elsize, comp);
+        sort3(memoff(mid, -elsize), mid, memoff(mid, elsize), elsize, comp);
+        swap(vec, mid, elsize);
+    } else {
+        sort3(mid, vec, last, elsize, comp);
+    }
+}
 
-        } else if (comp(p1, pivot) < 0) {
-            p1 = memoff(p1, elsize);
+// Partitions the range around its first element: the smaller elements go to its
+// left and the others to its right. Returns the final position of the pivot and
+// sets already when no element had to be swapped.
+static void *partition_right(void *vec, size_t nmemb, size_t elsize, comp_t comp, bool *already) {
+    byte_t pivot[elsize];
+    memcpy(pivot, vec, elsize);
+    void *first = vec, *last = memoff(vec, nmemb * elsize);
+
+    // choose_pivot left an element not less than the pivot at the end.
+    do first = memoff(first, elsize); while (comp(first, pivot) < 0);
+    if (memoff(first, -elsize) == vec) {
+        do last = memoff(last, -elsize); while (first < last && comp(last, pivot) >= 0);
+    } else {
+        // There is a smaller element before first to stop on.
+        do last = memoff(last, -elsize); while (comp(last, pivot) >= 0);
+    }
 
-        } else if (comp(p2, pivot) >= 0) {
-            p2 = memoff(p2, -elsize);
-        }
+    *already = first >= last;
+    while (first < last) {
+        swap(first, last, elsize);
+        do first = memoff(first, elsize); while (comp(first, pivot) < 0);
+        do last = memoff(last, -elsize); while (comp(last, pivot) >= 0);
     }
 
-    if (comp(p2, pivot) < 0) {
-        swap(p2, pivot, elsize);
-    
+    void *pos = memoff(first, -elsize);
+    memcpy(vec, pos, elsize);
+    memcpy(pos, pivot, elsize);
+    return pos;
+}
+
+// Partitions the range around its first element with the elements equal to it
+// on its left. Used when the pivot equals the element before the range, which
+// is not greater than any in it: everything left of the pivot is then equal to
+// it and done, so runs of duplicates are sorted in linear time.
+static void *partition_left(void *vec, size_t nmemb, size_t elsize, comp_t comp) {
+    byte_t pivot[elsize];
+    memcpy(pivot, vec, elsize);
+    void *first = vec, *last = memoff(vec, nmemb * elsize);
+
+    // The pivot itself stops last.
+    do last = memoff(last, -elsize); while (comp(pivot, last) < 0);
+    if (memoff(last, elsize) == memoff(vec, nmemb * elsize)) {
+        do first = memoff(first, elsize); while (first < last && comp(pivot, first) >= 0);
     } else {
-        p2 = memoff(p2, -elsize);
-        swap(p2, pivot, elsize);
+        do first = memoff(first, elsize); while (comp(pivot, first) >= 0);
+    }
+
+    while (first < last) {
+        swap(first, last, elsize);
+        do last = memoff(last, -elsize); while (comp(pivot, last) < 0);
+        do first = memoff(first, elsize); while (comp(pivot, first) >= 0);
+    }
+
+    memcpy(vec, last, elsize);
+    memcpy(last, pivot, elsize);
+    return last;
+}
+
+// Breaks the patterns that made the partition unbalanced by swapping a few
+// elements of a side with elements a quarter of the way in.
+static void shuffle_side(void *vec, size_t nmemb, size_t elsize) {
+    if (nmemb < QS_INSERTION) return;
+    void *last = memoff(vec, (nmemb - 1) * elsize);
+    size_t q = nmemb / 4;
+    swap(vec, memoff(vec, q * elsize), elsize);
+    swap(last, memoff(last, -q * elsize), elsize);
+    if (nmemb > QS_NINTHER) {
+        swap(memoff(vec, elsize), memoff(vec, (q + 1) * elsize), elsize);
+        swap(memoff(vec, 2 * elsize), memoff(vec, (q + 2) * elsize), elsize);
+        swap(memoff(last, -elsize), memoff(last, -(q + 1) * elsize), elsize);
+        swap(memoff(last, -2 * elsize), memoff(last, -(q + 2) * elsize), elsize);
+    }
+}
+
+// bad is how many unbalanced partitions are still allowed before falling back to
+// heap sort. leftmost tells there is no element before the range.
+static void pdq_sort(void *vec, size_t nmemb, size_t elsize, comp_t comp, int bad, bool leftmost) {
+    while (nmemb >= QS_INSERTION) {
+        choose_pivot(vec, nmemb, elsize, comp);
+
+        if (!leftmost && comp(memoff(vec, -elsize), vec) >= 0) {
+            void *pos = partition_left(vec, nmemb, elsize, comp);
+            size_t skip = (pos - vec) / elsize + 1;
+            vec = memoff(vec, skip * elsize);
+            nmemb -= skip;
+            continue;
+        }
+
+        bool already;
+        void *pos = partition_right(vec, nmemb, elsize, comp, &already);
+        size_t nleft = (pos - vec) / elsize, nright = nmemb - nleft - 1;
+        void *right = memoff(pos, elsize);
+
+        if (nleft < nmemb / 8 || nright < nmemb / 8) {
+            if (--bad == 0) return heap_sort_with(vec, nmemb, elsize, comp);
+            shuffle_side(vec, nleft, elsize);
+            shuffle_side(right, nright, elsize);
+        } else if (already &&
+                   insertion_sort_limit(vec, nleft, elsize, comp, QS_PARTIAL_MOVES) &&
+                   insertion_sort_limit(right, nright, elsize, comp, QS_PARTIAL_MOVES)) {
+            // The range looked sorted and was.
+            return;
+        }
+
+        // Recurses on the smaller side so the stack stays logarithmic.
+        if (nleft < nright) {
+            pdq_sort(vec, nleft, elsize, comp, bad, leftmost);
+            vec = right;
+            nmemb = nright;
+            leftmost = false;
+        } else {
+            pdq_sort(right, nright, elsize, comp, bad, false);
+            nmemb = nleft;
+        }
     }
+    insertion_sort_limit(vec, nmemb, elsize, comp, 0);
+}
 
-    const size_t nleft = (p2 - vec) / elsize;
-    quick_sort_with(vec, nleft, elsize, comp);
-    quick_sort_with(memoff(p2, elsize), nmemb - nleft - 1, elsize, comp);
+// Pattern-defeating quick sort (Orson Peters' pdqsort): O(n log n) on any input,
+// linear on sorted input and on runs of equal elements.
+void quick_sort_with(void *vec, size_t nmemb, size_t elsize, comp_t comp) {
+    int bad = 1;
+    for (size_t n = nmemb; n > 1; n >>= 1) bad++;
+    pdq_sort(vec, nmemb, elsize, comp, bad, true);
 }
 
 void radix256_sort_with(void *vec, size_t nmemb, size_t elsize, get_key_t get_key, void *arg) {
@@ -124,36 +265,68 @@ void heap_sort_with(void *vec, size_t nmemb, size_t elsize, comp_t comp) {
     }
 }
 
-void merge_with(void *start, void *mid, void *end, size_t elsize, comp_t comp) {
-    void *auxorig = malloc(end - start);
-    void *startPtr = start, *midPtr = mid, *aux = auxorig;
-
-    while (startPtr < mid && midPtr < end) {
-        if (comp(startPtr, midPtr) <= 0) {
-            memcpy(aux, startPtr, elsize);
-            startPtr = memoff(startPtr, elsize);
-        } else {
-            memcpy(aux, midPtr, elsize);
-            midPtr = memoff(midPtr, elsize);
+// Merges the sorted ranges [start, mid) and [mid, end), stably. Only the smaller
+// one is copied to buffer, which holds at least that many bytes: a smaller left
+// run is merged from the front, a smaller right run from the back.
+static void merge_with(void *start, void *mid, void *end, size_t elsize, comp_t comp, void *buffer) {
+    if (start == mid || mid == end) return;
+    // Already in order, nothing to move.
+    if (comp(memoff(mid, -elsize), mid) <= 0) return;
+
+    if (mid - start <= end - mid) {
+        void *buf = buffer, *bufend = memoff(buffer, mid - start);
+        void *out = start, *right = mid;
+        memcpy(buffer, start, mid - start);
+        while (buf < bufend && right < end) {
+            if (comp(right, buf) < 0) {
+                memcpy(out, right, elsize);
+                right = memoff(right, elsize);
+            } else {
+                memcpy(out, buf, elsize);
+                buf = memoff(buf, elsize);
+            }
+            out = memoff(out, elsize);
         }
-        aux = memoff(aux, elsize);
+        // What is left of the right run is already in place.
+        memcpy(out, buf, bufend - buf);
+    } else {
+        void *buf = memoff(buffer, end - mid);
+        void *out = end, *left = mid;
+        memcpy(buffer, mid, end - mid);
+        while (buf > buffer && left > start) {
+            out = memoff(out, -elsize);
+            if (comp(memoff(buf, -elsize), memoff(left, -elsize)) < 0) {
+                left = memoff(left, -elsize);
+                memcpy(out, left, elsize);
+            } else {
+                buf = memoff(buf, -elsize);
+                memcpy(out, buf, elsize);
+            }
+        }
+        // What is left of the left run is already in place.
+        memcpy(start, buffer, buf - buffer);
     }
-
-    if (startPtr < mid) 
-        memcpy(aux, startPtr, mid - startPtr);
-
-    memcpy(start, auxorig, midPtr - start);
-    free(auxorig);
 }
 
-void merge_sort_with(void *vec, size_t nmemb, size_t elsize, comp_t comp) {
-    if (nmemb <= 1) return;
+#define MERGE_INSERTION 16 // Ranges up to this size are insertion sorted.
+
+void merge_sort_with_buffer(void *vec, size_t nmemb, size_t elsize, comp_t comp, void *buffer) {
+    if (nmemb <= MERGE_INSERTION) {
+        insertion_sort_limit(vec, nmemb, elsize, comp, 0);
+        return;
+    }
     void *mid = memoff(vec, (nmemb / 2) * elsize);
     void *end = memoff(vec, nmemb * elsize);
 
-    merge_sort_with(vec, nmemb / 2, elsize, comp);
-    merge_sort_with(mid, nmemb / 2 + nmemb % 2, elsize, comp);
-    merge_with(vec, mid, end, elsize, comp);
+    merge_sort_with_buffer(vec, nmemb / 2, elsize, comp, buffer);
+    merge_sort_with_buffer(mid, nmemb - nmemb / 2, elsize, comp, buffer);
+    merge_with(vec, mid, end, elsize, comp, buffer);
+}
+
+void merge_sort_with(void *vec, size_t nmemb, size_t elsize, comp_t comp) {
+    void *buffer = nmemb > MERGE_INSERTION ? malloc((nmemb / 2) * elsize) : NULL;
+    merge_sort_with_buffer(vec, nmemb, elsize, comp, buffer);
+    free(buffer);
 }
 
 void *lower_bound(void *search, void *vec, size_t nmemb, size_t elsize, comp_t comp) {
@@ -163,7 +336,7 @@ void *lower_bound(void *search, void *vec, size_t nmemb, size_t elsize, comp_t c
         p = start + step;
         if (comp(search, vec + p * elsize) > 0) {
             start = p + 1;
-            nmemb -= step;
+            nmemb -= step + 1;
         } else {
             nmemb = step;
         }
@@ -212,23 +385,20 @@ inline static void reverse_vec(void *vec, size_t nmemb, size_t elsize) {
         swap(vec + i * elsize, vec + (nmemb - i - 1) * elsize, elsize);
 }
 
-inline static int sign(int a) { return a > 0 ? 1 : (a == 0 ? 0 : -1); }
-
+// Finds the run at the start of the vector: the longest nondecreasing prefix,
+// or strictly decreasing one, which is reversed. Equal elements would swap
+// places if a decreasing run could hold them, so it must be strict.
 static size_t find_run(void *start, size_t nmemb, size_t elsize, comp_t comp) {
     if (nmemb == 1) return 1;
-    size_t end = 1;
-    int dir = 0;
-    void *ptr;
-    for (ptr = start + elsize;
-         end < nmemb && (dir = comp(ptr - elsize, ptr)) == 0;
-         ptr += elsize, end++);
-
-    while (end < nmemb - 1 && sign(dir) == sign(comp(ptr, ptr + elsize)))
-         ptr += elsize, end++;
-
-    // If the order is reversed, reverse the subarray.
-    if (dir > 0) reverse_vec(start, end + 1, elsize);
-    return end + 1;
+    size_t end = 2;
+    void *ptr = start + 2 * elsize;
+    if (comp(start + elsize, start) < 0) {
+        for (; end < nmemb && comp(ptr, ptr - elsize) < 0; ptr += elsize) end++;
+        reverse_vec(start, end, elsize);
+    } else {
+        for (; end < nmemb && comp(ptr, ptr - elsize) >= 0; ptr += elsize) end++;
+    }
+    return end;
 }
 
 struct tim_run {
@@ -236,7 +406,7 @@ struct tim_run {
     uint size;
 };
 
-static void tim_merge(void *vec, size_t elsize, comp_t comp, struct tim_run *s, uint *sz) {
+static void tim_merge(void *vec, size_t elsize, comp_t comp, struct tim_run *s, uint *sz, void *buffer) {
     uint n = *sz;
     bool inv1 = true;
     bool inv2 = false;
@@ -244,14 +414,13 @@ static void tim_merge(void *vec, size_t elsize, comp_t comp, struct tim_run *s,
         inv1 = s[n-2].size > s[n-1].size;
         inv2 = n < 3 || s[n-3].size > s[n-2].size + s[n-1].size;
         if (n >= 3 && !(inv1 && inv2)) {
-            // TODO: replace with a more efficient merge algorithm.
             // TODO: add galloping to merge.
             if (s[n-1].size < s[n-3].size) {
                 // Merge Y + X
                 merge_with(vec + s[n-2].start * elsize,
                            vec + s[n-1].start * elsize,
                            vec + (s[n-1].start + s[n-1].size) * elsize,
-                           elsize, comp);
+                           elsize, comp, buffer);
 
                 s[n-2].size += s[n-1].size; // start is the same.
             } else {
@@ -259,7 +428,7 @@ static void tim_merge(void *vec, size_t elsize, comp_t comp, struct tim_run *s,
                 merge_with(vec + s[n-3].start * elsize,
                            vec + s[n-2].start * elsize,
                            vec + (s[n-2].start + s[n-2].size) * elsize,
-                           elsize, comp);
+                           elsize, comp, buffer);
 
                 s[n-3].size += s[n-2].size; // start is the same.
                 s[n-2] = s[n-1]; // Copy X one position down the stack.
@@ -270,7 +439,7 @@ static void tim_merge(void *vec, size_t elsize, comp_t comp, struct tim_run *s,
             merge_with(vec + s[n-2].start * elsize,
                        vec + s[n-1].start * elsize,
                        vec + (s[n-1].start + s[n-1].size) * elsize,
-                       elsize, comp);
+                       elsize, comp, buffer);
 
             s[n-2].size += s[n-1].size;
             n--;
@@ -279,13 +448,13 @@ static void tim_merge(void *vec, size_t elsize, comp_t comp, struct tim_run *s,
     *sz = n;
 }
 
-static void tim_merge_force(void *vec, size_t elsize, comp_t comp, struct tim_run *s, uint *sz) {
+static void tim_merge_force(void *vec, size_t elsize, comp_t comp, struct tim_run *s, uint *sz, void *buffer) {
     uint n;
     for (n = *sz; n > 1; n--) {
         merge_with(vec + s[n-2].start * elsize,
                    vec + s[n-1].start * elsize,
                    vec + (s[n-1].start + s[n-1].size) * elsize,
-                   elsize, comp);
+                   elsize, comp, buffer);
 
         s[n-2].size += s[n-1].size;
     }
@@ -293,7 +462,7 @@ static void tim_merge_force(void *vec, size_t elsize, comp_t comp, struct tim_ru
 }
 
 // Source: "https://pt.wikipedia.org/wiki/Timsort"
-void tim_sort_with(void *vec, size_t nmemb, size_t elsize, comp_t comp) {
+void tim_sort_with_buffer(void *vec, size_t nmemb, size_t elsize, comp_t comp, void *buffer) {
     if (nmemb < MIN_MERGE)
         return binary_insertion_sort_with(vec, nmemb, elsize, comp);
 
@@ -318,9 +487,15 @@ void tim_sort_with(void *vec, size_t nmemb, size_t elsize, comp_t comp) {
         run_ptr += stack[stack_sz].size * elsize;
         stack_sz++;
 
-        tim_merge(vec, elsize, comp, stack, &stack_sz);
+        tim_merge(vec, elsize, comp, stack, &stack_sz, buffer);
     }
-    tim_merge_force(vec, elsize, comp, stack, &stack_sz);
+    tim_merge_force(vec, elsize, comp, stack, &stack_sz, buffer);
+}
+
+void tim_sort_with(void *vec, size_t nmemb, size_t elsize, comp_t comp) {
+    void *buffer = nmemb >= MIN_MERGE ? malloc((nmemb / 2) * elsize) : NULL;
+    tim_sort_with_buffer(vec, nmemb, elsize, comp, buffer);
+    free(buffer);
 }
 
 void insertion_sort_with(void *vec, size_t nmemb, size_t elsize, comp_t comp) {
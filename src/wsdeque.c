@@ -0,0 +1,120 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <wsdeque.h>
+
+#define CACHE_LINE 64
+
+#define load_relaxed(p)      __atomic_load_n((p), __ATOMIC_RELAXED)
+#define load_acquire(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define store_relaxed(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define store_release(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+typedef struct _array {
+    struct _array *retired; // The array this one replaced.
+    size_t mask;
+    void *slots[];
+} array_t;
+
+struct _wsdeque {
+    // Written by thieves (and by the owner for the last element).
+    _Alignas(CACHE_LINE) int64_t top;
+    // Written by the owner.
+    _Alignas(CACHE_LINE) int64_t bottom;
+    array_t *array;
+};
+
+static array_t *array_create(size_t cap) {
+    array_t *array = (array_t *)malloc(sizeof(array_t) + cap * sizeof(void *));
+    array->retired = NULL;
+    array->mask = cap - 1;
+    return array;
+}
+
+wsdeque_t *wsdeque_create(size_t cap) {
+    wsdeque_t *deque = (wsdeque_t *)aligned_alloc(CACHE_LINE, sizeof(wsdeque_t));
+    size_t slots = 2;
+    while (slots < cap) slots <<= 1;
+
+    deque->top = deque->bottom = 0;
+    deque->array = array_create(slots);
+    return deque;
+}
+
+// Moves the elements in [top, bottom) into an array twice as big.
+static array_t *grow(wsdeque_t *deque, array_t *array, int64_t top, int64_t bottom) {
+    array_t *bigger = array_create((array->mask + 1) * 2);
+    for (int64_t i = top; i < bottom; i++)
+        store_relaxed(&bigger->slots[i & bigger->mask], load_relaxed(&array->slots[i & array->mask]));
+    bigger->retired = array;
+    store_release(&deque->array, bigger);
+    return bigger;
+}
+
+void wsdeque_push(wsdeque_t *deque, void *element) {
+    int64_t bottom = load_relaxed(&deque->bottom);
+    int64_t top = load_acquire(&deque->top);
+    array_t *array = load_relaxed(&deque->array);
+    if (bottom - top > (int64_t)array->mask) array = grow(deque, array, top, bottom);
+
+    store_relaxed(&array->slots[bottom & array->mask], element);
+    // Publishes the element (and what it points to) to thieves reading bottom.
+    store_release(&deque->bottom, bottom + 1);
+}
+
+void *wsdeque_pop(wsdeque_t *deque) {
+    int64_t bottom = load_relaxed(&deque->bottom) - 1;
+    array_t *array = load_relaxed(&deque->array);
+    // Claims the element before looking at top, so a thief reading bottom
+    // after this does not take it too.
+    store_relaxed(&deque->bottom, bottom);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t top = load_relaxed(&deque->top);
+
+    if (top > bottom) {
+        store_relaxed(&deque->bottom, bottom + 1);
+        return NULL;
+    }
+    void *element = load_relaxed(&array->slots[bottom & array->mask]);
+    if (top == bottom) {
+        // The last element, thieves may be after it too.
+        if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            element = NULL;
+        store_relaxed(&deque->bottom, bottom + 1);
+    }
+    return element;
+}
+
+void *wsdeque_steal(wsdeque_t *deque) {
+    int64_t top = load_acquire(&deque->top);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t bottom = load_acquire(&deque->bottom);
+    if (top >= bottom) return NULL;
+
+    array_t *array = load_acquire(&deque->array);
+    void *element = load_relaxed(&array->slots[top & array->mask]);
+    if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        return NULL;
+    return element;
+}
+
+size_t wsdeque_get_size(wsdeque_t *deque) {
+    int64_t bottom = load_relaxed(&deque->bottom);
+    int64_t top = load_relaxed(&deque->top);
+    return bottom > top ? bottom - top : 0;
+}
+
+bool wsdeque_is_empty(wsdeque_t *deque) {
+    return wsdeque_get_size(deque) == 0;
+}
+
+void wsdeque_delete(wsdeque_t *deque) {
+    if (!deque) return;
+    for (array_t *array = deque->array, *next; array; array = next) {
+        next = array->retired;
+        free(array);
+    }
+    free(deque);
+}
@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <arena.h>
+
+bool test_arena_alloc() {
+    arena_t *arena = arena_create(64);
+    assert_neq(arena, NULL);
+    assert_eq(arena_get_capacity(arena), 0);
+
+    // Allocations are aligned and don't overlap.
+    char *prev = NULL;
+    for (size_t i = 1; i < 100; i++) {
+        char *ptr = (char *)arena_alloc(arena, i);
+        bool aligned = (uintptr_t)ptr % 8 == 0;
+        assert_eq(aligned, true);
+        memset(ptr, (int)i, i);
+        if (prev) assert_eq(prev[0], (char)(i - 1));
+        prev = ptr;
+    }
+
+    // Slabs grow, so few of them are needed.
+    assert_geq(arena_get_capacity(arena), 99 * 50);
+    assert_le(arena_get_capacity(arena), ARENA_MAX_SLAB_SZ);
+
+    arena_delete(arena);
+    return true;
+}
+
+bool test_arena_large() {
+    arena_t *arena = arena_create(64);
+
+    char *small = (char *)arena_alloc(arena, 8);
+    // Larger than a slab, gets a slab of its own.
+    char *large = (char *)arena_alloc(arena, 10000);
+    memset(large, 'x', 10000);
+    // The current slab is still used after the large allocation.
+    char *next = (char *)arena_alloc(arena, 8);
+    assert_eq(next, small + 8);
+
+    arena_delete(arena);
+    return true;
+}
+
+bool test_arena_strndup() {
+    arena_t *arena = arena_create(0);
+
+    char *copy = arena_strndup(arena, "Hello, World!", 5);
+    assert_eq(strcmp(copy, "Hello"), 0);
+    copy = arena_strndup(arena, "", 0);
+    assert_eq(strcmp(copy, ""), 0);
+
+    arena_delete(arena);
+    return true;
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_arena_alloc());
+    test_fn(test_arena_large());
+    test_fn(test_arena_strndup());
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}
@@ -160,6 +160,18 @@ bool test_avl_remove() {
 
     assert_eq(avl_get_size(avl), 0);
 
+    // Out of order, so that nodes with two children are removed too.
+    for (int i = 0; i < 30; i++)
+        assert_eq(avl_insert(avl, &i), true);
+
+    for (int i = 0; i < 30; i++) {
+        val = (i * 7) % 30;
+        assert_eq(avl_remove(avl, &val, NULL), true);
+        assert_eq(avl_search(avl, &val), NULL);
+    }
+
+    assert_eq(avl_get_size(avl), 0);
+
     avl_delete(avl, NULL);
     return true;
 }
@@ -0,0 +1,284 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <bqueue.h>
+#include <queue_bank.h>
+
+bool test_bqueue() {
+    bqueue_t *queue = bqueue_create(sizeof(int), 6);
+    int value;
+
+    for (int i = 0; i < 8; i++) assert_eq(bqueue_push(queue, &i, 0), BQUEUE_OK);
+    assert_eq(bqueue_get_size(queue), 8);
+    assert_eq(bqueue_push(queue, &value, 0), BQUEUE_TIMEOUT);
+
+    // Wraps around the end of the ring.
+    for (int lap = 0; lap < 3; lap++) {
+        for (int i = 0; i < 5; i++) {
+            assert_eq(bqueue_pop(queue, &value, 0), BQUEUE_OK);
+            assert_eq(value, lap * 5 + i);
+        }
+        for (int i = 0; i < 5; i++) {
+            value = 8 + lap * 5 + i;
+            assert_eq(bqueue_push(queue, &value, 0), BQUEUE_OK);
+        }
+    }
+
+    int values[16];
+    assert_eq(bqueue_pop_n(queue, values, 16, 0), 8);
+    for (int i = 0; i < 8; i++) assert_eq(values[i], 15 + i);
+    assert_eq(bqueue_pop(queue, &value, 0), BQUEUE_TIMEOUT);
+
+    bqueue_delete(queue);
+    return true;
+}
+
+bool test_bqueue_timeout() {
+    bqueue_t *queue = bqueue_create(sizeof(int), 1);
+    int value = 1;
+
+    double start = now_ms();
+    assert_eq(bqueue_pop(queue, &value, 20000), BQUEUE_TIMEOUT);
+    assert_geq(now_ms() - start, 19.0);
+
+    assert_eq(bqueue_push(queue, &value, 20000), BQUEUE_OK);
+    start = now_ms();
+    assert_eq(bqueue_push(queue, &value, 20000), BQUEUE_TIMEOUT);
+    assert_geq(now_ms() - start, 19.0);
+
+    bqueue_delete(queue);
+    return true;
+}
+
+static void *pop_one(void *arg) {
+    bqueue_t *queue = (bqueue_t *)arg;
+    int value;
+    return (void *)(intptr_t)bqueue_pop(queue, &value, BQUEUE_FOREVER);
+}
+
+static void *push_one(void *arg) {
+    bqueue_t *queue = (bqueue_t *)arg;
+    int value = 42;
+    return (void *)(intptr_t)bqueue_push(queue, &value, BQUEUE_FOREVER);
+}
+
+bool test_bqueue_close() {
+    // Threads waiting on an empty queue wake up when it is closed.
+    bqueue_t *queue = bqueue_create(sizeof(int), 4);
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++) pthread_create(&threads[i], NULL, pop_one, queue);
+    usleep(10000);
+    bqueue_close(queue);
+    for (int i = 0; i < 4; i++) {
+        void *status;
+        pthread_join(threads[i], &status);
+        assert_eq((intptr_t)status, BQUEUE_CLOSED);
+    }
+    bqueue_delete(queue);
+
+    // So do threads waiting on a full queue. What was pushed is still popped.
+    queue = bqueue_create(sizeof(int), 2);
+    int value = 7;
+    bqueue_push(queue, &value, 0);
+    bqueue_push(queue, &value, 0);
+    pthread_create(&threads[0], NULL, push_one, queue);
+    usleep(10000);
+    bqueue_close(queue);
+    void *status;
+    pthread_join(threads[0], &status);
+    assert_eq((intptr_t)status, BQUEUE_CLOSED);
+    assert_eq(bqueue_is_closed(queue), true);
+
+    assert_eq(bqueue_push(queue, &value, 0), BQUEUE_CLOSED);
+    assert_eq(bqueue_pop(queue, &value, BQUEUE_FOREVER), BQUEUE_OK);
+    assert_eq(bqueue_pop(queue, &value, BQUEUE_FOREVER), BQUEUE_OK);
+    assert_eq(bqueue_pop(queue, &value, BQUEUE_FOREVER), BQUEUE_CLOSED);
+    assert_eq(bqueue_pop_n(queue, &value, 1, BQUEUE_FOREVER), 0);
+
+    bqueue_delete(queue);
+    return true;
+}
+
+typedef struct {
+    bqueue_t *queue;
+    long n;       // Items pushed by each producer.
+    bool batch;   // Consumers pop with bqueue_pop_n.
+    long sum;
+    long count;
+    long max_size; // Largest size seen by a producer, to check backpressure.
+} worker_t;
+
+static void *producer(void *arg) {
+    worker_t *w = (worker_t *)arg;
+    for (long i = 1; i <= w->n; i++) {
+        bqueue_push(w->queue, &i, BQUEUE_FOREVER);
+        if (i % 1024 == 0) {
+            long size = bqueue_get_size(w->queue);
+            if (size > w->max_size) w->max_size = size;
+        }
+    }
+    return NULL;
+}
+
+static void *consumer(void *arg) {
+    worker_t *w = (worker_t *)arg;
+    long values[64];
+    for (;;) {
+        size_t k = bqueue_pop_n(w->queue, values, w->batch ? 64 : 1, BQUEUE_FOREVER);
+        if (k == 0) break;
+        for (size_t i = 0; i < k; i++) w->sum += values[i];
+        w->count += k;
+    }
+    return NULL;
+}
+
+// Runs producers and consumers until the producers are done and the queue is
+// drained. Returns false if an item was lost or duplicated.
+static bool run_threads(int producers, int consumers, long n, bool batch, size_t cap, double *ms) {
+    bqueue_t *queue = bqueue_create(sizeof(long), cap);
+    worker_t *workers = (worker_t *)calloc(producers + consumers, sizeof(worker_t));
+    pthread_t *threads = (pthread_t *)malloc((producers + consumers) * sizeof(pthread_t));
+
+    double start = now_ms();
+    for (int i = 0; i < producers + consumers; i++) {
+        workers[i] = (worker_t){ queue, n, batch };
+        pthread_create(&threads[i], NULL, i < producers ? producer : consumer, &workers[i]);
+    }
+    for (int i = 0; i < producers; i++) pthread_join(threads[i], NULL);
+    bqueue_close(queue);
+    for (int i = producers; i < producers + consumers; i++) pthread_join(threads[i], NULL);
+    *ms = now_ms() - start;
+
+    long sum = 0, count = 0, max_size = 0;
+    for (int i = 0; i < producers + consumers; i++) {
+        sum += workers[i].sum;
+        count += workers[i].count;
+        if (workers[i].max_size > max_size) max_size = workers[i].max_size;
+    }
+    bool ok = count == producers * n && sum == producers * (n * (n + 1) / 2) && max_size <= cap;
+
+    bqueue_delete(queue);
+    free(workers);
+    free(threads);
+    return ok;
+}
+
+bool test_bqueue_threads() {
+    double ms;
+    assert_eq(run_threads(1, 1, 100000, false, 64, &ms), true);
+    assert_eq(run_threads(4, 4, 20000, false, 16, &ms), true);
+    assert_eq(run_threads(3, 2, 20000, true, 128, &ms), true);
+    // A queue of a single slot, producers wait for each pop.
+    assert_eq(run_threads(2, 2, 5000, false, 1, &ms), true);
+    return true;
+}
+
+/* Benchmarks */
+
+typedef struct {
+    bqueue_t *queue;
+    pthread_mutex_t *lock;
+    queue_t *polled;
+    int rounds;
+    double total_ms;
+} latency_t;
+
+static void *blocked_consumer(void *arg) {
+    latency_t *l = (latency_t *)arg;
+    double sent;
+    for (int i = 0; i < l->rounds; i++) {
+        bqueue_pop(l->queue, &sent, BQUEUE_FOREVER);
+        l->total_ms += now_ms() - sent;
+    }
+    return NULL;
+}
+
+// What workers did so far: check a locked queue, sleep a bit when empty.
+static void *polling_consumer(void *arg) {
+    latency_t *l = (latency_t *)arg;
+    for (int i = 0; i < l->rounds;) {
+        pthread_mutex_lock(l->lock);
+        bool some = !queue_is_empty(l->polled);
+        double sent = some ? *(double *)queue_pop(l->polled) : 0;
+        pthread_mutex_unlock(l->lock);
+        if (!some) {
+            usleep(100);
+            continue;
+        }
+        l->total_ms += now_ms() - sent;
+        i++;
+    }
+    return NULL;
+}
+
+// Time between a push and the wakeup of a consumer that was waiting for it.
+void test_bqueue_latency_benchmark(int rounds) {
+    pthread_mutex_t lock;
+    pthread_mutex_init(&lock, NULL);
+    latency_t blocked = { bqueue_create(sizeof(double), 16), NULL, NULL, rounds, 0 };
+    latency_t polled = { NULL, &lock, queue_create(sizeof(double)), rounds, 0 };
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, blocked_consumer, &blocked);
+    for (int i = 0; i < rounds; i++) {
+        usleep(200); // Lets the consumer go to sleep.
+        double sent = now_ms();
+        bqueue_push(blocked.queue, &sent, BQUEUE_FOREVER);
+    }
+    pthread_join(thread, NULL);
+
+    pthread_create(&thread, NULL, polling_consumer, &polled);
+    for (int i = 0; i < rounds; i++) {
+        usleep(200);
+        pthread_mutex_lock(&lock);
+        double sent = now_ms();
+        queue_push(polled.polled, &sent);
+        pthread_mutex_unlock(&lock);
+    }
+    pthread_join(thread, NULL);
+
+    printf(CYAN "Wakeup latency over %d pushes: bqueue %.1lf us, sleep-polling every 100 us %.1lf us" RESET "\n",
+           rounds, blocked.total_ms * 1e3 / rounds, polled.total_ms * 1e3 / rounds);
+
+    bqueue_delete(blocked.queue);
+    queue_delete(polled.polled);
+    pthread_mutex_destroy(&lock);
+}
+
+void test_bqueue_throughput_benchmark(long n) {
+    struct { int producers, consumers; bool batch; size_t cap; } runs[] = {
+        { 1, 1, false, 1024 }, { 1, 1, true, 1024 }, { 4, 4, false, 1024 },
+        { 4, 4, true, 1024 }, { 8, 2, false, 64 }, { 2, 8, false, 64 },
+    };
+    for (int r = 0; r < sizeof(runs) / sizeof(*runs); r++) {
+        double ms;
+        long per_producer = n / runs[r].producers;
+        run_threads(runs[r].producers, runs[r].consumers, per_producer, runs[r].batch, runs[r].cap, &ms);
+        printf(CYAN "bqueue%s, %d producers / %d consumers, %zu slots: %ld items in %.2lf ms (%.2lf Mitems/s)" RESET "\n",
+               runs[r].batch ? " pop_n" : "", runs[r].producers, runs[r].consumers, runs[r].cap,
+               per_producer * runs[r].producers, ms, per_producer * runs[r].producers / ms / 1e3);
+    }
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_bqueue());
+    test_fn(test_bqueue_timeout());
+    test_fn(test_bqueue_close());
+    test_fn(test_bqueue_threads());
+
+    test_bqueue_latency_benchmark(2000);
+    test_bqueue_throughput_benchmark(1000000);
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <cdict.h>
+#include <dict.h>
+
+#define N_KEYS 20000
+
+bool test_cdict_create() {
+    cdict_t *cdict = cdict_create();
+    assert_neq(cdict, NULL);
+    assert_eq(cdict_get_size(cdict), 0);
+    assert_eq(cdict_get(cdict, "Hello"), NULL);
+    assert_eq(cdict_contains(cdict, "Hello"), false);
+
+    cdict_delete(cdict, free);
+    return true;
+}
+
+bool test_cdict_insert_remove() {
+    // Few stripes and a small size, so that stripes resize many times.
+    cdict_t *cdict = cdict_create_with(CDICT_OPTS(.stripes = 4, .size = 4));
+    char key[32];
+
+    for (intptr_t i = 0; i < N_KEYS; i++) {
+        sprintf(key, "key%ld", (long)i);
+        assert_eq(cdict_insert(cdict, key, (dict_value_t)(i + 1)), true);
+    }
+    assert_eq(cdict_get_size(cdict), N_KEYS);
+    assert_eq(cdict_insert(cdict, "key0", NULL), false);
+
+    for (intptr_t i = 0; i < N_KEYS; i++) {
+        sprintf(key, "key%ld", (long)i);
+        assert_eq((intptr_t)cdict_get(cdict, key), i + 1);
+    }
+    assert_eq(cdict_contains(cdict, "key"), false);
+
+    for (intptr_t i = 0; i < N_KEYS; i += 2) {
+        sprintf(key, "key%ld", (long)i);
+        assert_eq((intptr_t)cdict_remove_entry(cdict, key), i + 1);
+    }
+    assert_eq(cdict_get_size(cdict), N_KEYS / 2);
+    assert_eq(cdict_remove(cdict, "key0", NULL), false);
+
+    for (intptr_t i = 0; i < N_KEYS; i++) {
+        sprintf(key, "key%ld", (long)i);
+        bool kept = i % 2 == 1;
+        assert_eq(cdict_contains(cdict, key), kept);
+    }
+
+    assert_eq(cdict_insert(cdict, "Hello", strdup("World")), true);
+    assert_eq(cdict_remove(cdict, "Hello", free), true);
+
+    cdict_delete(cdict, NULL);
+    return true;
+}
+
+typedef struct {
+    cdict_t *cdict;
+    int id;
+    int n_threads;
+    bool failed;
+} worker_t;
+
+// Keys owned by a thread are always in the dict with the value i + 1, keys of
+// other threads come and go. Lookups must never miss a key that is always
+// there nor see a wrong value.
+static void *churn_worker(void *arg) {
+    worker_t *w = (worker_t *)arg;
+    char key[32];
+
+    for (int round = 0; round < 20; round++) {
+        for (intptr_t i = w->id; i < N_KEYS; i += w->n_threads) {
+            sprintf(key, "tmp%ld", (long)i);
+            if (round % 2 == 0) cdict_insert(w->cdict, key, (dict_value_t)(i + 1));
+            else cdict_remove(w->cdict, key, NULL);
+
+            intptr_t j = (i * 7919 + round) % N_KEYS;
+            sprintf(key, "key%ld", (long)j);
+            if ((intptr_t)cdict_get(w->cdict, key) != j + 1) w->failed = true;
+
+            sprintf(key, "tmp%ld", (long)j);
+            intptr_t value = (intptr_t)cdict_get(w->cdict, key);
+            if (value != 0 && value != j + 1) w->failed = true;
+        }
+    }
+    return NULL;
+}
+
+bool test_cdict_threads() {
+    cdict_t *cdict = cdict_create_with(CDICT_OPTS(.stripes = 8, .size = 8));
+    char key[32];
+    for (intptr_t i = 0; i < N_KEYS; i++) {
+        sprintf(key, "key%ld", (long)i);
+        cdict_insert(cdict, key, (dict_value_t)(i + 1));
+    }
+
+    int n_threads = 4;
+    pthread_t threads[4];
+    worker_t workers[4];
+    for (int i = 0; i < n_threads; i++) {
+        workers[i] = (worker_t){ .cdict = cdict, .id = i, .n_threads = n_threads };
+        pthread_create(&threads[i], NULL, churn_worker, &workers[i]);
+    }
+    for (int i = 0; i < n_threads; i++) {
+        pthread_join(threads[i], NULL);
+        assert_eq(workers[i].failed, false);
+    }
+
+    // Every thread did an even number of rounds, so no tmp key is left.
+    assert_eq(cdict_get_size(cdict), N_KEYS);
+
+    cdict_delete(cdict, NULL);
+    return true;
+}
+
+/* Benchmark */
+
+typedef struct {
+    cdict_t *cdict;
+    dict_t *dict; // Used instead of cdict if not NULL, under `lock`.
+    pthread_mutex_t *lock;
+    int write_pct;
+    int seed;
+} bench_worker_t;
+
+#define BENCH_OPS 200000
+
+static void *bench_worker(void *arg) {
+    bench_worker_t *w = (bench_worker_t *)arg;
+    unsigned int seed = w->seed;
+    char key[32];
+
+    for (int i = 0; i < BENCH_OPS; i++) {
+        int r = rand_r(&seed);
+        sprintf(key, "key%d", r % N_KEYS);
+        bool write = r / N_KEYS % 100 < w->write_pct;
+
+        if (w->dict) pthread_mutex_lock(w->lock);
+        if (!write) {
+            if (w->dict) dict_get(w->dict, key);
+            else cdict_get(w->cdict, key);
+        } else if (r & 1) {
+            if (w->dict) dict_insert(w->dict, key, NULL);
+            else cdict_insert(w->cdict, key, NULL);
+        } else {
+            if (w->dict) dict_remove(w->dict, key, NULL);
+            else cdict_remove(w->cdict, key, NULL);
+        }
+        if (w->dict) pthread_mutex_unlock(w->lock);
+    }
+    return NULL;
+}
+
+// Runs `n_threads` threads doing a mix of lookups and writes on a cdict and
+// on a dict behind a single mutex, and reports the throughput of each.
+void test_cdict_benchmark(int n_threads, int write_pct) {
+    cdict_t *cdict = cdict_create();
+    dict_t *dict = dict_create();
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    char key[32];
+    for (int i = 0; i < N_KEYS; i += 2) {
+        sprintf(key, "key%d", i);
+        cdict_insert(cdict, key, NULL);
+        dict_insert(dict, key, NULL);
+    }
+
+    pthread_t threads[n_threads];
+    bench_worker_t workers[n_threads];
+    double mops[2];
+    for (int mode = 0; mode < 2; mode++) {
+        double start = now_ms();
+        for (int i = 0; i < n_threads; i++) {
+            workers[i] = (bench_worker_t){
+                .cdict = cdict,
+                .dict = mode == 1 ? dict : NULL,
+                .lock = &lock,
+                .write_pct = write_pct,
+                .seed = i + 1,
+            };
+            pthread_create(&threads[i], NULL, bench_worker, &workers[i]);
+        }
+        for (int i = 0; i < n_threads; i++)
+            pthread_join(threads[i], NULL);
+
+        mops[mode] = (double)BENCH_OPS * n_threads / (now_ms() - start) / 1e3;
+    }
+
+    printf(CYAN "%d threads, %d%% writes: cdict %.2lf Mops/s, dict with a mutex %.2lf Mops/s" RESET "\n",
+           n_threads, write_pct, mops[0], mops[1]);
+
+    cdict_delete(cdict, NULL);
+    dict_delete(dict, NULL);
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_cdict_create());
+    test_fn(test_cdict_insert_remove());
+    test_fn(test_cdict_threads());
+
+    long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n_cpus < 4) n_cpus = 4;
+    for (int write_pct = 5; write_pct <= 50; write_pct += 45)
+        for (int n_threads = 1; n_threads <= n_cpus; n_threads *= 2)
+            test_cdict_benchmark(n_threads, write_pct);
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}
@@ -7,8 +7,66 @@
 #include <colors.h>
 #include <dict.h>
 
-void test_dict_benchmark(size_t n_inputs) {
-    dict_t *dict = dict_create();
+typedef struct {
+    char *name;
+    dict_opts_t opts;
+} dict_config_t;
+
+// Every test runs on each of these configurations.
+static dict_config_t configs[] = {
+    { "DICT_CHAINED", DICT_OPTS(.kind = DICT_CHAINED) },
+    { "DICT_CHAINED incremental", DICT_OPTS(.kind = DICT_CHAINED, .incremental = true) },
+    { "DICT_OPEN", DICT_OPTS(.kind = DICT_OPEN) },
+    { "DICT_CHAINED sdbm", DICT_OPTS(.kind = DICT_CHAINED, .hash = hash_sdbm) },
+    { "DICT_OPEN sdbm", DICT_OPTS(.kind = DICT_OPEN, .hash = hash_sdbm) },
+    { "DICT_CHAINED arena", DICT_OPTS(.kind = DICT_CHAINED, .arena = true) },
+    { "DICT_OPEN arena", DICT_OPTS(.kind = DICT_OPEN, .arena = true) },
+    { "DICT_ORDERED", DICT_OPTS(.kind = DICT_ORDERED) },
+    { "DICT_ORDERED arena", DICT_OPTS(.kind = DICT_ORDERED, .arena = true) },
+    { "DICT_ORDERED small", DICT_OPTS(.kind = DICT_ORDERED, .size = 4) },
+};
+
+#define N_CONFIGS (sizeof(configs) / sizeof(*configs))
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(double *)a, y = *(double *)b;
+    return (x > y) - (x < y);
+}
+
+static double now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Measures the latency of each insertion. With incremental rehashing the worst
+// insertions should not grow with the size of the table.
+void test_dict_latency_benchmark(dict_config_t config, size_t n_inputs) {
+    dict_t *dict = dict_create_with(config.opts);
+    double *latency = (double *)malloc(n_inputs * sizeof(double));
+
+    char key[32];
+    for (int i = 0; i < n_inputs; i++) {
+        sprintf(key, "%d", i);
+        double start = now_us();
+        dict_insert(dict, key, NULL);
+        latency[i] = now_us() - start;
+    }
+    qsort(latency, n_inputs, sizeof(double), compare_double);
+
+    printf(CYAN "%s: Insertion latency p50 %.2lfus, p99 %.2lfus, p99.99 %.2lfus, max %.2lfus" RESET "\n",
+           config.name,
+           latency[n_inputs / 2],
+           latency[n_inputs / 100 * 99],
+           latency[n_inputs / 10000 * 9999],
+           latency[n_inputs - 1]);
+
+    free(latency);
+    dict_delete(dict, NULL);
+}
+
+void test_dict_benchmark(dict_config_t config, size_t n_inputs) {
+    dict_t *dict = dict_create_with(config.opts);
 
     char **keys = (char **)malloc(n_inputs * sizeof(char *));
     char **values = (char **)malloc(n_inputs * sizeof(char *));
@@ -32,16 +90,80 @@ void test_dict_benchmark(size_t n_inputs) {
     for (int i = 0; i < n_inputs; i++)
         dict_insert(dict, keys[i], values[i]);
 
-    printf(CYAN "Insertion benchmark took %lf milliseconds" RESET "\n", (double)(clock() - start_time) / (double)(CLOCKS_PER_SEC / 1000));
+    printf(CYAN "%s: Insertion benchmark took %lf milliseconds" RESET "\n", config.name, (double)(clock() - start_time) / (double)(CLOCKS_PER_SEC / 1000));
 
+    start_time = clock();
     for (int i = 0; i < n_inputs; i++)
+        dict_get(dict, keys[i]);
+
+    printf(CYAN "%s: Lookup benchmark took %lf milliseconds" RESET "\n", config.name, (double)(clock() - start_time) / (double)(CLOCKS_PER_SEC / 1000));
+
+    for (int i = 0; i < n_inputs; i++) {
         free(keys[i]);
+        free(values[i]);
+    }
+
+    start_time = clock();
+    dict_delete(dict, NULL);
+
+    printf(CYAN "%s: Deletion benchmark took %lf milliseconds" RESET "\n", config.name, (double)(clock() - start_time) / (double)(CLOCKS_PER_SEC / 1000));
+
+    free(keys);
+    free(values);
+}
+
+bool test_dict_resize(dict_opts_t opts) {
+    dict_t *dict = dict_create_with(opts);
+    assert_neq(dict, NULL);
+
+    // Reserving avoids every resize of the bulk load.
+    char key[32];
+    dict_reserve(dict, 1000);
+    size_t reserved = dict_get_capacity(dict);
+    assert_geq(reserved, 1000);
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "key%d", i);
+        assert_eq(dict_insert(dict, key, strdup(key)), true);
+    }
+    assert_eq(dict_get_capacity(dict), reserved);
+
+    // Does not shrink below the reserved size.
+    for (int i = 10; i < 1000; i++) {
+        sprintf(key, "key%d", i);
+        assert_eq(dict_remove(dict, key, free), true);
+    }
+    assert_eq(dict_get_capacity(dict), reserved);
+
+    dict_shrink_to_fit(dict);
+    assert_le(dict_get_capacity(dict), reserved);
+    for (int i = 0; i < 10; i++) {
+        sprintf(key, "key%d", i);
+        assert_eq(strcmp(dict_get(dict, key), key), 0);
+    }
+
+    // Grows and then shrinks automatically as entries are removed.
+    for (int i = 10; i < 10000; i++) {
+        sprintf(key, "key%d", i);
+        assert_eq(dict_insert(dict, key, strdup(key)), true);
+    }
+    size_t grown = dict_get_capacity(dict);
+    for (int i = 10; i < 10000; i++) {
+        sprintf(key, "key%d", i);
+        assert_eq(dict_remove(dict, key, free), true);
+    }
+    assert_le(dict_get_capacity(dict), grown / 8);
+    assert_eq(dict_get_size(dict), 10);
+    for (int i = 0; i < 10; i++) {
+        sprintf(key, "key%d", i);
+        assert_eq(strcmp(dict_get(dict, key), key), 0);
+    }
 
     dict_delete(dict, free);
+    return true;
 }
 
-bool test_dict_remove() {
-    dict_t *dict = dict_create();
+bool test_dict_remove(dict_opts_t opts) {
+    dict_t *dict = dict_create_with(opts);
     assert_neq(dict, NULL);
 
     // Cant remove something that isn't there.
@@ -51,13 +173,29 @@ bool test_dict_remove() {
 
     // Removed is no longer accessible.
     assert_eq(dict_get(dict, "Hello"), NULL);
+    assert_eq(dict_get_size(dict), 0);
+
+    // Interleaved inserts and removals (leaves tombstones in DICT_OPEN).
+    char key[32];
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "key%d", i);
+        assert_eq(dict_insert(dict, key, strdup(key)), true);
+        if (i % 3 == 0) assert_eq(dict_remove(dict, key, free), true);
+    }
+    assert_eq(dict_get_size(dict), 666);
+    for (int i = 0; i < 1000; i++) {
+        bool kept = i % 3 != 0;
+        sprintf(key, "key%d", i);
+        assert_eq(dict_contains(dict, key), kept);
+        if (kept) assert_eq(strcmp(dict_get(dict, key), key), 0);
+    }
 
     dict_delete(dict, free);
     return true;
 }
 
-bool test_dict_insert() {
-    dict_t *dict = dict_create();
+bool test_dict_insert(dict_opts_t opts) {
+    dict_t *dict = dict_create_with(opts);
     assert_neq(dict, NULL);
 
     assert_eq(dict_insert(dict, "Hello", strdup("World")), true);
@@ -100,8 +238,241 @@ bool test_dict_insert() {
     return true;
 }
 
-bool test_dict_get() {
-    dict_t *dict = dict_create();
+bool test_dict_get_many(dict_opts_t opts) {
+    dict_t *dict = dict_create_with(opts);
+    char *keys[1500];
+    dict_value_t out[1500];
+
+    // Even keys are in the dict, odd keys are not. Inserting keeps incremental
+    // tables in the middle of a rehash for part of the lookups.
+    for (intptr_t i = 0; i < 1500; i++) {
+        keys[i] = (char *)malloc(32);
+        sprintf(keys[i], "key%ld", (long)i);
+        if (i % 2 == 0) dict_insert(dict, keys[i], (dict_value_t)(i + 1));
+    }
+
+    // A size that is not a multiple of the batch size.
+    assert_eq(dict_get_many(dict, keys, 1499, out), 750);
+    for (intptr_t i = 0; i < 1499; i++) {
+        dict_value_t expected = i % 2 == 0 ? (dict_value_t)(i + 1) : NULL;
+        assert_eq(out[i], expected);
+    }
+    assert_eq(dict_get_many(dict, keys, 0, out), 0);
+
+    for (int i = 0; i < 1500; i++) free(keys[i]);
+    dict_delete(dict, NULL);
+    return true;
+}
+
+bool test_dict_iter(dict_opts_t opts) {
+    dict_t *dict = dict_create_with(opts);
+    char key[32], *it_key;
+    dict_value_t value;
+
+    dict_iter_t it = dict_iter(dict);
+    assert_eq(dict_iter_next(&it, &it_key, &value), false);
+
+    // Incremental tables are in the middle of a rehash when the iteration starts.
+    int seen[1000] = { 0 };
+    for (intptr_t i = 0; i < 1000; i++) {
+        sprintf(key, "key%ld", (long)i);
+        dict_insert(dict, key, (dict_value_t)i);
+    }
+
+    size_t n = 0;
+    for (dict_iter_t it = dict_iter(dict); dict_iter_next(&it, &it_key, &value); n++) {
+        intptr_t i = (intptr_t)value;
+        sprintf(key, "key%ld", (long)i);
+        assert_eq(strcmp(it_key, key), 0);
+        // Lookups are allowed while iterating.
+        assert_eq(dict_get(dict, key), value);
+        seen[i]++;
+    }
+    assert_eq(n, 1000);
+    for (int i = 0; i < 1000; i++) assert_eq(seen[i], 1);
+
+    dict_delete(dict, NULL);
+    return true;
+}
+
+// Removing and inserting again moves a key to the end, and rebuilding the
+// table to drop removed entries keeps the order of the others.
+bool test_dict_ordered() {
+    dict_t *dict = dict_create_with(DICT_OPTS(.kind = DICT_ORDERED));
+    char key[32], *it_key;
+    dict_value_t value;
+
+    for (intptr_t i = 0; i < 1000; i++) {
+        sprintf(key, "key%ld", (long)i);
+        dict_insert(dict, key, (dict_value_t)i);
+    }
+    for (intptr_t i = 0; i < 1000; i += 3) {
+        sprintf(key, "key%ld", (long)i);
+        dict_remove(dict, key, NULL);
+    }
+    for (intptr_t i = 0; i < 1000; i += 6) {
+        sprintf(key, "key%ld", (long)i);
+        dict_insert(dict, key, (dict_value_t)(i + 1000));
+    }
+    // Enough churn to rebuild the table a few times.
+    for (int round = 0; round < 2000; round++) {
+        dict_insert(dict, "tmp", NULL);
+        dict_remove(dict, "tmp", NULL);
+    }
+
+    intptr_t prev = -1;
+    size_t n = 0;
+    for (dict_iter_t it = dict_iter(dict); dict_iter_next(&it, &it_key, &value); n++) {
+        intptr_t i = (intptr_t)value;
+        assert_ge(i, prev);
+        sprintf(key, "key%ld", (long)(i >= 1000 ? i - 1000 : i));
+        assert_eq(strcmp(it_key, key), 0);
+        prev = i;
+    }
+    assert_eq(n, dict_get_size(dict));
+
+    dict_shrink_to_fit(dict);
+    assert_eq(dict_get(dict, "key1"), (dict_value_t)1);
+    assert_eq(dict_get(dict, "key6"), (dict_value_t)1006);
+
+    dict_delete(dict, NULL);
+    return true;
+}
+
+// Small ordered dicts keep their entries inline until they are full. Keys that
+// don't fit in the inline space, removals and the promotion to a table must
+// all keep the entries and their order.
+bool test_dict_ordered_small() {
+    dict_t *dict = dict_create_with(DICT_OPTS(.kind = DICT_ORDERED, .size = 8, .arena = true));
+    char *long_key = "a key that is too long to be stored inline";
+    assert_eq(dict_get_capacity(dict), 8);
+
+    assert_eq(dict_insert(dict, long_key, (dict_value_t)1), true);
+    assert_eq(dict_insert(dict, "a", (dict_value_t)2), true);
+    assert_eq(dict_insert(dict, "b", (dict_value_t)3), true);
+    assert_eq(dict_insert(dict, "a", NULL), false);
+    assert_eq((intptr_t)dict_get(dict, long_key), 1);
+    assert_eq((intptr_t)dict_remove_entry(dict, "a"), 2);
+    assert_eq(dict_get(dict, "a"), NULL);
+
+    char key[32];
+    for (intptr_t i = 4; i <= 9; i++) {
+        sprintf(key, "k%ld", (long)i);
+        dict_insert(dict, key, (dict_value_t)i);
+    }
+    // 8 entries went in with a hole in the middle, the array was compacted.
+    assert_eq(dict_get_size(dict), 8);
+    assert_eq(dict_get_capacity(dict), 8);
+
+    dict_insert(dict, "k10", (dict_value_t)10);
+    assert_ge(dict_get_capacity(dict), 8);
+
+    intptr_t prev = 0;
+    dict_value_t value;
+    for (dict_iter_t it = dict_iter(dict); dict_iter_next(&it, NULL, &value);) {
+        assert_ge((intptr_t)value, prev);
+        prev = (intptr_t)value;
+    }
+    assert_eq(prev, 10);
+    assert_eq((intptr_t)dict_get(dict, long_key), 1);
+    assert_eq((intptr_t)dict_get(dict, "b"), 3);
+
+    dict_delete(dict, NULL);
+    return true;
+}
+
+#define SCAN_KEYS 1000
+
+static void count_seen(char *key, dict_value_t value, void *ctx) {
+    intptr_t i = (intptr_t)value;
+    if (i < SCAN_KEYS) ((int *)ctx)[i]++;
+}
+
+// The dict grows and then shrinks back between the calls of a scan, every key
+// that is there all along must still be visited.
+bool test_dict_scan(dict_opts_t opts) {
+    dict_t *dict = dict_create_with(opts);
+    int seen[SCAN_KEYS] = { 0 };
+    char key[32];
+
+    assert_eq(dict_scan(dict, 0, 10, count_seen, seen), 0);
+
+    for (intptr_t i = 0; i < SCAN_KEYS; i++) {
+        sprintf(key, "key%ld", (long)i);
+        dict_insert(dict, key, (dict_value_t)i);
+    }
+
+    size_t cursor = 0, calls = 0;
+    intptr_t extra = 0;
+    do {
+        cursor = dict_scan(dict, cursor, 10, count_seen, seen);
+        calls++;
+        if (calls < 20) {
+            for (int j = 0; j < 500; j++, extra++) {
+                sprintf(key, "extra%ld", (long)extra);
+                dict_insert(dict, key, (dict_value_t)(SCAN_KEYS + extra));
+            }
+        } else if (extra > 0) {
+            for (int j = 0; j < 500 && extra > 0; j++) {
+                sprintf(key, "extra%ld", (long)--extra);
+                dict_remove(dict, key, NULL);
+            }
+        }
+    } while (cursor != 0);
+
+    assert_geq(calls, 20);
+    for (int i = 0; i < SCAN_KEYS; i++) assert_geq(seen[i], 1);
+
+    // Without changes, a scan visits each key exactly once.
+    memset(seen, 0, sizeof(seen));
+    cursor = 0;
+    do cursor = dict_scan(dict, cursor, 1, count_seen, seen); while (cursor != 0);
+    for (int i = 0; i < SCAN_KEYS; i++) assert_eq(seen[i], 1);
+
+    dict_delete(dict, NULL);
+    return true;
+}
+
+// Looks up keys in random order in a table larger than the caches, one at a
+// time and then in batches.
+void test_dict_get_many_benchmark(dict_config_t config, size_t n_inputs) {
+    dict_t *dict = dict_create_with(config.opts);
+    char **keys = (char **)malloc(n_inputs * sizeof(char *));
+    dict_value_t *out = (dict_value_t *)malloc(n_inputs * sizeof(dict_value_t));
+    for (size_t i = 0; i < n_inputs; i++) {
+        keys[i] = (char *)malloc(32);
+        sprintf(keys[i], "some key %zu", i);
+        dict_insert(dict, keys[i], keys[i]);
+    }
+
+    srand(57);
+    for (size_t i = n_inputs - 1; i > 0; i--) {
+        size_t j = rand() % (i + 1);
+        char *tmp = keys[i];
+        keys[i] = keys[j];
+        keys[j] = tmp;
+    }
+
+    double start = now_us();
+    for (size_t i = 0; i < n_inputs; i++)
+        out[i] = dict_get(dict, keys[i]);
+    double single = now_us() - start;
+
+    start = now_us();
+    dict_get_many(dict, keys, n_inputs, out);
+    double batched = now_us() - start;
+
+    printf(CYAN "%s: %zu lookups took %.2lf milliseconds one by one, %.2lf milliseconds with dict_get_many" RESET "\n",
+           config.name, n_inputs, single / 1e3, batched / 1e3);
+
+    for (size_t i = 0; i < n_inputs; i++) free(keys[i]);
+    free(keys);
+    free(out);
+    dict_delete(dict, NULL);
+}
+
+bool test_dict_get(dict_opts_t opts) {
+    dict_t *dict = dict_create_with(opts);
     assert_neq(dict, NULL);
 
     assert_eq(dict_get(dict, "Hello"), NULL);
@@ -113,8 +484,8 @@ bool test_dict_get() {
     return true;
 }
 
-bool test_dict_create() {
-    dict_t *dict = dict_create();
+bool test_dict_create(dict_opts_t opts) {
+    dict_t *dict = dict_create_with(opts);
     assert_neq(dict, NULL);
     assert_eq(dict_get_size(dict), 0);
 
@@ -125,12 +496,30 @@ bool test_dict_create() {
 int main(int argc, char *argv[]) {
     TEST_SETUP();
 
-    test_fn(test_dict_create());
-    test_fn(test_dict_get());
-    test_fn(test_dict_insert());
-    test_fn(test_dict_remove());
+    for (int i = 0; i < N_CONFIGS; i++) {
+        printf(BLUE "%s" RESET "\n", configs[i].name);
+        test_fn(test_dict_create(configs[i].opts));
+        test_fn(test_dict_get(configs[i].opts));
+        test_fn(test_dict_get_many(configs[i].opts));
+        test_fn(test_dict_iter(configs[i].opts));
+        test_fn(test_dict_scan(configs[i].opts));
+        test_fn(test_dict_insert(configs[i].opts));
+        test_fn(test_dict_remove(configs[i].opts));
+        test_fn(test_dict_resize(configs[i].opts));
+    }
+
+    test_fn(test_dict_ordered());
+    test_fn(test_dict_ordered_small());
+
+    for (int i = 0; i < N_CONFIGS; i++)
+        test_dict_benchmark(configs[i], 10000);
+
+    for (int i = 0; i < N_CONFIGS; i++)
+        test_dict_latency_benchmark(configs[i], 300000);
 
-    test_dict_benchmark(10000);
+    // Only the plain engines, the table must be large to be worth it.
+    test_dict_get_many_benchmark(configs[0], 1000000);
+    test_dict_get_many_benchmark(configs[2], 1000000);
 
     TEST_TEARDOWN();
     return EXIT_SUCCESS;
@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <dict.h>
+#include <fdict.h>
+
+#define N_KEYS 20000
+
+// A dict mapping "key<i>" to "value<i>".
+static dict_t *mk_dict(dict_opts_t opts, size_t n) {
+    dict_t *dict = dict_create_with(opts);
+    char key[32], value[32];
+    for (size_t i = 0; i < n; i++) {
+        sprintf(key, "key%zu", i);
+        sprintf(value, "value%zu", i);
+        dict_insert(dict, key, strdup(value));
+    }
+    return dict;
+}
+
+static char *tmp_path() {
+    static char path[64];
+    sprintf(path, "/tmp/fdict_test_%d.fdict", (int)getpid());
+    return path;
+}
+
+bool test_fdict_buffer() {
+    dict_t *dict = mk_dict(DICT_OPTS(), N_KEYS);
+    size_t size;
+    void *image = fdict_freeze_buffer(dict, NULL, &size);
+    fdict_t *fdict = fdict_from_buffer(image, size);
+    assert_neq(fdict, NULL);
+    assert_eq(fdict_get_size(fdict), N_KEYS);
+
+    char key[32];
+    for (size_t i = 0; i < N_KEYS; i++) {
+        sprintf(key, "key%zu", i);
+        size_t value_size;
+        const char *value = fdict_get_sized(fdict, key, &value_size);
+        assert_neq(value, NULL);
+        assert_eq(strcmp(value, (char *)dict_get(dict, key)), 0);
+        assert_eq(value_size, strlen(value) + 1);
+        bool aligned = (uintptr_t)value % 8 == 0;
+        assert_eq(aligned, true);
+    }
+    assert_eq(fdict_get(fdict, "key"), NULL);
+    assert_eq(fdict_contains(fdict, "value0"), false);
+    assert_eq(fdict_contains(fdict, ""), false);
+
+    fdict_close(fdict);
+    free(image);
+    dict_delete(dict, free);
+    return true;
+}
+
+bool test_fdict_file() {
+    dict_t *dict = mk_dict(DICT_OPTS(.kind = DICT_OPEN), N_KEYS);
+    assert_eq(fdict_freeze(dict, tmp_path(), NULL), true);
+    dict_delete(dict, free);
+
+    fdict_t *fdict = fdict_open(tmp_path());
+    assert_neq(fdict, NULL);
+    assert_eq(fdict_get_size(fdict), N_KEYS);
+
+    char key[32], value[32];
+    for (size_t i = 0; i < N_KEYS; i++) {
+        sprintf(key, "key%zu", i);
+        sprintf(value, "value%zu", i);
+        assert_eq(strcmp(fdict_get(fdict, key), value), 0);
+    }
+    assert_eq(fdict_get(fdict, "key-1"), NULL);
+
+    // Freezing again replaces the file without changing the mapped image.
+    dict = mk_dict(DICT_OPTS(), 10);
+    assert_eq(fdict_freeze(dict, tmp_path(), NULL), true);
+    dict_delete(dict, free);
+    assert_eq(strcmp(fdict_get(fdict, "key100"), "value100"), 0);
+    fdict_close(fdict);
+
+    fdict = fdict_open(tmp_path());
+    assert_eq(fdict_get_size(fdict), 10);
+    assert_eq(fdict_get(fdict, "key100"), NULL);
+    fdict_close(fdict);
+
+    unlink(tmp_path());
+    assert_eq(fdict_open(tmp_path()), NULL);
+    return true;
+}
+
+typedef struct {
+    int id;
+    double score;
+} record_t;
+
+static size_t dump_record(dict_value_t value, const void **data) {
+    *data = value;
+    return sizeof(record_t);
+}
+
+// Writes every value into the same buffer.
+static size_t dump_scratch(dict_value_t value, const void **data) {
+    static char scratch[32];
+    *data = scratch;
+    return sprintf(scratch, "id=%d", ((record_t *)value)->id) + 1;
+}
+
+bool test_fdict_dump() {
+    dict_t *dict = dict_create();
+    record_t records[100];
+    char key[32];
+    for (int i = 0; i < 100; i++) {
+        records[i] = (record_t){ i, i / 2.0 };
+        sprintf(key, "record%d", i);
+        dict_insert(dict, key, &records[i]);
+    }
+    // Keys of any length, and no key at all.
+    dict_insert(dict, "", &records[0]);
+    char long_key[1000];
+    memset(long_key, 'k', sizeof(long_key) - 1);
+    long_key[sizeof(long_key) - 1] = '\0';
+    dict_insert(dict, long_key, &records[1]);
+
+    size_t size;
+    void *image = fdict_freeze_buffer(dict, dump_record, &size);
+    fdict_t *fdict = fdict_from_buffer(image, size);
+    for (int i = 0; i < 100; i++) {
+        sprintf(key, "record%d", i);
+        const record_t *record = fdict_get(fdict, key);
+        assert_eq(record->id, i);
+        bool same_score = record->score == i / 2.0;
+        assert_eq(same_score, true);
+    }
+    assert_eq(((const record_t *)fdict_get(fdict, ""))->id, 0);
+    assert_eq(((const record_t *)fdict_get(fdict, long_key))->id, 1);
+
+    fdict_close(fdict);
+    free(image);
+
+    // Each value is copied when dumped, before the buffer is reused.
+    image = fdict_freeze_buffer(dict, dump_scratch, &size);
+    fdict = fdict_from_buffer(image, size);
+    char expected[32];
+    for (int i = 0; i < 100; i++) {
+        sprintf(key, "record%d", i);
+        sprintf(expected, "id=%d", i);
+        assert_eq(strcmp(fdict_get(fdict, key), expected), 0);
+    }
+    fdict_close(fdict);
+    free(image);
+    dict_delete(dict, NULL);
+
+    // An empty dict, and NULL values stored as empty strings.
+    dict = dict_create();
+    image = fdict_freeze_buffer(dict, NULL, &size);
+    fdict = fdict_from_buffer(image, size);
+    assert_eq(fdict_get_size(fdict), 0);
+    assert_eq(fdict_get(fdict, "key"), NULL);
+    fdict_close(fdict);
+    free(image);
+
+    dict_insert(dict, "null", NULL);
+    image = fdict_freeze_buffer(dict, NULL, &size);
+    fdict = fdict_from_buffer(image, size);
+    size_t value_size = 1;
+    assert_neq(fdict_get_sized(fdict, "null", &value_size), NULL);
+    assert_eq(value_size, 0);
+    fdict_close(fdict);
+    free(image);
+
+    dict_delete(dict, NULL);
+    return true;
+}
+
+bool test_fdict_invalid() {
+    dict_t *dict = mk_dict(DICT_OPTS(), 100);
+    size_t size;
+    unsigned char *image = fdict_freeze_buffer(dict, NULL, &size);
+
+    // Truncated images and images with a wrong magic are refused.
+    assert_eq(fdict_from_buffer(image, 16), NULL);
+    assert_eq(fdict_from_buffer(image, size - 8), NULL);
+    image[0] ^= 1;
+    assert_eq(fdict_from_buffer(image, size), NULL);
+    image[0] ^= 1;
+
+    // Corrupted entries don't make lookups read out of the image.
+    fdict_t *fdict = fdict_from_buffer(image, size);
+    memset(image + 64, 0xff, size - 64);
+    char key[32];
+    for (size_t i = 0; i < 100; i++) {
+        sprintf(key, "key%zu", i);
+        fdict_get(fdict, key);
+    }
+    fdict_close(fdict);
+
+    // So does a file that is not an image.
+    FILE *f = fopen(tmp_path(), "w");
+    fprintf(f, "not a frozen dict, not a frozen dict, not a frozen dict\n");
+    fclose(f);
+    assert_eq(fdict_open(tmp_path()), NULL);
+    unlink(tmp_path());
+
+    free(image);
+    dict_delete(dict, free);
+    return true;
+}
+
+/* Benchmarks */
+
+// Compares building a dict with dict_insert against opening its frozen image,
+// then the lookups on both.
+void test_fdict_benchmark(size_t n) {
+    char **keys = (char **)malloc(n * sizeof(char *));
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = (char *)malloc(32);
+        sprintf(keys[i], "key%zu", i);
+    }
+
+    double start = now_ms();
+    dict_t *dict = dict_create();
+    for (size_t i = 0; i < n; i++) dict_insert(dict, keys[i], keys[i]);
+    double build = now_ms() - start;
+
+    start = now_ms();
+    fdict_freeze(dict, tmp_path(), NULL);
+    double freeze = now_ms() - start;
+
+    start = now_ms();
+    fdict_t *fdict = fdict_open(tmp_path());
+    double open = now_ms() - start;
+
+    printf(CYAN "%zu keys: building the dict took %.2lf ms, freezing it %.2lf ms, opening the image %.3lf ms" RESET "\n",
+           n, build, freeze, open);
+
+    size_t found = 0;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found += dict_get(dict, keys[(i * 7919) % n]) != NULL;
+    double dict_lookups = now_ms() - start;
+
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found += fdict_get(fdict, keys[(i * 7919) % n]) != NULL;
+    double fdict_lookups = now_ms() - start;
+
+    if (found != 2 * n) printf(YELLOW "Lookups missed some keys" RESET "\n");
+    printf(CYAN "%zu lookups: dict %.2lf ms, frozen dict %.2lf ms (first pass, pages faulted in)" RESET "\n",
+           n, dict_lookups, fdict_lookups);
+
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found += fdict_get(fdict, keys[(i * 7919) % n]) != NULL;
+    printf(CYAN "%zu lookups: frozen dict %.2lf ms (second pass)" RESET "\n", n, now_ms() - start);
+
+    fdict_close(fdict);
+    unlink(tmp_path());
+    dict_delete(dict, NULL);
+    for (size_t i = 0; i < n; i++) free(keys[i]);
+    free(keys);
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_fdict_buffer());
+    test_fn(test_fdict_file());
+    test_fn(test_fdict_dump());
+    test_fn(test_fdict_invalid());
+
+    test_fdict_benchmark(1000000);
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}
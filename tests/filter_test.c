@@ -0,0 +1,253 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <filter.h>
+#include <hashset.h>
+
+bool test_bloom() {
+    size_t n = 10000;
+    char **keys = mk_keys("key", n), **absent = mk_keys("absent", n);
+    bloom_t *bloom = bloom_create_with(BLOOM_OPTS(.n = n, .bits_per_key = 10));
+    assert_geq(bloom_get_bits(bloom), n * 10);
+
+    for (size_t i = 0; i < n; i++) bloom_insert(bloom, keys[i]);
+
+    // No false negatives, and about 1% of false positives.
+    size_t false_positives = 0;
+    for (size_t i = 0; i < n; i++) {
+        assert_eq(bloom_contains(bloom, keys[i]), true);
+        false_positives += bloom_contains(bloom, absent[i]);
+    }
+    assert_le(false_positives, n * 3 / 100);
+
+    bloom_delete(bloom);
+    free_keys(keys, n);
+    free_keys(absent, n);
+    return true;
+}
+
+bool test_bloom_from_hashset() {
+    hashset_t *set = hashset_create_with(HASHSET_OPTS(.hash = hash_sdbm));
+    char **keys = mk_keys("key", 1000);
+    for (size_t i = 0; i < 1000; i++) hashset_insert(set, keys[i]);
+
+    bloom_t *bloom = bloom_from_hashset(set, 8);
+    hash_fn_t hash;
+    uint64_t seed;
+    hashset_get_hash(set, &hash, &seed);
+    for (size_t i = 0; i < 1000; i++) {
+        assert_eq(bloom_contains(bloom, keys[i]), true);
+        // The filter hashes keys exactly like the hashset.
+        assert_eq(bloom_contains_hash(bloom, hash(keys[i], strlen(keys[i]), seed)), true);
+    }
+
+    bloom_delete(bloom);
+    hashset_delete(set);
+    free_keys(keys, 1000);
+    return true;
+}
+
+bool test_cuckoo() {
+    size_t n = 10000;
+    char **keys = mk_keys("key", n), **absent = mk_keys("absent", n);
+    cuckoo_t *cuckoo = cuckoo_create_with(CUCKOO_OPTS(.n = n));
+
+    for (size_t i = 0; i < n; i++) assert_eq(cuckoo_insert(cuckoo, keys[i]), true);
+    assert_eq(cuckoo_get_size(cuckoo), n);
+
+    size_t false_positives = 0;
+    for (size_t i = 0; i < n; i++) {
+        assert_eq(cuckoo_contains(cuckoo, keys[i]), true);
+        false_positives += cuckoo_contains(cuckoo, absent[i]);
+    }
+    assert_le(false_positives, n / 1000);
+
+    // Removed keys are gone, the others stay.
+    for (size_t i = 0; i < n; i += 2) assert_eq(cuckoo_remove(cuckoo, keys[i]), true);
+    size_t still_there = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (i % 2 == 1) assert_eq(cuckoo_contains(cuckoo, keys[i]), true);
+        else still_there += cuckoo_contains(cuckoo, keys[i]);
+    }
+    assert_le(still_there, n / 1000);
+    assert_eq(cuckoo_get_size(cuckoo), n / 2);
+
+    // A key inserted twice must be removed twice.
+    assert_eq(cuckoo_insert(cuckoo, "twice"), true);
+    assert_eq(cuckoo_insert(cuckoo, "twice"), true);
+    assert_eq(cuckoo_remove(cuckoo, "twice"), true);
+    assert_eq(cuckoo_contains(cuckoo, "twice"), true);
+    assert_eq(cuckoo_remove(cuckoo, "twice"), true);
+
+    cuckoo_delete(cuckoo);
+    free_keys(keys, n);
+    free_keys(absent, n);
+    return true;
+}
+
+bool test_cuckoo_full() {
+    // A fixed seed, so the keys fill the table and find room again the same way
+    // on every run.
+    cuckoo_t *cuckoo = cuckoo_create_with(CUCKOO_OPTS(.n = 4096, .seed = 42));
+    size_t slots = cuckoo_get_bits(cuckoo) / 16;
+    char key[32];
+
+    size_t n = 0;
+    for (;; n++) {
+        sprintf(key, "key%zu", n);
+        if (!cuckoo_insert(cuckoo, key)) break;
+    }
+    // Inserting only fails once the table is nearly full.
+    assert_geq(n, slots * 9 / 10);
+    for (size_t i = 0; i < n; i++) {
+        sprintf(key, "key%zu", i);
+        assert_eq(cuckoo_contains(cuckoo, key), true);
+    }
+
+    // Removing keys makes room again.
+    for (size_t i = 0; i < n / 10; i++) {
+        sprintf(key, "key%zu", i);
+        assert_eq(cuckoo_remove(cuckoo, key), true);
+    }
+    sprintf(key, "key%zu", n);
+    assert_eq(cuckoo_insert(cuckoo, key), true);
+    assert_eq(cuckoo_contains(cuckoo, key), true);
+
+    cuckoo_delete(cuckoo);
+    return true;
+}
+
+bool test_cuckoo_from_hashset() {
+    hashset_t *set = hashset_create();
+    char **keys = mk_keys("key", 1000);
+    for (size_t i = 0; i < 1000; i++) hashset_insert(set, keys[i]);
+
+    cuckoo_t *cuckoo = cuckoo_from_hashset(set);
+    assert_eq(cuckoo_get_size(cuckoo), 1000);
+    for (size_t i = 0; i < 1000; i++) assert_eq(cuckoo_contains(cuckoo, keys[i]), true);
+
+    // The filter follows the hashset as keys are removed.
+    for (size_t i = 0; i < 1000; i++) {
+        hashset_remove(set, keys[i]);
+        cuckoo_remove(cuckoo, keys[i]);
+    }
+    assert_eq(cuckoo_get_size(cuckoo), 0);
+
+    cuckoo_delete(cuckoo);
+    hashset_delete(set);
+    free_keys(keys, 1000);
+    return true;
+}
+
+/* Benchmarks */
+
+// Measures the false positive rate of each filter for some memory per key.
+void test_filter_fpr_benchmark(size_t n) {
+    char **keys = mk_keys("key", n), **absent = mk_keys("absent", n);
+
+    double bits[] = { 4, 6, 8, 10, 12, 16, 20 };
+    for (int b = 0; b < sizeof(bits) / sizeof(*bits); b++) {
+        bloom_t *bloom = bloom_create_with(BLOOM_OPTS(.n = n, .bits_per_key = bits[b]));
+        for (size_t i = 0; i < n; i++) bloom_insert(bloom, keys[i]);
+
+        size_t false_positives = 0;
+        for (size_t i = 0; i < n; i++) false_positives += bloom_contains(bloom, absent[i]);
+
+        printf(CYAN "bloom: %.1lf bits/key, %.3lf%% false positives" RESET "\n",
+               (double)bloom_get_bits(bloom) / n, 100. * false_positives / n);
+        bloom_delete(bloom);
+    }
+
+    // The cuckoo filter has a fixed fingerprint, its memory per key depends on
+    // how full it is.
+    cuckoo_t *cuckoo = cuckoo_create_with(CUCKOO_OPTS(.n = n));
+    for (size_t i = 0; i < n; i++) cuckoo_insert(cuckoo, keys[i]);
+
+    size_t false_positives = 0;
+    for (size_t i = 0; i < n; i++) false_positives += cuckoo_contains(cuckoo, absent[i]);
+
+    printf(CYAN "cuckoo: %.1lf bits/key (%.0lf%% full), %.3lf%% false positives" RESET "\n",
+           (double)cuckoo_get_bits(cuckoo) / n, 100. * n / (cuckoo_get_bits(cuckoo) / 16),
+           100. * false_positives / n);
+    cuckoo_delete(cuckoo);
+
+    free_keys(keys, n);
+    free_keys(absent, n);
+}
+
+// Looks up keys that are mostly absent in a hashset alone and with a filter in
+// front of it.
+void test_filter_lookup_benchmark(size_t n) {
+    char **keys = mk_keys("key", n), **absent = mk_keys("absent", n);
+    hashset_t *set = hashset_create();
+    for (size_t i = 0; i < n; i++) hashset_insert(set, keys[i]);
+
+    bloom_t *bloom = bloom_from_hashset(set, 10);
+    cuckoo_t *cuckoo = cuckoo_from_hashset(set);
+
+    // 1 in 16 lookups is of a key in the set.
+    char **lookups = (char **)malloc(n * sizeof(char *));
+    for (size_t i = 0; i < n; i++) lookups[i] = i % 16 == 0 ? keys[i] : absent[i];
+
+    size_t found[3] = { 0 };
+    double start = now_ms();
+    for (size_t i = 0; i < n; i++) found[0] += hashset_contains(set, lookups[i]);
+    double plain = now_ms() - start;
+
+    start = now_ms();
+    for (size_t i = 0; i < n; i++)
+        found[1] += bloom_contains(bloom, lookups[i]) && hashset_contains(set, lookups[i]);
+    double with_bloom = now_ms() - start;
+
+    start = now_ms();
+    for (size_t i = 0; i < n; i++)
+        found[2] += cuckoo_contains(cuckoo, lookups[i]) && hashset_contains(set, lookups[i]);
+    double with_cuckoo = now_ms() - start;
+
+    if (found[0] != found[1] || found[0] != found[2])
+        printf(YELLOW "Filters changed the result of the lookups" RESET "\n");
+
+    printf(CYAN "%zu lookups, mostly absent: hashset %.2lf Mops/s, bloom + hashset %.2lf Mops/s, "
+           "cuckoo + hashset %.2lf Mops/s" RESET "\n",
+           n, n / plain / 1e3, n / with_bloom / 1e3, n / with_cuckoo / 1e3);
+
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found[1] += bloom_contains(bloom, lookups[i]);
+    double bloom_only = now_ms() - start;
+
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found[2] += cuckoo_contains(cuckoo, lookups[i]);
+    double cuckoo_only = now_ms() - start;
+
+    printf(CYAN "%zu lookups on the filters alone: bloom %.2lf Mops/s, cuckoo %.2lf Mops/s" RESET "\n",
+           n, n / bloom_only / 1e3, n / cuckoo_only / 1e3);
+
+    free(lookups);
+    bloom_delete(bloom);
+    cuckoo_delete(cuckoo);
+    hashset_delete(set);
+    free_keys(keys, n);
+    free_keys(absent, n);
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_bloom());
+    test_fn(test_bloom_from_hashset());
+    test_fn(test_cuckoo());
+    test_fn(test_cuckoo_full());
+    test_fn(test_cuckoo_from_hashset());
+
+    test_filter_fpr_benchmark(200000);
+    test_filter_lookup_benchmark(1000000);
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <generic.h>
+#include <gdict.h>
+#include <dict.h>
+
+typedef struct {
+    int x, y, z;
+} point_t;
+
+bool test_gdict_create() {
+    gdict_t *gdict = gdict_create(GEN_INT);
+    assert_neq(gdict, NULL);
+    assert_eq(gdict_get_size(gdict), 0);
+    assert_eq(gdict_contains(gdict, &(int){ 0 }), false);
+
+    gdict_delete(gdict, NULL);
+    return true;
+}
+
+bool test_gdict_int() {
+    gdict_t *gdict = gdict_create(GEN_INT);
+
+    for (intptr_t i = 0; i < 10000; i++)
+        assert_eq(gdict_insert(gdict, &(int){ i * 7 }, (dict_value_t)i), true);
+
+    assert_eq(gdict_get_size(gdict), 10000);
+    assert_eq(gdict_insert(gdict, &(int){ 7 }, NULL), false);
+    for (intptr_t i = 0; i < 10000; i++) {
+        assert_eq((intptr_t)gdict_get(gdict, &(int){ i * 7 }), i);
+        assert_eq(gdict_contains(gdict, &(int){ i * 7 + 1 }), false);
+    }
+
+    // Removes most of the keys, the table shrinks as it empties.
+    size_t grown = gdict_get_capacity(gdict);
+    for (intptr_t i = 10; i < 10000; i++)
+        assert_eq((intptr_t)gdict_remove_entry(gdict, &(int){ i * 7 }), i);
+
+    assert_eq(gdict_get_size(gdict), 10);
+    assert_le(gdict_get_capacity(gdict), grown / 8);
+    assert_eq(gdict_remove(gdict, &(int){ 7 * 20 }, NULL), false);
+    for (intptr_t i = 0; i < 10; i++)
+        assert_eq((intptr_t)gdict_get(gdict, &(int){ i * 7 }), i);
+
+    gdict_delete(gdict, NULL);
+    return true;
+}
+
+bool test_gdict_double() {
+    gdict_t *gdict = gdict_create(GEN_DOUBLE);
+
+    assert_eq(gdict_insert(gdict, &(double){ 0.5 }, "half"), true);
+    assert_eq(gdict_insert(gdict, &(double){ 0.0 }, "zero"), true);
+    // 0.0 and -0.0 are the same key.
+    assert_eq(gdict_insert(gdict, &(double){ -0.0 }, "minus zero"), false);
+    assert_eq(strcmp(gdict_get(gdict, &(double){ -0.0 }), "zero"), 0);
+    assert_eq(strcmp(gdict_get(gdict, &(double){ 0.5 }), "half"), 0);
+    assert_eq(gdict_get(gdict, &(double){ 0.25 }), NULL);
+
+    gdict_delete(gdict, NULL);
+    return true;
+}
+
+bool test_gdict_struct() {
+    // 12 byte keys, hashed as bytes.
+    gdict_t *gdict = gdict_create(GEN_STRUCT(3,
+        GEN_SFIELD("x", GEN_INT),
+        GEN_SFIELD("y", GEN_INT),
+        GEN_SFIELD("z", GEN_INT)
+    ));
+
+    for (int i = 0; i < 1000; i++) {
+        point_t p = { i, -i, i * i };
+        int *value = (int *)malloc(sizeof(int));
+        *value = i;
+        assert_eq(gdict_insert(gdict, &p, value), true);
+    }
+    for (int i = 0; i < 1000; i++) {
+        point_t p = { i, -i, i * i };
+        point_t q = { i, i, i * i };
+        bool same = i == 0;
+        assert_eq(*(int *)gdict_get(gdict, &p), i);
+        assert_eq(gdict_contains(gdict, &q), same);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        point_t p = { i, -i, i * i };
+        assert_eq(gdict_remove(gdict, &p, free), true);
+    }
+    assert_eq(gdict_get_size(gdict), 500);
+
+    gdict_delete(gdict, free);
+    return true;
+}
+
+bool test_gdict_small_keys() {
+    gdict_t *gdict = gdict_create(GEN_CHAR);
+
+    for (int c = 0; c < 256; c++)
+        assert_eq(gdict_insert(gdict, &(char){ c }, (dict_value_t)(intptr_t)c), true);
+    for (int c = 0; c < 256; c++)
+        assert_eq((intptr_t)gdict_get(gdict, &(char){ c }), c);
+
+    gdict_delete(gdict, NULL);
+    return true;
+}
+
+// Integer keyed map: gdict with int keys against dict with formatted keys.
+void test_gdict_benchmark(size_t n) {
+    char key[32];
+    double start;
+
+    gdict_t *gdict = gdict_create(GEN_INT);
+    start = now_ms();
+    for (int i = 0; i < n; i++)
+        gdict_insert(gdict, &i, NULL);
+    for (int i = 0; i < n; i++)
+        gdict_contains(gdict, &i);
+    printf(CYAN "gdict int keys: %zu insertions and lookups took %.2lf milliseconds" RESET "\n",
+           n, now_ms() - start);
+    gdict_delete(gdict, NULL);
+
+    dict_t *dict = dict_create_with(DICT_OPTS(.kind = DICT_OPEN));
+    start = now_ms();
+    for (int i = 0; i < n; i++) {
+        sprintf(key, "%d", i);
+        dict_insert(dict, key, NULL);
+    }
+    for (int i = 0; i < n; i++) {
+        sprintf(key, "%d", i);
+        dict_contains(dict, key);
+    }
+    printf(CYAN "dict sprintf keys: %zu insertions and lookups took %.2lf milliseconds" RESET "\n",
+           n, now_ms() - start);
+    dict_delete(dict, NULL);
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_gdict_create());
+    test_fn(test_gdict_int());
+    test_fn(test_gdict_double());
+    test_fn(test_gdict_struct());
+    test_fn(test_gdict_small_keys());
+
+    test_gdict_benchmark(200000);
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <hash.h>
+
+#define N_BUCKETS 1024
+#define BUCKET_BITS 10
+
+typedef struct {
+    char *name;
+    hash_fn_t hash;
+} hash_config_t;
+
+static hash_config_t configs[] = {
+    { "hash_wy", hash_wy },
+    { "hash_sdbm", hash_sdbm },
+};
+
+#define N_CONFIGS (sizeof(configs) / sizeof(*configs))
+
+static double now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// xorshift, only used to generate inputs.
+static uint64_t next_rand(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// Chi-square statistic of `n` keys of the form "key<i>" spread over N_BUCKETS,
+// using either the low or the high bits of the hash. For a uniform hash it is
+// close to N_BUCKETS - 1 (standard deviation of about 45).
+static double chi_square(hash_fn_t hash, size_t n, bool high_bits) {
+    size_t counts[N_BUCKETS] = { 0 };
+    char key[32];
+    for (size_t i = 0; i < n; i++) {
+        int len = sprintf(key, "key%zu", i);
+        uint64_t h = hash(key, len, 0x1234);
+        counts[high_bits ? h >> (64 - BUCKET_BITS) : h & (N_BUCKETS - 1)]++;
+    }
+
+    double expected = (double)n / N_BUCKETS, chi = 0;
+    for (int i = 0; i < N_BUCKETS; i++)
+        chi += (counts[i] - expected) * (counts[i] - expected) / expected;
+    return chi;
+}
+
+// Flips each bit of random `len` byte inputs and measures how often each output
+// bit changes. Returns the worst distance from 1/2 among the output bits.
+static double avalanche_bias(hash_fn_t hash, size_t len, int trials) {
+    uint8_t input[64];
+    size_t flips[64] = { 0 };
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+
+    for (int t = 0; t < trials; t++) {
+        for (size_t i = 0; i < len; i++) input[i] = next_rand(&state);
+        uint64_t h = hash(input, len, 0x1234);
+
+        for (size_t bit = 0; bit < len * 8; bit++) {
+            input[bit / 8] ^= 1 << (bit % 8);
+            uint64_t diff = h ^ hash(input, len, 0x1234);
+            input[bit / 8] ^= 1 << (bit % 8);
+            for (int o = 0; o < 64; o++) flips[o] += (diff >> o) & 1;
+        }
+    }
+
+    double worst = 0, samples = (double)trials * len * 8;
+    for (int o = 0; o < 64; o++) {
+        double bias = flips[o] / samples - 0.5;
+        if (bias < 0) bias = -bias;
+        if (bias > worst) worst = bias;
+    }
+    return worst;
+}
+
+bool test_hash_seed() {
+    char *str = "Hello, World!";
+    size_t len = strlen(str);
+
+    assert_eq(hash_wy(str, len, 1), hash_wy(str, len, 1));
+    assert_neq(hash_wy(str, len, 1), hash_wy(str, len, 2));
+    assert_neq(hash_sdbm(str, len, 1), hash_sdbm(str, len, 2));
+    assert_neq(hash_random_seed(), 0);
+    return true;
+}
+
+bool test_hash_lengths() {
+    // Every length goes through a different path of hash_wy. Inputs that are
+    // prefixes of each other or that differ on a single byte must not collide.
+    char buf[256];
+    uint64_t hashes[200];
+    memset(buf, 'a', sizeof(buf));
+
+    for (size_t len = 0; len < 200; len++) {
+        hashes[len] = hash_wy(buf + 1, len, 42); // Unaligned on purpose.
+        for (size_t prev = 0; prev < len; prev++)
+            assert_neq(hashes[len], hashes[prev]);
+
+        for (size_t i = 0; i < len; i++) {
+            buf[1 + i] = 'b';
+            assert_neq(hash_wy(buf + 1, len, 42), hashes[len]);
+            buf[1 + i] = 'a';
+        }
+    }
+    return true;
+}
+
+bool test_hash_distribution() {
+    // 6 standard deviations above the expected value.
+    double limit = N_BUCKETS - 1 + 6 * 45;
+
+    for (int i = 0; i < N_CONFIGS; i++) {
+        double low = chi_square(configs[i].hash, 100000, false);
+        double high = chi_square(configs[i].hash, 100000, true);
+        double short_bias = avalanche_bias(configs[i].hash, 8, 2000);
+        double long_bias = avalanche_bias(configs[i].hash, 40, 500);
+        printf(CYAN "%s: chi-square low bits %.0lf, high bits %.0lf (expected ~%d), "
+               "avalanche bias 8 bytes %.3lf, 40 bytes %.3lf" RESET "\n",
+               configs[i].name, low, high, N_BUCKETS - 1, short_bias, long_bias);
+
+        if (configs[i].hash == hash_wy) {
+            assert_le(low, limit);
+            assert_le(high, limit);
+            assert_le(short_bias, 0.02);
+            assert_le(long_bias, 0.02);
+        }
+    }
+    return true;
+}
+
+// Hashes `n` keys of `len` bytes and reports the time per hash and throughput.
+void test_hash_benchmark(hash_config_t config, size_t len, size_t n) {
+    char *buf = (char *)malloc(len + n);
+    for (size_t i = 0; i < len + n; i++) buf[i] = 'a' + i % 26;
+
+    volatile uint64_t sink = 0;
+    double start = now_us();
+    for (size_t i = 0; i < n; i++)
+        sink ^= config.hash(buf + i, len, 0x1234);
+    double elapsed = now_us() - start;
+    (void)sink;
+
+    printf(CYAN "%s: %zu byte keys, %.2lf ns/hash, %.0lf MB/s" RESET "\n",
+           config.name, len, elapsed * 1e3 / n, (double)len * n / elapsed);
+    free(buf);
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_hash_seed());
+    test_fn(test_hash_lengths());
+    test_fn(test_hash_distribution());
+
+    for (int i = 0; i < N_CONFIGS; i++) {
+        test_hash_benchmark(configs[i], 8, 2000000);
+        test_hash_benchmark(configs[i], 24, 2000000);
+        test_hash_benchmark(configs[i], 256, 200000);
+    }
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,228 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <hashset.h>
+
+bool test_hashset_resize(hashset_opts_t opts) {
+    hashset_t *set = hashset_create_with(opts);
+    assert_neq(set, NULL);
+
+    // Reserving avoids every resize of the bulk load.
+    char key[32];
+    hashset_reserve(set, 1000);
+    size_t reserved = hashset_get_capacity(set);
+    assert_geq(reserved, 1000);
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "key%d", i);
+        assert_eq(hashset_insert(set, key), true);
+    }
+    assert_eq(hashset_get_capacity(set), reserved);
+
+    // Does not shrink below the reserved size.
+    for (int i = 10; i < 1000; i++) {
+        sprintf(key, "key%d", i);
+        assert_eq(hashset_remove(set, key), true);
+    }
+    assert_eq(hashset_get_capacity(set), reserved);
+
+    hashset_shrink_to_fit(set);
+    assert_le(hashset_get_capacity(set), reserved);
+
+    // Grows and then shrinks automatically as keys are removed.
+    for (int i = 10; i < 10000; i++) {
+        sprintf(key, "key%d", i);
+        assert_eq(hashset_insert(set, key), true);
+    }
+    size_t grown = hashset_get_capacity(set);
+    for (int i = 10; i < 10000; i++) {
+        sprintf(key, "key%d", i);
+        assert_eq(hashset_remove(set, key), true);
+    }
+    assert_le(hashset_get_capacity(set), grown / 8);
+    for (int i = 0; i < 10; i++) {
+        sprintf(key, "key%d", i);
+        assert_eq(hashset_contains(set, key), true);
+    }
+
+    hashset_delete(set);
+    return true;
+}
+
+bool test_hashset_remove(hashset_opts_t opts) {
+    hashset_t *set = hashset_create_with(opts);
+    assert_neq(set, NULL);
+
+    // Cant remove something that isn't there.
+    assert_eq(hashset_remove(set, "Hello"), false);
+    assert_eq(hashset_insert(set, "Hello"), true);
+    assert_eq(hashset_remove(set, "Hello"), true);
+    assert_eq(hashset_contains(set, "Hello"), false);
+    assert_eq(hashset_get_size(set), 0);
+
+    char key[32];
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "key%d", i);
+        assert_eq(hashset_insert(set, key), true);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        sprintf(key, "key%d", i);
+        assert_eq(hashset_remove(set, key), true);
+    }
+    assert_eq(hashset_get_size(set), 500);
+    for (int i = 0; i < 1000; i++) {
+        bool kept = i & 1;
+        sprintf(key, "key%d", i);
+        assert_eq(hashset_contains(set, key), kept);
+    }
+
+    hashset_delete(set);
+    return true;
+}
+
+bool test_hashset_insert(hashset_opts_t opts) {
+    hashset_t *set = hashset_create_with(opts);
+    assert_neq(set, NULL);
+
+    // Keys are copied, so a stack buffer can be reused.
+    char key[32];
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "key%d", i);
+        assert_eq(hashset_insert(set, key), true);
+        assert_eq(hashset_get_size(set), i + 1);
+    }
+
+    // No duplicates.
+    assert_eq(hashset_insert(set, "key0"), false);
+    assert_eq(hashset_insert(set, "key999"), false);
+
+    // Keys that share a prefix are different keys.
+    assert_eq(hashset_contains(set, "key"), false);
+    assert_eq(hashset_contains(set, "key1000"), false);
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "key%d", i);
+        assert_eq(hashset_contains(set, key), true);
+    }
+
+    hashset_delete(set);
+    return true;
+}
+
+bool test_hashset_contains_many(hashset_opts_t opts) {
+    hashset_t *set = hashset_create_with(opts);
+    char *keys[1500];
+    bool out[1500];
+
+    // Even keys are in the set, odd keys are not.
+    for (int i = 0; i < 1500; i++) {
+        keys[i] = (char *)malloc(32);
+        sprintf(keys[i], "key%d", i);
+        if (i % 2 == 0) hashset_insert(set, keys[i]);
+    }
+
+    // A size that is not a multiple of the batch size.
+    assert_eq(hashset_contains_many(set, keys, 1499, out), 750);
+    for (int i = 0; i < 1499; i++) {
+        bool expected = i % 2 == 0;
+        assert_eq(out[i], expected);
+    }
+
+    for (int i = 0; i < 1500; i++) free(keys[i]);
+    hashset_delete(set);
+    return true;
+}
+
+bool test_hashset_iter(hashset_opts_t opts) {
+    hashset_t *set = hashset_create_with(opts);
+    int seen[1000] = { 0 };
+    char key[32], *it_key;
+
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "key%d", i);
+        hashset_insert(set, key);
+    }
+
+    size_t n = 0;
+    for (hashset_iter_t it = hashset_iter(set); hashset_iter_next(&it, &it_key); n++)
+        seen[atoi(it_key + 3)]++;
+
+    assert_eq(n, 1000);
+    for (int i = 0; i < 1000; i++) assert_eq(seen[i], 1);
+
+    hashset_delete(set);
+    return true;
+}
+
+static void count_seen(char *key, void *ctx) {
+    if (!strncmp(key, "key", 3)) ((int *)ctx)[atoi(key + 3)]++;
+}
+
+// The hashset grows and then shrinks back between the calls of a scan, every
+// key that is there all along must still be visited.
+bool test_hashset_scan(hashset_opts_t opts) {
+    hashset_t *set = hashset_create_with(opts);
+    int seen[1000] = { 0 };
+    char key[32];
+
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "key%d", i);
+        hashset_insert(set, key);
+    }
+
+    size_t cursor = 0, calls = 0;
+    int extra = 0;
+    do {
+        cursor = hashset_scan(set, cursor, 10, count_seen, seen);
+        calls++;
+        if (calls < 20) {
+            for (int j = 0; j < 500; j++, extra++) {
+                sprintf(key, "extra%d", extra);
+                hashset_insert(set, key);
+            }
+        } else {
+            for (int j = 0; j < 500 && extra > 0; j++) {
+                sprintf(key, "extra%d", --extra);
+                hashset_remove(set, key);
+            }
+        }
+    } while (cursor != 0);
+
+    for (int i = 0; i < 1000; i++) assert_geq(seen[i], 1);
+
+    hashset_delete(set);
+    return true;
+}
+
+bool test_hashset_create() {
+    hashset_t *set = hashset_create();
+    assert_neq(set, NULL);
+    assert_eq(hashset_get_size(set), 0);
+    assert_eq(hashset_contains(set, "Hello"), false);
+
+    hashset_delete(set);
+    return true;
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_hashset_create());
+    test_fn(test_hashset_insert(HASHSET_OPTS()));
+    test_fn(test_hashset_remove(HASHSET_OPTS()));
+    test_fn(test_hashset_resize(HASHSET_OPTS()));
+    test_fn(test_hashset_contains_many(HASHSET_OPTS()));
+    test_fn(test_hashset_iter(HASHSET_OPTS()));
+    test_fn(test_hashset_scan(HASHSET_OPTS()));
+    test_fn(test_hashset_insert(HASHSET_OPTS(.incremental = true)));
+    test_fn(test_hashset_remove(HASHSET_OPTS(.incremental = true)));
+    test_fn(test_hashset_resize(HASHSET_OPTS(.incremental = true)));
+    test_fn(test_hashset_contains_many(HASHSET_OPTS(.incremental = true)));
+    test_fn(test_hashset_iter(HASHSET_OPTS(.incremental = true)));
+    test_fn(test_hashset_scan(HASHSET_OPTS(.incremental = true)));
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}
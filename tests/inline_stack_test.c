@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <inline_stack.h>
+
+bool test_istack() {
+    istack_t stack;
+    istack_init(&stack, sizeof(int));
+    assert_eq(istack_pop(&stack, NULL), false);
+    assert_eq(istack_peek(&stack), NULL);
+
+    for (int i = 0; i < 1000; i++) istack_push(&stack, &i);
+    assert_eq(istack_get_size(&stack), 1000);
+    assert_eq(*(int *)istack_peek(&stack), 999);
+
+    int value;
+    for (int i = 999; i >= 0; i--) {
+        assert_eq(istack_pop(&stack, &value), true);
+        assert_eq(value, i);
+    }
+    assert_eq(istack_is_empty(&stack), true);
+
+    istack_destroy(&stack);
+    return true;
+}
+
+bool test_istack_small() {
+    istack_t stack;
+    istack_init(&stack, sizeof(double));
+    size_t small = ISTACK_SMALL_BYTES / sizeof(double);
+    assert_eq(istack_get_cap(&stack), small);
+
+    // Up to the small buffer, elements stay in the struct.
+    for (size_t i = 0; i < small; i++) {
+        double value = i;
+        istack_push(&stack, &value);
+    }
+    assert_eq(stack.data, stack.small);
+
+    // Then they spill to the heap...
+    double value = small;
+    istack_push(&stack, &value);
+    assert_neq(stack.data, stack.small);
+    for (size_t i = small + 1; i < 10 * small; i++) {
+        value = i;
+        istack_push(&stack, &value);
+    }
+
+    // ... and come back once they fit again, in order.
+    for (size_t i = 10 * small; i-- > 0;) {
+        assert_eq(istack_pop(&stack, &value), true);
+        assert_eq(value, (double)i);
+    }
+    assert_eq(stack.data, stack.small);
+    assert_eq(istack_get_cap(&stack), small);
+
+    istack_destroy(&stack);
+    return true;
+}
+
+bool test_istack_hysteresis() {
+    istack_t *stack = istack_create(sizeof(long));
+    long value = 0;
+    for (int i = 0; i < 1024; i++) istack_push(stack, &value);
+    size_t cap = istack_get_cap(stack);
+
+    // Going up and down around a power of two keeps the same memory.
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 300; i++) istack_pop(stack, NULL);
+        assert_eq(istack_get_cap(stack), cap);
+        for (int i = 0; i < 300; i++) istack_push(stack, &value);
+        assert_eq(istack_get_cap(stack), cap);
+    }
+
+    // It shrinks once mostly empty.
+    while (istack_get_size(stack) > 100) istack_pop(stack, NULL);
+    assert_le(istack_get_cap(stack), cap);
+
+    istack_clear(stack);
+    assert_eq(istack_is_empty(stack), true);
+    istack_delete(stack);
+    return true;
+}
+
+bool test_istack_large_elements() {
+    // Elements bigger than the small buffer go to the heap right away.
+    typedef struct { char bytes[ISTACK_SMALL_BYTES + 8]; } big_t;
+    istack_t stack;
+    istack_init(&stack, sizeof(big_t));
+    big_t big;
+    for (int i = 0; i < 10; i++) {
+        memset(big.bytes, i, sizeof(big.bytes));
+        istack_push(&stack, &big);
+    }
+    for (int i = 9; i >= 0; i--) {
+        assert_eq(istack_pop(&stack, &big), true);
+        assert_eq(big.bytes[sizeof(big.bytes) - 1], i);
+    }
+    istack_destroy(&stack);
+    return true;
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_istack());
+    test_fn(test_istack_small());
+    test_fn(test_istack_hysteresis());
+    test_fn(test_istack_large_elements());
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}
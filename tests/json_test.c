@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <time.h>
 
 #include "test_utils.h"
 #include <colors.h>
@@ -64,6 +65,13 @@ bool test_json_object_simple() {
     assert_eq(jtype(dict_get(dict, "key3")), JSON_STRING);
     assert_eq(strcmp(jas_str(dict_get(dict, "key3"))->content, "value2 (string value)"), 0);
 
+    // Pairs are kept in document order.
+    char *order[] = { "key", "key2", "key3" }, *key;
+    int n = 0;
+    for (dict_iter_t it = dict_iter(dict); dict_iter_next(&it, &key, NULL); n++)
+        assert_eq(strcmp(key, order[n]), 0);
+    assert_eq(n, 3);
+
     json_value_delete((json_value_t *)json_object);
     return true;
 }
@@ -265,6 +273,41 @@ bool test_json_null_fail() {
     return true;
 }
 
+// Parses and deletes an array of `n` small objects.
+void test_json_benchmark(size_t n) {
+    char *object = "{\"id\": 1234, \"name\": \"some name\", \"active\": true, "
+                   "\"score\": 0.5, \"tags\": [\"a\", \"b\"], \"parent\": null}";
+    size_t len = strlen(object);
+    char *document = (char *)malloc(n * (len + 1) + 2);
+    char *ptr = document;
+    *ptr++ = '[';
+    for (size_t i = 0; i < n; i++) {
+        memcpy(ptr, object, len);
+        ptr += len;
+        *ptr++ = i + 1 < n ? ',' : ']';
+    }
+    *ptr = '\0';
+
+    json_array_t *array;
+    char *input = document;
+    clock_t start_time = clock();
+    json_parse_array(&input, &array);
+    printf(CYAN "Parsing %zu objects took %lf milliseconds" RESET "\n", n, (double)(clock() - start_time) / (double)(CLOCKS_PER_SEC / 1000));
+
+    char *keys[] = { "id", "name", "active", "score", "tags", "parent", "missing" };
+    size_t found = 0;
+    start_time = clock();
+    for (size_t i = 0; i < array->size; i++)
+        for (size_t j = 0; j < 7; j++)
+            found += json_object_get(jas_obj(array->values[i]), keys[j]) != NULL;
+    printf(CYAN "Looking up %zu keys took %lf milliseconds" RESET "\n", found, (double)(clock() - start_time) / (double)(CLOCKS_PER_SEC / 1000));
+
+    start_time = clock();
+    json_value_delete((json_value_t *)array);
+    printf(CYAN "Deleting %zu objects took %lf milliseconds" RESET "\n", n, (double)(clock() - start_time) / (double)(CLOCKS_PER_SEC / 1000));
+    free(document);
+}
+
 int main(int argc, char *argv[]) {
     TEST_SETUP();
 
@@ -282,6 +325,8 @@ int main(int argc, char *argv[]) {
     test_fn(test_json_object_simple());
     test_fn(test_json_object());
 
+    test_json_benchmark(100000);
+
     TEST_TEARDOWN();
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <hashset.h>
+#include <mphf.h>
+
+// Every key must have its own index in [0, n).
+static bool is_minimal_perfect(mphf_t *mphf, char **keys, size_t n) {
+    bool *seen = (bool *)calloc(n ? n : 1, sizeof(bool));
+    bool ok = mphf_get_size(mphf) == n;
+    for (size_t i = 0; i < n && ok; i++) {
+        size_t idx = mphf_index(mphf, keys[i]);
+        ok = idx < n && !seen[idx];
+        if (ok) seen[idx] = true;
+    }
+    free(seen);
+    return ok;
+}
+
+bool test_mphf_build() {
+    size_t sizes[] = { 0, 1, 2, 3, 10, 100, 1000, 100000 };
+    for (int s = 0; s < sizeof(sizes) / sizeof(*sizes); s++) {
+        size_t n = sizes[s];
+        char **keys = mk_keys("key", n);
+        mphf_t *mphf = mphf_build(keys, n);
+        assert_neq(mphf, NULL);
+        assert_eq(is_minimal_perfect(mphf, keys, n), true);
+
+        // Other keys are mapped in range too.
+        if (n > 0) assert_le(mphf_index(mphf, "not a key"), n);
+
+        mphf_delete(mphf);
+        free_keys(keys, n);
+    }
+    return true;
+}
+
+bool test_mphf_opts() {
+    size_t n = 50000;
+    char **keys = mk_keys("key", n);
+    double cs[] = { 2, 4, 7 }, alphas[] = { 0.8, 0.95, 1 };
+
+    for (int c = 0; c < 3; c++) {
+        for (int a = 0; a < 3; a++) {
+            mphf_t *mphf = mphf_build_with(keys, n, MPHF_OPTS(.c = cs[c], .alpha = alphas[a]));
+            assert_neq(mphf, NULL);
+            assert_eq(is_minimal_perfect(mphf, keys, n), true);
+            mphf_delete(mphf);
+        }
+    }
+
+    // The same seed gives the same function.
+    mphf_t *m1 = mphf_build_with(keys, n, MPHF_OPTS(.seed = 42));
+    mphf_t *m2 = mphf_build_with(keys, n, MPHF_OPTS(.seed = 42));
+    for (size_t i = 0; i < n; i++) assert_eq(mphf_index(m1, keys[i]), mphf_index(m2, keys[i]));
+    mphf_delete(m1);
+    mphf_delete(m2);
+
+    free_keys(keys, n);
+    return true;
+}
+
+bool test_mphf_duplicates() {
+    char *keys[] = { "a", "b", "c", "b" };
+    assert_eq(mphf_build(keys, 4), NULL);
+    return true;
+}
+
+bool test_mphf_from_hashset() {
+    size_t n = 10000;
+    char **keys = mk_keys("key", n);
+    hashset_t *set = hashset_create();
+    for (size_t i = 0; i < n; i++) hashset_insert(set, keys[i]);
+
+    mphf_t *mphf = mphf_from_hashset(set);
+    assert_eq(is_minimal_perfect(mphf, keys, n), true);
+
+    mphf_delete(mphf);
+    hashset_delete(set);
+    free_keys(keys, n);
+    return true;
+}
+
+/* Benchmarks */
+
+// Compares membership tests with a hashset and with a MPHF over an array of
+// the keys ordered by index.
+void test_mphf_benchmark(size_t n) {
+    char **keys = mk_keys("key", n), **absent = mk_keys("absent", n);
+    hashset_t *set = hashset_create();
+    for (size_t i = 0; i < n; i++) hashset_insert(set, keys[i]);
+
+    double start = now_ms();
+    mphf_t *mphf = mphf_build(keys, n);
+    double build = now_ms() - start;
+    printf(CYAN "%zu keys: MPHF built in %.2lf ms, %.2lf bits/key" RESET "\n",
+           n, build, (double)mphf_get_bits(mphf) / n);
+
+    char **by_index = (char **)malloc(n * sizeof(char *));
+    for (size_t i = 0; i < n; i++) by_index[mphf_index(mphf, keys[i])] = keys[i];
+
+    // Half of the lookups are of keys of the set.
+    char **lookups = (char **)malloc(n * sizeof(char *));
+    for (size_t i = 0; i < n; i++) {
+        size_t k = (i * 7919) % n;
+        lookups[i] = i % 2 ? keys[k] : absent[k];
+    }
+
+    size_t found[2] = { 0 };
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found[0] += hashset_contains(set, lookups[i]);
+    double with_set = now_ms() - start;
+
+    start = now_ms();
+    for (size_t i = 0; i < n; i++)
+        found[1] += strcmp(by_index[mphf_index(mphf, lookups[i])], lookups[i]) == 0;
+    double with_mphf = now_ms() - start;
+
+    start = now_ms();
+    size_t sum = 0;
+    for (size_t i = 0; i < n; i++) sum += mphf_index(mphf, lookups[i]);
+    double index_only = now_ms() - start;
+
+    if (found[0] != found[1] || sum == 0) printf(YELLOW "Lookups disagree" RESET "\n");
+    printf(CYAN "%zu lookups: hashset_contains %.2lf ms, mphf_index + key compare %.2lf ms, "
+           "mphf_index alone %.2lf ms" RESET "\n",
+           n, with_set, with_mphf, index_only);
+
+    free(lookups);
+    free(by_index);
+    mphf_delete(mphf);
+    hashset_delete(set);
+    free_keys(keys, n);
+    free_keys(absent, n);
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_mphf_build());
+    test_fn(test_mphf_opts());
+    test_fn(test_mphf_duplicates());
+    test_fn(test_mphf_from_hashset());
+
+    test_mphf_benchmark(1000000);
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <pool.h>
+#include <sorting.h>
+
+/* Fibonacci, the smallest tasks there are */
+
+typedef struct {
+    int n;
+    long result;
+} fib_t;
+
+static long fib_seq(int n) {
+    return n < 2 ? n : fib_seq(n - 1) + fib_seq(n - 2);
+}
+
+static void fib(void *arg) {
+    fib_t *f = (fib_t *)arg;
+    if (f->n < 2) {
+        f->result = f->n;
+        return;
+    }
+    fib_t a = { f->n - 1 }, b = { f->n - 2 };
+    pool_task_t task = POOL_TASK(fib, &a);
+    pool_fork(&task);
+    fib(&b);
+    pool_join(&task);
+    f->result = a.result + b.result;
+}
+
+bool test_pool_fib() {
+    pool_t *pool = pool_create(4);
+    assert_eq(pool_get_threads(pool), 4);
+
+    for (int n = 0; n < 22; n++) {
+        fib_t f = { n };
+        pool_run(pool, fib, &f);
+        assert_eq(f.result, fib_seq(n));
+    }
+
+    pool_delete(pool);
+    return true;
+}
+
+bool test_pool_outside() {
+    // Outside of a pool, forks run right away.
+    fib_t f = { 15 };
+    fib(&f);
+    assert_eq(f.result, fib_seq(15));
+    return true;
+}
+
+/* Parallel merge sort, built on the sequential sorts */
+
+#define SORT_CUTOFF 4096
+
+typedef struct {
+    int *vec;
+    int *tmp;
+    size_t n;
+} range_t;
+
+static int int_compare(void *a, void *b) {
+    return *(int *)a < *(int *)b ? -1 : *(int *)a > *(int *)b;
+}
+
+static void merge(int *vec, int *tmp, size_t mid, size_t n) {
+    size_t i = 0, j = mid, k = 0;
+    while (i < mid && j < n) tmp[k++] = vec[j] < vec[i] ? vec[j++] : vec[i++];
+    while (i < mid) tmp[k++] = vec[i++];
+    memcpy(vec, tmp, k * sizeof(int));
+}
+
+static void parallel_sort(void *arg) {
+    range_t *range = (range_t *)arg;
+    if (range->n < SORT_CUTOFF) {
+        quick_sort_with(range->vec, range->n, sizeof(int), int_compare);
+        return;
+    }
+    size_t mid = range->n / 2;
+    range_t left = { range->vec, range->tmp, mid };
+    range_t right = { range->vec + mid, range->tmp + mid, range->n - mid };
+    pool_task_t task = POOL_TASK(parallel_sort, &left);
+    pool_fork(&task);
+    parallel_sort(&right);
+    pool_join(&task);
+    merge(range->vec, range->tmp, mid, range->n);
+}
+
+static int *random_ints(size_t n, unsigned seed) {
+    srand(seed);
+    int *vec = (int *)malloc(n * sizeof(int));
+    for (size_t i = 0; i < n; i++) vec[i] = rand();
+    return vec;
+}
+
+static bool is_sorted(int *vec, size_t n) {
+    for (size_t i = 1; i < n; i++)
+        if (vec[i - 1] > vec[i]) return false;
+    return true;
+}
+
+bool test_pool_sort() {
+    pool_t *pool = pool_create(3);
+    size_t n = 200000;
+    int *vec = random_ints(n, 42), *tmp = (int *)malloc(n * sizeof(int));
+
+    range_t range = { vec, tmp, n };
+    pool_run(pool, parallel_sort, &range);
+    assert_eq(is_sorted(vec, n), true);
+
+    free(vec);
+    free(tmp);
+    pool_delete(pool);
+    return true;
+}
+
+typedef struct {
+    pool_t *pool;
+    int n;
+    bool ok;
+} caller_t;
+
+static void *caller(void *arg) {
+    caller_t *c = (caller_t *)arg;
+    c->ok = true;
+    for (int i = 0; i < 50; i++) {
+        fib_t f = { c->n };
+        pool_run(c->pool, fib, &f);
+        c->ok &= f.result == fib_seq(c->n);
+    }
+    return NULL;
+}
+
+// Many threads outside of the pool running tasks at once.
+bool test_pool_many_callers() {
+    pool_t *pool = pool_create(2);
+    caller_t callers[6];
+    pthread_t threads[6];
+    for (int i = 0; i < 6; i++) {
+        callers[i] = (caller_t){ pool, 10 + i };
+        pthread_create(&threads[i], NULL, caller, &callers[i]);
+    }
+    for (int i = 0; i < 6; i++) {
+        pthread_join(threads[i], NULL);
+        assert_eq(callers[i].ok, true);
+    }
+    pool_delete(pool);
+    return true;
+}
+
+/* Benchmarks */
+
+// The cost of a fork and join, with tasks too small to be worth it.
+void test_pool_fib_benchmark(int n) {
+    pool_t *pool = pool_create(0);
+
+    double start = now_ms();
+    long expected = fib_seq(n);
+    double seq_ms = now_ms() - start;
+
+    fib_t f = { n };
+    start = now_ms();
+    pool_run(pool, fib, &f);
+    double pool_ms = now_ms() - start;
+
+    if (f.result != expected) printf(YELLOW "Parallel fib(%d) is wrong" RESET "\n", n);
+    // fib(n) makes fib(n + 1) - 1 forks.
+    long forks = fib_seq(n + 1) - 1;
+    printf(CYAN "fib(%d) on %zu threads: sequential %.2lf ms, fork-join %.2lf ms (%.1lf ns per fork)" RESET "\n",
+           n, pool_get_threads(pool), seq_ms, pool_ms, pool_ms * 1e6 / forks);
+    pool_delete(pool);
+}
+
+void test_pool_sort_benchmark(size_t n) {
+    int *vec = random_ints(n, 7), *tmp = (int *)malloc(n * sizeof(int));
+
+    double start = now_ms();
+    quick_sort_with(vec, n, sizeof(int), int_compare);
+    double seq_ms = now_ms() - start;
+
+    size_t threads[] = { 1, 2, 4, 0 };
+    for (int t = 0; t < sizeof(threads) / sizeof(*threads); t++) {
+        pool_t *pool = pool_create(threads[t]);
+        free(vec);
+        vec = random_ints(n, 7);
+
+        range_t range = { vec, tmp, n };
+        start = now_ms();
+        pool_run(pool, parallel_sort, &range);
+        double pool_ms = now_ms() - start;
+
+        if (!is_sorted(vec, n)) printf(YELLOW "Parallel sort did not sort" RESET "\n");
+        printf(CYAN "Sorting %zu ints: quick_sort_with %.2lf ms, parallel merge sort on %zu threads %.2lf ms" RESET "\n",
+               n, seq_ms, pool_get_threads(pool), pool_ms);
+        pool_delete(pool);
+    }
+
+    free(vec);
+    free(tmp);
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_pool_fib());
+    test_fn(test_pool_outside());
+    test_fn(test_pool_sort());
+    test_fn(test_pool_many_callers());
+
+    test_pool_fib_benchmark(27);
+    test_pool_sort_benchmark(2000000);
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}
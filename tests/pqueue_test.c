@@ -0,0 +1,293 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <pqueue.h>
+#include <lltreap.h>
+
+static int int_compare(void *a, void *b) {
+    return *(int *)a < *(int *)b ? -1 : *(int *)a > *(int *)b;
+}
+
+bool test_pqueue() {
+    pqueue_t *queue = pqueue_create(sizeof(int), int_compare);
+    assert_eq(pqueue_peek(queue), NULL);
+    assert_eq(pqueue_pop(queue, NULL), false);
+
+    srand(42);
+    int n = 10000;
+    for (int i = 0; i < n; i++) {
+        int value = rand() % 1000;
+        pqueue_push(queue, &value);
+    }
+    assert_eq(pqueue_get_size(queue), n);
+
+    int value, last = -1;
+    for (int i = 0; i < n; i++) {
+        assert_eq(*(int *)pqueue_peek(queue), *(int *)pqueue_peek(queue));
+        int top = *(int *)pqueue_peek(queue);
+        assert_eq(pqueue_pop(queue, &value), true);
+        assert_eq(value, top);
+        assert_geq(value, last);
+        last = value;
+    }
+    assert_eq(pqueue_is_empty(queue), true);
+
+    pqueue_delete(queue);
+    return true;
+}
+
+bool test_pqueue_from_array() {
+    for (int n = 0; n < 50; n++) {
+        int *values = (int *)malloc((n + 1) * sizeof(int));
+        for (int i = 0; i < n; i++) values[i] = (i * 37) % 41;
+        pqueue_t *queue = pqueue_from_array(values, n, sizeof(int), int_compare);
+
+        // The handle of each element is its index in the array.
+        for (int i = 0; i < n; i++) assert_eq(*(int *)pqueue_get(queue, i), values[i]);
+
+        int value, last = -1;
+        for (int i = 0; i < n; i++) {
+            assert_eq(pqueue_pop(queue, &value), true);
+            assert_geq(value, last);
+            last = value;
+        }
+        assert_eq(pqueue_pop(queue, &value), false);
+
+        pqueue_delete(queue);
+        free(values);
+    }
+    return true;
+}
+
+bool test_pqueue_handles() {
+    pqueue_t *queue = pqueue_create(sizeof(int), int_compare);
+    pqueue_handle_t handles[100];
+    for (int i = 0; i < 100; i++) {
+        int value = 1000 + i;
+        handles[i] = pqueue_push(queue, &value);
+    }
+
+    // Decrease key: the element moves up to the top.
+    int value = 1;
+    pqueue_update(queue, handles[50], &value);
+    assert_eq(*(int *)pqueue_peek(queue), 1);
+    assert_eq(*(int *)pqueue_get(queue, handles[50]), 1);
+
+    // Increase key: it moves down.
+    value = 5000;
+    pqueue_update(queue, handles[0], &value);
+    assert_eq(*(int *)pqueue_get(queue, handles[0]), 5000);
+
+    pqueue_remove(queue, handles[10], &value);
+    assert_eq(value, 1010);
+    assert_eq(pqueue_contains(queue, handles[10]), false);
+    assert_eq(pqueue_contains(queue, handles[11]), true);
+
+    // Every element still follows its handle.
+    for (int i = 1; i < 100; i++) {
+        if (i == 10 || i == 50) continue;
+        assert_eq(*(int *)pqueue_get(queue, handles[i]), 1000 + i);
+    }
+
+    int expected[] = { 1, 1001, 1002 };
+    for (int i = 0; i < 3; i++) {
+        assert_eq(pqueue_pop(queue, &value), true);
+        assert_eq(value, expected[i]);
+    }
+
+    // Freed handles are given again.
+    value = 0;
+    pqueue_handle_t handle = pqueue_push(queue, &value);
+    assert_le(handle, 100);
+    assert_eq(pqueue_contains(queue, handle), true);
+    assert_eq(*(int *)pqueue_peek(queue), 0);
+
+    pqueue_delete(queue);
+    return true;
+}
+
+// Random operations checked against a plain array of the elements by handle.
+bool test_pqueue_random() {
+    srand(7);
+    pqueue_t *queue = pqueue_create(sizeof(int), int_compare);
+    size_t cap = 4096;
+    int *values = (int *)malloc(cap * sizeof(int));
+    bool *present = (bool *)calloc(cap, sizeof(bool));
+    size_t size = 0;
+
+    for (int op = 0; op < 200000; op++) {
+        int kind = rand() % 4, value = rand() % 100000;
+        if (kind <= 1 && size < 2000) {
+            pqueue_handle_t handle = pqueue_push(queue, &value);
+            assert_le(handle, cap);
+            assert_eq(present[handle], false);
+            values[handle] = value;
+            present[handle] = true;
+            size++;
+        } else if (kind == 2 && size > 0) {
+            int min = INT32_MAX;
+            for (size_t h = 0; h < cap; h++)
+                if (present[h] && values[h] < min) min = values[h];
+            int popped;
+            pqueue_pop(queue, &popped);
+            assert_eq(popped, min);
+            // Among equal elements any may come first, find one to forget.
+            for (size_t h = 0; h < cap; h++) {
+                if (present[h] && values[h] == min && !pqueue_contains(queue, h)) {
+                    present[h] = false;
+                    break;
+                }
+            }
+            size--;
+        } else if (size > 0) {
+            size_t h = rand() % cap;
+            while (!present[h]) h = (h + 1) % cap;
+            if (rand() % 2) {
+                pqueue_update(queue, h, &value);
+                values[h] = value;
+            } else {
+                int removed;
+                pqueue_remove(queue, h, &removed);
+                assert_eq(removed, values[h]);
+                present[h] = false;
+                size--;
+            }
+        }
+        assert_eq(pqueue_get_size(queue), size);
+    }
+
+    free(values);
+    free(present);
+    pqueue_delete(queue);
+    return true;
+}
+
+/* Benchmarks */
+
+// A timer for the scheduling benchmark. Ids keep the keys unique for the treap.
+typedef struct {
+    long deadline;
+    long id;
+} timer_t_;
+
+static int timer_compare(void *a, void *b) {
+    timer_t_ *x = (timer_t_ *)a, *y = (timer_t_ *)b;
+    if (x->deadline != y->deadline) return x->deadline < y->deadline ? -1 : 1;
+    return x->id < y->id ? -1 : x->id > y->id;
+}
+
+static void find_first(void *element, void *arg) {
+    timer_t_ *first = (timer_t_ *)arg;
+    if (first->id < 0) *first = *(timer_t_ *)element;
+}
+
+// A scheduler holding n timers: it runs the earliest one, which sets a new one
+// later, then postpones it (through its handle, or by removing and inserting
+// it again in the treap).
+void test_pqueue_scheduler_benchmark(size_t n, size_t steps, size_t treap_steps) {
+    srand(1);
+    timer_t_ *timers = (timer_t_ *)malloc(n * sizeof(timer_t_));
+    for (size_t i = 0; i < n; i++) timers[i] = (timer_t_){ rand() % 1000000, i };
+    unsigned seed = rand();
+
+    pqueue_t *queue = pqueue_from_array(timers, n, sizeof(timer_t_), timer_compare);
+    long checksum = 0, treap_checksum = 0, next_id = n;
+    timer_t_ timer;
+    srand(seed);
+    double start = now_ms();
+    for (size_t s = 0; s < steps; s++) {
+        pqueue_pop(queue, &timer);
+        if (s < treap_steps) checksum += timer.id;
+        timer = (timer_t_){ timer.deadline + rand() % 1000000, next_id++ };
+        pqueue_handle_t handle = pqueue_push(queue, &timer);
+        timer.deadline += 1000;
+        pqueue_update(queue, handle, &timer);
+    }
+    double pqueue_ms = now_ms() - start;
+    pqueue_delete(queue);
+
+    // The treap has no pop, the earliest timer is found with an in-order
+    // traversal, so it only runs a few steps.
+    lltreap_t *treap = lltreap_create(sizeof(timer_t_), timer_compare);
+    for (size_t i = 0; i < n; i++) lltreap_insert(treap, &timers[i]);
+    next_id = n;
+    srand(seed);
+    start = now_ms();
+    for (size_t s = 0; s < treap_steps; s++) {
+        timer_t_ first = { 0, -1 };
+        lltreap_inorder_foreach(treap, find_first, &first);
+        lltreap_remove(treap, &first, free);
+        treap_checksum += first.id;
+        timer = (timer_t_){ first.deadline + rand() % 1000000, next_id++ };
+        lltreap_insert(treap, &timer);
+        lltreap_remove(treap, &timer, free);
+        timer.deadline += 1000;
+        lltreap_insert(treap, &timer);
+    }
+    double treap_ms = now_ms() - start;
+    lltreap_delete(treap, free);
+
+    if (checksum != treap_checksum) printf(YELLOW "The treap ran timers in another order" RESET "\n");
+    printf(CYAN "Scheduler with %zu timers: pqueue %.3lf us per step (%zu steps), lltreap %.3lf us per step (%zu steps)" RESET "\n",
+           n, pqueue_ms * 1e3 / steps, steps, treap_ms * 1e3 / treap_steps, treap_steps);
+    free(timers);
+}
+
+// Sorted insertion then removal of the smallest, where the treap does not need
+// a traversal since the order of removal is known.
+void test_pqueue_push_pop_benchmark(size_t n) {
+    int *values = (int *)malloc(n * sizeof(int));
+    for (size_t i = 0; i < n; i++) values[i] = i;
+    srand(3);
+    for (size_t i = n - 1; i > 0; i--) {
+        size_t j = rand() % (i + 1);
+        int t = values[i];
+        values[i] = values[j];
+        values[j] = t;
+    }
+
+    double start = now_ms();
+    pqueue_t *queue = pqueue_create(sizeof(int), int_compare);
+    for (size_t i = 0; i < n; i++) pqueue_push(queue, &values[i]);
+    int value;
+    for (size_t i = 0; i < n; i++) pqueue_pop(queue, &value);
+    double pqueue_ms = now_ms() - start;
+    pqueue_delete(queue);
+
+    start = now_ms();
+    queue = pqueue_from_array(values, n, sizeof(int), int_compare);
+    double heapify_ms = now_ms() - start;
+    pqueue_delete(queue);
+
+    start = now_ms();
+    lltreap_t *treap = lltreap_create(sizeof(int), int_compare);
+    for (size_t i = 0; i < n; i++) lltreap_insert(treap, &values[i]);
+    for (int i = 0; i < n; i++) lltreap_remove(treap, &i, free);
+    double treap_ms = now_ms() - start;
+    lltreap_delete(treap, free);
+
+    printf(CYAN "%zu pushes then pops: pqueue %.2lf ms, lltreap %.2lf ms, pqueue_from_array %.2lf ms" RESET "\n",
+           n, pqueue_ms, treap_ms, heapify_ms);
+    free(values);
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_pqueue());
+    test_fn(test_pqueue_from_array());
+    test_fn(test_pqueue_handles());
+    test_fn(test_pqueue_random());
+
+    test_pqueue_scheduler_benchmark(100000, 1000000, 200);
+    test_pqueue_push_pop_benchmark(1000000);
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}
@@ -2,13 +2,16 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <time.h>
 
 #include "test_utils.h"
+#include <colors.h>
 #include <queue_bank.h>
 
 bool test_queue_bank_peak() {
     queue_t *queue = queue_create(sizeof(int));
     assert_neq(queue, NULL);
+    assert_eq(queue_peak(queue), NULL);
 
     for (int i = 0; i < 100; i++)
         queue_push(queue, &i);
@@ -37,6 +40,8 @@ bool test_queue_bank_pop() {
         assert_eq(*(int *)queue_pop(queue), i);
 
     assert_eq(queue_get_size(queue), 0);
+    assert_eq(queue_pop(queue), NULL);
+    assert_eq(queue_peak(queue), NULL);
 
     queue_delete(queue);
     return true;
@@ -83,6 +88,137 @@ bool test_queue_bank_create() {
     return true;
 }
 
+bool test_queue_bank_wrap() {
+    // Pops and pushes so that the elements wrap around the end of the buffer
+    // when it grows.
+    queue_t *queue = queue_create_with_cap(sizeof(int), 8);
+    int next_push = 0, next_pop = 0;
+    for (int round = 0; round < 200; round++) {
+        for (int i = 0; i < round % 7 + 3; i++, next_push++) queue_push(queue, &next_push);
+        for (int i = 0; i < round % 5 + 1 && !queue_is_empty(queue); i++, next_pop++) {
+            assert_eq(*(int *)queue_peak(queue), next_pop);
+            assert_eq(*(int *)queue_pop(queue), next_pop);
+        }
+        assert_eq(queue_get_size(queue), next_push - next_pop);
+    }
+    while (!queue_is_empty(queue)) assert_eq(*(int *)queue_pop(queue), next_pop++);
+    assert_eq(next_pop, next_push);
+
+    queue_delete(queue);
+    return true;
+}
+
+bool test_queue_bank_batch() {
+    queue_t *queue = queue_create(sizeof(int));
+    int in[1000], out[1000];
+    for (int i = 0; i < 1000; i++) in[i] = i;
+
+    // Batches that span several segments.
+    queue_push_n(queue, in, 10);
+    queue_push_n(queue, in + 10, 990);
+    assert_eq(queue_get_size(queue), 1000);
+    assert_eq(queue_pop_n(queue, out, 7), 7);
+    assert_eq(queue_pop_n(queue, out + 7, 500), 500);
+    assert_eq(*(int *)queue_pop(queue), 507);
+    assert_eq(queue_pop_n(queue, out + 508, 1000), 492);
+    for (int i = 0; i < 1000; i++) if (i != 507) assert_eq(out[i], i);
+    assert_eq(queue_is_empty(queue), true);
+    assert_eq(queue_pop_n(queue, out, 10), 0);
+
+    queue_delete(queue);
+    return true;
+}
+
+bool test_queue_bank_reserve() {
+    queue_t *queue = queue_create(sizeof(int));
+    int *first = NULL;
+    int *slots[100];
+
+    // Elements never move, whatever is pushed after them.
+    for (int i = 0; i < 100; i++) {
+        slots[i] = (int *)queue_reserve(queue, i + 1);
+        for (int j = 0; j <= i; j++) slots[i][j] = i;
+        if (!first) first = (int *)queue_peak(queue);
+    }
+    assert_eq(queue_get_size(queue), 100 * 101 / 2);
+    for (int i = 0; i < 100; i++)
+        for (int j = 0; j <= i; j++) assert_eq(slots[i][j], i);
+    assert_eq(first, slots[0]);
+
+    for (int i = 0; i < 100; i++) {
+        for (int j = 0; j <= i; j++) {
+            int *element = (int *)queue_pop(queue);
+            assert_eq(element, &slots[i][j]);
+            assert_eq(*element, i);
+        }
+    }
+
+    // A large reservation gets a segment of its own.
+    int *many = (int *)queue_reserve(queue, 100000);
+    for (int i = 0; i < 100000; i++) many[i] = i;
+    for (int i = 0; i < 100000; i++) assert_eq(*(int *)queue_pop(queue), i);
+
+    queue_delete(queue);
+    return true;
+}
+
+typedef struct {
+    long values[8];
+} big_t;
+
+void test_queue_bank_benchmark(size_t n) {
+    long sum = 0;
+
+    // Fills the queue, then empties it.
+    double start = now_ms();
+    queue_t *queue = queue_create(sizeof(long));
+    for (long i = 0; i < n; i++) queue_push(queue, &i);
+    while (!queue_is_empty(queue)) sum += *(long *)queue_pop(queue);
+    queue_delete(queue);
+    printf(CYAN "Pushing then popping %zu longs took %.2lf ms" RESET "\n", n, now_ms() - start);
+
+    // Same, 64 at a time.
+    long batch[64];
+    start = now_ms();
+    queue = queue_create(sizeof(long));
+    for (long i = 0; i < n; i += 64) {
+        for (long j = 0; j < 64; j++) batch[j] = i + j;
+        queue_push_n(queue, batch, 64);
+    }
+    for (size_t k; (k = queue_pop_n(queue, batch, 64)) > 0;)
+        for (size_t j = 0; j < k; j++) sum += batch[j];
+    queue_delete(queue);
+    printf(CYAN "Pushing then popping %zu longs in batches of 64 took %.2lf ms" RESET "\n", n, now_ms() - start);
+
+    // A steady stream through a queue that holds about 1000 elements.
+    start = now_ms();
+    queue = queue_create(sizeof(big_t));
+    big_t big = { { 0 } };
+    for (long i = 0; i < 1000; i++) queue_push(queue, &big);
+    for (long i = 0; i < n; i++) {
+        big.values[0] = i;
+        queue_push(queue, &big);
+        sum += ((big_t *)queue_pop(queue))->values[0];
+    }
+    queue_delete(queue);
+    printf(CYAN "Streaming %zu elements of 64 bytes took %.2lf ms" RESET "\n", n, now_ms() - start);
+
+    // Breadth first order, each element pops one and pushes two until n.
+    start = now_ms();
+    queue = queue_create(sizeof(long));
+    long pushed = 1, first = 0;
+    queue_push(queue, &first);
+    while (!queue_is_empty(queue)) {
+        long curr = *(long *)queue_pop(queue);
+        sum += curr;
+        for (int c = 0; c < 2 && pushed < n; c++, pushed++) queue_push(queue, &pushed);
+    }
+    queue_delete(queue);
+    printf(CYAN "Breadth first walk of %zu elements took %.2lf ms" RESET "\n", n, now_ms() - start);
+
+    if (sum == 42) printf("\n");
+}
+
 int main(void) {
     TEST_SETUP();
 
@@ -90,6 +226,11 @@ int main(void) {
     test_fn(test_queue_bank_push());
     test_fn(test_queue_bank_pop());
     test_fn(test_queue_bank_peak());
+    test_fn(test_queue_bank_wrap());
+    test_fn(test_queue_bank_batch());
+    test_fn(test_queue_bank_reserve());
+
+    test_queue_bank_benchmark(10000000);
 
     TEST_TEARDOWN();
     return EXIT_SUCCESS;
@@ -0,0 +1,351 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <queue_bank.h>
+#include <ring.h>
+
+typedef struct {
+    uint32_t producer;
+    uint32_t seq;
+    uint64_t payload;
+} item_t;
+
+bool test_spsc() {
+    spsc_t *ring = spsc_create(sizeof(item_t), 100);
+    assert_eq(spsc_get_cap(ring), 128);
+    assert_eq(spsc_get_size(ring), 0);
+
+    item_t item;
+    assert_eq(spsc_pop(ring, &item), false);
+
+    // Several laps, so positions wrap around the slots.
+    for (uint32_t lap = 0; lap < 5; lap++) {
+        for (uint32_t i = 0; i < 128; i++) {
+            item = (item_t){ 0, lap * 128 + i, i * 3 };
+            assert_eq(spsc_push(ring, &item), true);
+        }
+        assert_eq(spsc_push(ring, &item), false);
+        assert_eq(spsc_get_size(ring), 128);
+
+        for (uint32_t i = 0; i < 128; i++) {
+            assert_eq(spsc_pop(ring, &item), true);
+            assert_eq(item.seq, lap * 128 + i);
+            assert_eq(item.payload, i * 3);
+        }
+        assert_eq(spsc_pop(ring, &item), false);
+    }
+
+    spsc_delete(ring);
+    return true;
+}
+
+bool test_spsc_batch() {
+    spsc_t *ring = spsc_create(sizeof(int), 16);
+    int in[40], out[40];
+    for (int i = 0; i < 40; i++) in[i] = i;
+
+    // Only as many as there is room for are pushed.
+    assert_eq(spsc_push_n(ring, in, 40), 16);
+    assert_eq(spsc_pop_n(ring, out, 10), 10);
+    for (int i = 0; i < 10; i++) assert_eq(out[i], i);
+
+    // This batch wraps around the end of the slots.
+    assert_eq(spsc_push_n(ring, in + 16, 24), 10);
+    assert_eq(spsc_pop_n(ring, out, 40), 16);
+    for (int i = 0; i < 16; i++) assert_eq(out[i], i + 10);
+    assert_eq(spsc_pop_n(ring, out, 40), 0);
+
+    spsc_delete(ring);
+    return true;
+}
+
+bool test_mpmc() {
+    mpmc_t *ring = mpmc_create(sizeof(item_t), 1);
+    assert_eq(mpmc_get_cap(ring), 2);
+    mpmc_delete(ring);
+
+    ring = mpmc_create(sizeof(item_t), 64);
+    item_t item;
+    assert_eq(mpmc_pop(ring, &item), false);
+
+    for (uint32_t lap = 0; lap < 5; lap++) {
+        for (uint32_t i = 0; i < 64; i++) {
+            item = (item_t){ 0, lap * 64 + i, i };
+            assert_eq(mpmc_push(ring, &item), true);
+        }
+        assert_eq(mpmc_push(ring, &item), false);
+        assert_eq(mpmc_get_size(ring), 64);
+        for (uint32_t i = 0; i < 64; i++) {
+            assert_eq(mpmc_pop(ring, &item), true);
+            assert_eq(item.seq, lap * 64 + i);
+        }
+        assert_eq(mpmc_pop(ring, &item), false);
+    }
+
+    int in[100], out[100];
+    for (int i = 0; i < 100; i++) in[i] = i;
+    mpmc_t *ints = mpmc_create(sizeof(int), 64);
+    assert_eq(mpmc_push_n(ints, in, 100), 64);
+    assert_eq(mpmc_pop_n(ints, out, 30), 30);
+    assert_eq(mpmc_push_n(ints, in + 64, 36), 30);
+    assert_eq(mpmc_pop_n(ints, out + 30, 100), 64);
+    for (int i = 0; i < 94; i++) assert_eq(out[i], i);
+
+    mpmc_delete(ints);
+    mpmc_delete(ring);
+    return true;
+}
+
+/* Cross-thread tests and benchmarks */
+
+#define BATCH 32
+
+typedef enum { SPSC, SPSC_BATCH, MPMC, MPMC_BATCH, LOCKED_QUEUE } kind_t;
+
+static char *kind_names[] = { "spsc", "spsc batch", "mpmc", "mpmc batch", "mutex + queue_bank" };
+
+// The baseline: a queue_bank queue behind a mutex, bounded like the rings.
+typedef struct {
+    pthread_mutex_t lock;
+    queue_t *queue;
+    size_t cap;
+} locked_queue_t;
+
+typedef struct {
+    kind_t kind;
+    void *ring;
+    uint32_t id;
+    size_t n;           // Items pushed by each producer.
+    size_t n_producers;
+    size_t *consumed;   // Shared count of items popped.
+    size_t total;
+    uint32_t *last_seq; // Last seq seen per producer, for this consumer.
+    bool failed;
+} worker_t;
+
+static size_t push_some(kind_t kind, void *ring, item_t *items, size_t n) {
+    switch (kind) {
+    case SPSC: return spsc_push(ring, items);
+    case SPSC_BATCH: return spsc_push_n(ring, items, n);
+    case MPMC: return mpmc_push(ring, items);
+    case MPMC_BATCH: return mpmc_push_n(ring, items, n);
+    case LOCKED_QUEUE: {
+        locked_queue_t *q = (locked_queue_t *)ring;
+        pthread_mutex_lock(&q->lock);
+        bool room = queue_get_size(q->queue) < q->cap;
+        if (room) queue_push(q->queue, items);
+        pthread_mutex_unlock(&q->lock);
+        return room;
+    }
+    }
+    return 0;
+}
+
+static size_t pop_some(kind_t kind, void *ring, item_t *items, size_t n) {
+    switch (kind) {
+    case SPSC: return spsc_pop(ring, items);
+    case SPSC_BATCH: return spsc_pop_n(ring, items, n);
+    case MPMC: return mpmc_pop(ring, items);
+    case MPMC_BATCH: return mpmc_pop_n(ring, items, n);
+    case LOCKED_QUEUE: {
+        locked_queue_t *q = (locked_queue_t *)ring;
+        pthread_mutex_lock(&q->lock);
+        bool some = !queue_is_empty(q->queue);
+        if (some) *items = *(item_t *)queue_pop(q->queue);
+        pthread_mutex_unlock(&q->lock);
+        return some;
+    }
+    }
+    return 0;
+}
+
+static void *producer(void *arg) {
+    worker_t *w = (worker_t *)arg;
+    item_t items[BATCH];
+    for (size_t i = 0; i < w->n;) {
+        size_t k = w->n - i < BATCH ? w->n - i : BATCH;
+        for (size_t j = 0; j < k; j++) items[j] = (item_t){ w->id, (uint32_t)(i + j), i + j };
+
+        size_t pushed = push_some(w->kind, w->ring, items, k);
+        // The whole batch is retried from the first item that didn't fit.
+        i += pushed;
+        if (pushed == 0) sched_yield();
+    }
+    return NULL;
+}
+
+// Pops until every item of every producer was consumed, checking that items
+// of each producer come in order.
+static void *consumer(void *arg) {
+    worker_t *w = (worker_t *)arg;
+    item_t items[BATCH];
+    size_t goal = w->n * w->n_producers;
+    for (;;) {
+        if (__atomic_load_n(w->consumed, __ATOMIC_RELAXED) == goal) break;
+
+        size_t popped = pop_some(w->kind, w->ring, items, BATCH);
+        if (popped == 0) {
+            sched_yield();
+            continue;
+        }
+        for (size_t j = 0; j < popped; j++) {
+            item_t *item = &items[j];
+            if (item->producer >= w->n_producers || item->payload != item->seq ||
+                (w->last_seq[item->producer] != UINT32_MAX && item->seq <= w->last_seq[item->producer]))
+                w->failed = true;
+            w->last_seq[item->producer] = item->seq;
+            w->total += item->payload;
+        }
+        __atomic_fetch_add(w->consumed, popped, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+// Runs producers and consumers over a ring, returns false if an item was lost,
+// duplicated or reordered. Sets `ms` to the time it took.
+static bool run_threads(kind_t kind, size_t n_producers, size_t n_consumers, size_t n, double *ms) {
+    void *ring = NULL;
+    locked_queue_t locked;
+    switch (kind) {
+    case SPSC: case SPSC_BATCH: ring = spsc_create(sizeof(item_t), 1024); break;
+    case MPMC: case MPMC_BATCH: ring = mpmc_create(sizeof(item_t), 1024); break;
+    case LOCKED_QUEUE:
+        pthread_mutex_init(&locked.lock, NULL);
+        locked.queue = queue_create_with_cap(sizeof(item_t), 1024);
+        locked.cap = 1024;
+        ring = &locked;
+        break;
+    }
+
+    size_t consumed = 0;
+
+    size_t n_workers = n_producers + n_consumers;
+    worker_t *workers = (worker_t *)calloc(n_workers, sizeof(worker_t));
+    pthread_t *threads = (pthread_t *)malloc(n_workers * sizeof(pthread_t));
+
+    double start = now_ms();
+    for (size_t i = 0; i < n_workers; i++) {
+        workers[i] = (worker_t){ kind, ring, (uint32_t)i, n, n_producers, &consumed };
+        if (i < n_producers) {
+            pthread_create(&threads[i], NULL, producer, &workers[i]);
+        } else {
+            workers[i].last_seq = (uint32_t *)malloc(n_producers * sizeof(uint32_t));
+            memset(workers[i].last_seq, 0xff, n_producers * sizeof(uint32_t));
+            pthread_create(&threads[i], NULL, consumer, &workers[i]);
+        }
+    }
+    for (size_t i = 0; i < n_workers; i++) pthread_join(threads[i], NULL);
+    *ms = now_ms() - start;
+
+    // Every producer pushed 0 + 1 + ... + n - 1.
+    size_t total = 0;
+    bool ok = true;
+    for (size_t i = n_producers; i < n_workers; i++) {
+        total += workers[i].total;
+        ok = ok && !workers[i].failed;
+        free(workers[i].last_seq);
+    }
+    ok = ok && total == n_producers * (n * (n - 1) / 2);
+
+    switch (kind) {
+    case SPSC: case SPSC_BATCH: spsc_delete(ring); break;
+    case MPMC: case MPMC_BATCH: mpmc_delete(ring); break;
+    case LOCKED_QUEUE:
+        queue_delete(locked.queue);
+        pthread_mutex_destroy(&locked.lock);
+        break;
+    }
+    free(workers);
+    free(threads);
+    return ok;
+}
+
+bool test_spsc_threads() {
+    double ms;
+    assert_eq(run_threads(SPSC, 1, 1, 100000, &ms), true);
+    assert_eq(run_threads(SPSC_BATCH, 1, 1, 100000, &ms), true);
+    return true;
+}
+
+bool test_mpmc_threads() {
+    double ms;
+    assert_eq(run_threads(MPMC, 4, 4, 20000, &ms), true);
+    assert_eq(run_threads(MPMC_BATCH, 4, 4, 20000, &ms), true);
+    assert_eq(run_threads(MPMC_BATCH, 1, 3, 50000, &ms), true);
+    return true;
+}
+
+// Throughput of each ring between threads.
+void test_ring_throughput_benchmark(size_t n) {
+    struct { kind_t kind; size_t producers, consumers; } runs[] = {
+        { SPSC, 1, 1 }, { SPSC_BATCH, 1, 1 }, { MPMC, 1, 1 }, { MPMC_BATCH, 1, 1 },
+        { LOCKED_QUEUE, 1, 1 }, { MPMC, 2, 2 }, { MPMC_BATCH, 2, 2 }, { LOCKED_QUEUE, 2, 2 },
+    };
+    for (int r = 0; r < sizeof(runs) / sizeof(*runs); r++) {
+        double ms;
+        size_t per_producer = n / runs[r].producers;
+        run_threads(runs[r].kind, runs[r].producers, runs[r].consumers, per_producer, &ms);
+        printf(CYAN "%s, %zu producers / %zu consumers: %zu items in %.2lf ms (%.2lf Mitems/s)" RESET "\n",
+               kind_names[runs[r].kind], runs[r].producers, runs[r].consumers,
+               per_producer * runs[r].producers, ms, per_producer * runs[r].producers / ms / 1e3);
+    }
+}
+
+typedef struct {
+    spsc_t *ping, *pong;
+    size_t rounds;
+} ping_pong_t;
+
+static void *echo(void *arg) {
+    ping_pong_t *p = (ping_pong_t *)arg;
+    uint64_t value;
+    for (size_t i = 0; i < p->rounds; i++) {
+        while (!spsc_pop(p->ping, &value)) sched_yield();
+        while (!spsc_push(p->pong, &value)) sched_yield();
+    }
+    return NULL;
+}
+
+// Round trip latency: an element is sent to another thread that sends it back.
+void test_ring_latency_benchmark(size_t rounds) {
+    ping_pong_t p = { spsc_create(sizeof(uint64_t), 16), spsc_create(sizeof(uint64_t), 16), rounds };
+    pthread_t thread;
+    pthread_create(&thread, NULL, echo, &p);
+
+    double start = now_ms();
+    for (uint64_t i = 0; i < rounds; i++) {
+        uint64_t value;
+        while (!spsc_push(p.ping, &i)) sched_yield();
+        while (!spsc_pop(p.pong, &value)) sched_yield();
+    }
+    double ms = now_ms() - start;
+    pthread_join(thread, NULL);
+
+    printf(CYAN "spsc ping-pong: %zu round trips, %.2lf us each" RESET "\n", rounds, ms * 1e3 / rounds);
+    spsc_delete(p.ping);
+    spsc_delete(p.pong);
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_spsc());
+    test_fn(test_spsc_batch());
+    test_fn(test_mpmc());
+    test_fn(test_spsc_threads());
+    test_fn(test_mpmc_threads());
+
+    test_ring_throughput_benchmark(2000000);
+    test_ring_latency_benchmark(100000);
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}
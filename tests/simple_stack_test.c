@@ -1,9 +1,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <assert.h>
+#include <time.h>
 #include <tests.h>
 #include <simple_stack.h>
+#include <inline_stack.h>
 
 #define WITH_STACK(func) ({ \
     stack_t *__stack = stack_create(); \
@@ -41,6 +44,91 @@ void fifo(stack_t *s) {
     }
 }
 
+// Iterative depth first search of a complete binary tree whose nodes are
+// numbered like a heap, with a new stack for every search.
+size_t dfs_simple_stack(int depth) {
+    stack_t *stack = stack_create();
+    size_t visited = 0, leaves = (size_t)1 << depth;
+    stack_push(stack, (void *)(uintptr_t)1);
+    while (!stack_is_empty(stack)) {
+        size_t node = (uintptr_t)stack_pop(stack);
+        visited++;
+        if (node >= leaves) continue;
+        stack_push(stack, (void *)(uintptr_t)(2 * node + 1));
+        stack_push(stack, (void *)(uintptr_t)(2 * node));
+    }
+    stack_destroy(stack, free);
+    return visited;
+}
+
+size_t dfs_istack(int depth) {
+    istack_t stack;
+    istack_init(&stack, sizeof(size_t));
+    size_t node = 1, visited = 0, leaves = (size_t)1 << depth;
+    istack_push(&stack, &node);
+    while (istack_pop(&stack, &node)) {
+        visited++;
+        if (node >= leaves) continue;
+        size_t left = 2 * node, right = 2 * node + 1;
+        istack_push(&stack, &right);
+        istack_push(&stack, &left);
+    }
+    istack_destroy(&stack);
+    return visited;
+}
+
+void dfs_benchmark(int nodes) {
+    int depths[] = { 4, 8, 16 };
+    for (int d = 0; d < sizeof(depths) / sizeof(*depths); d++) {
+        int n = nodes >> depths[d];
+        size_t visited = 0;
+        clock_t start = clock();
+        for (int i = 0; i < n; i++) visited += dfs_simple_stack(depths[d]);
+        double simple_ms = (clock() - start) * 1e3 / CLOCKS_PER_SEC;
+
+        start = clock();
+        for (int i = 0; i < n; i++) visited -= dfs_istack(depths[d]);
+        double istack_ms = (clock() - start) * 1e3 / CLOCKS_PER_SEC;
+
+        assert(visited == 0);
+        printf(CYAN "%d searches of depth %d: simple_stack %.2lf ms, istack %.2lf ms" RESET "\n",
+               n, depths[d], simple_ms, istack_ms);
+    }
+}
+
+// Pushes and pops around a power of two, where a stack that shrinks as soon as
+// it is half empty reallocates every time.
+void boundary_benchmark(int rounds) {
+    stack_t *stack = stack_create();
+    for (int i = 0; i < 63; i++) stack_push(stack, NULL);
+    clock_t start = clock();
+    for (int i = 0; i < rounds; i++) {
+        stack_push(stack, NULL);
+        stack_push(stack, NULL);
+        stack_pop(stack);
+        stack_pop(stack);
+    }
+    double simple_ms = (clock() - start) * 1e3 / CLOCKS_PER_SEC;
+    while (!stack_is_empty(stack)) stack_pop(stack);
+    stack_destroy(stack, free);
+
+    istack_t istack;
+    istack_init(&istack, sizeof(void *));
+    void *element = NULL;
+    for (int i = 0; i < 63; i++) istack_push(&istack, &element);
+    start = clock();
+    for (int i = 0; i < rounds; i++) {
+        istack_push(&istack, &element);
+        istack_push(&istack, &element);
+        istack_pop(&istack, NULL);
+        istack_pop(&istack, NULL);
+    }
+    double istack_ms = (clock() - start) * 1e3 / CLOCKS_PER_SEC;
+    istack_destroy(&istack);
+
+    printf(CYAN "%d rounds of 2 pushes and 2 pops around 64 elements: simple_stack %.2lf ms, istack %.2lf ms" RESET "\n",
+           rounds, simple_ms, istack_ms);
+}
 
 int main() {
     TEST_SETUP();
@@ -49,6 +137,9 @@ int main() {
     NAMED_TEST("insert_and_remove", WITH_STACK(insert_and_remove));
     NAMED_TEST("fifo", WITH_STACK(fifo));
 
+    dfs_benchmark(1 << 22);
+    boundary_benchmark(1000000);
+
     TEST_TEARDOWN();
 
     return EXIT_SUCCESS;
@@ -3,8 +3,10 @@
 #include <stdbool.h>
 #include <string.h>
 #include <limits.h>
+#include <time.h>
 
 #include "test_utils.h"
+#include <colors.h>
 #include <sorting.h>
 
 int int_compare(void *a, void *b) {
@@ -136,6 +138,128 @@ bool test_quick_sort() {
     return true;
 }
 
+// The inputs that make naive quick sorts quadratic or deep.
+enum pattern { RANDOM, SORTED, REVERSED, EQUAL, FEW_UNIQUE, ORGAN_PIPE, SAWTOOTH, SORTED_TAIL, NPATTERNS };
+static const char *pattern_names[] = {
+    "random", "sorted", "reversed", "all equal", "4 unique", "organ pipe", "sawtooth", "sorted + 1%"
+};
+
+int *create_pattern(int n, enum pattern pattern) {
+    int *arr = (int *)malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        switch (pattern) {
+        case RANDOM: arr[i] = rand(); break;
+        case SORTED: arr[i] = i; break;
+        case REVERSED: arr[i] = n - i; break;
+        case EQUAL: arr[i] = 42; break;
+        case FEW_UNIQUE: arr[i] = rand() % 4; break;
+        case ORGAN_PIPE: arr[i] = i < n / 2 ? i : n - i; break;
+        case SAWTOOTH: arr[i] = i % 1000; break;
+        default: arr[i] = i < n - n / 100 ? i : rand() % n; break;
+        }
+    }
+    return arr;
+}
+
+int qsort_compare(const void *a, const void *b) {
+    return *(int *)a - *(int *)b;
+}
+
+bool test_quick_sort_patterns() {
+    srand(42);
+    int sizes[] = { 0, 1, 2, 3, 23, 24, 25, 128, 129, 1000, 50000 };
+    for (int p = 0; p < NPATTERNS; p++) {
+        for (int k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+            int n = sizes[k];
+            int *vec = create_pattern(n, p);
+            int *expected = (int *)malloc((n + 1) * sizeof(int));
+            memcpy(expected, vec, n * sizeof(int));
+            qsort(expected, n, sizeof(int), qsort_compare);
+
+            quick_sort_with(vec, n, sizeof(int), int_compare);
+            assert_eq(memcmp(vec, expected, n * sizeof(int)), 0);
+
+            free(vec);
+            free(expected);
+        }
+    }
+    return true;
+}
+
+typedef struct {
+    int key;
+    char payload[20];
+} wide_t;
+
+int wide_compare(void *a, void *b) {
+    return ((wide_t *)a)->key - ((wide_t *)b)->key;
+}
+
+// Elements larger than a word, with many equal keys.
+bool test_quick_sort_wide() {
+    srand(42);
+    int n = 10000;
+    wide_t *vec = (wide_t *)malloc(n * sizeof(wide_t));
+    for (int i = 0; i < n; i++) {
+        vec[i].key = rand() % 100;
+        sprintf(vec[i].payload, "%d", vec[i].key);
+    }
+
+    quick_sort_with(vec, n, sizeof(wide_t), wide_compare);
+    for (int i = 0; i < n; i++) {
+        if (i > 0) assert_leq(vec[i - 1].key, vec[i].key);
+        assert_eq(atoi(vec[i].payload), vec[i].key);
+    }
+
+    free(vec);
+    return true;
+}
+
+typedef void (*sort_fn_t)(void *, size_t, size_t, comp_t);
+typedef void (*sort_buffer_fn_t)(void *, size_t, size_t, comp_t, void *);
+
+// The stable sorts keep elements with equal keys in their order, the payload
+// holding the original index.
+bool test_stable_sorts() {
+    sort_fn_t sorts[] = { merge_sort_with, tim_sort_with };
+    sort_buffer_fn_t buffer_sorts[] = { merge_sort_with_buffer, tim_sort_with_buffer };
+    int sizes[] = { 0, 1, 2, 16, 17, 63, 64, 65, 1000, 20000 };
+
+    for (int s = 0; s < 4; s++) {
+        for (int p = 0; p < NPATTERNS; p++) {
+            for (int k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+                srand(42);
+                int n = sizes[k];
+                int *keys = create_pattern(n, p);
+                wide_t *vec = (wide_t *)malloc((n + 1) * sizeof(wide_t));
+                for (int i = 0; i < n; i++) {
+                    vec[i].key = keys[i] % 50;
+                    sprintf(vec[i].payload, "%d", i);
+                }
+
+                if (s < 2) {
+                    sorts[s](vec, n, sizeof(wide_t), wide_compare);
+                } else {
+                    // Exactly the documented size, so ASan sees any overflow.
+                    void *buffer = malloc((n / 2) * sizeof(wide_t));
+                    buffer_sorts[s - 2](vec, n, sizeof(wide_t), wide_compare, buffer);
+                    free(buffer);
+                }
+
+                for (int i = 1; i < n; i++) {
+                    assert_leq(vec[i - 1].key, vec[i].key);
+                    if (vec[i - 1].key == vec[i].key)
+                        assert_le(atoi(vec[i - 1].payload), atoi(vec[i].payload));
+                }
+
+                free(keys);
+                free(vec);
+            }
+        }
+    }
+    return true;
+}
+
 bool test_heap_sort() {
     srand(42);
     int n = 1000;
@@ -158,18 +282,83 @@ bool test_insertion_sort() {
     return true;
 }
 
+static size_t ncomparisons;
+
+int counting_compare(void *a, void *b) {
+    ncomparisons++;
+    return *(int *)a - *(int *)b;
+}
+
+// Time and comparisons per element of each sort on each pattern.
+void bench_sort_patterns(int n) {
+    sort_fn_t sorts[] = { quick_sort_with, heap_sort_with, tim_sort_with, merge_sort_with };
+    const char *names[] = { "quick", "heap", "tim", "merge" };
+    for (int p = 0; p < NPATTERNS; p++) {
+        srand(7);
+        int *vec = create_pattern(n, p);
+        int *to_sort = (int *)malloc(n * sizeof(int));
+        printf(CYAN "%-12s", pattern_names[p]);
+        for (int s = 0; s < 4; s++) {
+            memcpy(to_sort, vec, n * sizeof(int));
+            ncomparisons = 0;
+            double start = now_ms();
+            sorts[s](to_sort, n, sizeof(int), counting_compare);
+            printf(" %s %7.2lf ms %5.1lf cmp/el%s", names[s], now_ms() - start,
+                   (double)ncomparisons / n, s < 3 ? "," : "");
+        }
+        printf(RESET "\n");
+        free(vec);
+        free(to_sort);
+    }
+}
+
+// Sorting many small arrays, where merge_sort_with and tim_sort_with allocate a
+// buffer each time and the _with_buffer variants reuse one.
+void bench_sort_buffer(int narrays, int n) {
+    srand(7);
+    int *vecs = create_arr(narrays * n);
+    int *to_sort = (int *)malloc(narrays * n * sizeof(int));
+    void *buffer = malloc((n / 2) * sizeof(int));
+    sort_fn_t sorts[] = { merge_sort_with, tim_sort_with };
+    sort_buffer_fn_t buffer_sorts[] = { merge_sort_with_buffer, tim_sort_with_buffer };
+    const char *names[] = { "merge", "tim" };
+
+    for (int s = 0; s < 2; s++) {
+        memcpy(to_sort, vecs, narrays * n * sizeof(int));
+        double start = now_ms();
+        for (int i = 0; i < narrays; i++) sorts[s](to_sort + i * n, n, sizeof(int), int_compare);
+        double ms = now_ms() - start;
+
+        memcpy(to_sort, vecs, narrays * n * sizeof(int));
+        start = now_ms();
+        for (int i = 0; i < narrays; i++)
+            buffer_sorts[s](to_sort + i * n, n, sizeof(int), int_compare, buffer);
+        double buffer_ms = now_ms() - start;
+
+        printf(CYAN "%d sorts of %d ints: %s_sort_with %.2lf ms, %s_sort_with_buffer %.2lf ms" RESET "\n",
+               narrays, n, names[s], ms, names[s], buffer_ms);
+    }
+
+    free(vecs);
+    free(to_sort);
+    free(buffer);
+}
+
 int main(void) {
     TEST_SETUP();
 
     test_fn(test_insertion_sort());
     test_fn(test_heap_sort());
     test_fn(test_quick_sort());
+    test_fn(test_quick_sort_patterns());
+    test_fn(test_quick_sort_wide());
     test_fn(test_merge_sort());
     test_fn(test_radix_sort());
     test_fn(test_lower_bound());
     test_fn(test_upper_bound());
     test_fn(test_binary_insertion_sort());
     test_fn(test_tim_sort());
+    test_fn(test_stable_sorts());
 
     int n = 100000;
     int *vec = create_arr(n);
@@ -184,6 +373,10 @@ int main(void) {
     free(vec);
     free(to_sort);
 
+    printf(CYAN "%d elements:" RESET "\n", n);
+    bench_sort_patterns(n);
+    bench_sort_buffer(2000, 1000);
+
     TEST_TEARDOWN();
     return EXIT_SUCCESS;
 }
@@ -105,4 +105,26 @@ void test_teardown() {
     /* Nothing yet, but something could be placed here */
 }
 
+// Wall clock time in milliseconds, to time benchmarks.
+double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// Makes the keys "<prefix>0", "<prefix>1", ... "<prefix>{n - 1}".
+char **mk_keys(char *prefix, size_t n) {
+    char **keys = (char **)malloc((n ? n : 1) * sizeof(char *));
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = (char *)malloc(32);
+        sprintf(keys[i], "%s%zu", prefix, i);
+    }
+    return keys;
+}
+
+void free_keys(char **keys, size_t n) {
+    for (size_t i = 0; i < n; i++) free(keys[i]);
+    free(keys);
+}
+
 #endif
@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <typed_avl.h>
+#include <avl.h>
+
+typedef struct {
+    int key;
+    char name[12];
+} record_t;
+
+#define int_cmp(a, b) TYPED_CMP(a, b)
+#define record_cmp(a, b) TYPED_CMP((a)->key, (b)->key)
+
+DEFINE_AVL(int_avl, int, int_cmp)
+DEFINE_AVL(record_avl, record_t *, record_cmp)
+
+// Checks the AVL invariants, returns the height or -1.
+static int check_node(int_avl_node_t *node, int *last, bool *ordered) {
+    if (!node) return 0;
+    int l = check_node(node->left, last, ordered);
+    if (*last >= node->value) *ordered = false;
+    *last = node->value;
+    int r = check_node(node->right, last, ordered);
+    if (l < 0 || r < 0 || l - r > 1 || r - l > 1) return -1;
+    int height = (l > r ? l : r) + 1;
+    return node->height == height ? height : -1;
+}
+
+static bool is_avl(int_avl_t *avl) {
+    int last = -1;
+    bool ordered = true;
+    return check_node(avl->root, &last, &ordered) >= 0 && ordered;
+}
+
+bool test_typed_avl() {
+    int_avl_t *avl = int_avl_create();
+    assert_eq(int_avl_min(avl), NULL);
+
+    srand(42);
+    int n = 5000;
+    bool *present = (bool *)calloc(2 * n, sizeof(bool));
+    size_t size = 0;
+    for (int i = 0; i < n; i++) {
+        int value = rand() % (2 * n);
+        assert_eq(int_avl_insert(avl, value), !present[value]);
+        size += !present[value];
+        present[value] = true;
+    }
+    assert_eq(int_avl_get_size(avl), size);
+    assert_eq(is_avl(avl), true);
+
+    for (int i = 0; i < 2 * n; i++) {
+        int *found = int_avl_search(avl, i);
+        bool is_found = found != NULL;
+        assert_eq(is_found, present[i]);
+        if (found) assert_eq(*found, i);
+    }
+
+    // Removes half of the values, checking the tree along the way.
+    for (int i = 0; i < 2 * n; i += 2) {
+        int removed = -1;
+        assert_eq(int_avl_remove(avl, i, &removed), present[i]);
+        if (present[i]) assert_eq(removed, i);
+        size -= present[i];
+        present[i] = false;
+        if (i % 500 == 0) assert_eq(is_avl(avl), true);
+    }
+    assert_eq(int_avl_get_size(avl), size);
+    assert_eq(is_avl(avl), true);
+    for (int i = 0; i < 2 * n; i++) {
+        bool is_found = int_avl_search(avl, i) != NULL;
+        assert_eq(is_found, present[i]);
+    }
+
+    int min = 0, max = 2 * n - 1;
+    while (!present[min]) min++;
+    while (!present[max]) max--;
+    assert_eq(*int_avl_min(avl), min);
+    assert_eq(*int_avl_max(avl), max);
+
+    int_avl_clear(avl);
+    assert_eq(int_avl_get_size(avl), 0);
+    assert_eq(int_avl_search(avl, min), NULL);
+
+    int_avl_delete(avl);
+    free(present);
+    return true;
+}
+
+static void collect(record_t **record, void *arg) {
+    int **keys = (int **)arg;
+    *(*keys)++ = (*record)->key;
+}
+
+bool test_typed_avl_pointers() {
+    record_avl_t avl;
+    record_avl_init(&avl);
+    record_t records[100];
+    for (int i = 0; i < 100; i++) {
+        records[i].key = (i * 37) % 100;
+        sprintf(records[i].name, "record%d", records[i].key);
+        record_avl_insert(&avl, &records[i]);
+    }
+
+    // Searching goes through what the pointers point to.
+    record_t probe = { 42 };
+    record_t **found = record_avl_search(&avl, &probe);
+    assert_neq(found, NULL);
+    assert_eq(strcmp((*found)->name, "record42"), 0);
+
+    int keys[100], *next = keys;
+    record_avl_inorder_foreach(&avl, collect, &next);
+    for (int i = 0; i < 100; i++) assert_eq(keys[i], i);
+
+    record_t *removed;
+    assert_eq(record_avl_remove(&avl, &probe, &removed), true);
+    assert_eq(removed->key, 42);
+    assert_eq(record_avl_search(&avl, &probe), NULL);
+
+    record_avl_clear(&avl);
+    return true;
+}
+
+/* Benchmarks */
+
+static int int_compare(void *a, void *b) {
+    return *(int *)a < *(int *)b ? -1 : *(int *)a > *(int *)b;
+}
+
+static int record_compare(void *a, void *b) {
+    int x = (*(record_t **)a)->key, y = (*(record_t **)b)->key;
+    return x < y ? -1 : x > y;
+}
+
+static void print_times(char *what, size_t n, double *generic, double *typed) {
+    printf(CYAN "%s, %zu elements: insert %.2lf / %.2lf ms, search %.2lf / %.2lf ms, remove %.2lf / %.2lf ms "
+           "(avl_t / typed, %.1lfx faster overall)" RESET "\n",
+           what, n, generic[0], typed[0], generic[1], typed[1], generic[2], typed[2],
+           (generic[0] + generic[1] + generic[2]) / (typed[0] + typed[1] + typed[2]));
+}
+
+void test_typed_avl_benchmark(size_t n) {
+    int *keys = (int *)malloc(n * sizeof(int));
+    record_t *records = (record_t *)malloc(n * sizeof(record_t));
+    record_t **pointers = (record_t **)malloc(n * sizeof(record_t *));
+    srand(5);
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = rand();
+        records[i].key = keys[i];
+        pointers[i] = &records[i];
+    }
+    double generic[3], typed[3], start;
+    size_t found = 0;
+
+    // int keys.
+    avl_t *avl = avl_create(sizeof(int), int_compare);
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) avl_insert(avl, &keys[i]);
+    generic[0] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found += avl_search(avl, &keys[i]) != NULL;
+    generic[1] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) avl_remove(avl, &keys[i], NULL);
+    generic[2] = now_ms() - start;
+    avl_delete(avl, NULL);
+
+    int_avl_t *int_avl = int_avl_create();
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) int_avl_insert(int_avl, keys[i]);
+    typed[0] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found -= int_avl_search(int_avl, keys[i]) != NULL;
+    typed[1] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) int_avl_remove(int_avl, keys[i], NULL);
+    typed[2] = now_ms() - start;
+    int_avl_delete(int_avl);
+    print_times("int keys", n, generic, typed);
+
+    // Pointers to records, compared by key.
+    avl = avl_create(sizeof(record_t *), record_compare);
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) avl_insert(avl, &pointers[i]);
+    generic[0] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found += avl_search(avl, &pointers[i]) != NULL;
+    generic[1] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) avl_remove(avl, &pointers[i], NULL);
+    generic[2] = now_ms() - start;
+    avl_delete(avl, NULL);
+
+    record_avl_t *record_avl = record_avl_create();
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) record_avl_insert(record_avl, pointers[i]);
+    typed[0] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found -= record_avl_search(record_avl, pointers[i]) != NULL;
+    typed[1] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) record_avl_remove(record_avl, pointers[i], NULL);
+    typed[2] = now_ms() - start;
+    record_avl_delete(record_avl);
+    print_times("record pointers", n, generic, typed);
+
+    if (found != 0) printf(YELLOW "The trees found different elements" RESET "\n");
+    free(keys);
+    free(records);
+    free(pointers);
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_typed_avl());
+    test_fn(test_typed_avl_pointers());
+
+    test_typed_avl_benchmark(200000);
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}
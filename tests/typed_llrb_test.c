@@ -0,0 +1,215 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <typed_llrb.h>
+#include <llrb_tree.h>
+
+typedef struct {
+    int key;
+    char name[12];
+} record_t;
+
+#define int_cmp(a, b) TYPED_CMP(a, b)
+#define record_cmp(a, b) TYPED_CMP((a)->key, (b)->key)
+
+DEFINE_LLRB(int_llrb, int, int_cmp)
+DEFINE_LLRB(record_llrb, record_t *, record_cmp)
+
+// Checks the LLRB invariants, returns the black height or -1.
+static int check_node(int_llrb_node_t *node, int *last, bool *ordered) {
+    if (!node) return 1;
+    if (int_llrb__is_red(node->right)) return -1;
+    if (node->is_red && int_llrb__is_red(node->left)) return -1;
+    int l = check_node(node->left, last, ordered);
+    if (*last >= node->value) *ordered = false;
+    *last = node->value;
+    int r = check_node(node->right, last, ordered);
+    if (l < 0 || l != r) return -1;
+    return l + !node->is_red;
+}
+
+static bool is_llrb(int_llrb_t *tree) {
+    int last = -1;
+    bool ordered = true;
+    return check_node(tree->root, &last, &ordered) >= 0 && ordered;
+}
+
+bool test_typed_llrb() {
+    int_llrb_t *tree = int_llrb_create();
+    assert_eq(int_llrb_min(tree), NULL);
+
+    srand(42);
+    int n = 5000;
+    bool *present = (bool *)calloc(2 * n, sizeof(bool));
+    size_t size = 0;
+    for (int i = 0; i < n; i++) {
+        int value = rand() % (2 * n);
+        assert_eq(int_llrb_insert(tree, value), !present[value]);
+        size += !present[value];
+        present[value] = true;
+        if (i % 500 == 0) assert_eq(is_llrb(tree), true);
+    }
+    assert_eq(int_llrb_get_size(tree), size);
+    assert_eq(is_llrb(tree), true);
+
+    int last = -1;
+    for (int i = 0; i < 2 * n; i++) {
+        int *found = int_llrb_search(tree, i);
+        bool is_found = found != NULL;
+        assert_eq(is_found, present[i]);
+        if (!found) {
+            assert_eq(int_llrb_successor(tree, i), NULL);
+            continue;
+        }
+        assert_eq(*found, i);
+
+        // Walks the present values through their predecessors.
+        int *pred = int_llrb_predecessor(tree, i);
+        if (last < 0) assert_eq(pred, NULL);
+        else assert_eq(*pred, last);
+        last = i;
+    }
+
+    int min = 0, max = 2 * n - 1;
+    while (!present[min]) min++;
+    while (!present[max]) max--;
+    assert_eq(*int_llrb_min(tree), min);
+    assert_eq(*int_llrb_max(tree), max);
+    assert_eq(int_llrb_successor(tree, max), NULL);
+    int next = min + 1;
+    while (!present[next]) next++;
+    assert_eq(*int_llrb_successor(tree, min), next);
+
+    int_llrb_clear(tree);
+    assert_eq(int_llrb_get_size(tree), 0);
+    assert_eq(int_llrb_search(tree, min), NULL);
+
+    int_llrb_delete(tree);
+    free(present);
+    return true;
+}
+
+static void collect(record_t **record, void *arg) {
+    int **keys = (int **)arg;
+    *(*keys)++ = (*record)->key;
+}
+
+bool test_typed_llrb_pointers() {
+    record_llrb_t tree;
+    record_llrb_init(&tree);
+    record_t records[100];
+    for (int i = 0; i < 100; i++) {
+        records[i].key = (i * 37) % 100;
+        sprintf(records[i].name, "record%d", records[i].key);
+        record_llrb_insert(&tree, &records[i]);
+    }
+
+    // Searching goes through what the pointers point to.
+    record_t probe = { 42 };
+    record_t **found = record_llrb_search(&tree, &probe);
+    assert_neq(found, NULL);
+    assert_eq(strcmp((*found)->name, "record42"), 0);
+    assert_eq((*record_llrb_successor(&tree, &probe))->key, 43);
+    assert_eq(record_llrb_insert(&tree, &probe), false);
+
+    int keys[100], *next = keys;
+    record_llrb_inorder_foreach(&tree, collect, &next);
+    for (int i = 0; i < 100; i++) assert_eq(keys[i], i);
+
+    record_llrb_clear(&tree);
+    return true;
+}
+
+/* Benchmarks */
+
+static int int_compare(void *a, void *b) {
+    return *(int *)a < *(int *)b ? -1 : *(int *)a > *(int *)b;
+}
+
+static int record_compare(void *a, void *b) {
+    int x = (*(record_t **)a)->key, y = (*(record_t **)b)->key;
+    return x < y ? -1 : x > y;
+}
+
+static void print_times(char *what, size_t n, double *generic, double *typed) {
+    printf(CYAN "%s, %zu elements: insert %.2lf / %.2lf ms, search %.2lf / %.2lf ms "
+           "(llrb_tree_t / typed, %.1lfx faster overall)" RESET "\n",
+           what, n, generic[0], typed[0], generic[1], typed[1],
+           (generic[0] + generic[1]) / (typed[0] + typed[1]));
+}
+
+void test_typed_llrb_benchmark(size_t n) {
+    int *keys = (int *)malloc(n * sizeof(int));
+    record_t *records = (record_t *)malloc(n * sizeof(record_t));
+    record_t **pointers = (record_t **)malloc(n * sizeof(record_t *));
+    srand(5);
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = rand();
+        records[i].key = keys[i];
+        pointers[i] = &records[i];
+    }
+    double generic[2], typed[2], start;
+    size_t found = 0;
+
+    // int keys.
+    llrb_tree_t *llrb = llrb_create(sizeof(int), int_compare);
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) llrb_insert(llrb, &keys[i]);
+    generic[0] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found += llrb_search(llrb, &keys[i]) != NULL;
+    generic[1] = now_ms() - start;
+    llrb_delete(llrb, free);
+
+    int_llrb_t *int_llrb = int_llrb_create();
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) int_llrb_insert(int_llrb, keys[i]);
+    typed[0] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found -= int_llrb_search(int_llrb, keys[i]) != NULL;
+    typed[1] = now_ms() - start;
+    int_llrb_delete(int_llrb);
+    print_times("int keys", n, generic, typed);
+
+    // Pointers to records, compared by key.
+    llrb = llrb_create(sizeof(record_t *), record_compare);
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) llrb_insert(llrb, &pointers[i]);
+    generic[0] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found += llrb_search(llrb, &pointers[i]) != NULL;
+    generic[1] = now_ms() - start;
+    llrb_delete(llrb, free);
+
+    record_llrb_t *record_llrb = record_llrb_create();
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) record_llrb_insert(record_llrb, pointers[i]);
+    typed[0] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found -= record_llrb_search(record_llrb, pointers[i]) != NULL;
+    typed[1] = now_ms() - start;
+    record_llrb_delete(record_llrb);
+    print_times("record pointers", n, generic, typed);
+
+    if (found != 0) printf(YELLOW "The trees found different elements" RESET "\n");
+    free(keys);
+    free(records);
+    free(pointers);
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_typed_llrb());
+    test_fn(test_typed_llrb_pointers());
+
+    test_typed_llrb_benchmark(200000);
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <typed_lltreap.h>
+#include <lltreap.h>
+
+typedef struct {
+    int key;
+    char name[12];
+} record_t;
+
+#define int_cmp(a, b) TYPED_CMP(a, b)
+#define record_cmp(a, b) TYPED_CMP((a)->key, (b)->key)
+
+DEFINE_LLTREAP(int_treap, int, int_cmp)
+DEFINE_LLTREAP(record_treap, record_t *, record_cmp)
+
+// Checks the search order and, when heap is set, the priorities.
+static bool check_node(int_treap_node_t *node, int *last, bool heap) {
+    if (!node) return true;
+    if (heap && node->left && node->left->priority > node->priority) return false;
+    if (heap && node->right && node->right->priority > node->priority) return false;
+    if (!check_node(node->left, last, heap) || *last >= node->value) return false;
+    *last = node->value;
+    return check_node(node->right, last, heap);
+}
+
+static bool is_treap(int_treap_t *treap, bool heap) {
+    int last = -1;
+    return check_node(treap->root, &last, heap);
+}
+
+bool test_typed_lltreap() {
+    int_treap_t *treap = int_treap_create();
+
+    srand(42);
+    int n = 5000;
+    bool *present = (bool *)calloc(2 * n, sizeof(bool));
+    size_t size = 0;
+    for (int i = 0; i < n; i++) {
+        int value = rand() % (2 * n);
+        assert_eq(int_treap_insert(treap, value), !present[value]);
+        size += !present[value];
+        present[value] = true;
+    }
+    assert_eq(int_treap_get_size(treap), size);
+    assert_eq(is_treap(treap, true), true);
+
+    for (int i = 0; i < 2 * n; i++) {
+        int *found = int_treap_search(treap, i);
+        bool is_found = found != NULL;
+        assert_eq(is_found, present[i]);
+        if (found) assert_eq(*found, i);
+    }
+
+    // Removes half of the values. Removal keeps the order, not the priorities.
+    for (int i = 0; i < 2 * n; i += 2) {
+        int removed = -1;
+        assert_eq(int_treap_remove(treap, i, &removed), present[i]);
+        if (present[i]) assert_eq(removed, i);
+        size -= present[i];
+        present[i] = false;
+    }
+    assert_eq(int_treap_get_size(treap), size);
+    assert_eq(is_treap(treap, false), true);
+    for (int i = 0; i < 2 * n; i++) {
+        bool is_found = int_treap_search(treap, i) != NULL;
+        assert_eq(is_found, present[i]);
+    }
+
+    int_treap_clear(treap);
+    assert_eq(int_treap_get_size(treap), 0);
+    assert_eq(int_treap_remove(treap, 1, NULL), false);
+
+    // The highest priority goes to the root.
+    int_treap_insert_with_priority(treap, 1, 10);
+    int_treap_insert_with_priority(treap, 2, 30);
+    int_treap_insert_with_priority(treap, 3, 20);
+    assert_eq(treap->root->value, 2);
+    assert_eq(treap->root->right->value, 3);
+
+    int_treap_delete(treap);
+    free(present);
+    return true;
+}
+
+static void collect(record_t **record, void *arg) {
+    int **keys = (int **)arg;
+    *(*keys)++ = (*record)->key;
+}
+
+bool test_typed_lltreap_pointers() {
+    record_treap_t treap;
+    record_treap_init(&treap);
+    record_t records[100];
+    for (int i = 0; i < 100; i++) {
+        records[i].key = (i * 37) % 100;
+        sprintf(records[i].name, "record%d", records[i].key);
+        record_treap_insert(&treap, &records[i]);
+    }
+
+    // Searching goes through what the pointers point to.
+    record_t probe = { 42 };
+    record_t **found = record_treap_search(&treap, &probe);
+    assert_neq(found, NULL);
+    assert_eq(strcmp((*found)->name, "record42"), 0);
+
+    int keys[100], *next = keys;
+    record_treap_inorder_foreach(&treap, collect, &next);
+    for (int i = 0; i < 100; i++) assert_eq(keys[i], i);
+
+    record_t *removed;
+    assert_eq(record_treap_remove(&treap, &probe, &removed), true);
+    assert_eq(removed->key, 42);
+    assert_eq(record_treap_search(&treap, &probe), NULL);
+
+    record_treap_clear(&treap);
+    return true;
+}
+
+/* Benchmarks */
+
+static int int_compare(void *a, void *b) {
+    return *(int *)a < *(int *)b ? -1 : *(int *)a > *(int *)b;
+}
+
+static int record_compare(void *a, void *b) {
+    int x = (*(record_t **)a)->key, y = (*(record_t **)b)->key;
+    return x < y ? -1 : x > y;
+}
+
+static void print_times(char *what, size_t n, double *generic, double *typed) {
+    printf(CYAN "%s, %zu elements: insert %.2lf / %.2lf ms, search %.2lf / %.2lf ms, remove %.2lf / %.2lf ms "
+           "(lltreap_t / typed, %.1lfx faster overall)" RESET "\n",
+           what, n, generic[0], typed[0], generic[1], typed[1], generic[2], typed[2],
+           (generic[0] + generic[1] + generic[2]) / (typed[0] + typed[1] + typed[2]));
+}
+
+void test_typed_lltreap_benchmark(size_t n) {
+    int *keys = (int *)malloc(n * sizeof(int));
+    record_t *records = (record_t *)malloc(n * sizeof(record_t));
+    record_t **pointers = (record_t **)malloc(n * sizeof(record_t *));
+    srand(5);
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = rand();
+        records[i].key = keys[i];
+        pointers[i] = &records[i];
+    }
+    double generic[3], typed[3], start;
+    size_t found = 0;
+
+    // int keys.
+    lltreap_t *lltreap = lltreap_create(sizeof(int), int_compare);
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) lltreap_insert(lltreap, &keys[i]);
+    generic[0] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found += lltreap_search(lltreap, &keys[i]) != NULL;
+    generic[1] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) lltreap_remove(lltreap, &keys[i], free);
+    generic[2] = now_ms() - start;
+    lltreap_delete(lltreap, free);
+
+    int_treap_t *int_treap = int_treap_create();
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) int_treap_insert(int_treap, keys[i]);
+    typed[0] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found -= int_treap_search(int_treap, keys[i]) != NULL;
+    typed[1] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) int_treap_remove(int_treap, keys[i], NULL);
+    typed[2] = now_ms() - start;
+    int_treap_delete(int_treap);
+    print_times("int keys", n, generic, typed);
+
+    // Pointers to records, compared by key.
+    lltreap = lltreap_create(sizeof(record_t *), record_compare);
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) lltreap_insert(lltreap, &pointers[i]);
+    generic[0] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found += lltreap_search(lltreap, &pointers[i]) != NULL;
+    generic[1] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) lltreap_remove(lltreap, &pointers[i], free);
+    generic[2] = now_ms() - start;
+    lltreap_delete(lltreap, free);
+
+    record_treap_t *record_treap = record_treap_create();
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) record_treap_insert(record_treap, pointers[i]);
+    typed[0] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found -= record_treap_search(record_treap, pointers[i]) != NULL;
+    typed[1] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) record_treap_remove(record_treap, pointers[i], NULL);
+    typed[2] = now_ms() - start;
+    record_treap_delete(record_treap);
+    print_times("record pointers", n, generic, typed);
+
+    if (found != 0) printf(YELLOW "The treaps found different elements" RESET "\n");
+    free(keys);
+    free(records);
+    free(pointers);
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_typed_lltreap());
+    test_fn(test_typed_lltreap_pointers());
+
+    test_typed_lltreap_benchmark(200000);
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}
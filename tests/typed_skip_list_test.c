@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <typed_skip_list.h>
+#include <skip_list.h>
+
+typedef struct {
+    int key;
+    char name[12];
+} record_t;
+
+#define int_cmp(a, b) TYPED_CMP(a, b)
+#define record_cmp(a, b) TYPED_CMP((a)->key, (b)->key)
+
+DEFINE_SKIP_LIST(int_list, int, int_cmp)
+DEFINE_SKIP_LIST(record_list, record_t *, record_cmp)
+
+// Checks that every layer is sorted and skips over the layer below it.
+static bool is_skip_list(int_list_t *list) {
+    for (unsigned i = 0; i < list->height; i++) {
+        if (i > 0 && !list->head[i]) return false;
+        int_list_node_t *below = list->head[i ? i - 1 : 0];
+        for (int_list_node_t *node = list->head[i]; node; node = node->next[i]) {
+            if (node->next[i] && node->next[i]->value <= node->value) return false;
+            if (i == 0) continue;
+            while (below && below != node) below = below->next[i - 1];
+            if (!below) return false;
+        }
+    }
+    for (unsigned i = list->height; i < TYPED_SKIP_LIST_MAX_LAYERS; i++)
+        if (list->head[i]) return false;
+    return true;
+}
+
+bool test_typed_skip_list() {
+    int_list_t *list = int_list_create(16);
+    assert_eq(int_list_min(list), NULL);
+
+    srand(42);
+    int n = 5000;
+    bool *present = (bool *)calloc(2 * n, sizeof(bool));
+    size_t size = 0;
+    for (int i = 0; i < n; i++) {
+        int value = rand() % (2 * n);
+        assert_eq(int_list_insert(list, value), !present[value]);
+        size += !present[value];
+        present[value] = true;
+    }
+    assert_eq(int_list_get_size(list), size);
+    assert_eq(is_skip_list(list), true);
+    assert_leq(list->height, 16);
+
+    for (int i = 0; i < 2 * n; i++) {
+        int *found = int_list_search(list, i);
+        bool is_found = found != NULL;
+        assert_eq(is_found, present[i]);
+        if (found) assert_eq(*found, i);
+    }
+
+    // Removes half of the values, checking the list along the way.
+    for (int i = 0; i < 2 * n; i += 2) {
+        int removed = -1;
+        assert_eq(int_list_remove(list, i, &removed), present[i]);
+        if (present[i]) assert_eq(removed, i);
+        size -= present[i];
+        present[i] = false;
+        if (i % 500 == 0) assert_eq(is_skip_list(list), true);
+    }
+    assert_eq(int_list_get_size(list), size);
+    assert_eq(is_skip_list(list), true);
+    for (int i = 0; i < 2 * n; i++) {
+        bool is_found = int_list_search(list, i) != NULL;
+        assert_eq(is_found, present[i]);
+    }
+
+    int min = 0;
+    while (!present[min]) min++;
+    assert_eq(*int_list_min(list), min);
+
+    int_list_clear(list);
+    assert_eq(int_list_get_size(list), 0);
+    assert_eq(int_list_search(list, min), NULL);
+    assert_eq(int_list_remove(list, min, NULL), false);
+
+    int_list_delete(list);
+    free(present);
+    return true;
+}
+
+static void collect(record_t **record, void *arg) {
+    int **keys = (int **)arg;
+    *(*keys)++ = (*record)->key;
+}
+
+bool test_typed_skip_list_pointers() {
+    record_list_t list;
+    record_list_init(&list, 8);
+    record_t records[100];
+    for (int i = 0; i < 100; i++) {
+        records[i].key = (i * 37) % 100;
+        sprintf(records[i].name, "record%d", records[i].key);
+        record_list_insert(&list, &records[i]);
+    }
+
+    // Searching goes through what the pointers point to.
+    record_t probe = { 42 };
+    record_t **found = record_list_search(&list, &probe);
+    assert_neq(found, NULL);
+    assert_eq(strcmp((*found)->name, "record42"), 0);
+
+    int keys[100], *next = keys;
+    record_list_foreach(&list, collect, &next);
+    for (int i = 0; i < 100; i++) assert_eq(keys[i], i);
+
+    record_t *removed;
+    assert_eq(record_list_remove(&list, &probe, &removed), true);
+    assert_eq(removed->key, 42);
+    assert_eq(record_list_search(&list, &probe), NULL);
+
+    record_list_clear(&list);
+    return true;
+}
+
+/* Benchmarks */
+
+// skip_list_t holds char pointers, so the int keys are stored in them.
+static int int_compare(char *a, char *b) {
+    return (intptr_t)a < (intptr_t)b ? -1 : (intptr_t)a > (intptr_t)b;
+}
+
+static int record_compare(char *a, char *b) {
+    int x = ((record_t *)a)->key, y = ((record_t *)b)->key;
+    return x < y ? -1 : x > y;
+}
+
+static void no_free(char *_) {}
+
+static void print_times(char *what, size_t n, double *generic, double *typed) {
+    printf(CYAN "%s, %zu elements: insert %.2lf / %.2lf ms, search %.2lf / %.2lf ms, remove %.2lf / %.2lf ms "
+           "(skip_list_t / typed, %.1lfx faster overall)" RESET "\n",
+           what, n, generic[0], typed[0], generic[1], typed[1], generic[2], typed[2],
+           (generic[0] + generic[1] + generic[2]) / (typed[0] + typed[1] + typed[2]));
+}
+
+void test_typed_skip_list_benchmark(size_t n) {
+    int *keys = (int *)malloc(n * sizeof(int));
+    record_t *records = (record_t *)malloc(n * sizeof(record_t));
+    srand(5);
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = rand();
+        records[i].key = keys[i];
+    }
+    double generic[3], typed[3], start;
+    size_t found = 0;
+
+    // int keys.
+    skip_list_t *skip_list = skip_list_create(int_compare, (char *)(intptr_t)-1, 16);
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) skip_list_insert(skip_list, (char *)(intptr_t)keys[i]);
+    generic[0] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found += skip_list_find(skip_list, (char *)(intptr_t)keys[i]) != NULL;
+    generic[1] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) skip_list_remove_free(skip_list, (char *)(intptr_t)keys[i], no_free);
+    generic[2] = now_ms() - start;
+    skip_list_destroy(skip_list, no_free);
+
+    int_list_t *int_list = int_list_create(16);
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) int_list_insert(int_list, keys[i]);
+    typed[0] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found -= int_list_search(int_list, keys[i]) != NULL;
+    typed[1] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) int_list_remove(int_list, keys[i], NULL);
+    typed[2] = now_ms() - start;
+    int_list_delete(int_list);
+    print_times("int keys", n, generic, typed);
+
+    // Pointers to records, compared by key.
+    record_t min_record = { -1 };
+    skip_list = skip_list_create(record_compare, (char *)&min_record, 16);
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) skip_list_insert(skip_list, (char *)&records[i]);
+    generic[0] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found += skip_list_find(skip_list, (char *)&records[i]) != NULL;
+    generic[1] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) skip_list_remove_free(skip_list, (char *)&records[i], no_free);
+    generic[2] = now_ms() - start;
+    skip_list_destroy(skip_list, no_free);
+
+    record_list_t *record_list = record_list_create(16);
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) record_list_insert(record_list, &records[i]);
+    typed[0] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found -= record_list_search(record_list, &records[i]) != NULL;
+    typed[1] = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) record_list_remove(record_list, &records[i], NULL);
+    typed[2] = now_ms() - start;
+    record_list_delete(record_list);
+    print_times("record pointers", n, generic, typed);
+
+    if (found != 0) printf(YELLOW "The lists found different elements" RESET "\n");
+    free(keys);
+    free(records);
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_typed_skip_list());
+    test_fn(test_typed_skip_list_pointers());
+
+    test_typed_skip_list_benchmark(200000);
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <typed_sort.h>
+#include <sorting.h>
+
+typedef struct {
+    int key;
+    char name[12];
+} record_t;
+
+#define int_cmp(a, b) TYPED_CMP(a, b)
+#define record_cmp(a, b) TYPED_CMP((a)->key, (b)->key)
+
+DEFINE_SORT(ints, int, int_cmp)
+DEFINE_SORT(records, record_t *, record_cmp)
+
+static int int_compare(void *a, void *b) {
+    return *(int *)a < *(int *)b ? -1 : *(int *)a > *(int *)b;
+}
+
+static int record_compare(void *a, void *b) {
+    int x = (*(record_t **)a)->key, y = (*(record_t **)b)->key;
+    return x < y ? -1 : x > y;
+}
+
+static bool is_sorted(int *vec, size_t n) {
+    for (size_t i = 1; i < n; i++)
+        if (vec[i - 1] > vec[i]) return false;
+    return true;
+}
+
+// Fills vec with one of the inputs that trouble quick sorts.
+static void fill(int *vec, size_t n, int kind) {
+    for (size_t i = 0; i < n; i++) {
+        switch (kind) {
+        case 0: vec[i] = rand(); break;
+        case 1: vec[i] = i; break;
+        case 2: vec[i] = n - i; break;
+        case 3: vec[i] = 7; break;
+        case 4: vec[i] = rand() % 4; break;
+        default: vec[i] = i < n / 2 ? i : n - i; break; // Organ pipe.
+        }
+    }
+}
+
+bool test_typed_sort() {
+    srand(42);
+    void (*sorts[])(int *, size_t) = { ints_sort, ints_heap_sort, ints_insertion_sort };
+    size_t sizes[] = { 0, 1, 2, 3, 15, 16, 17, 100, 1000, 10000 };
+    int *vec = (int *)malloc(10000 * sizeof(int));
+    int *expected = (int *)malloc(10000 * sizeof(int));
+
+    for (int s = 0; s < 3; s++) {
+        for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+            size_t n = sizes[k];
+            if (s == 2 && n > 1000) continue;
+            for (int kind = 0; kind < 6; kind++) {
+                fill(vec, n, kind);
+                memcpy(expected, vec, n * sizeof(int));
+                qsort(expected, n, sizeof(int), (int (*)(const void *, const void *))int_compare);
+                sorts[s](vec, n);
+                assert_eq(is_sorted(vec, n), true);
+                assert_eq(memcmp(vec, expected, n * sizeof(int)), 0);
+            }
+        }
+    }
+
+    free(vec);
+    free(expected);
+    return true;
+}
+
+bool test_typed_sort_pointers() {
+    size_t n = 1000;
+    record_t *records = (record_t *)malloc(n * sizeof(record_t));
+    record_t **pointers = (record_t **)malloc(n * sizeof(record_t *));
+    for (size_t i = 0; i < n; i++) {
+        records[i].key = (i * 7919) % n;
+        sprintf(records[i].name, "record%d", records[i].key);
+        pointers[i] = &records[i];
+    }
+
+    records_sort(pointers, n);
+    for (size_t i = 0; i < n; i++) {
+        assert_eq(pointers[i]->key, i);
+        bool same_name = strncmp(pointers[i]->name, "record", 6) == 0 && atoi(pointers[i]->name + 6) == (int)i;
+        assert_eq(same_name, true);
+    }
+
+    record_t key = { 500, "" };
+    record_t **found = records_binary_search(pointers, n, &key);
+    assert_neq(found, NULL);
+    assert_eq((*found)->key, 500);
+    key.key = -1;
+    assert_eq(records_binary_search(pointers, n, &key), NULL);
+
+    free(pointers);
+    free(records);
+    return true;
+}
+
+bool test_typed_lower_bound() {
+    int vec[] = { 1, 3, 3, 3, 5, 8 };
+    size_t n = sizeof(vec) / sizeof(vec[0]);
+
+    assert_eq(ints_lower_bound(vec, n, 0), 0);
+    assert_eq(ints_lower_bound(vec, n, 1), 0);
+    assert_eq(ints_lower_bound(vec, n, 3), 1);
+    assert_eq(ints_lower_bound(vec, n, 4), 4);
+    assert_eq(ints_lower_bound(vec, n, 8), 5);
+    assert_eq(ints_lower_bound(vec, n, 9), n);
+    assert_eq(ints_lower_bound(vec, 0, 9), 0);
+
+    assert_eq(ints_binary_search(vec, n, 5), &vec[4]);
+    assert_eq(*ints_binary_search(vec, n, 3), 3);
+    assert_eq(ints_binary_search(vec, n, 4), NULL);
+    assert_eq(ints_binary_search(vec, n, 9), NULL);
+    assert_eq(ints_binary_search(vec, 0, 1), NULL);
+    return true;
+}
+
+/* Benchmarks */
+
+void test_typed_sort_benchmark(size_t n) {
+    srand(5);
+    int *values = (int *)malloc(n * sizeof(int));
+    int *vec = (int *)malloc(n * sizeof(int));
+    for (size_t i = 0; i < n; i++) values[i] = rand();
+
+    memcpy(vec, values, n * sizeof(int));
+    double start = now_ms();
+    quick_sort_with(vec, n, sizeof(int), int_compare);
+    double quick_ms = now_ms() - start;
+
+    memcpy(vec, values, n * sizeof(int));
+    start = now_ms();
+    heap_sort_with(vec, n, sizeof(int), int_compare);
+    double heap_ms = now_ms() - start;
+
+    memcpy(vec, values, n * sizeof(int));
+    start = now_ms();
+    ints_sort(vec, n);
+    double typed_ms = now_ms() - start;
+
+    memcpy(vec, values, n * sizeof(int));
+    start = now_ms();
+    ints_heap_sort(vec, n);
+    double typed_heap_ms = now_ms() - start;
+
+    printf(CYAN "int, %zu elements: quick_sort_with %.2lf ms, ints_sort %.2lf ms (%.1lfx), "
+           "heap_sort_with %.2lf ms, ints_heap_sort %.2lf ms (%.1lfx)" RESET "\n",
+           n, quick_ms, typed_ms, quick_ms / typed_ms, heap_ms, typed_heap_ms, heap_ms / typed_heap_ms);
+
+    record_t *records = (record_t *)malloc(n * sizeof(record_t));
+    record_t **pointers = (record_t **)malloc(n * sizeof(record_t *));
+    for (size_t i = 0; i < n; i++) {
+        records[i].key = values[i];
+        pointers[i] = &records[i];
+    }
+
+    start = now_ms();
+    quick_sort_with(pointers, n, sizeof(record_t *), record_compare);
+    quick_ms = now_ms() - start;
+
+    for (size_t i = 0; i < n; i++) pointers[i] = &records[i];
+    start = now_ms();
+    records_sort(pointers, n);
+    typed_ms = now_ms() - start;
+
+    size_t found = 0;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) {
+        record_t *key = &records[i];
+        found += binary_search(&key, pointers, n, sizeof(record_t *), record_compare) != NULL;
+    }
+    double search_ms = now_ms() - start;
+    start = now_ms();
+    for (size_t i = 0; i < n; i++) found -= records_binary_search(pointers, n, &records[i]) != NULL;
+    double typed_search_ms = now_ms() - start;
+    if (found != 0) printf(YELLOW "The searches found different elements" RESET "\n");
+
+    printf(CYAN "record *, %zu elements: quick_sort_with %.2lf ms, records_sort %.2lf ms (%.1lfx), "
+           "binary_search %.2lf ms, records_binary_search %.2lf ms (%.1lfx)" RESET "\n",
+           n, quick_ms, typed_ms, quick_ms / typed_ms, search_ms, typed_search_ms, search_ms / typed_search_ms);
+
+    free(records);
+    free(pointers);
+    free(values);
+    free(vec);
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_typed_sort());
+    test_fn(test_typed_sort_pointers());
+    test_fn(test_typed_lower_bound());
+
+    test_typed_sort_benchmark(1000000);
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}
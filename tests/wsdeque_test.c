@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "test_utils.h"
+#include <colors.h>
+#include <wsdeque.h>
+
+// Elements are the numbers 1, 2, ... disguised as pointers.
+#define ELEMENT(i) ((void *)(uintptr_t)(i))
+
+bool test_wsdeque() {
+    wsdeque_t *deque = wsdeque_create(4);
+    assert_eq(wsdeque_pop(deque), NULL);
+    assert_eq(wsdeque_steal(deque), NULL);
+
+    // Grows past its starting capacity.
+    for (uintptr_t i = 1; i <= 100; i++) wsdeque_push(deque, ELEMENT(i));
+    assert_eq(wsdeque_get_size(deque), 100);
+
+    // The owner takes the newest, thieves the oldest.
+    assert_eq((uintptr_t)wsdeque_pop(deque), 100);
+    assert_eq((uintptr_t)wsdeque_steal(deque), 1);
+    assert_eq((uintptr_t)wsdeque_steal(deque), 2);
+    assert_eq((uintptr_t)wsdeque_pop(deque), 99);
+
+    for (uintptr_t i = 98; i >= 3; i--) assert_eq((uintptr_t)wsdeque_pop(deque), i);
+    assert_eq(wsdeque_is_empty(deque), true);
+    assert_eq(wsdeque_pop(deque), NULL);
+    assert_eq(wsdeque_steal(deque), NULL);
+
+    // Wraps around the array.
+    for (uintptr_t lap = 0; lap < 10; lap++) {
+        for (uintptr_t i = 1; i <= 50; i++) wsdeque_push(deque, ELEMENT(i));
+        for (uintptr_t i = 1; i <= 50; i++) assert_eq((uintptr_t)wsdeque_steal(deque), i);
+    }
+
+    wsdeque_delete(deque);
+    return true;
+}
+
+typedef struct {
+    wsdeque_t *deque;
+    uint8_t *taken; // How many times each element was taken.
+    bool *done;
+    size_t count;
+} thief_t;
+
+static void *thief(void *arg) {
+    thief_t *t = (thief_t *)arg;
+    for (;;) {
+        bool done = __atomic_load_n(t->done, __ATOMIC_ACQUIRE);
+        void *element = wsdeque_steal(t->deque);
+        if (element) {
+            __atomic_fetch_add(&t->taken[(uintptr_t)element], 1, __ATOMIC_RELAXED);
+            t->count++;
+        } else if (done && wsdeque_is_empty(t->deque)) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+// The owner pushes and pops while thieves steal: every element must be taken
+// exactly once, even while the deque grows.
+bool test_wsdeque_threads() {
+    size_t n = 200000;
+    wsdeque_t *deque = wsdeque_create(2);
+    uint8_t *taken = (uint8_t *)calloc(n + 1, 1);
+    bool done = false;
+
+    thief_t thieves[3];
+    pthread_t threads[3];
+    for (int i = 0; i < 3; i++) {
+        thieves[i] = (thief_t){ deque, taken, &done, 0 };
+        pthread_create(&threads[i], NULL, thief, &thieves[i]);
+    }
+
+    size_t popped = 0;
+    for (uintptr_t i = 1; i <= n; i++) {
+        wsdeque_push(deque, ELEMENT(i));
+        // Pops about one in three, so the deque both grows and empties.
+        if (i % 3 == 0) {
+            void *element = wsdeque_pop(deque);
+            if (element) {
+                __atomic_fetch_add(&taken[(uintptr_t)element], 1, __ATOMIC_RELAXED);
+                popped++;
+            }
+        }
+    }
+    for (void *element; (element = wsdeque_pop(deque));) {
+        __atomic_fetch_add(&taken[(uintptr_t)element], 1, __ATOMIC_RELAXED);
+        popped++;
+    }
+    __atomic_store_n(&done, true, __ATOMIC_RELEASE);
+
+    size_t stolen = 0;
+    for (int i = 0; i < 3; i++) {
+        pthread_join(threads[i], NULL);
+        stolen += thieves[i].count;
+    }
+    assert_eq(popped + stolen, n);
+    size_t wrong = 0;
+    for (size_t i = 1; i <= n; i++) wrong += taken[i] != 1;
+    assert_eq(wrong, 0);
+
+    free(taken);
+    wsdeque_delete(deque);
+    return true;
+}
+
+/* Benchmarks */
+
+// The owner side alone, which is what a worker does when nobody steals, and
+// thieves alone emptying a full deque.
+void test_wsdeque_benchmark(size_t n) {
+    wsdeque_t *deque = wsdeque_create(64);
+    size_t sum = 0;
+
+    double start = now_ms();
+    for (size_t round = 0; round < n / 64; round++) {
+        for (uintptr_t i = 1; i <= 64; i++) wsdeque_push(deque, ELEMENT(i));
+        for (int i = 0; i < 64; i++) sum += (uintptr_t)wsdeque_pop(deque);
+    }
+    double owner_ms = now_ms() - start;
+
+    for (uintptr_t i = 1; i <= n; i++) wsdeque_push(deque, ELEMENT(i));
+    start = now_ms();
+    for (void *element; (element = wsdeque_steal(deque));) sum -= (uintptr_t)element;
+    double steal_ms = now_ms() - start;
+
+    if (sum != (n / 64) * (64 * 65 / 2) - n * (n + 1) / 2)
+        printf(YELLOW "The deque lost elements" RESET "\n");
+    printf(CYAN "wsdeque: %zu pushes and pops by the owner in %.2lf ms (%.1lf ns each), "
+           "%zu steals in %.2lf ms (%.1lf ns each)" RESET "\n",
+           n / 64 * 64, owner_ms, owner_ms * 1e6 / (n / 64 * 64), n, steal_ms, steal_ms * 1e6 / n);
+
+    wsdeque_delete(deque);
+}
+
+int main(void) {
+    TEST_SETUP();
+
+    test_fn(test_wsdeque());
+    test_fn(test_wsdeque_threads());
+
+    test_wsdeque_benchmark(10000000);
+
+    TEST_TEARDOWN();
+    return EXIT_SUCCESS;
+}